@@ -0,0 +1,68 @@
+//! Batch throughput of `Nfiq2::compute_batch` on the bundled SFinGe images.
+//!
+//! Run with `cargo bench --bench batch`. Each row scores the same batch
+//! (the five images replicated `REPEAT` times) with a different worker
+//! count and reports images/sec, plus the speedup over one worker.
+
+use std::time::Instant;
+
+use nfiq2::create_nfiq2;
+
+const IMAGES: [&str; 5] = [
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test02.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test03.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test04.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test05.pgm",
+];
+
+const REPEAT: usize = 8;
+
+fn main() {
+    let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+    let files: Vec<Vec<u8>> = IMAGES
+        .iter()
+        .map(|path| std::fs::read(path).expect("failed to read test image"))
+        .collect();
+    let batch: Vec<Vec<u8>> = (0..REPEAT).flat_map(|_| files.iter().cloned()).collect();
+
+    let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+    let mut counts = vec![1];
+    while counts[counts.len() - 1] * 2 <= cores {
+        counts.push(counts[counts.len() - 1] * 2);
+    }
+    if counts[counts.len() - 1] != cores {
+        counts.push(cores);
+    }
+
+    // warm up model and allocator
+    nfiq.compute_batch(files.clone(), 1).expect("batch failed");
+
+    println!(
+        "{:>8} {:>8} {:>12} {:>10} {:>8}",
+        "threads", "images", "seconds", "images/s", "speedup"
+    );
+    let mut base = 0.0;
+    for threads in counts {
+        let start = Instant::now();
+        let results = nfiq
+            .compute_batch(batch.clone(), threads as u32)
+            .expect("batch failed");
+        let seconds = start.elapsed().as_secs_f64();
+        assert!(results.iter().all(|r| r.error.is_none()));
+
+        let rate = batch.len() as f64 / seconds;
+        if threads == 1 {
+            base = rate;
+        }
+        println!(
+            "{:>8} {:>8} {:>12.3} {:>10.2} {:>7.2}x",
+            threads,
+            batch.len(),
+            seconds,
+            rate,
+            rate / base
+        );
+    }
+}
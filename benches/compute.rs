@@ -0,0 +1,60 @@
+//! Per-image latency of `Nfiq2::compute` on the bundled SFinGe images.
+//!
+//! Run with `cargo bench --bench compute`. To compare against another
+//! revision (e.g. the two-pass wrapper that scored by re-running every
+//! quality module), check that revision out and run the same command; the
+//! output format is stable so the two reports can be diffed directly.
+
+use std::time::{Duration, Instant};
+
+use nfiq2::create_nfiq2;
+
+const IMAGES: [&str; 5] = [
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test02.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test03.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test04.pgm",
+    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test05.pgm",
+];
+
+const WARMUP: usize = 2;
+const ITERATIONS: usize = 20;
+
+fn main() {
+    let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+    let mut total = Duration::ZERO;
+    for path in IMAGES.iter() {
+        let bytes = std::fs::read(path).expect("failed to read test image");
+
+        for _ in 0..WARMUP {
+            nfiq.compute(&bytes).expect("compute failed");
+        }
+
+        let mut samples = Vec::with_capacity(ITERATIONS);
+        let mut score = 0;
+        for _ in 0..ITERATIONS {
+            let start = Instant::now();
+            score = nfiq.compute(&bytes).expect("compute failed").score;
+            samples.push(start.elapsed());
+        }
+        samples.sort();
+
+        let sum: Duration = samples.iter().sum();
+        total += sum;
+        println!(
+            "{:<20} score={:>3}  min={:>8.2?}  median={:>8.2?}  mean={:>8.2?}",
+            path.rsplit('/').next().unwrap_or(path),
+            score,
+            samples[0],
+            samples[ITERATIONS / 2],
+            sum / ITERATIONS as u32,
+        );
+    }
+
+    println!(
+        "{:<20} mean per image = {:.2?}",
+        "all",
+        total / (ITERATIONS * IMAGES.len()) as u32
+    );
+}
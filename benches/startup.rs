@@ -0,0 +1,38 @@
+//! Cost of `create_nfiq2`, which loads the embedded random forest.
+//!
+//! Run with `cargo bench --bench startup`. The first creation in the
+//! process loads the model shared by all handles and is reported
+//! separately; later creations only allocate a handle. To compare against
+//! the YAML model, rebuild with `NFIQ2_YAML_MODEL=1 cargo bench --bench startup`.
+
+use std::time::{Duration, Instant};
+
+use nfiq2::create_nfiq2;
+
+const ITERATIONS: usize = 20;
+
+fn main() {
+    let start = Instant::now();
+    let first = create_nfiq2().expect("failed to create wrapper");
+    let cold = start.elapsed();
+    drop(first);
+
+    let mut samples = Vec::with_capacity(ITERATIONS);
+    for _ in 0..ITERATIONS {
+        let start = Instant::now();
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+        samples.push(start.elapsed());
+        drop(nfiq);
+    }
+    samples.sort();
+
+    let mean = samples.iter().sum::<Duration>() / ITERATIONS as u32;
+    println!("first create_nfiq2: {:>10.3} ms", cold.as_secs_f64() * 1e3);
+    println!(
+        "create_nfiq2 min/median/mean: {:.3} / {:.3} / {:.3} ms ({} iterations)",
+        samples[0].as_secs_f64() * 1e3,
+        samples[ITERATIONS / 2].as_secs_f64() * 1e3,
+        mean.as_secs_f64() * 1e3,
+        ITERATIONS
+    );
+}
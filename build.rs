@@ -47,6 +47,11 @@ fn copy_dir(source: &Path, dest: &Path) -> std::io::Result<()> {
 
 fn main() {
     println!("cargo:rerun-if-env-changed=CLIPPY");
+    println!("cargo:rerun-if-env-changed=NFIQ2_YAML_MODEL");
+    println!("cargo:rerun-if-env-changed=NFIQ2_MODEL_COMPILER");
+    println!("cargo:rerun-if-env-changed=NFIQ2_OPENCV_CPU_BASELINE");
+    println!("cargo:rerun-if-env-changed=NFIQ2_OPENCV_CPU_DISPATCH");
+    println!("cargo:rerun-if-env-changed=NFIQ2_CPU_DISPATCH");
 
     let target = env::var("TARGET").unwrap_or_default();
     let is_android = target.contains("android");
@@ -76,7 +81,44 @@ fn main() {
         .define("CMAKE_INSTALL_PREFIX", "NFIQ2-2.3.0/install")
         .define("EMBED_RANDOM_FOREST_PARAMETERS", "ON")
         .define("EMBEDDED_RANDOM_FOREST_PARAMETER_FCT", "3")
-        .define("BUILD_NFIQ2_CLI", "OFF");
+        .define("BUILD_NFIQ2_CLI", "OFF")
+        .define("BUILD_NFIQ2_TESTS", "OFF");
+
+    // The model is compiled to a binary table at build time unless
+    // NFIQ2_YAML_MODEL is set (e.g. to compare startup time). Cross builds
+    // need a host `nfiq2-compile-model` passed in NFIQ2_MODEL_COMPILER.
+    if env::var_os("NFIQ2_YAML_MODEL").is_some() {
+        cmake.define("COMPILE_RANDOM_FOREST_PARAMETERS", "OFF");
+    } else if let Some(compiler) = env::var_os("NFIQ2_MODEL_COMPILER") {
+        cmake.define("NFIQ2_MODEL_COMPILER", compiler);
+    } else if env::var("HOST").unwrap_or_default() != target {
+        panic!(
+            "Cross-compiling for {target} needs a host nfiq2-compile-model \
+             in NFIQ2_MODEL_COMPILER (built by a native build of this \
+             crate, as build_android.sh does), or NFIQ2_YAML_MODEL=1 to \
+             embed the YAML model"
+        );
+    }
+
+    // OpenCV's own thread pool, sized at run time by set_opencv_threads
+    let opencv_pthreads = env::var_os("CARGO_FEATURE_OPENCV_PTHREADS").is_some();
+    cmake.define(
+        "OPENCV_PARALLEL_PTHREADS",
+        if opencv_pthreads { "ON" } else { "OFF" },
+    );
+
+    // Instruction sets: OpenCV's baseline and run-time dispatched ones
+    // (OpenCV's defaults for the target when unset), and whether NFIQ2
+    // clones its hot kernels for AVX2/AVX-512 (on by default, x86-64 only)
+    if let Some(baseline) = env::var_os("NFIQ2_OPENCV_CPU_BASELINE") {
+        cmake.define("OPENCV_CPU_BASELINE", baseline);
+    }
+    if let Some(dispatch) = env::var_os("NFIQ2_OPENCV_CPU_DISPATCH") {
+        cmake.define("OPENCV_CPU_DISPATCH", dispatch);
+    }
+    if let Some(dispatch) = env::var_os("NFIQ2_CPU_DISPATCH") {
+        cmake.define("NFIQ2_CPU_DISPATCH", dispatch);
+    }
 
     if is_android {
         let ndk = env::var("ANDROID_NDK_ROOT").expect("ANDROID_NDK_ROOT not set");
@@ -113,6 +155,7 @@ fn main() {
         .cpp(true) // switch to a C++ compiler
         .flag_if_supported("-std=c++14") // or c++11/17, whichever you need
         .include(&nfiq2_include_path) // where nfiq2.hpp lives
+        .include(nfiq2_include_path.join("opencv4")) // cv::setNumThreads
         .include("src/cwrapper")
         .file("src/cwrapper/nfiq_wrapper.cpp") // your FFI source
         .define("NOVERBOSE", None) // you probably don’t want stdout spam
@@ -149,6 +192,9 @@ fn main() {
     if is_linux {
         println!("cargo:rustc-link-lib=dylib=stdc++");
         println!("cargo:rustc-link-lib=dylib=z");
+        if opencv_pthreads {
+            println!("cargo:rustc-link-lib=dylib=pthread");
+        }
     }
 
     if is_android {
@@ -22,6 +22,19 @@ TARGETS=(
   "armv7-linux-androideabi"  # armeabi-v7a
 )
 
+# Cross builds cannot run the nfiq2-compile-model they build, so build the
+# crate natively first and compile the Android models with its host one
+if [ -z "$NFIQ2_MODEL_COMPILER" ] && [ -z "$NFIQ2_YAML_MODEL" ]; then
+  echo "🔧 Building the host model compiler..."
+  cargo build --release
+  MODEL_COMPILER=$(ls -t target/release/build/nfiq2-rs-*/out/build/nfiq2-prefix/src/nfiq2-build/nfiq2-compile-model 2>/dev/null | head -n 1)
+  if [ -z "$MODEL_COMPILER" ]; then
+    echo "❌ No nfiq2-compile-model found in the native build"
+    exit 1
+  fi
+  export NFIQ2_MODEL_COMPILER="$PWD/$MODEL_COMPILER"
+fi
+
 # Build each target
 for TARGET in "${TARGETS[@]}"; do
   echo "📦 Building for $TARGET..."
@@ -0,0 +1,160 @@
+#include <opencv2/imgcodecs.hpp>
+
+#include "benchmark_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+void
+NFIQ2::Benchmarks::printUsage(const char *program, const std::string &usage)
+{
+	std::cerr << "Usage: " << program << " " << usage << "\n";
+}
+
+bool
+NFIQ2::Benchmarks::parseOptions(int argc, char **argv, Options &options,
+    const std::string &usage)
+{
+	const auto count = [&](const int i, unsigned int &value) {
+		value = static_cast<unsigned int>(
+		    std::strtoul(argv[i], nullptr, 10));
+		return (value != 0);
+	};
+
+	for (int i { 1 }; i < argc; ++i) {
+		if ((std::strcmp(argv[i], "-i") == 0) && (i + 1 < argc)) {
+			if (!count(++i, options.iterations)) {
+				printUsage(argv[0], usage);
+				return (false);
+			}
+			continue;
+		}
+		if ((std::strcmp(argv[i], "-b") == 0) && (i + 1 < argc)) {
+			if (!count(++i, options.blocks)) {
+				printUsage(argv[0], usage);
+				return (false);
+			}
+			continue;
+		}
+		if ((std::strcmp(argv[i], "-m") == 0) && (i + 1 < argc)) {
+			options.model = argv[++i];
+			continue;
+		}
+		if ((std::strcmp(argv[i], "-h") == 0) && (i + 1 < argc)) {
+			options.modelHash = argv[++i];
+			continue;
+		}
+		if (argv[i][0] == '-') {
+			printUsage(argv[0], usage);
+			return (false);
+		}
+
+		cv::Mat image = cv::imread(argv[i], cv::IMREAD_GRAYSCALE);
+		if (image.empty()) {
+			std::cerr << "Cannot read " << argv[i] << "\n";
+			return (false);
+		}
+		if (!image.isContinuous()) {
+			image = image.clone();
+		}
+		options.images.push_back(image);
+	}
+
+	return (true);
+}
+
+NFIQ2::FingerprintImageData
+NFIQ2::Benchmarks::copyImage(const cv::Mat &image)
+{
+	return (NFIQ2::FingerprintImageData(image.data,
+	    static_cast<uint32_t>(image.total()),
+	    static_cast<uint32_t>(image.cols),
+	    static_cast<uint32_t>(image.rows), 0,
+	    NFIQ2::FingerprintImageData::Resolution500PPI));
+}
+
+NFIQ2::FingerprintImageData
+NFIQ2::Benchmarks::viewImage(const cv::Mat &image)
+{
+	return (NFIQ2::FingerprintImageData::view(image.data,
+	    static_cast<uint32_t>(image.total()),
+	    static_cast<uint32_t>(image.cols),
+	    static_cast<uint32_t>(image.rows), 0,
+	    NFIQ2::FingerprintImageData::Resolution500PPI));
+}
+
+bool
+NFIQ2::Benchmarks::identical(const double a, const double b)
+{
+	return (std::memcmp(&a, &b, sizeof(double)) == 0);
+}
+
+bool
+NFIQ2::Benchmarks::identical(const void *a, const void *b,
+    const std::size_t size)
+{
+	return ((size == 0) || (std::memcmp(a, b, size) == 0));
+}
+
+bool
+NFIQ2::Benchmarks::identical(const cv::Mat &a, const cv::Mat &b)
+{
+	if ((a.size() != b.size()) || (a.type() != b.type())) {
+		return (false);
+	}
+	for (int r = 0; r < a.rows; r++) {
+		if (std::memcmp(a.ptr(r), b.ptr(r), a.cols * a.elemSize()) !=
+		    0) {
+			return (false);
+		}
+	}
+	return (true);
+}
+
+bool
+NFIQ2::Benchmarks::identical(
+    const std::unordered_map<std::string, double> &a,
+    const std::unordered_map<std::string, double> &b)
+{
+	return ((a.size() == b.size()) && identicalSubset(a, b));
+}
+
+bool
+NFIQ2::Benchmarks::identical(
+    const std::vector<std::unordered_map<std::string, double>> &a,
+    const std::vector<std::unordered_map<std::string, double>> &b)
+{
+	if (a.size() != b.size()) {
+		return (false);
+	}
+	for (size_t i { 0 }; i < a.size(); ++i) {
+		if (!identical(a[i], b[i])) {
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+bool
+NFIQ2::Benchmarks::identicalSubset(
+    const std::unordered_map<std::string, double> &subset,
+    const std::unordered_map<std::string, double> &values)
+{
+	for (const auto &value : subset) {
+		const auto other = values.find(value.first);
+		if ((other == values.cend()) ||
+		    !identical(value.second, other->second)) {
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+int
+NFIQ2::Benchmarks::report(const std::string &what, const bool same)
+{
+	std::cout << what << " identical: " << (same ? "yes" : "no") << "\n";
+	return (same ? EXIT_SUCCESS : EXIT_FAILURE);
+}
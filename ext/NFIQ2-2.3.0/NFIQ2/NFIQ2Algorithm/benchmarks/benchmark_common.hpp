@@ -0,0 +1,125 @@
+#ifndef NFIQ2_BENCHMARK_COMMON_HPP_
+#define NFIQ2_BENCHMARK_COMMON_HPP_
+
+#include <nfiq2_fingerprintimagedata.hpp>
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Code shared by the benchmarks, which also run as regression tests: each
+ * compares an optimized implementation against the one it replaced and
+ * exits with EXIT_SUCCESS only when the results are identical.
+ */
+namespace NFIQ2 { namespace Benchmarks {
+
+/** Exit code of a benchmark lacking its input (CTest SKIP_RETURN_CODE) */
+static const int SkipReturnCode { 77 };
+
+/** Command line options shared by the benchmarks */
+struct Options {
+	/** `-i iterations`: repetitions of each timed operation */
+	unsigned int iterations {};
+	/** `-b blocks`: number of synthetic blocks or samples */
+	unsigned int blocks {};
+	/** `-m model`: path of random forest parameters (YAML) */
+	std::string model {};
+	/** `-h md5`: MD5 checksum of the random forest parameters */
+	std::string modelHash {};
+	/** Remaining arguments, read as 8-bit grayscale images */
+	std::vector<cv::Mat> images {};
+};
+
+/**
+ * @brief
+ * Parse `[-i iterations] [-b blocks] [-m model] [-h md5] [image]...`.
+ *
+ * @param options
+ * Defaults on input, parsed options on output. Images are stored
+ * contiguously.
+ * @param usage
+ * Arguments accepted by the benchmark, printed when parsing fails.
+ *
+ * @return
+ * Whether the arguments were valid, all images could be read, and counts
+ * are positive.
+ */
+bool parseOptions(int argc, char **argv, Options &options,
+    const std::string &usage);
+
+/** @brief Print the usage message of the benchmark to stderr. */
+void printUsage(const char *program, const std::string &usage);
+
+/** @return 500 PPI fingerprint image copying the pixels of `image` */
+NFIQ2::FingerprintImageData copyImage(const cv::Mat &image);
+
+/** @return 500 PPI fingerprint image viewing the pixels of `image` */
+NFIQ2::FingerprintImageData viewImage(const cv::Mat &image);
+
+/** Bitwise comparison, so NaN compares equal to itself */
+bool identical(const double a, const double b);
+
+/** Bitwise comparison of `size` bytes */
+bool identical(const void *a, const void *b, const std::size_t size);
+
+/** Same size and type, and bitwise identical pixels */
+bool identical(const cv::Mat &a, const cv::Mat &b);
+
+/** Same names, and bitwise identical values */
+bool identical(const std::unordered_map<std::string, double> &a,
+    const std::unordered_map<std::string, double> &b);
+
+/** identical() of every pair of maps */
+bool identical(const std::vector<std::unordered_map<std::string, double>> &a,
+    const std::vector<std::unordered_map<std::string, double>> &b);
+
+/**
+ * @return
+ * Whether every value of `subset` is in `values`, bitwise identical.
+ */
+bool identicalSubset(const std::unordered_map<std::string, double> &subset,
+    const std::unordered_map<std::string, double> &values);
+
+/**
+ * @brief
+ * Print `<what> identical: yes|no`.
+ *
+ * @return
+ * Exit code of the benchmark.
+ */
+int report(const std::string &what, const bool same);
+
+/** @return Mean duration of `iterations` calls of `f`, in milliseconds */
+template <typename F>
+double
+timeMilliseconds(const unsigned int iterations, F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i { 0 }; i < iterations; ++i) {
+		f();
+	}
+	return (std::chrono::duration<double, std::milli>(
+		    std::chrono::steady_clock::now() - start)
+		    .count() /
+	    iterations);
+}
+
+/** @return Duration of a call of `f`, in microseconds */
+template <typename F>
+double
+timeMicroseconds(F &&f)
+{
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return (std::chrono::duration<double, std::micro>(
+	    std::chrono::steady_clock::now() - start)
+		    .count());
+}
+
+}}
+
+#endif /* NFIQ2_BENCHMARK_COMMON_HPP_ */
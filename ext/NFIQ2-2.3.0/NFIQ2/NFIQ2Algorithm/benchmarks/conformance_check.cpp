@@ -0,0 +1,177 @@
+/*
+ * Checks native quality measures against the expected output of the NFIQ 2
+ * conformance test (conformance/conformance_expected_output-*.csv), for
+ * the columns whose names start with one of the given prefixes. Values are
+ * compared as the nfiq2 tool prints them. Rows without values (images
+ * NFIQ 2 could not score) are ignored. The conformance images are licensed
+ * separately, so this skips when none of them is in the image directory.
+ *
+ * Usage: nfiq2-conformance-check <expected.csv> <image directory>
+ *     <column prefix>...
+ */
+
+#include <nfiq2.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "benchmark_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/** Fields of a line of CSV, without the quotes around them */
+std::vector<std::string>
+splitFields(const std::string &line)
+{
+	std::vector<std::string> fields(1);
+	bool quoted { false };
+	for (const char c : line) {
+		if (c == '"') {
+			quoted = !quoted;
+		} else if ((c == ',') && !quoted) {
+			fields.emplace_back();
+		} else if (c != '\r') {
+			fields.back() += c;
+		}
+	}
+	return (fields);
+}
+
+/** `value` as the nfiq2 tool prints it (NFIQ2UI::formatDouble(value, 5)) */
+std::string
+formatValue(const double value)
+{
+	switch (std::fpclassify(value)) {
+	case FP_NORMAL:
+		break;
+	case FP_ZERO:
+		return ("0");
+	default:
+		return (std::to_string(value));
+	}
+
+	const std::string s = std::to_string(value);
+	if (!std::isfinite(value)) {
+		return (s);
+	}
+	if (static_cast<long>(value) == value) {
+		return (std::to_string(static_cast<long>(value)));
+	}
+
+	const std::string::size_type decimalPosition = s.find('.');
+	if ((decimalPosition == std::string::npos) ||
+	    (5 >= (s.length() - decimalPosition - 1))) {
+		return (s);
+	}
+	return (s.substr(0, decimalPosition + 5 + 1));
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 4) {
+		NFIQ2::Benchmarks::printUsage(argv[0],
+		    "<expected.csv> <image directory> <column prefix>...");
+		return (EXIT_FAILURE);
+	}
+
+	std::ifstream csv(argv[1]);
+	std::string line {};
+	if (!csv || !std::getline(csv, line)) {
+		std::cerr << "Cannot read " << argv[1] << "\n";
+		return (EXIT_FAILURE);
+	}
+	const std::vector<std::string> header = splitFields(line);
+	std::vector<size_t> columns {};
+	for (size_t i { 0 }; i < header.size(); ++i) {
+		for (int arg { 3 }; arg < argc; ++arg) {
+			if (header[i].rfind(argv[arg], 0) == 0) {
+				columns.push_back(i);
+				break;
+			}
+		}
+	}
+	if (columns.empty()) {
+		std::cerr << "No column of " << argv[1]
+			  << " starts with the given prefixes\n";
+		return (EXIT_FAILURE);
+	}
+
+	const std::string directory { argv[2] };
+	unsigned int images { 0 }, missing { 0 }, differing { 0 };
+	while (std::getline(csv, line)) {
+		const std::vector<std::string> fields = splitFields(line);
+		if (fields.size() != header.size()) {
+			std::cerr << "Malformed line in " << argv[1] << ": "
+				  << line << "\n";
+			return (EXIT_FAILURE);
+		}
+		if (std::all_of(columns.cbegin(), columns.cend(),
+			[&](const size_t column) {
+				return (fields[column] == "NA");
+			})) {
+			continue;
+		}
+
+		const std::string path { directory + "/" + fields[0] };
+		if (!std::ifstream(path)) {
+			++missing;
+			continue;
+		}
+		const cv::Mat image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+		if (image.empty()) {
+			std::cerr << "Cannot read " << path << "\n";
+			return (EXIT_FAILURE);
+		}
+		++images;
+
+		std::unordered_map<std::string, double> measures {};
+		try {
+			measures = NFIQ2::QualityMeasures::
+			    getNativeQualityMeasures(NFIQ2::QualityMeasures::
+				    computeNativeQualityMeasureAlgorithms(
+					NFIQ2::Benchmarks::viewImage(image)));
+		} catch (const NFIQ2::Exception &e) {
+			std::cerr << fields[0] << ": " << e.what() << "\n";
+			++differing;
+			continue;
+		}
+
+		bool same { true };
+		for (const size_t column : columns) {
+			const auto it = measures.find(header[column]);
+			const std::string value { (it == measures.cend()) ?
+				    "NA" :
+				    formatValue(it->second) };
+			if (value != fields[column]) {
+				same = false;
+				std::cerr << fields[0] << ": " << header[column]
+					  << " is " << value << ", expected "
+					  << fields[column] << "\n";
+			}
+		}
+		differing += same ? 0 : 1;
+	}
+
+	if (images == 0) {
+		std::cerr << "No conformance image in " << directory << "\n";
+		return (NFIQ2::Benchmarks::SkipReturnCode);
+	}
+	std::cout << "images: " << images << ", columns: " << columns.size()
+		  << ", differing images: " << differing << "\n";
+	if (missing != 0) {
+		std::cerr << missing << " conformance images missing from "
+			  << directory << "\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("conformance values",
+	    (missing == 0) && (differing == 0)));
+}
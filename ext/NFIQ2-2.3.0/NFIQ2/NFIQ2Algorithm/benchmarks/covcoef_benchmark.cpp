@@ -0,0 +1,109 @@
+/*
+ * Times covcoef() with centered differences against the implementation it
+ * replaced (a 64-bit floating-point copy of the block, diffGrad() of the
+ * copy and of its transpose, then per-element products averaged with
+ * cv::mean()) on random blocks of several sizes, cut from a larger image
+ * as BlockGeometry does. Reports the instruction set the dispatched kernels
+ * use on this CPU. Results must be identical.
+ *
+ * Usage: nfiq2-covcoef-benchmark [-i iterations]
+ */
+
+#include <quality_modules/CPUDispatch.h>
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/** Covariance coefficients as covcoef() computed them */
+void
+referenceCovcoef(const cv::Mat &imblock, double &a, double &b, double &c)
+{
+	cv::Mat dfx, dfy, dfxT;
+	cv::Mat doubleIm;
+	imblock.convertTo(doubleIm, CV_64F);
+	NFIQ2::QualityMeasures::diffGrad(doubleIm, dfy);
+	NFIQ2::QualityMeasures::diffGrad(doubleIm.t(), dfxT);
+	dfx = dfxT.t();
+
+	a = cv::mean(dfx.mul(dfx)).val[0];
+	b = cv::mean(dfy.mul(dfy)).val[0];
+	c = cv::mean(dfx.mul(dfy)).val[0];
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 20;
+	const std::string usage { "[-i iterations]" };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (!options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	cv::Mat image(1024, 1024, CV_8UC1);
+	cv::RNG rng { 0x4e464951 };
+	rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+
+	std::cout << "dispatched kernels: "
+		  << NFIQ2::QualityMeasures::getCPUDispatchTarget() << "\n";
+	bool same { true };
+	for (const int size : { 2, 3, 16, 32, 64, 255 }) {
+		std::vector<cv::Mat> blocks {};
+		for (int r = 1; r + size <= image.rows; r += size + 3) {
+			for (int c = 1; c + size <= image.cols; c += size + 5) {
+				blocks.push_back(image(cv::Rect(c, r, size,
+				    size)));
+			}
+		}
+
+		double referenceTime { 0 }, integerTime { 0 };
+		for (const cv::Mat &block : blocks) {
+			double ra, rb, rc, a, b, c;
+			referenceTime += NFIQ2::Benchmarks::timeMicroseconds(
+			    [&]() {
+				    for (unsigned int i { 0 }; i < iterations;
+					 ++i) {
+					    referenceCovcoef(block, ra, rb, rc);
+				    }
+			    });
+
+			integerTime += NFIQ2::Benchmarks::timeMicroseconds(
+			    [&]() {
+				    for (unsigned int i { 0 }; i < iterations;
+					 ++i) {
+					    NFIQ2::QualityMeasures::covcoef(
+						block, a, b, c,
+						NFIQ2::QualityMeasures::
+						    CENTERED_DIFFERENCES);
+				    }
+			    });
+
+			if (!NFIQ2::Benchmarks::identical(a, ra) ||
+			    !NFIQ2::Benchmarks::identical(b, rb) ||
+			    !NFIQ2::Benchmarks::identical(c, rc)) {
+				same = false;
+			}
+		}
+
+		const double runs = static_cast<double>(iterations) *
+		    blocks.size();
+		std::cout << size << "x" << size << " blocks: floating-point "
+			  << referenceTime / runs << " us, integer "
+			  << integerTime / runs << " us\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("results", same));
+}
@@ -0,0 +1,267 @@
+/*
+ * Times the amplitude spectrum of FDA slanted block profiles computed per
+ * block with cv::dft() (transpose, pad, merge, dft, split, magnitude)
+ * against AmplitudeSpectrumBatch, on random profiles and on the profiles of
+ * the foreground blocks of 500 PPI grayscale images. Spectra must be
+ * identical. For every image, the FDA quality measures must also be
+ * identical to a histogram of IQMs computed per block with cv::dft().
+ *
+ * Usage: nfiq2-fda-spectrum-benchmark [-b blocks] [image]...
+ */
+
+#include <nfiq2_constants.hpp>
+#include <quality_modules/AmplitudeSpectrum.h>
+#include <quality_modules/BlockGeometry.h>
+#include <quality_modules/FDA.h>
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using SpectrumBatch = NFIQ2::QualityMeasures::AmplitudeSpectrumBatch<32, 16>;
+using Profile = NFIQ2::QualityMeasures::ScratchVector<double>;
+
+/** Amplitude spectrum of `profile` as fda() computed it before batching */
+cv::Mat
+referenceSpectrum(const Profile &profile)
+{
+	const cv::Mat t(static_cast<int>(profile.size()), 1, CV_64F,
+	    const_cast<double *>(profile.data()));
+	cv::Mat tmpM;
+	const int m = cv::getOptimalDFTSize(t.cols);
+	const int n = cv::getOptimalDFTSize(t.rows);
+	cv::copyMakeBorder(t.t(), tmpM, 0, m - t.cols, 0, n - t.rows,
+	    cv::BORDER_CONSTANT, cv::Scalar::all(0));
+	cv::Mat planes[] = { tmpM, cv::Mat::zeros(tmpM.size(), CV_64F) };
+	cv::Mat complex;
+	cv::merge(planes, 2, complex);
+	cv::dft(complex, complex, cv::DFT_COMPLEX_OUTPUT | cv::DFT_ROWS);
+	cv::split(complex, planes);
+	cv::magnitude(planes[0], planes[1], planes[0]);
+	return (abs(planes[0]));
+}
+
+/** IQM of a block from its spectrum, as fda() computed it */
+double
+referenceIQM(const cv::Mat &absMag)
+{
+	cv::Mat amp(absMag, cv::Rect(1, 0, absMag.cols - 1, 1));
+	double mVal;
+	cv::Point mLoc;
+	cv::minMaxLoc(amp, 0, &mVal, 0, &mLoc);
+	cv::Mat ampDenom(amp,
+	    cv::Rect(0, 0, (int)floor((double)(amp.cols / 2)), 1));
+	cv::Scalar iqmDenom = sum(ampDenom);
+	if (mLoc.x == 0 || mLoc.x + 1 >= amp.cols) {
+		return 1.0;
+	}
+	return (mVal +
+		   0.3 *
+		       (amp.at<double>(0, mLoc.x - 1) +
+			   amp.at<double>(0, mLoc.x + 1))) /
+	    iqmDenom.val[0];
+}
+
+/** Row means of the slanted blocks of foreground blocks, as FDA does */
+std::vector<Profile>
+slantedBlockProfiles(const cv::Mat &img)
+{
+	const int blksize { NFIQ2::Sizes::LocalRegionSquare };
+	const int v1sz_x { NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth };
+	const int v1sz_y { NFIQ2::Sizes::VerticallyAlignedLocalRegionHeight };
+	const NFIQ2::QualityMeasures::BlockGeometry geometry(img, blksize, .1,
+	    v1sz_x, v1sz_y);
+	const int blkoffset = geometry.getBlockOffset();
+	const cv::Mat &maskBseg = geometry.getBlockMask();
+	const cv::Mat &blkorient = geometry.getBlockOrientation();
+
+	std::vector<Profile> profiles {};
+	int br = 0;
+	for (int r = blkoffset; r < img.rows - (blksize + blkoffset - 1);
+	     r += blksize, ++br) {
+		int bc = 0;
+		for (int c = blkoffset;
+		     c < img.cols - (blksize + blkoffset - 1);
+		     c += blksize, ++bc) {
+			if (maskBseg.at<uint8_t>(br, bc) != 1) {
+				continue;
+			}
+			const cv::Mat block = img(cv::Range(r - blkoffset,
+						      cv::min(r + blksize +
+							      blkoffset,
+							  img.rows)),
+			    cv::Range(c - blkoffset,
+				cv::min(c + blksize + blkoffset, img.cols)));
+			const int icBlock { block.rows / 2 };
+			const int xoff { v1sz_x / 2 }, yoff { v1sz_y / 2 };
+			profiles.emplace_back();
+			NFIQ2::QualityMeasures::getRotatedBlockProfile(block,
+			    blkorient.at<double>(br, bc) + (M_PI / 2), true,
+			    cv::Range(icBlock - xoff, icBlock + xoff),
+			    cv::Range(icBlock - yoff, icBlock + yoff),
+			    NFIQ2::QualityMeasures::ROW_MEANS,
+			    profiles.back(), cv::noArray());
+		}
+	}
+
+	return (profiles);
+}
+
+/** Time both spectra of `profiles` and count those that differ */
+unsigned int
+compareSpectra(const std::vector<Profile> &profiles, double &referenceTime,
+    double &batchedTime)
+{
+	std::vector<cv::Mat> reference(profiles.size());
+	referenceTime += NFIQ2::Benchmarks::timeMicroseconds([&]() {
+		for (size_t i { 0 }; i < profiles.size(); ++i) {
+			reference[i] = referenceSpectrum(profiles[i]);
+		}
+	});
+
+	std::vector<double> batched(profiles.size() * SpectrumBatch::Length);
+	SpectrumBatch batch;
+	size_t first { 0 };
+	const auto flush = [&]() {
+		batch.compute();
+		for (int lane { 0 }; lane < batch.size(); ++lane) {
+			for (int bin { 0 }; bin < SpectrumBatch::Length;
+			     ++bin) {
+				batched[((first + lane) *
+					    SpectrumBatch::Length) +
+				    bin] = batch.amplitude(lane, bin);
+			}
+		}
+		first += batch.size();
+		batch.clear();
+	};
+	batchedTime += NFIQ2::Benchmarks::timeMicroseconds([&]() {
+		for (const Profile &profile : profiles) {
+			batch.push(profile.data(),
+			    static_cast<int>(profile.size()));
+			if (batch.full()) {
+				flush();
+			}
+		}
+		if (batch.size() != 0) {
+			flush();
+		}
+	});
+
+	unsigned int mismatches { 0 };
+	for (size_t i { 0 }; i < profiles.size(); ++i) {
+		if ((reference[i].cols != SpectrumBatch::Length) ||
+		    !NFIQ2::Benchmarks::identical(reference[i].ptr<double>(),
+			&batched[i * SpectrumBatch::Length],
+			SpectrumBatch::Length * sizeof(double))) {
+			++mismatches;
+		}
+	}
+	return (mismatches);
+}
+
+/** FDA measures from IQMs computed per block with cv::dft() */
+NFIQ2::QualityMeasures::QualityMeasureValues
+referenceMeasures(const std::vector<Profile> &profiles)
+{
+	NFIQ2::QualityMeasures::ScratchVector<double> dataVector {};
+	for (const Profile &profile : profiles) {
+		dataVector.push_back(referenceIQM(referenceSpectrum(profile)));
+	}
+
+	std::vector<double> bins(NFIQ2::QualityMeasures::FDAHISTLIMITS,
+	    NFIQ2::QualityMeasures::FDAHISTLIMITS + 9);
+	NFIQ2::QualityMeasures::QualityMeasureValues measures {
+		NFIQ2::QualityMeasures::NativeQualityMeasure::
+		    FrequencyDomainAnalysisBin0,
+		12
+	};
+	NFIQ2::QualityMeasures::addHistogramFeatures(measures,
+	    NFIQ2::QualityMeasures::NativeQualityMeasure::
+		FrequencyDomainAnalysisBin0,
+	    bins, dataVector, 10);
+	return (measures);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.blocks = 20000;
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options,
+		"[-b blocks] [image]...")) {
+		return (EXIT_FAILURE);
+	}
+	const unsigned int blockCount { options.blocks };
+
+	/* Random profiles, some zero-padded to the transform length */
+	cv::RNG rng { 0x4e464951 };
+	std::vector<Profile> random(blockCount);
+	for (Profile &profile : random) {
+		int length {};
+		do {
+			length = rng.uniform(1, SpectrumBatch::Length + 1);
+		} while (cv::getOptimalDFTSize(length) !=
+		    SpectrumBatch::Length);
+		profile.resize(length);
+		for (double &mean : profile) {
+			mean = rng.uniform(0., 255.);
+		}
+	}
+	double referenceTime { 0 }, batchedTime { 0 };
+	const unsigned int randomMismatches = compareSpectra(random,
+	    referenceTime, batchedTime);
+	std::cout << "random profiles: " << blockCount << ", cv::dft "
+		  << referenceTime / blockCount << " us/block, batched "
+		  << batchedTime / blockCount << " us/block, mismatches "
+		  << randomMismatches << "\n";
+	bool identical { randomMismatches == 0 };
+
+	size_t imageBlocks { 0 };
+	unsigned int imageMismatches { 0 }, measureMismatches { 0 };
+	referenceTime = batchedTime = 0;
+	for (const cv::Mat &image : options.images) {
+		const std::vector<Profile> profiles = slantedBlockProfiles(
+		    image);
+		imageBlocks += profiles.size();
+		imageMismatches += compareSpectra(profiles, referenceTime,
+		    batchedTime);
+
+		const NFIQ2::FingerprintImageData data =
+		    NFIQ2::Benchmarks::viewImage(image);
+		const NFIQ2::QualityMeasures::FDA fda(data);
+		const auto &measures = fda.getFeatureValues();
+		const auto reference = referenceMeasures(profiles);
+		for (unsigned int i { 0 }; i < reference.getCount(); ++i) {
+			const auto measure = static_cast<
+			    NFIQ2::QualityMeasures::NativeQualityMeasure::Index>(
+			    reference.getFirst() + i);
+			if (!NFIQ2::Benchmarks::identical(reference.at(measure),
+				measures.at(measure))) {
+				++measureMismatches;
+			}
+		}
+	}
+	if (imageBlocks != 0) {
+		std::cout << "image blocks: " << imageBlocks << ", cv::dft "
+			  << referenceTime / imageBlocks
+			  << " us/block, batched "
+			  << batchedTime / imageBlocks
+			  << " us/block, mismatches " << imageMismatches
+			  << "\n"
+			  << "FDA measures differing: " << measureMismatches
+			  << "\n";
+	}
+	identical = identical && (imageMismatches == 0) &&
+	    (measureMismatches == 0);
+
+	return (NFIQ2::Benchmarks::report("spectra", identical));
+}
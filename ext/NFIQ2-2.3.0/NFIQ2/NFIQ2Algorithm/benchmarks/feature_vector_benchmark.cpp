@@ -0,0 +1,169 @@
+/*
+ * Counts the heap allocations made per image to gather the native quality
+ * measures of computed modules and predict a unified quality score from
+ * them, through the string-keyed map (getNativeQualityMeasures()) and
+ * through the fixed vector (getNativeQualityMeasureVector()), and times
+ * both. Also reports the allocations of computing the modules, for scale.
+ * Scores must be identical. Without `-m`, uses the embedded random forest
+ * parameters, and skips when there are none; skips too when the model file
+ * is missing.
+ *
+ * Usage: nfiq2-feature-vector-benchmark [-i iterations] [-m model.yaml
+ *     -h md5] <image>...
+ */
+
+#include <nfiq2.hpp>
+
+#include "benchmark_common.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<unsigned long> allocationCount { 0 };
+
+struct Run {
+	double microseconds {};
+	unsigned long allocations {};
+	std::vector<unsigned int> scores {};
+};
+
+template <typename F>
+Run
+scoreAll(const std::vector<std::vector<
+	     std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>> &modules,
+    const unsigned int iterations, F &&score)
+{
+	Run run {};
+	run.scores.reserve(modules.size());
+	const unsigned long allocations { allocationCount.load() };
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i { 0 }; i < iterations; ++i) {
+		for (const auto &imageModules : modules) {
+			const unsigned int s = score(imageModules);
+			if (i == 0) {
+				run.scores.push_back(s);
+			}
+		}
+	}
+	run.microseconds = std::chrono::duration<double, std::micro>(
+	    std::chrono::steady_clock::now() - start)
+			       .count();
+	run.allocations = allocationCount.load() - allocations;
+
+	return (run);
+}
+
+}
+
+void *
+operator new(std::size_t size)
+{
+	++allocationCount;
+	if (void *p = std::malloc(size != 0 ? size : 1)) {
+		return (p);
+	}
+	throw std::bad_alloc();
+}
+
+void
+operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 100;
+	const std::string usage {
+		"[-i iterations] [-m model.yaml -h md5] <image>..."
+	};
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.images.empty() ||
+	    (options.model.empty() != options.modelHash.empty())) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	std::unique_ptr<const NFIQ2::Algorithm> model {};
+	if (options.model.empty()) {
+		model.reset(new NFIQ2::Algorithm());
+		if (!model->isInitialized()) {
+			std::cerr << "No embedded random forest parameters, "
+				     "pass -m and -h\n";
+			return (NFIQ2::Benchmarks::SkipReturnCode);
+		}
+	} else {
+		if (!std::ifstream(options.model)) {
+			std::cerr << "Cannot read " << options.model << "\n";
+			return (NFIQ2::Benchmarks::SkipReturnCode);
+		}
+		model.reset(
+		    new NFIQ2::Algorithm(options.model, options.modelHash));
+	}
+
+	std::vector<std::vector<
+	    std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>>
+	    modules {};
+	unsigned long moduleAllocations {};
+	for (const cv::Mat &image : options.images) {
+		const NFIQ2::FingerprintImageData data =
+		    NFIQ2::Benchmarks::viewImage(image);
+
+		const unsigned long allocations { allocationCount.load() };
+		modules.push_back(NFIQ2::QualityMeasures::
+			computeNativeQualityMeasureAlgorithms(data));
+		moduleAllocations += allocationCount.load() - allocations;
+	}
+
+	const Run map = scoreAll(modules, iterations,
+	    [&](const std::vector<
+		std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>> &m) {
+		    return (model->computeUnifiedQualityScore(
+			NFIQ2::QualityMeasures::getNativeQualityMeasures(m)));
+	    });
+	const Run vector = scoreAll(modules, iterations,
+	    [&](const std::vector<
+		std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>> &m) {
+		    return (model->computeUnifiedQualityScore(
+			NFIQ2::QualityMeasures::getNativeQualityMeasureVector(
+			    m)));
+	    });
+	const double scored = static_cast<double>(modules.size()) *
+	    iterations;
+
+	std::cout << "images: " << modules.size()
+		  << ", iterations: " << iterations
+		  << ", native quality measures: "
+		  << NFIQ2::QualityMeasures::NativeQualityMeasureCount << "\n"
+		  << "computing modules: "
+		  << static_cast<double>(moduleAllocations) / modules.size()
+		  << " allocations/image\n";
+	for (const Run *run : { &map, &vector }) {
+		std::cout << (run == &map ? "map:    " : "vector: ")
+			  << run->microseconds / scored << " us/image, "
+			  << run->allocations / scored
+			  << " allocations/image\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("scores",
+	    map.scores == vector.scores));
+}
@@ -0,0 +1,133 @@
+/*
+ * Times the block map neighbourhood operations of OF as they were (a 3x3
+ * ROI, absdiff() and sum() or allfun() per block) against orientangdiff()
+ * and allfunNeighbourhood(), on random orientation maps and block masks of
+ * several sizes, including maps one block wide or high. Results must be
+ * identical.
+ *
+ * Usage: nfiq2-orientation-flow-benchmark [-i iterations]
+ */
+
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+/** Orientation differences as OF computed them */
+void
+referenceOrientangdiff(const cv::Mat &blkorient, cv::Mat &loqall)
+{
+	cv::Mat paddedBlkorient;
+	cv::copyMakeBorder(blkorient, paddedBlkorient, 1, 1, 1, 1,
+	    cv::BORDER_CONSTANT, 0);
+	loqall.create(blkorient.rows, blkorient.cols, CV_64F);
+	const double bsize = 9;
+	constexpr double ThreeSixtyRad = (M_PI / 180.0) * 360.0;
+	for (int i = 1; i <= blkorient.rows; i++) {
+		for (int j = 1; j <= blkorient.cols; j++) {
+			cv::Mat blkROI = paddedBlkorient(
+			    cv::Range(i - 1, i + 2), cv::Range(j - 1, j + 2));
+			cv::Mat blockAbsDiff;
+			cv::Scalar centerVal = blkROI.at<double>(1, 1);
+			absdiff(centerVal, blkROI, blockAbsDiff);
+			blockAbsDiff.forEach<double>(
+			    [&](double &angleDiff, const int *) {
+				    angleDiff = std::min(angleDiff,
+					ThreeSixtyRad - angleDiff);
+			    });
+			cv::Scalar loq = sum(blockAbsDiff) / (bsize - 1);
+			loqall.at<double>(i - 1, j - 1) = loq.val[0];
+		}
+	}
+}
+
+/** Neighbourhood mask as OF computed it */
+void
+referenceAllfun(const cv::Mat &maskBseg, cv::Mat &maskBloqseg)
+{
+	cv::Mat paddedMaskBseg;
+	cv::copyMakeBorder(maskBseg, paddedMaskBseg, 1, 1, 1, 1,
+	    cv::BORDER_CONSTANT, 0);
+	maskBloqseg.create(maskBseg.rows, maskBseg.cols, CV_8UC1);
+	for (int i = 1; i <= maskBseg.rows; i++) {
+		for (int j = 1; j <= maskBseg.cols; j++) {
+			cv::Mat blkROI = paddedMaskBseg(
+			    cv::Range(i - 1, i + 2), cv::Range(j - 1, j + 2));
+			maskBloqseg.at<uint8_t>(i - 1, j - 1) =
+			    NFIQ2::QualityMeasures::allfun(blkROI);
+		}
+	}
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 20;
+	const std::string usage { "[-i iterations]" };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (!options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	/* Block maps of 500 PPI images of up to 800x1000 pixels, and thin */
+	const cv::Size sizes[] { { 1, 1 }, { 1, 7 }, { 9, 1 }, { 2, 3 },
+		{ 24, 30 }, { 32, 32 }, { 50, 62 } };
+	cv::RNG rng { 0x4e464951 };
+	bool same { true };
+	double referenceTime { 0 }, stencilTime { 0 };
+	for (const cv::Size &size : sizes) {
+		cv::Mat blkorient(size, CV_64F), maskBseg(size, CV_8UC1);
+		rng.fill(blkorient, cv::RNG::UNIFORM, -M_PI / 2, M_PI / 2);
+		rng.fill(maskBseg, cv::RNG::UNIFORM, 0, 2);
+		/* mostly foreground, as in fingerprints */
+		maskBseg |= (blkorient > -1.2);
+		maskBseg &= 1;
+
+		cv::Mat loqall, maskBloqseg, referenceLoqall,
+		    referenceMaskBloqseg;
+		referenceTime += NFIQ2::Benchmarks::timeMicroseconds([&]() {
+			for (unsigned int i { 0 }; i < iterations; ++i) {
+				referenceOrientangdiff(blkorient,
+				    referenceLoqall);
+				referenceAllfun(maskBseg, referenceMaskBloqseg);
+			}
+		});
+
+		stencilTime += NFIQ2::Benchmarks::timeMicroseconds([&]() {
+			for (unsigned int i { 0 }; i < iterations; ++i) {
+				NFIQ2::QualityMeasures::orientangdiff(blkorient,
+				    loqall);
+				NFIQ2::QualityMeasures::allfunNeighbourhood(
+				    maskBseg, maskBloqseg);
+			}
+		});
+
+		if (!NFIQ2::Benchmarks::identical(loqall, referenceLoqall) ||
+		    !NFIQ2::Benchmarks::identical(maskBloqseg,
+			referenceMaskBloqseg)) {
+			same = false;
+			std::cerr << "Maps differ: " << size.width << "x"
+				  << size.height << " blocks\n";
+		}
+	}
+
+	const double runs = static_cast<double>(iterations) *
+	    (sizeof(sizes) / sizeof(sizes[0]));
+	std::cout << "per-block ROIs: " << referenceTime / runs
+		  << " us/map\n"
+		  << "stencil:        " << stencilTime / runs << " us/map\n";
+	return (NFIQ2::Benchmarks::report("maps", same));
+}
@@ -0,0 +1,149 @@
+/*
+ * Times partial requests with LazyQualityMeasures against computing every
+ * native quality measure algorithm, on a set of 500 PPI grayscale images:
+ * actionable quality feedback only, and a small set of native quality
+ * measures. Requested values must be identical to those of the full
+ * computation.
+ *
+ * Usage: nfiq2-partial-request-benchmark [-i iterations] <image>...
+ */
+
+#include <nfiq2.hpp>
+#include <opencv2/core.hpp>
+
+#include "benchmark_common.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Request = std::function<std::unordered_map<std::string, double>(
+    const NFIQ2::FingerprintImageData &)>;
+
+struct Run {
+	double milliseconds {};
+	std::vector<std::unordered_map<std::string, double>> values {};
+};
+
+Run
+computeAll(const std::vector<NFIQ2::FingerprintImageData> &images,
+    const unsigned int iterations, const Request &request)
+{
+	Run run {};
+	/* The first pass warms up and is not timed */
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int i { 0 }; i <= iterations; ++i) {
+		if (i == 1) {
+			start = std::chrono::steady_clock::now();
+		}
+		for (const auto &image : images) {
+			auto values = request(image);
+			if (i == 0) {
+				run.values.push_back(std::move(values));
+			}
+		}
+	}
+	run.milliseconds = std::chrono::duration<double, std::milli>(
+	    std::chrono::steady_clock::now() - start)
+			       .count();
+
+	return (run);
+}
+
+/** Bitwise comparison of the values of `partial` */
+bool
+identical(const Run &full, const Run &partial)
+{
+	for (size_t i { 0 }; i < full.values.size(); ++i) {
+		if (!NFIQ2::Benchmarks::identicalSubset(partial.values[i],
+			full.values[i])) {
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 10;
+	const std::string usage { "[-i iterations] <image>..." };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	std::vector<NFIQ2::FingerprintImageData> images {};
+	for (const cv::Mat &image : options.images) {
+		images.push_back(NFIQ2::Benchmarks::viewImage(image));
+	}
+
+	const Run full = computeAll(images, iterations,
+	    [](const NFIQ2::FingerprintImageData &image) {
+		    const auto algorithms = NFIQ2::QualityMeasures::
+			computeNativeQualityMeasureAlgorithms(image);
+		    auto values = NFIQ2::QualityMeasures::
+			getNativeQualityMeasures(algorithms);
+		    for (const auto &feedback : NFIQ2::QualityMeasures::
+			     getActionableQualityFeedback(algorithms)) {
+			    values.insert(feedback);
+		    }
+		    return (values);
+	    });
+
+	const std::vector<std::pair<std::string, Request>> requests {
+		{ "feedback",
+		    [](const NFIQ2::FingerprintImageData &image) {
+			    NFIQ2::QualityMeasures::LazyQualityMeasures lazy {
+				    image
+			    };
+			    return (lazy.computeActionableQualityFeedback(1));
+		    } },
+		{ "FJFXPos_Mu_MinutiaeQuality_2, OCL_Bin10_Mean",
+		    [](const NFIQ2::FingerprintImageData &image) {
+			    NFIQ2::QualityMeasures::LazyQualityMeasures lazy {
+				    image
+			    };
+			    return (lazy.computeNativeQualityMeasures(
+				{ "FJFXPos_Mu_MinutiaeQuality_2",
+				    "OCL_Bin10_Mean" },
+				1));
+		    } },
+		{ "OCL_Bin10_Mean, RVUP_Bin10_Mean",
+		    [](const NFIQ2::FingerprintImageData &image) {
+			    NFIQ2::QualityMeasures::LazyQualityMeasures lazy {
+				    image
+			    };
+			    return (lazy.computeNativeQualityMeasures(
+				{ "OCL_Bin10_Mean", "RVUP_Bin10_Mean" }, 1));
+		    } }
+	};
+
+	const double computed = static_cast<double>(images.size()) *
+	    iterations;
+	std::cout << images.size() << " images\n"
+		  << "  full: " << full.milliseconds / computed
+		  << " ms/image\n";
+	bool same { true };
+	for (const auto &request : requests) {
+		const Run partial = computeAll(images, iterations,
+		    request.second);
+		std::cout << "  " << request.first << ": "
+			  << partial.milliseconds / computed << " ms/image\n";
+		same = same && identical(full, partial);
+	}
+	return (NFIQ2::Benchmarks::report("requested values", same));
+}
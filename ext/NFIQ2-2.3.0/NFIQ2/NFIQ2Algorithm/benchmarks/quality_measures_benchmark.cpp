@@ -0,0 +1,97 @@
+/*
+ * Times the computation of native quality measures for a set of 500 PPI
+ * grayscale images, with and without the per-thread scratch arena, and
+ * reports how many scratch allocations reached the system allocator in
+ * each mode. Native quality measures must be identical in both modes.
+ *
+ * Usage: nfiq2-measures-benchmark [-i iterations] <image>...
+ */
+
+#include <nfiq2.hpp>
+
+#include "benchmark_common.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Run {
+	double milliseconds {};
+	NFIQ2::QualityMeasures::ScratchMemoryStatistics statistics {};
+	std::vector<std::unordered_map<std::string, double>> measures {};
+};
+
+Run
+computeAll(const std::vector<NFIQ2::FingerprintImageData> &images,
+    const unsigned int iterations, const bool arena)
+{
+	NFIQ2::QualityMeasures::setScratchArenaEnabled(arena);
+
+	Run run {};
+	/* Warm up, so block allocation is not charged to the first image */
+	NFIQ2::QualityMeasures::computeNativeQualityMeasures(images.front());
+	NFIQ2::QualityMeasures::resetScratchMemoryStatistics();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i { 0 }; i < iterations; ++i) {
+		for (const auto &image : images) {
+			auto measures = NFIQ2::QualityMeasures::
+			    computeNativeQualityMeasures(image);
+			if (i == 0) {
+				run.measures.push_back(std::move(measures));
+			}
+		}
+	}
+	run.milliseconds = std::chrono::duration<double, std::milli>(
+	    std::chrono::steady_clock::now() - start)
+			       .count();
+	run.statistics =
+	    NFIQ2::QualityMeasures::getScratchMemoryStatistics();
+
+	return (run);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 5;
+	const std::string usage { "[-i iterations] <image>..." };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+	std::vector<NFIQ2::FingerprintImageData> images {};
+	for (const cv::Mat &image : options.images) {
+		images.push_back(NFIQ2::Benchmarks::copyImage(image));
+	}
+
+	const Run heap = computeAll(images, iterations, false);
+	const Run arena = computeAll(images, iterations, true);
+	const double scored = static_cast<double>(images.size()) * iterations;
+
+	std::cout << "images: " << images.size()
+		  << ", iterations: " << iterations << "\n";
+	for (const Run *run : { &heap, &arena }) {
+		std::cout << (run == &heap ? "system allocator: " :
+					     "scratch arena:    ")
+			  << run->milliseconds / scored << " ms/image, "
+			  << run->statistics.allocations / scored
+			  << " allocations/image, "
+			  << run->statistics.systemAllocations / scored
+			  << " system allocations/image\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("native quality measures",
+	    NFIQ2::Benchmarks::identical(heap.measures, arena.measures)));
+}
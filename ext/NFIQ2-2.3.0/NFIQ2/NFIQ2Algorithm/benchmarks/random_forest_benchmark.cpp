@@ -0,0 +1,125 @@
+/*
+ * Compares RTrees::predict(RAW_OUTPUT) against FlatForest on synthetic
+ * samples drawn around the split thresholds of a trained model, and checks
+ * that both produce identical raw predictions. The FlatForest is loaded
+ * from its binary form, whose load time is compared against parsing the
+ * YAML model. Skips when the model file is missing.
+ *
+ * Usage: nfiq2-forest-benchmark [-b samples] -m model.yaml
+ */
+
+#include <prediction/FlatForest.h>
+
+#include "benchmark_common.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using NFIQ2::Benchmarks::timeMicroseconds;
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.blocks = 10000;
+	const std::string usage { "[-b samples] -m model.yaml" };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.model.empty() || !options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	if (!std::ifstream(options.model)) {
+		std::cerr << "Cannot read " << options.model << "\n";
+		return (NFIQ2::Benchmarks::SkipReturnCode);
+	}
+	const size_t count { options.blocks };
+
+	cv::FileStorage fs {};
+	cv::Ptr<cv::ml::RTrees> rtrees = cv::ml::RTrees::create();
+	const double yamlLoadTime = timeMicroseconds([&] {
+		fs.open(options.model, cv::FileStorage::READ);
+		rtrees->read(fs["my_random_trees"]);
+	});
+	const std::vector<uint8_t> binary =
+	    NFIQ2::Prediction::FlatForest(*rtrees, fs["my_random_trees"])
+		.serialize();
+	std::unique_ptr<NFIQ2::Prediction::FlatForest> loaded {};
+	const double binaryLoadTime = timeMicroseconds([&] {
+		loaded.reset(new NFIQ2::Prediction::FlatForest(binary.data(),
+		    binary.size()));
+	});
+	const NFIQ2::Prediction::FlatForest &flat = *loaded;
+	const size_t featureCount = flat.getFeatureCount();
+
+	// Draw each feature near one of the thresholds it is split on
+	std::vector<std::vector<float>> thresholds(featureCount);
+	for (const auto &split : rtrees->getSplits()) {
+		thresholds[split.varIdx].push_back(split.c);
+	}
+	std::mt19937 rng(29794);
+	std::normal_distribution<float> jitter(0.f, 0.05f);
+	cv::Mat samples(static_cast<int>(count),
+	    static_cast<int>(featureCount), CV_32FC1);
+	for (size_t i { 0 }; i < count; ++i) {
+		float *row = samples.ptr<float>(static_cast<int>(i));
+		for (size_t j { 0 }; j < featureCount; ++j) {
+			const auto &t = thresholds[j];
+			const float base = t.empty() ? 0.f : t[rng() % t.size()];
+			row[j] = base * (1.f + jitter(rng));
+		}
+	}
+
+	std::vector<float> expected(count), single(count), batch(count);
+	const double opencvTime = timeMicroseconds([&] {
+		for (size_t i { 0 }; i < count; ++i) {
+			expected[i] = rtrees->predict(
+			    samples.row(static_cast<int>(i)), cv::noArray(),
+			    cv::ml::StatModel::RAW_OUTPUT);
+		}
+	});
+	const double singleTime = timeMicroseconds([&] {
+		for (size_t i { 0 }; i < count; ++i) {
+			single[i] = flat.predict(
+			    samples.ptr<float>(static_cast<int>(i)));
+		}
+	});
+	const double batchTime = timeMicroseconds([&] {
+		flat.predict(samples.ptr<float>(), count, featureCount,
+		    batch.data());
+	});
+
+	size_t mismatches { 0 };
+	for (size_t i { 0 }; i < count; ++i) {
+		if (!NFIQ2::Benchmarks::identical(&expected[i], &single[i],
+			sizeof(float)) ||
+		    !NFIQ2::Benchmarks::identical(&expected[i], &batch[i],
+			sizeof(float))) {
+			++mismatches;
+		}
+	}
+
+	std::cout << "trees: " << flat.getTreeCount()
+		  << ", samples: " << count << "\n"
+		  << "YAML model load:      " << yamlLoadTime / 1000 << " ms\n"
+		  << "binary model load:    " << binaryLoadTime / 1000
+		  << " ms (" << binary.size() << " bytes)\n"
+		  << "RTrees::predict:      " << opencvTime / count
+		  << " us/sample\n"
+		  << "FlatForest (single):  " << singleTime / count
+		  << " us/sample\n"
+		  << "FlatForest (batch):   " << batchTime / count
+		  << " us/sample\n"
+		  << "mismatches: " << mismatches << "\n";
+
+	return (NFIQ2::Benchmarks::report("predictions", mismatches == 0));
+}
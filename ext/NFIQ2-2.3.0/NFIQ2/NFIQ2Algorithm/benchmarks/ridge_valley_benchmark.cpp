@@ -0,0 +1,203 @@
+/*
+ * Times the ridge/valley segmentation of slanted blocks as LCS and RVUP
+ * did it (cv::solve(cv::DECOMP_QR) per block, then vectors of changes and
+ * widths) against getRidgeValleyStructure(). Uses the column means of
+ * blocks of a random image with random orientations, as LCS and RVUP
+ * project them, and random column means. Trends, ridges, LCS widths and
+ * RVUP changes must be identical.
+ *
+ * Usage: nfiq2-ridge-valley-benchmark [-b blocks]
+ */
+
+#include <nfiq2_constants.hpp>
+#include <opencv2/imgproc.hpp>
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int Width { NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth };
+
+struct Reference {
+	std::vector<double> dt;
+	std::vector<uint8_t> ridval;
+	/** Wrv of LCS */
+	std::vector<uint8_t> widths;
+	/** changeIndex of RVUP */
+	std::vector<uint8_t> changeIndex;
+};
+
+/** getRidgeValleyStructure() and the change loops as they were */
+void
+referenceStructure(const NFIQ2::QualityMeasures::ScratchVector<double> &v,
+    Reference &out)
+{
+	const cv::Mat v3(static_cast<int>(v.size()), 1, CV_64F,
+	    const_cast<double *>(v.data()));
+	cv::Mat dttemp(v3.rows, 2, CV_64F);
+	for (int i = 0; i < v3.rows; i++) {
+		dttemp.at<double>(i, 0) = 1;
+		dttemp.at<double>(i, 1) = i + 1;
+	}
+	cv::Mat dt1;
+	cv::solve(dttemp, v3, dt1, cv::DECOMP_QR);
+	dt1.forEach<double>([&](double &val, const int *) {
+		val = round(val * 10000000000) / 10000000000;
+	});
+
+	out.dt.clear();
+	out.ridval.clear();
+	for (int i = 0; i < v3.rows; i++) {
+		out.dt.push_back(static_cast<double>(i + 1) *
+			dt1.at<double>(1, 0) +
+		    dt1.at<double>(0, 0));
+		out.ridval.push_back(v3.at<double>(i, 0) < out.dt[i] ? 1 : 0);
+	}
+
+	/* LCS */
+	const std::vector<uint8_t> &ridval = out.ridval;
+	std::vector<uint8_t> change, changeIndex;
+	for (size_t i = 0; i < ridval.size(); i++) {
+		const size_t j = (i == 0) ? ridval.size() - 1 : i - 1;
+		change.push_back(ridval[i] != ridval[j] ? 1 : 0);
+	}
+	for (size_t i = 1; i < change.size(); i++) {
+		if (change[i] == 1) {
+			changeIndex.push_back(i - 1);
+		}
+	}
+	out.widths.clear();
+	if (!changeIndex.empty()) {
+		out.widths.push_back(changeIndex[0]);
+		for (size_t i = 1; i < changeIndex.size(); i++) {
+			out.widths.push_back(
+			    changeIndex[i] - changeIndex[i - 1]);
+		}
+	}
+
+	/* RVUP */
+	change.clear();
+	out.changeIndex.clear();
+	for (size_t i = 0; i < ridval.size() - 1; i++) {
+		const size_t j = (i == 0) ? ridval.size() - 1 : i - 1;
+		change.push_back(ridval[i] != ridval[j] ? 1 : 0);
+	}
+	for (size_t i = 1; i < change.size(); i++) {
+		if (change[i] == 1) {
+			out.changeIndex.push_back(i - 1);
+		}
+	}
+}
+
+bool
+same(const Reference &reference,
+    const NFIQ2::QualityMeasures::RidgeValleyStructure<Width> &structure)
+{
+	const int length = static_cast<int>(reference.dt.size());
+	if ((structure.length != length) ||
+	    !NFIQ2::Benchmarks::identical(reference.dt.data(),
+		structure.dt.data(), length * sizeof(double)) ||
+	    !NFIQ2::Benchmarks::identical(reference.ridval.data(),
+		structure.ridval.data(), length)) {
+		return (false);
+	}
+
+	if ((static_cast<int>(reference.widths.size()) != structure.changes) ||
+	    !NFIQ2::Benchmarks::identical(reference.widths.data(),
+		structure.widths.data(), structure.changes)) {
+		return (false);
+	}
+
+	/* RVUP leaves out a change into the last column */
+	int changes = structure.changes;
+	if ((changes != 0) &&
+	    (structure.changeIndex[changes - 1] == length - 2)) {
+		changes--;
+	}
+	return ((static_cast<int>(reference.changeIndex.size()) == changes) &&
+	    NFIQ2::Benchmarks::identical(reference.changeIndex.data(),
+		structure.changeIndex.data(), changes));
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.blocks = 20000;
+	const std::string usage { "[-b blocks]" };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (!options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int blockCount { options.blocks };
+
+	/* Column means of slanted blocks, then random ones */
+	const int height { NFIQ2::Sizes::VerticallyAlignedLocalRegionHeight };
+	const int size { 36 };
+	cv::RNG rng { 0x4e464951 };
+	cv::Mat image(256, 256, CV_8UC1);
+	rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+	cv::GaussianBlur(image, image, cv::Size(5, 5), 0);
+	std::vector<NFIQ2::QualityMeasures::ScratchVector<double>> profiles(
+	    blockCount);
+	for (unsigned int i { 0 }; i < blockCount; ++i) {
+		if (i % 2 == 0) {
+			const int x { rng.uniform(0, image.cols - size + 1) };
+			const int y { rng.uniform(0, image.rows - size + 1) };
+			const int c { size / 2 };
+			NFIQ2::QualityMeasures::getRotatedBlockProfile(
+			    image(cv::Rect(x, y, size, size)),
+			    rng.uniform(-M_PI, M_PI), true,
+			    cv::Range(c - height / 2, c + height / 2),
+			    cv::Range(c - Width / 2, c + Width / 2),
+			    NFIQ2::QualityMeasures::COLUMN_MEANS, profiles[i],
+			    cv::noArray());
+		} else {
+			profiles[i].resize(rng.uniform(2, Width + 1));
+			for (double &mean : profiles[i]) {
+				mean = rng.uniform(0., 255.);
+			}
+		}
+	}
+
+	std::vector<Reference> reference(blockCount);
+	const double referenceTime = NFIQ2::Benchmarks::timeMicroseconds(
+	    [&]() {
+		    for (unsigned int i { 0 }; i < blockCount; ++i) {
+			    referenceStructure(profiles[i], reference[i]);
+		    }
+	    });
+
+	std::vector<NFIQ2::QualityMeasures::RidgeValleyStructure<Width>>
+	    structures(blockCount);
+	const double fusedTime = NFIQ2::Benchmarks::timeMicroseconds([&]() {
+		for (unsigned int i { 0 }; i < blockCount; ++i) {
+			NFIQ2::QualityMeasures::getRidgeValleyStructure(
+			    profiles[i], structures[i]);
+		}
+	});
+
+	unsigned int mismatches { 0 };
+	for (unsigned int i { 0 }; i < blockCount; ++i) {
+		if (!same(reference[i], structures[i])) {
+			++mismatches;
+		}
+	}
+
+	std::cout << "blocks: " << blockCount << ", cv::solve "
+		  << referenceTime / blockCount << " us/block, fused "
+		  << fusedTime / blockCount << " us/block, mismatches "
+		  << mismatches << "\n";
+	return (NFIQ2::Benchmarks::report("structures", mismatches == 0));
+}
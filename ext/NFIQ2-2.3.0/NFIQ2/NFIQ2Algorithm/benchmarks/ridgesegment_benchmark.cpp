@@ -0,0 +1,117 @@
+/*
+ * Times QualityMeasures::ridgesegment() against the reference
+ * implementation it replaced (per-block cv::meanStdDev over a normalized
+ * double copy of the image) on 500 PPI grayscale images, for several block
+ * sizes and thresholds. The ridge masks must be identical.
+ *
+ * Usage: nfiq2-ridgesegment-benchmark [-i iterations] <image>...
+ */
+
+#include <nfiq2_constants.hpp>
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using NFIQ2::Benchmarks::timeMilliseconds;
+
+/** ridgesegment() as it was before integral images */
+void
+referenceRidgesegment(const cv::Mat &img, const int blksze,
+    const double thresh, cv::Mat &maskImage)
+{
+	cv::Mat double_im;
+	img.convertTo(double_im, CV_64F);
+
+	cv::Scalar imMean = 0, imStd = 0;
+	cv::meanStdDev(double_im, imMean, imStd, cv::noArray());
+	double_im = (double_im - imMean.val[0]) / imStd.val[0];
+
+	cv::Mat stddevim = double_im.clone();
+	cv::Mat im_roi;
+	for (int r = 0; r < stddevim.rows; r += blksze) {
+		for (int c = 0; c < stddevim.cols; c += blksze) {
+			im_roi = stddevim(
+			    cv::Range(r, cv::min(r + blksze, stddevim.rows)),
+			    cv::Range(c, cv::min(c + blksze, stddevim.cols)));
+			cv::meanStdDev(im_roi, imMean, imStd, cv::noArray());
+			im_roi = imStd.val[0];
+		}
+	}
+
+	maskImage = (stddevim > thresh);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 5;
+	const std::string usage { "[-i iterations] <image>..." };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+	const std::vector<cv::Mat> &images = options.images;
+
+	const int blockSizes[] { 16,
+		static_cast<int>(NFIQ2::Sizes::LocalRegionSquare), 33 };
+	const double thresholds[] { 0.05, 0.1, 0.2, 0.5 };
+
+	bool identical { true };
+	double referenceTime { 0 }, integralTime { 0 };
+	for (const cv::Mat &image : images) {
+		for (const int blksze : blockSizes) {
+			for (const double thresh : thresholds) {
+				cv::Mat reference {}, mask {};
+				referenceTime += timeMilliseconds(iterations,
+				    [&]() {
+					    referenceRidgesegment(image, blksze,
+						thresh, reference);
+				    });
+				integralTime += timeMilliseconds(iterations,
+				    [&]() {
+					    using NFIQ2::QualityMeasures::
+						ridgesegment;
+					    ridgesegment(image, blksze, thresh,
+						cv::noArray(), mask,
+						cv::noArray());
+				    });
+
+				if (!NFIQ2::Benchmarks::identical(reference,
+					mask)) {
+					identical = false;
+					std::cerr << "Masks differ: image "
+						  << image.cols << "x"
+						  << image.rows
+						  << ", block size " << blksze
+						  << ", threshold " << thresh
+						  << "\n";
+				}
+			}
+		}
+	}
+
+	const double runs = static_cast<double>(images.size()) *
+	    (sizeof(blockSizes) / sizeof(blockSizes[0])) *
+	    (sizeof(thresholds) / sizeof(thresholds[0]));
+	std::cout << "images: " << images.size()
+		  << ", iterations: " << iterations << "\n"
+		  << "per-block meanStdDev: " << referenceTime / runs
+		  << " ms/image\n"
+		  << "integral images:      " << integralTime / runs
+		  << " ms/image\n";
+
+	return (NFIQ2::Benchmarks::report("masks", identical));
+}
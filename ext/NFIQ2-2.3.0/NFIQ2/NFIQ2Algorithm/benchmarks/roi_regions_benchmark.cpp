@@ -0,0 +1,233 @@
+/*
+ * Times ImgProcROI::computeROI() against the implementation it replaced
+ * (a raster search for a black seed and a cv::floodFill() per region, a
+ * second flood fill of every region but the largest, then two passes over
+ * the image for the mean and standard deviation of the ROI) on synthetic
+ * fingerprint-like images surrounded by a growing number of dark blobs,
+ * and on 500 PPI grayscale images. Times include the blurring and
+ * thresholding that precede both. Results must be identical.
+ *
+ * Usage: nfiq2-roi-regions-benchmark [-i iterations] [image]...
+ */
+
+#include <opencv2/imgproc.hpp>
+#include <quality_modules/ImgProcROI.h>
+
+#include "benchmark_common.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using NFIQ2::Benchmarks::timeMilliseconds;
+
+bool
+isBlackPixelAvailable(cv::Mat &img, cv::Point &point)
+{
+	for (int i = 0; i < img.rows; i++) {
+		for (int j = 0; j < img.cols; j++) {
+			if (img.at<uchar>(i, j) == 0) {
+				point = cv::Point(j, i);
+				return (true);
+			}
+		}
+	}
+	return (false);
+}
+
+/** Steps 7 and later of computeROI() as they were */
+NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults
+referenceROI(const cv::Mat &img, cv::Mat threshImg2, const unsigned int bs,
+    size_t &regionCount)
+{
+	cv::Mat ffImg = threshImg2.clone();
+	cv::Point point;
+	std::vector<cv::Rect> vecRects;
+	std::vector<cv::Point> vecPoints;
+	while (isBlackPixelAvailable(ffImg, point)) {
+		cv::Rect rect;
+		cv::floodFill(ffImg, point, cv::Scalar(255, 255, 255, 0),
+		    &rect);
+		vecRects.push_back(rect);
+		vecPoints.push_back(point);
+	}
+	regionCount = vecRects.size();
+
+	unsigned int maxIdx = 0;
+	int maxSize = 0;
+	for (unsigned int i = 0; i < vecRects.size(); i++) {
+		if ((vecRects.at(i).width * vecRects.at(i).height) > maxSize) {
+			maxIdx = i;
+			maxSize = (vecRects.at(i).width *
+			    vecRects.at(i).height);
+		}
+	}
+	for (unsigned int i = 0; i < vecRects.size(); i++) {
+		if (i != maxIdx) {
+			cv::floodFill(threshImg2, vecPoints.at(i),
+			    cv::Scalar(255, 255, 255, 0));
+		}
+	}
+
+	unsigned int noOfROIPixels = 0;
+	double meanOfROIPixels = 0.0;
+	for (int i = 0; i < threshImg2.rows; i++) {
+		for (int j = 0; j < threshImg2.cols; j++) {
+			if (threshImg2.at<uchar>(i, j) == 0) {
+				noOfROIPixels++;
+				meanOfROIPixels += img.at<uchar>(i, j);
+			}
+		}
+	}
+	if (noOfROIPixels <= 0) {
+		meanOfROIPixels = 255.0;
+	} else {
+		meanOfROIPixels = (meanOfROIPixels / (double)noOfROIPixels);
+	}
+
+	double sumSquare = 0.0;
+	for (int i = 0; i < threshImg2.rows; i++) {
+		for (int j = 0; j < threshImg2.cols; j++) {
+			if (threshImg2.at<uchar>(i, j) == 0) {
+				const double x = img.at<uchar>(i, j);
+				sumSquare += ((x - meanOfROIPixels) *
+				    (x - meanOfROIPixels));
+			}
+		}
+	}
+	sumSquare = (1.0 / ((double)noOfROIPixels - 1.0) * sumSquare);
+
+	NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults results;
+	results.noOfROIPixels = noOfROIPixels;
+	results.meanOfROIPixels = meanOfROIPixels;
+	results.stdDevOfROIPixels = (sumSquare >= 0) ? sqrt(sumSquare) : 0.0;
+	for (unsigned int i = 0; i < static_cast<unsigned int>(img.rows);
+	     i += bs) {
+		for (unsigned int j = 0;
+		     j < static_cast<unsigned int>(img.cols); j += bs) {
+			const cv::Rect block(j, i,
+			    std::min(bs, img.cols - j),
+			    std::min(bs, img.rows - i));
+			if (cv::mean(threshImg2(block)).val[0] < 255) {
+				results.vecROIBlocks.push_back(block);
+			}
+		}
+	}
+	return (results);
+}
+
+/** Steps 1 to 6 of computeROI(), the binary image of its candidates */
+cv::Mat
+binarize(const cv::Mat &img)
+{
+	cv::Mat image, threshImg;
+	cv::erode(img, image, cv::Mat(5, 5, CV_8U, cv::Scalar(1)));
+	cv::GaussianBlur(image, image, cv::Size(41, 41), 0.0);
+	cv::threshold(image, threshImg, 0, 255, cv::THRESH_OTSU);
+	cv::GaussianBlur(threshImg, image, cv::Size(91, 91), 0.0);
+	cv::threshold(image, threshImg, 0, 255, cv::THRESH_OTSU);
+
+	std::vector<std::vector<cv::Point>> contours;
+	std::vector<cv::Vec4i> hierarchy;
+	cv::Mat contImg = ~threshImg;
+	cv::findContours(contImg, contours, hierarchy, cv::RETR_CCOMP,
+	    cv::CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
+	for (size_t h {}; h < hierarchy.size(); ++h) {
+		if (hierarchy[h][3] != -1) {
+			cv::drawContours(threshImg, contours,
+			    static_cast<int>(h), cv::Scalar(0),
+			    cv::LineTypes::FILLED, 8, hierarchy);
+		}
+	}
+	return (threshImg);
+}
+
+/** Ridge pattern in an ellipse, with dark blobs on a grid around it */
+cv::Mat
+makeImage(const int size, const int pitch)
+{
+	cv::Mat image(size, size, CV_8UC1, cv::Scalar(255));
+	for (int y { pitch / 2 }; y < size; y += pitch) {
+		for (int x { pitch / 2 }; x < size; x += pitch) {
+			cv::circle(image, cv::Point(x, y), pitch / 4,
+			    cv::Scalar(0), cv::FILLED);
+		}
+	}
+
+	const double c { size / 2.0 }, r { size * 0.3 };
+	cv::ellipse(image, cv::Point(c, c), cv::Size(r, r * 1.2), 0, 0, 360,
+	    cv::Scalar(255), cv::FILLED);
+	for (int y { 0 }; y < size; ++y) {
+		for (int x { 0 }; x < size; ++x) {
+			const double dx { (x - c) / r }, dy { (y - c) / (r *
+							     1.2) };
+			if ((dx * dx) + (dy * dy) > 1.0) {
+				continue;
+			}
+			const double d { std::hypot(x - c, y - c + r) };
+			image.at<uchar>(y, x) = cv::saturate_cast<uchar>(
+			    128 + (100 * std::sin(d * 2 * M_PI / 9)));
+		}
+	}
+	return (image);
+}
+
+bool
+identical(const NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults &a,
+    const NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults &b)
+{
+	return ((a.noOfROIPixels == b.noOfROIPixels) &&
+	    NFIQ2::Benchmarks::identical(a.meanOfROIPixels,
+		b.meanOfROIPixels) &&
+	    NFIQ2::Benchmarks::identical(a.stdDevOfROIPixels,
+		b.stdDevOfROIPixels) &&
+	    (a.vecROIBlocks == b.vecROIBlocks));
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 5;
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options,
+		"[-i iterations] [image]...")) {
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+	std::vector<cv::Mat> &images = options.images;
+	for (const int pitch : { 400, 200, 120, 100 }) {
+		images.push_back(makeImage(1200, pitch));
+	}
+
+	const unsigned int bs { NFIQ2::Sizes::LocalRegionSquare };
+	bool same { true };
+	for (cv::Mat &image : images) {
+		NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults reference,
+		    results;
+		size_t regionCount {};
+		const double referenceTime = timeMilliseconds(iterations,
+		    [&]() {
+			    reference = referenceROI(image, binarize(image),
+				bs, regionCount);
+		    });
+		const double labelledTime = timeMilliseconds(iterations,
+		    [&]() {
+			    using NFIQ2::QualityMeasures::ImgProcROI;
+			    results = ImgProcROI::computeROI(image, bs);
+		    });
+
+		const bool match = identical(reference, results);
+		same = same && match;
+		std::cout << image.cols << "x" << image.rows << ", "
+			  << regionCount << " regions: flood fills "
+			  << referenceTime << " ms, labelling " << labelledTime
+			  << " ms" << (match ? "" : ", results differ")
+			  << "\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("results", same));
+}
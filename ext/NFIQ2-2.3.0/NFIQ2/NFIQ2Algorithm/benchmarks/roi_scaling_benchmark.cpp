@@ -0,0 +1,126 @@
+/*
+ * Times ImgProcROI and QualityMap on synthetic fingerprint-like images of
+ * increasing size and on 500 PPI grayscale images, and compares looking up
+ * every block of the image in the ROI block index against a linear search
+ * of the ROI block vector. Both lookups must agree.
+ *
+ * Usage: nfiq2-roi-benchmark [-i iterations] [image]...
+ */
+
+#include <nfiq2_constants.hpp>
+#include <nfiq2_fingerprintimagedata.hpp>
+#include <quality_modules/ImgProcROI.h>
+#include <quality_modules/QualityMap.h>
+
+#include "benchmark_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using NFIQ2::Benchmarks::timeMilliseconds;
+
+/** White image with a ridge pattern inside an ellipse */
+cv::Mat
+makeImage(const int width, const int height)
+{
+	cv::Mat image(height, width, CV_8UC1, cv::Scalar(255));
+	const double cx { width / 2.0 }, cy { height / 2.0 };
+	const double rx { width * 0.4 }, ry { height * 0.45 };
+	for (int y { 0 }; y < height; ++y) {
+		for (int x { 0 }; x < width; ++x) {
+			const double dx { (x - cx) / rx }, dy { (y - cy) / ry };
+			if ((dx * dx) + (dy * dy) > 1.0) {
+				continue;
+			}
+			/* concentric ridges with a period of about 9 pixels */
+			const double r { std::sqrt(((x - cx) * (x - cx)) +
+			    ((y - cy + ry) * (y - cy + ry))) };
+			image.at<uchar>(y, x) = cv::saturate_cast<uchar>(
+			    128 + (100 * std::sin(r * 2 * M_PI / 9)));
+		}
+	}
+
+	return (image);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 3;
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options,
+		"[-i iterations] [image]...")) {
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	const unsigned int bs { NFIQ2::Sizes::LocalRegionSquare };
+	std::vector<cv::Mat> images { options.images };
+	for (const cv::Size &size : { cv::Size { 400, 500 },
+		 cv::Size { 800, 1000 }, cv::Size { 1600, 1500 },
+		 cv::Size { 2000, 2000 }, cv::Size { 4000, 4000 } }) {
+		images.push_back(makeImage(size.width, size.height));
+	}
+
+	bool agree { true };
+	for (cv::Mat &image : images) {
+		const NFIQ2::FingerprintImageData fingerprint =
+		    NFIQ2::Benchmarks::viewImage(image);
+
+		NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults roi {};
+		const double roiTime = timeMilliseconds(iterations, [&]() {
+			roi = NFIQ2::QualityMeasures::ImgProcROI::computeROI(
+			    image, bs);
+		});
+		const double qualityMapTime = timeMilliseconds(iterations,
+		    [&]() {
+			    const NFIQ2::QualityMeasures::QualityMap
+				qualityMap(fingerprint, roi);
+		    });
+
+		/* Every block of the image, as QualityMap visits them */
+		std::vector<cv::Rect> blocks {};
+		for (int i { 0 }; i < image.rows; i += bs) {
+			for (int j { 0 }; j < image.cols; j += bs) {
+				blocks.emplace_back(j, i,
+				    std::min<int>(bs, image.cols - j),
+				    std::min<int>(bs, image.rows - i));
+			}
+		}
+
+		std::vector<char> linear(blocks.size()), indexed(blocks.size());
+		const double linearTime = timeMilliseconds(iterations, [&]() {
+			for (size_t b { 0 }; b < blocks.size(); ++b) {
+				linear[b] = false;
+				for (const cv::Rect &rect : roi.vecROIBlocks) {
+					if (rect == blocks[b]) {
+						linear[b] = true;
+						break;
+					}
+				}
+			}
+		});
+		const double indexedTime = timeMilliseconds(iterations, [&]() {
+			for (size_t b { 0 }; b < blocks.size(); ++b) {
+				indexed[b] = roi.isROIBlock(blocks[b]);
+			}
+		});
+		agree = agree && (linear == indexed);
+
+		std::cout << image.cols << "x" << image.rows << ": "
+			  << blocks.size() << " blocks ("
+			  << roi.vecROIBlocks.size() << " ROI), ImgProcROI "
+			  << roiTime << " ms, QualityMap " << qualityMapTime
+			  << " ms, ROI lookup of all blocks: linear search "
+			  << linearTime << " ms, index " << indexedTime
+			  << " ms\n";
+	}
+
+	return (NFIQ2::Benchmarks::report("ROI lookups", agree));
+}
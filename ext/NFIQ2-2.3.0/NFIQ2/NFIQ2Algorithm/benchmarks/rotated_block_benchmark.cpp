@@ -0,0 +1,179 @@
+/*
+ * Times the projection of slanted blocks as done by FDA, LCS and RVUP:
+ * rotating the whole block with getRotatedBlock(), cropping it and taking
+ * the mean of every row or column, against getRotatedBlockProfile(). Uses
+ * blocks of a random image (some at its edges) with random orientations,
+ * with and without padding. Projections and cropped pixels must be
+ * identical.
+ *
+ * Usage: nfiq2-rotated-block-benchmark [-b blocks]
+ */
+
+#include <nfiq2_constants.hpp>
+#include <quality_modules/common_functions.h>
+
+#include "benchmark_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Slant {
+	const char *name;
+	NFIQ2::QualityMeasures::projection_type projection;
+	/** Orientation added to the block orientation */
+	double rotation;
+	/** Slanted block size, rows then columns */
+	int rows, cols;
+};
+
+/** Projection by rotating the whole block, as before */
+void
+referenceProfile(const cv::Mat &block, const double orientation,
+    const bool padFlag, const cv::Range &rows, const cv::Range &cols,
+    const NFIQ2::QualityMeasures::projection_type projection,
+    std::vector<double> &profile, cv::Mat &slantedBlock)
+{
+	cv::Mat rotatedBlock;
+	NFIQ2::QualityMeasures::getRotatedBlock(block, orientation, padFlag,
+	    rotatedBlock);
+	slantedBlock = rotatedBlock(rows, cols);
+
+	const bool rowMeans = (projection == NFIQ2::QualityMeasures::ROW_MEANS);
+	profile.resize(rowMeans ? slantedBlock.rows : slantedBlock.cols);
+	for (size_t i { 0 }; i < profile.size(); ++i) {
+		profile[i] = cv::mean(rowMeans ?
+			slantedBlock.row(static_cast<int>(i)) :
+			slantedBlock.col(static_cast<int>(i)))
+				 .val[0];
+	}
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.blocks = 20000;
+	const std::string usage { "[-b blocks]" };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (!options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int blockCount { options.blocks };
+
+	/* Local regions with the border added for slanted blocks */
+	const int width { static_cast<int>(
+	    std::ceil(std::sqrt(static_cast<double>(
+		(NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth *
+		    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth) +
+		(NFIQ2::Sizes::VerticallyAlignedLocalRegionHeight *
+		    NFIQ2::Sizes::VerticallyAlignedLocalRegionHeight))))) };
+	const int size { width + (width % 2) };
+	const int regionWidth { static_cast<int>(
+	    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth) };
+	const int regionHeight { static_cast<int>(
+	    NFIQ2::Sizes::VerticallyAlignedLocalRegionHeight) };
+	const Slant slants[] {
+		{ "FDA", NFIQ2::QualityMeasures::ROW_MEANS, M_PI / 2,
+		    regionWidth, regionHeight },
+		{ "LCS/RVUP", NFIQ2::QualityMeasures::COLUMN_MEANS, 0,
+		    regionHeight, regionWidth },
+	};
+
+	/* Padding reads the pixels around blocks inside of the image */
+	cv::RNG rng { 0x4e464951 };
+	cv::Mat image(256, 256, CV_8UC1);
+	rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+	const int last { image.cols - size };
+	std::vector<cv::Mat> blocks(blockCount);
+	std::vector<double> orientations(blockCount);
+	for (unsigned int i { 0 }; i < blockCount; ++i) {
+		const int x { std::min(std::max(rng.uniform(-8, last + 9), 0),
+		    last) };
+		const int y { std::min(std::max(rng.uniform(-8, last + 9), 0),
+		    last) };
+		blocks[i] = image(cv::Rect(x, y, size, size));
+		orientations[i] = rng.uniform(-M_PI, M_PI);
+	}
+
+	bool identical { true };
+	for (const Slant &slant : slants) {
+		for (const bool padFlag : { true, false }) {
+			const int c { size / 2 };
+			const cv::Range rows(c - slant.rows / 2,
+			    c + slant.rows / 2);
+			const cv::Range cols(c - slant.cols / 2,
+			    c + slant.cols / 2);
+
+			std::vector<std::vector<double>> reference(blockCount);
+			std::vector<cv::Mat> referenceBlocks(blockCount);
+			const double referenceTime =
+			    NFIQ2::Benchmarks::timeMicroseconds([&]() {
+				    for (unsigned int i { 0 }; i < blockCount;
+					 ++i) {
+					    referenceProfile(blocks[i],
+						orientations[i] +
+						    slant.rotation,
+						padFlag, rows, cols,
+						slant.projection, reference[i],
+						referenceBlocks[i]);
+				    }
+			    });
+
+			std::vector<NFIQ2::QualityMeasures::ScratchVector<
+			    double>>
+			    profiles(blockCount);
+			std::vector<cv::Mat> slantedBlocks(blockCount);
+			const double fusedTime =
+			    NFIQ2::Benchmarks::timeMicroseconds([&]() {
+				    for (unsigned int i { 0 }; i < blockCount;
+					 ++i) {
+					    NFIQ2::QualityMeasures::
+						getRotatedBlockProfile(
+						    blocks[i],
+						    orientations[i] +
+							slant.rotation,
+						    padFlag, rows, cols,
+						    slant.projection,
+						    profiles[i],
+						    slantedBlocks[i]);
+				    }
+			    });
+
+			unsigned int mismatches { 0 };
+			for (unsigned int i { 0 }; i < blockCount; ++i) {
+				if ((reference[i].size() !=
+					profiles[i].size()) ||
+				    !NFIQ2::Benchmarks::identical(
+					reference[i].data(), profiles[i].data(),
+					reference[i].size() *
+					    sizeof(double)) ||
+				    !NFIQ2::Benchmarks::identical(
+					referenceBlocks[i], slantedBlocks[i])) {
+					++mismatches;
+				}
+			}
+			identical = identical && (mismatches == 0);
+
+			std::cout << slant.name
+				  << (padFlag ? " (padded): " : ": ")
+				  << "rotate and crop "
+				  << referenceTime / blockCount
+				  << " us/block, fused "
+				  << fusedTime / blockCount
+				  << " us/block, mismatches " << mismatches
+				  << "\n";
+		}
+	}
+
+	return (NFIQ2::Benchmarks::report("projections", identical));
+}
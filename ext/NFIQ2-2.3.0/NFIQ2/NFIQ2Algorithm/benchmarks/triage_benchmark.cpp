@@ -0,0 +1,174 @@
+/*
+ * Times the computation of native quality measures with and without triage
+ * (the default TriagePolicy) on a set of 500 PPI grayscale images and on
+ * blank captures of the same sizes: a uniform gray platen, one with faint
+ * sensor noise, and an empty white platen, whose near-white frame covers
+ * the whole image. Reports how many images of each set were triaged, and
+ * how many failed (blank images make local region analyses or cropping
+ * throw). Every blank image must be triaged, and native quality measures
+ * of images that were not triaged must be identical to those computed
+ * without triage.
+ *
+ * Usage: nfiq2-triage-benchmark [-i iterations] <image>...
+ */
+
+#include <nfiq2.hpp>
+#include <opencv2/core.hpp>
+
+#include "benchmark_common.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Algorithms =
+    std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>;
+
+struct Run {
+	double milliseconds {};
+	unsigned int triaged {};
+	unsigned int failed {};
+	std::vector<Algorithms> algorithms {};
+};
+
+Run
+computeAll(const std::vector<NFIQ2::FingerprintImageData> &images,
+    const unsigned int iterations, const bool triage)
+{
+	const NFIQ2::QualityMeasures::TriagePolicy policy {};
+
+	Run run {};
+	/* The first pass warms up and is not timed */
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int i { 0 }; i <= iterations; ++i) {
+		if (i == 1) {
+			start = std::chrono::steady_clock::now();
+		}
+		for (const auto &image : images) {
+			Algorithms algorithms {};
+			bool triaged { false };
+			bool failed { false };
+			try {
+				if (triage) {
+					triaged = NFIQ2::QualityMeasures::
+					    triageNativeQualityMeasureAlgorithms(
+						image, policy, 1, algorithms);
+				} else {
+					algorithms = NFIQ2::QualityMeasures::
+					    computeNativeQualityMeasureAlgorithms(
+						image);
+				}
+			} catch (const NFIQ2::Exception &) {
+				/* e.g., FDA cannot analyze a blank image */
+				failed = true;
+			}
+			if (i == 0) {
+				run.triaged += triaged ? 1 : 0;
+				run.failed += failed ? 1 : 0;
+				run.algorithms.push_back(std::move(algorithms));
+			}
+		}
+	}
+	run.milliseconds = std::chrono::duration<double, std::milli>(
+	    std::chrono::steady_clock::now() - start)
+			       .count();
+
+	return (run);
+}
+
+/**
+ * Bitwise comparison of the images neither triaged nor failed, so NaN
+ * compares equal
+ */
+bool
+identical(const Run &full, const Run &triaged)
+{
+	for (size_t i { 0 }; i < full.algorithms.size(); ++i) {
+		if (full.algorithms[i].empty() ||
+		    (triaged.algorithms[i].size() !=
+			full.algorithms[i].size())) {
+			continue;
+		}
+		const auto a = NFIQ2::QualityMeasures::
+		    getNativeQualityMeasureVector(full.algorithms[i]);
+		const auto b = NFIQ2::QualityMeasures::
+		    getNativeQualityMeasureVector(triaged.algorithms[i]);
+		if (!NFIQ2::Benchmarks::identical(a.data(), b.data(),
+			sizeof(a))) {
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+}
+
+int
+main(int argc, char **argv)
+{
+	NFIQ2::Benchmarks::Options options {};
+	options.iterations = 10;
+	const std::string usage { "[-i iterations] <image>..." };
+	if (!NFIQ2::Benchmarks::parseOptions(argc, argv, options, usage)) {
+		return (EXIT_FAILURE);
+	}
+	if (options.images.empty()) {
+		NFIQ2::Benchmarks::printUsage(argv[0], usage);
+		return (EXIT_FAILURE);
+	}
+	const unsigned int iterations { options.iterations };
+
+	std::vector<cv::Mat> mats {};
+	std::vector<NFIQ2::FingerprintImageData> fingerprints {};
+	std::vector<NFIQ2::FingerprintImageData> blanks {};
+	cv::RNG rng { 0x12345 };
+	for (const cv::Mat &image : options.images) {
+		fingerprints.push_back(NFIQ2::Benchmarks::viewImage(image));
+
+		mats.push_back(cv::Mat(image.size(), CV_8UC1, cv::Scalar(128)));
+		blanks.push_back(NFIQ2::Benchmarks::viewImage(mats.back()));
+
+		cv::Mat noisy(image.size(), CV_8UC1);
+		rng.fill(noisy, cv::RNG::NORMAL, 200, 0.4);
+		mats.push_back(noisy);
+		blanks.push_back(NFIQ2::Benchmarks::viewImage(mats.back()));
+
+		/* Not uniform, so only the empty image condition applies */
+		cv::Mat white(image.size(), CV_8UC1);
+		rng.fill(white, cv::RNG::UNIFORM, 251, 256);
+		mats.push_back(white);
+		blanks.push_back(NFIQ2::Benchmarks::viewImage(mats.back()));
+	}
+
+	bool same { true };
+	unsigned int blanksTriaged {};
+	for (const auto *set : { &fingerprints, &blanks }) {
+		const Run full = computeAll(*set, iterations, false);
+		const Run triaged = computeAll(*set, iterations, true);
+		const double computed = static_cast<double>(set->size()) *
+		    iterations;
+
+		std::cout << (set == &fingerprints ? "fingerprints" : "blanks")
+			  << " (" << set->size() << " images)\n"
+			  << "  full:   " << full.milliseconds / computed
+			  << " ms/image, " << full.failed << " failed\n"
+			  << "  triage: " << triaged.milliseconds / computed
+			  << " ms/image, " << triaged.triaged
+			  << " triaged, " << triaged.failed << " failed\n";
+		same = same && identical(full, triaged);
+		if (set == &blanks) {
+			blanksTriaged = triaged.triaged;
+		}
+	}
+	if (blanksTriaged != blanks.size()) {
+		std::cerr << "Only " << blanksTriaged << " of " << blanks.size()
+			  << " blank images were triaged\n";
+		return (EXIT_FAILURE);
+	}
+	return (NFIQ2::Benchmarks::report("untriaged measures", same));
+}
@@ -131,6 +131,25 @@ class Algorithm {
 	unsigned int computeUnifiedQualityScore(
 	    const std::unordered_map<std::string, double> &features) const;
 
+	/**
+	 * @brief
+	 * Compute a unified quality score.
+	 *
+	 * @param features
+	 * Native quality measures, by position.
+	 *
+	 * @return
+	 * Computed unified quality score.
+	 *
+	 * @throw Exception
+	 * Called before random forest parameters were loaded.
+	 *
+	 * @ingroup compute
+	 * @see QualityMeasures::getNativeQualityMeasureVector
+	 */
+	unsigned int computeUnifiedQualityScore(
+	    const QualityMeasures::NativeQualityMeasureVector &features) const;
+
 	/**
 	 * @brief
 	 * Obtain the quality block values (i.e., [0, 100]) for the native
@@ -224,6 +243,36 @@ class Algorithm {
 	 */
 	unsigned int getEmbeddedFCT() const;
 
+	/**
+	 * @brief
+	 * Set the maximum number of threads used to compute native quality
+	 * measures when scoring a fingerprint image.
+	 *
+	 * @param threadCount
+	 * Maximum number of threads, including the calling thread. Values
+	 * less than 2 (the default) compute quality measures sequentially.
+	 *
+	 * @note
+	 * Quality measure algorithms without dependencies on each other are
+	 * run concurrently. Results are identical to sequential computation.
+	 * Helper threads come from a process-wide pool, started by this
+	 * call and shared by all Algorithm objects, with at most one
+	 * thread per hardware thread.
+	 *
+	 * @see QualityMeasures::computeNativeQualityMeasureAlgorithms
+	 */
+	void setQualityMeasureThreadCount(const unsigned int threadCount);
+
+	/**
+	 * @brief
+	 * Obtain the maximum number of threads used to compute native quality
+	 * measures when scoring a fingerprint image.
+	 *
+	 * @return
+	 * Maximum number of threads, including the calling thread.
+	 */
+	unsigned int getQualityMeasureThreadCount() const;
+
     private:
 	/** Pointer to Implementation class. */
 	class Impl;
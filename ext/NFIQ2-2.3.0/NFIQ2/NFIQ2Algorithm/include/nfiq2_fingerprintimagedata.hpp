@@ -67,6 +67,61 @@ class FingerprintImageData : public Data {
 	/** Copy constructor. */
 	FingerprintImageData(const FingerprintImageData &otherData);
 
+	/**
+	 * @brief
+	 * Obtain an image that refers to the caller's pixels instead of
+	 * copying them.
+	 *
+	 * @details
+	 * The pixels are only reachable through pixels() and pixelsSize(),
+	 * which return `pData` and `dataSize`; the NFIQ2::Data base of a
+	 * view is empty. The caller must keep the buffer alive and
+	 * unmodified for as long as the returned object and any copies of
+	 * it are in use. Copies of a view are views of the same buffer.
+	 *
+	 * @param pData
+	 * Pointer to decompressed 8 bit-per-pixel grayscale image data,
+	 * canonically encoded as per ISO/IEC 39794-4:2019.
+	 * @param dataSize
+	 * Size of the buffer pointed to by `pData`.
+	 * @param width
+	 * Width of the image in pixels.
+	 * @param height
+	 * Height of the image in pixels.
+	 * @param fingerCode
+	 * Finger position of the fingerprint in the image.
+	 * @param ppi
+	 * Resolution of the image in pixels per inch.
+	 *
+	 * @return
+	 * Image viewing `pData`.
+	 */
+	static FingerprintImageData view(const uint8_t *pData,
+	    uint32_t dataSize, uint32_t width, uint32_t height,
+	    uint8_t fingerCode, uint16_t ppi);
+
+	/** @return Whether this image refers to pixels it does not own. */
+	bool isView() const;
+
+	/**
+	 * @return
+	 * Pointer to the first pixel, whether owned (stored in the
+	 * NFIQ2::Data base) or viewed. Code reading the pixels of an image
+	 * must use this rather than data(), which is empty for views.
+	 */
+	const uint8_t *pixels() const;
+
+	/** @return Number of bytes of pixel data, whether owned or viewed. */
+	size_type pixelsSize() const;
+
+	/**
+	 * @return
+	 * Distance in bytes between the first pixels of two consecutive
+	 * rows. Equal to `width` unless this is a view returned by
+	 * viewRemovingNearWhiteFrame().
+	 */
+	uint32_t stride() const;
+
 	/** Destructor. */
 	virtual ~FingerprintImageData();
 
@@ -92,6 +147,33 @@ class FingerprintImageData : public Data {
 	 * after cropping.
 	 */
 	NFIQ2::FingerprintImageData copyRemovingNearWhiteFrame() const;
+
+	/**
+	 * @brief
+	 * Obtain a view of the image with near-white lines surrounding the
+	 * fingerprint removed.
+	 *
+	 * @details
+	 * The view refers to the pixels of this image, so this image (or
+	 * the buffer it views) must outlive it. Rows of the view are
+	 * stride() bytes apart.
+	 *
+	 * @return
+	 * Cropped fingerprint image, as a view.
+	 *
+	 * @throws NFIQ2::Exception
+	 * Error performing the crop, or the image is too small to be processed
+	 * after cropping.
+	 */
+	NFIQ2::FingerprintImageData viewRemovingNearWhiteFrame() const;
+
+    private:
+	/** Viewed pixels, or nullptr if the pixels are stored in Data. */
+	const uint8_t *viewData { nullptr };
+	/** Size of the buffer pointed to by viewData. */
+	size_type viewSize { 0 };
+	/** Row stride of the viewed pixels, or 0 if equal to width. */
+	uint32_t viewStride { 0 };
 };
 } // namespace NFIQ
 
@@ -0,0 +1,149 @@
+/*
+ * This file is part of NIST Fingerprint Image Quality (NFIQ) 2. For more
+ * information on this project, refer to:
+ *   - https://nist.gov/services-resources/software/nfiq2
+ *   - https://github.com/usnistgov/NFIQ2
+ *
+ * This work is in the public domain. For complete licensing details, refer to:
+ *   - https://github.com/usnistgov/NFIQ2/blob/master/LICENSE.md
+ */
+
+#ifndef NFIQ2_INSTRUMENTATION_HPP_
+#define NFIQ2_INSTRUMENTATION_HPP_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Opt-in measurements of where the computation of quality spends its time
+ * and memory, for single computations and aggregated over the process.
+ */
+namespace NFIQ2 { namespace Instrumentation {
+
+/** Stages timed inside quality measure algorithms and prediction. */
+namespace Stage {
+enum Stage : unsigned int {
+	/** Removal of the near-white frame around the fingerprint */
+	Crop = 0,
+	/** Segmentation of the local regions shared by several algorithms */
+	RidgeSegment,
+	/**
+	 * Segmentation and orientation of the local regions shared by
+	 * several algorithms, including RidgeSegment
+	 */
+	BlockGeometry,
+	/**
+	 * Enhancement and minutiae extraction by FingerJet FX, which runs
+	 * them as a single call
+	 */
+	FingerJetFXExtraction,
+	/** Random forest prediction of the unified quality score */
+	RandomForestPrediction,
+};
+}
+
+/** Number of stages. */
+constexpr unsigned int StageCount { Stage::RandomForestPrediction + 1 };
+
+/** Identifiers of stages, indexed by Stage. */
+constexpr const char *const StageIdentifiers[StageCount] { "Crop",
+	"RidgeSegment", "BlockGeometry", "FingerJetFXExtraction",
+	"RandomForestPrediction" };
+
+/**
+ * Number of native quality measure algorithms.
+ *
+ * @see NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs()
+ */
+constexpr unsigned int AlgorithmCount { 10 };
+
+/** Measurements of the computations made while a Scope was active. */
+struct Measurements {
+	/** Wall time since the Scope was created (milliseconds). */
+	double totalMilliseconds {};
+	/**
+	 * Wall time of each native quality measure algorithm, in the order
+	 * of getNativeQualityMeasureAlgorithmIDs() (milliseconds). NaN for
+	 * algorithms that did not run.
+	 */
+	std::array<double, AlgorithmCount> algorithmMilliseconds {};
+	/**
+	 * Wall time of each stage, indexed by Stage (milliseconds). NaN for
+	 * stages that did not run.
+	 */
+	std::array<double, StageCount> stageMilliseconds {};
+	/** Scratch allocations requested by quality modules. */
+	uint64_t scratchAllocations {};
+	/** Calls to the system allocator made for those allocations. */
+	uint64_t systemAllocations {};
+	/**
+	 * Local regions entirely in the fingerprint foreground, or -1 if the
+	 * shared local regions were not segmented.
+	 */
+	int64_t foregroundBlocks { -1 };
+};
+
+/**
+ * Measures the computations of the calling thread while it exists.
+ *
+ * @details
+ * Work a computation hands to other threads (see the `threadCount`
+ * parameters of NFIQ2::QualityMeasures) is measured too. When a scope is
+ * destroyed, its measurements are added to the process-wide histograms.
+ * Without an active scope nothing is measured, and quality is identical
+ * either way.
+ */
+class Scope {
+    public:
+	/** Start measuring on the calling thread. */
+	Scope();
+
+	/** Stop measuring and add the measurements to the histograms. */
+	~Scope();
+
+	Scope(const Scope &) = delete;
+	Scope &operator=(const Scope &) = delete;
+
+	/** @return Measurements so far. */
+	Measurements getMeasurements() const;
+
+    private:
+	/** Pointer to Implementation class. */
+	class Impl;
+
+	/** Pointer to Implementation smart pointer. */
+	std::unique_ptr<Scope::Impl> pimpl;
+};
+
+/**
+ * @brief
+ * Describe the process-wide histograms of the measurements of every Scope
+ * since the last call to resetHistograms(), one line per measurement.
+ *
+ * @details
+ * Histogram buckets are powers of 2, e.g. "le4=3" counts 3 values in
+ * (2, 4]. Empty buckets are left out.
+ */
+std::string getHistogramsText();
+
+/**
+ * @brief
+ * Describe the process-wide histograms as JSON.
+ *
+ * @details
+ * An object mapping "Total", the algorithm identifiers, the stage
+ * identifiers, "ScratchAllocations", "SystemAllocations" and
+ * "ForegroundBlocks" to objects with "count", "sum", "min", "max" and the
+ * non-empty "buckets", each an object with "le" (upper bound, null for
+ * the last bucket) and "count".
+ */
+std::string getHistogramsJSON();
+
+/** @brief Empty the process-wide histograms. */
+void resetHistograms();
+
+}}
+
+#endif /* NFIQ2_INSTRUMENTATION_HPP_ */
@@ -0,0 +1,181 @@
+/*
+ * This file is part of NIST Fingerprint Image Quality (NFIQ) 2. For more
+ * information on this project, refer to:
+ *   - https://nist.gov/services-resources/software/nfiq2
+ *   - https://github.com/usnistgov/NFIQ2
+ *
+ * This work is in the public domain. For complete licensing details, refer to:
+ *   - https://github.com/usnistgov/NFIQ2/blob/master/LICENSE.md
+ */
+
+#ifndef NFIQ2_LAZYQUALITYMEASURES_HPP_
+#define NFIQ2_LAZYQUALITYMEASURES_HPP_
+
+#include <nfiq2_fingerprintimagedata.hpp>
+#include <nfiq2_qualitymeasures.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+/**
+ * Computes the native quality measure algorithms of one fingerprint image
+ * on demand.
+ *
+ * @details
+ * Only the algorithms a request needs are computed, along with those they
+ * depend on: FJFXMinutiaeQuality needs FingerJetFX's minutiae, QualityMap
+ * needs ImgProcROI's region of interest, and FDA, LCS, OF and
+ * RVUPHistogram share the segmentation and orientation of local regions.
+ * Each of these is computed at most once, the first time it is needed, so
+ * asking for actionable quality feedback first and for all native quality
+ * measures afterwards costs no more than asking for the measures only.
+ * Native quality measures are identical to those of
+ * computeNativeQualityMeasureAlgorithms().
+ */
+class LazyQualityMeasures {
+    public:
+	/**
+	 * @brief
+	 * Constructor.
+	 *
+	 * @param rawImage
+	 * Fingerprint image in raw format. It is copied, but a copy of a view
+	 * (see FingerprintImageData::view()) is a view, so the pixels it
+	 * views must then outlive this object. If its near-white frame
+	 * cannot be cropped (e.g. all rows or columns are near-white),
+	 * computing algorithms throws, and only triage() can succeed.
+	 */
+	explicit LazyQualityMeasures(
+	    const NFIQ2::FingerprintImageData &rawImage);
+
+	/** Move constructor. */
+	LazyQualityMeasures(LazyQualityMeasures &&) noexcept;
+
+	/** Move assignment operator. */
+	LazyQualityMeasures &operator=(LazyQualityMeasures &&) noexcept;
+
+	/** Destructor. */
+	~LazyQualityMeasures();
+
+	/**
+	 * @brief
+	 * Compute quality measure algorithms, unless already computed.
+	 *
+	 * @param algorithmIDs
+	 * Identifiers of the algorithms to compute.
+	 * @param threadCount
+	 * Maximum number of threads used, including the calling thread.
+	 * Values less than 2 compute sequentially.
+	 *
+	 * @return
+	 * The algorithms of `algorithmIDs`, in the order of
+	 * getNativeQualityMeasureAlgorithmIDs().
+	 *
+	 * @throw Exception
+	 * An identifier is not one of getNativeQualityMeasureAlgorithmIDs(),
+	 * the image cannot be cropped, or an algorithm failed. Algorithms
+	 * computed before the failure are kept.
+	 *
+	 * @see Identifiers::QualityMeasureAlgorithms
+	 */
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	computeAlgorithms(const std::vector<std::string> &algorithmIDs,
+	    const unsigned int threadCount);
+
+	/**
+	 * @brief
+	 * Compute native quality measures, computing only the algorithms
+	 * they come from.
+	 *
+	 * @param qualityMeasureIDs
+	 * Identifiers of the native quality measures to compute.
+	 * @param threadCount
+	 * Maximum number of threads used, including the calling thread.
+	 *
+	 * @return
+	 * A map of the identifiers of `qualityMeasureIDs` to their values.
+	 *
+	 * @throw Exception
+	 * An identifier is not one of getNativeQualityMeasureIDs(), the
+	 * image cannot be cropped, or an algorithm failed.
+	 *
+	 * @see Identifiers::QualityMeasures
+	 */
+	std::unordered_map<std::string, double> computeNativeQualityMeasures(
+	    const std::vector<std::string> &qualityMeasureIDs,
+	    const unsigned int threadCount);
+
+	/**
+	 * @brief
+	 * Compute actionable quality feedback, computing only the algorithms
+	 * it comes from.
+	 *
+	 * @param threadCount
+	 * Maximum number of threads used, including the calling thread.
+	 *
+	 * @return
+	 * A map of actionable quality identifiers to actionable quality
+	 * values.
+	 *
+	 * @see getActionableQualityFeedbackAlgorithmIDs()
+	 */
+	std::unordered_map<std::string, double>
+	computeActionableQualityFeedback(const unsigned int threadCount);
+
+	/**
+	 * @brief
+	 * Compute the algorithms that `policy` checks, and check it.
+	 *
+	 * @details
+	 * Mu is computed, and ImgProcROI if `policy` checks the foreground
+	 * and Mu did not meet a condition. If the near-white frame of the
+	 * image cannot be cropped, as for an empty platen, Mu is computed on
+	 * the whole image instead, and nothing else.
+	 *
+	 * @param policy
+	 * Conditions to check.
+	 *
+	 * @return
+	 * true if the actionable quality feedback of the algorithms computed
+	 * so far meets a condition of `policy`.
+	 *
+	 * @throw Exception
+	 * The image cannot be cropped and does not meet a condition of
+	 * `policy`, or an algorithm failed.
+	 *
+	 * @see isTriaged()
+	 */
+	bool triage(const TriagePolicy &policy);
+
+	/**
+	 * @return
+	 * Algorithms computed so far, in the order of
+	 * getNativeQualityMeasureAlgorithmIDs().
+	 */
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	getComputedAlgorithms() const;
+
+	/**
+	 * @return
+	 * Values of the native quality measures of the algorithms computed
+	 * so far, by position. Measures of other algorithms are NaN.
+	 */
+	NativeQualityMeasureVector getComputedNativeQualityMeasures() const;
+
+	/**
+	 * Implementation class, shared with
+	 * computeNativeQualityMeasureAlgorithms().
+	 */
+	class Impl;
+
+    private:
+	/** Pointer to Implementation smart pointer. */
+	std::unique_ptr<LazyQualityMeasures::Impl> pimpl;
+};
+}}
+
+#endif /* NFIQ2_LAZYQUALITYMEASURES_HPP_ */
@@ -14,6 +14,8 @@
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -57,6 +59,35 @@ std::vector<std::string> getActionableQualityFeedbackIDs();
  */
 std::vector<std::string> getNativeQualityMeasureAlgorithmIDs();
 
+/**
+ * @brief
+ * Obtain the identifiers of the quality measure algorithms computing some
+ * native quality measures.
+ *
+ * @param qualityMeasureIDs
+ * Identifiers of native quality measures.
+ *
+ * @return
+ * Identifiers of the quality measure algorithms computing
+ * `qualityMeasureIDs`, without the algorithms they depend on, in the
+ * order of getNativeQualityMeasureAlgorithmIDs().
+ *
+ * @throw Exception
+ * An identifier is not one of getNativeQualityMeasureIDs().
+ */
+std::vector<std::string> getNativeQualityMeasureAlgorithmIDs(
+    const std::vector<std::string> &qualityMeasureIDs);
+
+/**
+ * @brief
+ * Obtain the identifiers of the quality measure algorithms that
+ * getActionableQualityFeedback() reads.
+ *
+ * @return
+ * Vector of strings with quality measure algorithm identifiers.
+ */
+std::vector<std::string> getActionableQualityFeedbackAlgorithmIDs();
+
 /**
  * @brief
  * Obtain all quality measure identifiers from quality measure algorithms.
@@ -70,6 +101,190 @@ std::vector<std::string> getNativeQualityMeasureIDs();
 
 /******************************************************************************/
 
+/*
+ * Native quality measures by position.
+ */
+
+/** Positions of native quality measures in a NativeQualityMeasureVector. */
+namespace NativeQualityMeasure {
+/**
+ * @brief
+ * Position of a native quality measure.
+ *
+ * @details
+ * Native quality measures are in the order of getNativeQualityMeasureIDs(),
+ * which is also the order of the features of the random forest model. Any
+ * modification to this ordering will result in incorrect NFIQ 2 scores.
+ */
+enum Index : unsigned int {
+	FrequencyDomainAnalysisBin0 = 0,
+	FrequencyDomainAnalysisBin1,
+	FrequencyDomainAnalysisBin2,
+	FrequencyDomainAnalysisBin3,
+	FrequencyDomainAnalysisBin4,
+	FrequencyDomainAnalysisBin5,
+	FrequencyDomainAnalysisBin6,
+	FrequencyDomainAnalysisBin7,
+	FrequencyDomainAnalysisBin8,
+	FrequencyDomainAnalysisBin9,
+	FrequencyDomainAnalysisMean,
+	FrequencyDomainAnalysisStdDev,
+	MinutiaeCountCOM,
+	MinutiaeCount,
+	MinutiaePercentImageMean50,
+	MinutiaePercentOrientationCertainty80,
+	RegionOfInterestMean,
+	LocalClarityBin0,
+	LocalClarityBin1,
+	LocalClarityBin2,
+	LocalClarityBin3,
+	LocalClarityBin4,
+	LocalClarityBin5,
+	LocalClarityBin6,
+	LocalClarityBin7,
+	LocalClarityBin8,
+	LocalClarityBin9,
+	LocalClarityMean,
+	LocalClarityStdDev,
+	ContrastMeanOfBlockMeans,
+	ContrastImageMean,
+	OrientationCertaintyBin0,
+	OrientationCertaintyBin1,
+	OrientationCertaintyBin2,
+	OrientationCertaintyBin3,
+	OrientationCertaintyBin4,
+	OrientationCertaintyBin5,
+	OrientationCertaintyBin6,
+	OrientationCertaintyBin7,
+	OrientationCertaintyBin8,
+	OrientationCertaintyBin9,
+	OrientationCertaintyMean,
+	OrientationCertaintyStdDev,
+	OrientationFlowBin0,
+	OrientationFlowBin1,
+	OrientationFlowBin2,
+	OrientationFlowBin3,
+	OrientationFlowBin4,
+	OrientationFlowBin5,
+	OrientationFlowBin6,
+	OrientationFlowBin7,
+	OrientationFlowBin8,
+	OrientationFlowBin9,
+	OrientationFlowMean,
+	OrientationFlowStdDev,
+	RegionOfInterestCoherenceMean,
+	RegionOfInterestCoherenceSum,
+	RidgeValleyUniformityBin0,
+	RidgeValleyUniformityBin1,
+	RidgeValleyUniformityBin2,
+	RidgeValleyUniformityBin3,
+	RidgeValleyUniformityBin4,
+	RidgeValleyUniformityBin5,
+	RidgeValleyUniformityBin6,
+	RidgeValleyUniformityBin7,
+	RidgeValleyUniformityBin8,
+	RidgeValleyUniformityBin9,
+	RidgeValleyUniformityMean,
+	RidgeValleyUniformityStdDev,
+};
+}
+
+/** Number of native quality measures. */
+constexpr unsigned int NativeQualityMeasureCount {
+	NativeQualityMeasure::RidgeValleyUniformityStdDev + 1
+};
+
+/**
+ * @brief
+ * Values of all native quality measures, indexed by NativeQualityMeasure.
+ *
+ * @details
+ * Unlike the maps of getNativeQualityMeasures(), a vector is filled and read
+ * without hashing or allocating identifiers.
+ */
+using NativeQualityMeasureVector = std::array<double,
+    NativeQualityMeasureCount>;
+
+/**
+ * Identifiers of native quality measures, indexed by NativeQualityMeasure.
+ *
+ * @see Identifiers::QualityMeasures
+ */
+constexpr const char *const
+    NativeQualityMeasureIdentifiers[NativeQualityMeasureCount] {
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin0,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin1,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin2,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin3,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin4,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin5,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin6,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin7,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin8,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Histogram::Bin9,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::Mean,
+	Identifiers::QualityMeasures::FrequencyDomainAnalysis::StdDev,
+	Identifiers::QualityMeasures::Minutiae::CountCOM,
+	Identifiers::QualityMeasures::Minutiae::Count,
+	Identifiers::QualityMeasures::Minutiae::PercentImageMean50,
+	Identifiers::QualityMeasures::Minutiae::PercentOrientationCertainty80,
+	Identifiers::QualityMeasures::RegionOfInterest::Mean,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin0,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin1,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin2,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin3,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin4,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin5,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin6,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin7,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin8,
+	Identifiers::QualityMeasures::LocalClarity::Histogram::Bin9,
+	Identifiers::QualityMeasures::LocalClarity::Mean,
+	Identifiers::QualityMeasures::LocalClarity::StdDev,
+	Identifiers::QualityMeasures::Contrast::MeanOfBlockMeans,
+	Identifiers::QualityMeasures::Contrast::ImageMean,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin0,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin1,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin2,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin3,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin4,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin5,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin6,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin7,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin8,
+	Identifiers::QualityMeasures::OrientationCertainty::Histogram::Bin9,
+	Identifiers::QualityMeasures::OrientationCertainty::Mean,
+	Identifiers::QualityMeasures::OrientationCertainty::StdDev,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin0,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin1,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin2,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin3,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin4,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin5,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin6,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin7,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin8,
+	Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin9,
+	Identifiers::QualityMeasures::OrientationFlow::Mean,
+	Identifiers::QualityMeasures::OrientationFlow::StdDev,
+	Identifiers::QualityMeasures::RegionOfInterest::CoherenceMean,
+	Identifiers::QualityMeasures::RegionOfInterest::CoherenceSum,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin0,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin1,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin2,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin3,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin4,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin5,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin6,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin7,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin8,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::Bin9,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::Mean,
+	Identifiers::QualityMeasures::RidgeValleyUniformity::StdDev
+    };
+
+/******************************************************************************/
+
 /**
  * @addtogroup compute
  * Compute unified quality scores, native quality measures, quality block
@@ -91,6 +306,160 @@ std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 computeNativeQualityMeasureAlgorithms(
     const NFIQ2::FingerprintImageData &rawImage);
 
+/**
+ * @brief
+ * Compute native quality measures, running independent quality measure
+ * algorithms concurrently.
+ *
+ * @param rawImage
+ * Fingerprint image in raw format.
+ * @param threadCount
+ * Maximum number of threads used, including the calling thread. Values less
+ * than 2 compute sequentially, as computeNativeQualityMeasureAlgorithms(
+ * const NFIQ2::FingerprintImageData&).
+ *
+ * @return
+ * A vector of evaluated native quality measure algorithms, in the same order
+ * as when computed sequentially.
+ *
+ * @note
+ * If more than one algorithm fails, which exception is thrown depends on
+ * scheduling.
+ */
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const unsigned int threadCount);
+
+/**
+ * @brief
+ * Compute some native quality measure algorithms, and only the algorithms
+ * they depend on.
+ *
+ * @param rawImage
+ * Fingerprint image in raw format.
+ * @param algorithmIDs
+ * Identifiers of the algorithms to compute, e.g.,
+ * getActionableQualityFeedbackAlgorithmIDs() or the result of
+ * getNativeQualityMeasureAlgorithmIDs(const std::vector<std::string>&).
+ * @param threadCount
+ * Maximum number of threads used, including the calling thread. Values less
+ * than 2 compute sequentially.
+ *
+ * @return
+ * The algorithms of `algorithmIDs`, in the order of
+ * getNativeQualityMeasureAlgorithmIDs(). Their native quality measures are
+ * identical to those computed by computeNativeQualityMeasureAlgorithms(
+ * const NFIQ2::FingerprintImageData&).
+ *
+ * @throw Exception
+ * An identifier is not one of getNativeQualityMeasureAlgorithmIDs(), or an
+ * algorithm failed.
+ *
+ * @see LazyQualityMeasures
+ */
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount);
+
+/**
+ * @brief
+ * Conditions of actionable quality feedback under which
+ * triageNativeQualityMeasureAlgorithms() stops before computing the
+ * expensive quality measure algorithms.
+ *
+ * @details
+ * Thresholds default to those of Thresholds::ActionableQualityFeedback, and
+ * a condition is met exactly when that feedback indicates a corrective
+ * action.
+ */
+struct TriagePolicy {
+	/** Stop when UniformImage is below uniformImageThreshold. */
+	bool stopOnUniformImage { true };
+	/** Threshold for stopOnUniformImage. */
+	double uniformImageThreshold {
+		Thresholds::ActionableQualityFeedback::UniformImage
+	};
+
+	/**
+	 * Stop when EmptyImageOrContrastTooLow is above emptyImageThreshold.
+	 */
+	bool stopOnEmptyImage { true };
+	/** Threshold for stopOnEmptyImage. */
+	double emptyImageThreshold {
+		Thresholds::ActionableQualityFeedback::
+		    EmptyImageOrContrastTooLow
+	};
+
+	/**
+	 * Stop when SufficientFingerprintForeground is below
+	 * foregroundThreshold.
+	 */
+	bool stopOnInsufficientForeground { false };
+	/** Threshold for stopOnInsufficientForeground. */
+	double foregroundThreshold {
+		Thresholds::ActionableQualityFeedback::
+		    SufficientFingerprintForeground
+	};
+};
+
+/**
+ * @brief
+ * Determine whether actionable quality feedback meets a condition of a
+ * triage policy.
+ *
+ * @param policy
+ * Conditions to check.
+ * @param actionableQualityFeedback
+ * Actionable quality feedback, as from getActionableQualityFeedback().
+ * Missing or NaN values never meet a condition.
+ *
+ * @return
+ * true if any enabled condition of `policy` is met, false otherwise.
+ */
+bool isTriaged(const TriagePolicy &policy,
+    const std::unordered_map<std::string, double> &actionableQualityFeedback);
+
+/**
+ * @brief
+ * Compute native quality measures in stages, stopping early for images
+ * that a triage policy rejects.
+ *
+ * @details
+ * Mu, which the uniform and empty image feedback come from, is computed
+ * first, then ImgProcROI if `policy` checks the foreground. If that feedback
+ * meets a condition of `policy`, minutiae detection and the local region
+ * analyses are skipped. Images whose near-white frame cannot be cropped,
+ * like empty platens, are checked with Mu of the whole image, and throw
+ * unless triaged. Otherwise, the remaining algorithms are computed as
+ * by computeNativeQualityMeasureAlgorithms(), reusing those computed first,
+ * so native quality measures are identical.
+ *
+ * @param rawImage
+ * Fingerprint image in raw format.
+ * @param policy
+ * Conditions under which to stop early.
+ * @param threadCount
+ * Maximum number of threads used, including the calling thread. Values less
+ * than 2 compute sequentially.
+ * @param[out] algorithms
+ * Evaluated native quality measure algorithms, in the same order as
+ * computeNativeQualityMeasureAlgorithms(): all of them, or, if the image was
+ * triaged, only those computed before stopping. Actionable quality feedback
+ * of algorithms that were not computed is NaN.
+ *
+ * @return
+ * true if the image was triaged, in which case no unified quality score
+ * can be computed from `algorithms`.
+ */
+bool triageNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const TriagePolicy &policy,
+    const unsigned int threadCount,
+    std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms);
+
 /**
  * @brief
  * Compute native quality measure values.
@@ -162,6 +531,25 @@ std::unordered_map<std::string, double> getNativeQualityMeasures(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&algorithms);
 
+/**
+ * @brief
+ * Obtain native quality measures from computed native quality measure
+ * algorithms, by position.
+ *
+ * @param algorithms
+ * Computed native quality measure algorithms, each of which fills its
+ * positions of the vector.
+ *
+ * @return
+ * Values of all native quality measures.
+ *
+ * @throw Exception
+ * `algorithms` does not compute every native quality measure.
+ */
+NativeQualityMeasureVector getNativeQualityMeasureVector(
+    const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms);
+
 /**
  * @brief
  * Obtain native quality measure algorithms organized as a map.
@@ -198,6 +586,55 @@ getNativeQualityMeasureAlgorithms(
 std::unordered_map<std::string, double> getNativeQualityMeasureAlgorithmSpeeds(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&algorithms);
+
+/******************************************************************************/
+
+/*
+ * Scratch memory.
+ */
+
+/**
+ * @brief
+ * Allocation counters of the scratch memory (cv::Mat data and temporary
+ * buffers) used by quality modules while computing native quality measures.
+ */
+struct ScratchMemoryStatistics {
+	/** Scratch allocations requested by quality modules. */
+	uint64_t allocations {};
+	/**
+	 * Calls to the system allocator made for those allocations. When the
+	 * scratch arena is enabled, this includes the large blocks the arena
+	 * carves allocations from.
+	 */
+	uint64_t systemAllocations {};
+};
+
+/**
+ * @brief
+ * Obtain scratch memory allocation counters, accumulated over all threads
+ * since the last call to resetScratchMemoryStatistics().
+ */
+ScratchMemoryStatistics getScratchMemoryStatistics();
+
+/**
+ * @brief
+ * Zero the scratch memory allocation counters.
+ */
+void resetScratchMemoryStatistics();
+
+/**
+ * @brief
+ * Enable or disable the per-thread scratch arena.
+ *
+ * @details
+ * The arena is enabled by default. When disabled, every scratch allocation
+ * is served by the system allocator, which is only useful to measure the
+ * effect of the arena. Native quality measures are identical either way.
+ *
+ * @param enabled
+ * Whether quality modules draw scratch memory from the arena.
+ */
+void setScratchArenaEnabled(const bool enabled);
 }}
 
 #endif /* NFIQ2_QUALITYMEASURES_HPP_ */
@@ -41,6 +41,16 @@ extern const std::string OpenCV;
 /** FingerJet version. */
 std::string FingerJet();
 
+/*
+ * Instruction sets.
+ */
+/** Variant of the NFIQ2 kernels used on this CPU ("avx512f", "avx2" or
+ * "default"). */
+std::string CPUDispatch();
+/** Instruction sets OpenCV was compiled for and dispatches to on this CPU.
+ */
+std::string OpenCVCPUFeatures();
+
 } // namespace Version
 } // namespace NFIQ
 
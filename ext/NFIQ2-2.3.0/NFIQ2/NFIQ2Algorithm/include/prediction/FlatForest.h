@@ -0,0 +1,136 @@
+#ifndef NFIQ2_PREDICTION_FLATFOREST_H_
+#define NFIQ2_PREDICTION_FLATFOREST_H_
+
+#include <opencv2/ml.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NFIQ2 { namespace Prediction {
+
+/**
+ * @brief
+ * Inference-only copy of a trained binary random forest classifier.
+ *
+ * @details
+ * The trees of a cv::ml::RTrees model are flattened into one contiguous
+ * node array stored as separate arrays of feature indices, thresholds,
+ * child offsets and leaf values. The children of every split node are
+ * adjacent, so a tree is walked without branching on the split direction.
+ *
+ * predict() returns exactly the value of
+ * `RTrees::predict(sample, noArray(), StatModel::RAW_OUTPUT)`: the leaf
+ * values are summed in tree order in double precision and converted to
+ * float, and missing values and NaNs are routed the same way OpenCV
+ * routes them.
+ */
+class FlatForest {
+    public:
+	/**
+	 * @brief
+	 * Flatten a trained forest.
+	 *
+	 * @param forest
+	 * Trained random forest.
+	 * @param params
+	 * File node the forest was read from. Used to read the variable
+	 * subset and missing value substitutes, which RTrees does not
+	 * expose.
+	 *
+	 * @throw NFIQ2::Exception
+	 * The forest uses a feature this engine does not reproduce
+	 * (regression, more than two classes or categorical variables).
+	 */
+	FlatForest(const cv::ml::RTrees &forest, const cv::FileNode &params);
+
+	/**
+	 * @brief
+	 * Load a forest from the binary representation produced by
+	 * serialize().
+	 *
+	 * @details
+	 * This avoids parsing the OpenCV model entirely. The buffer is
+	 * copied and may be released (or unmapped) afterwards.
+	 *
+	 * @param data
+	 * Binary model.
+	 * @param size
+	 * Size of `data` in bytes.
+	 *
+	 * @throw NFIQ2::Exception
+	 * The buffer is not a valid binary model for this build.
+	 */
+	FlatForest(const uint8_t *data, size_t size);
+
+	/**
+	 * @brief
+	 * Obtain the binary representation of this forest.
+	 *
+	 * @details
+	 * The format is a header (magic, version, feature, tree and node
+	 * counts) followed by the node arrays in host byte order. It is
+	 * meant to be generated at build time for the same platform
+	 * family, not exchanged between platforms.
+	 */
+	std::vector<uint8_t> serialize() const;
+
+	/** @return Number of features of one sample. */
+	unsigned int getFeatureCount() const;
+
+	/** @return Number of trees in the forest. */
+	unsigned int getTreeCount() const;
+
+	/**
+	 * @brief
+	 * Obtain the raw prediction (number of votes) for one sample.
+	 *
+	 * @param sample
+	 * getFeatureCount() feature values.
+	 */
+	float predict(const float *sample) const;
+
+	/**
+	 * @brief
+	 * Obtain raw predictions for several samples at once.
+	 *
+	 * @details
+	 * Every tree is walked for all samples before moving on to the next
+	 * tree, so the nodes of a tree are loaded into cache once per batch.
+	 * Results are identical to calling predict() per sample.
+	 *
+	 * @param samples
+	 * First feature value of the first sample.
+	 * @param count
+	 * Number of samples.
+	 * @param stride
+	 * Distance, in floats, between the first feature of two samples.
+	 * @param results
+	 * Receives `count` raw predictions.
+	 */
+	void predict(const float *samples, size_t count, size_t stride,
+	    float *results) const;
+
+    private:
+	/** Index of the leaf `sample` reaches in the tree rooted at `node`. */
+	int32_t findLeaf(int32_t node, const float *sample) const;
+
+	unsigned int featureCount {};
+
+	/** First node of every tree. */
+	std::vector<int32_t> roots;
+	/** Split feature of every node, -1 for leaves. */
+	std::vector<int32_t> features;
+	/** Split threshold; values <= threshold go to the left child. */
+	std::vector<float> thresholds;
+	/** Index of the left child; the right child follows it. */
+	std::vector<int32_t> children;
+	/** Child offset (0 or 1) taken when the feature value is missing. */
+	std::vector<uint8_t> missingDirections;
+	/** Leaf value (class label); 0 for split nodes. */
+	std::vector<double> values;
+};
+
+}}
+
+#endif /* NFIQ2_PREDICTION_FLATFOREST_H_ */
@@ -2,8 +2,11 @@
 #define NFIQ2_PREDICTION_RANDOMFORESTML_H_
 
 #include <nfiq2_constants.hpp>
+#include <nfiq2_qualitymeasures.hpp>
 #include <opencv2/ml.hpp>
+#include <prediction/FlatForest.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -42,15 +45,30 @@ class RandomForestML {
 	void evaluate(const std::unordered_map<std::string, double> &features,
 	    double &qualityValue) const;
 
+	/**
+	 * Compute NFIQ2 quality score based on model and provided native
+	 * quality measures, by position.
+	 */
+	void evaluate(
+	    const QualityMeasures::NativeQualityMeasureVector &features,
+	    double &qualityValue) const;
+
     private:
 	/** OpenCV shared smart pointer referring to the RF model itself. */
 	cv::Ptr<cv::ml::RTrees> m_pTrainedRF;
+	/**
+	 * Flattened copy of m_pTrainedRF used for prediction, or nullptr if
+	 * the model uses features FlatForest does not reproduce. With
+	 * compiled embedded parameters, this is the only model loaded.
+	 */
+	std::shared_ptr<const FlatForest> m_flatForest;
 	/** Calculates the hash of the RandomForest parameters. */
 	std::string calculateHashString(const std::string &s);
 	/** Initialize model using string parameters. */
 	void initModule(const std::string &params);
 
-#ifdef NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS
+#if defined(NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS) && \
+    !defined(NFIQ2_EMBED_COMPILED_RANDOM_FOREST_PARAMETERS)
 	/** Extracts string parameters when model is embedded. */
 	std::string joinRFTrainedParamsString();
 #endif
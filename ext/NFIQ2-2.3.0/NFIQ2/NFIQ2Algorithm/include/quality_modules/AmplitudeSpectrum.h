@@ -0,0 +1,343 @@
+#ifndef NFIQ2_QUALITYMODULES_AMPLITUDESPECTRUM_H_
+#define NFIQ2_QUALITYMODULES_AMPLITUDESPECTRUM_H_
+
+#include <nfiq2_exception.hpp>
+#include <opencv2/core/hal/hal.hpp>
+
+#include <algorithm>
+#include <array>
+
+/**
+******************************************************************************
+* @class AmplitudeSpectrumBatch
+* @brief Amplitude spectra of a batch of short real signals
+*
+* Computes |DFT(x)| of up to `Lanes` real signals of length `N` (a power of
+* two), zero-padded to `N` like cv::getOptimalDFTSize() and
+* cv::copyMakeBorder() would. Signals are stored one per lane with all
+* lanes of a bin contiguous, so every butterfly runs across the batch and
+* vectorizes without shuffles.
+*
+* The transform replays cv::dft() of a complex row of length `N`: same
+* twiddle factors (derived from the same table by the same recurrence),
+* same bit-reversed input order and same radix-4 and radix-2 butterflies,
+* with the imaginary input known to be zero. Amplitudes come from
+* cv::hal::magnitude64f(), as in cv::magnitude(), so the spectra are
+* bit-identical to those of the generic OpenCV path.
+******************************************************************************/
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+template <int N, int Lanes> class AmplitudeSpectrumBatch {
+    public:
+	static_assert((N >= 8) && (N <= 1024) && ((N & (N - 1)) == 0),
+	    "Length must be a power of two from 8 to 1024");
+	static_assert(Lanes > 0, "Batch must hold at least one signal");
+
+	/** Length of the transform */
+	static constexpr int Length { N };
+	/** Maximum number of signals in a batch */
+	static constexpr int Capacity { Lanes };
+
+	AmplitudeSpectrumBatch()
+	{
+		/* Unused lanes are transformed too; keep them finite */
+		re_.fill(0);
+		im_.fill(0);
+	}
+
+	/** @return Number of signals in the batch */
+	int size() const { return count_; }
+	/** @return true if no more signals can be added */
+	bool full() const { return count_ == Lanes; }
+	/** Empty the batch */
+	void clear() { count_ = 0; }
+
+	/**
+	 * @brief
+	 * Add a signal to the batch.
+	 *
+	 * @param signal
+	 * Samples of the signal.
+	 * @param length
+	 * Number of samples, at most `N`. Missing samples are zero.
+	 *
+	 * @throw NFIQ2::Exception
+	 * Batch is full or signal is too long.
+	 */
+	void
+	push(const double *signal, const int length)
+	{
+		if (this->full() || (length < 0) || (length > N)) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Cannot add signal to amplitude spectrum batch");
+		}
+
+		/* Load in bit-reversed order, as cv::dft() permutes */
+		const std::array<int, N> &reversed = bitReversal();
+		for (int k { 0 }; k < N; ++k) {
+			const int i { reversed[k] };
+			re_[(k * Lanes) + count_] = (i < length) ? signal[i] :
+								   0;
+		}
+		++count_;
+	}
+
+	/**
+	 * @brief
+	 * Transform all signals of the batch.
+	 *
+	 * @note
+	 * Afterwards, amplitude() returns the spectra; the signals are gone.
+	 */
+	void
+	compute()
+	{
+		const std::array<double, 2 * N> &wave = twiddles();
+		double *re = re_.data();
+		double *im = im_.data();
+
+		/* First radix-4 stage, on real input */
+		for (int i { 0 }; i < N; i += 4) {
+			double *a0 = re + (i * Lanes);
+			double *a1 = a0 + Lanes;
+			double *b0 = a1 + Lanes;
+			double *b1 = b0 + Lanes;
+			double *a1i = im + ((i + 1) * Lanes);
+			double *b1i = a1i + (2 * Lanes);
+			double *a0i = im + (i * Lanes);
+			double *b0i = a0i + (2 * Lanes);
+			for (int l { 0 }; l < Lanes; ++l) {
+				const double r1 { b0[l] + b1[l] };
+				const double i3 { b1[l] - b0[l] };
+				const double r0 { a0[l] + a1[l] };
+				const double r2 { a0[l] - a1[l] };
+				a0[l] = r0 + r1;
+				b0[l] = r0 - r1;
+				a1[l] = r2;
+				b1[l] = r2;
+				a0i[l] = 0;
+				b0i[l] = 0;
+				a1i[l] = i3;
+				b1i[l] = -i3;
+			}
+		}
+
+		/* Remaining radix-4 stages */
+		int n { 4 };
+		int dw0 { N / 4 };
+		for (; (n * 4) <= N;) {
+			const int nx { n };
+			n *= 4;
+			dw0 /= 4;
+			for (int i { 0 }; i < N; i += n) {
+				radix4(re, im, i, nx);
+				for (int j { 1 }, dw { dw0 }; j < nx;
+				     ++j, dw += dw0) {
+					radix4(re, im, i + j, nx, &wave[2 * dw],
+					    &wave[4 * dw], &wave[6 * dw]);
+				}
+			}
+		}
+
+		/* Final radix-2 stage */
+		if (n < N) {
+			const int nx { n };
+			n *= 2;
+			dw0 /= 2;
+			for (int j { 0 }, dw { 0 }; j < nx; ++j, dw += dw0) {
+				radix2(re, im, j, nx, &wave[2 * dw]);
+			}
+		}
+
+		cv::hal::magnitude64f(re, im, amplitude_.data(), N * Lanes);
+	}
+
+	/**
+	 * @return
+	 * Amplitude of `bin` in the spectrum of the `lane`th signal added,
+	 * after compute().
+	 */
+	double
+	amplitude(const int lane, const int bin) const
+	{
+		return amplitude_[(bin * Lanes) + lane];
+	}
+
+    private:
+	/** Butterfly of the first element of a radix-4 group */
+	static void
+	radix4(double *re, double *im, const int i, const int nx)
+	{
+		double *a0 = re + (i * Lanes), *a0i = im + (i * Lanes);
+		double *a1 = a0 + (nx * Lanes), *a1i = a0i + (nx * Lanes);
+		double *b0 = a1 + (nx * Lanes), *b0i = a1i + (nx * Lanes);
+		double *b1 = b0 + (nx * Lanes), *b1i = b0i + (nx * Lanes);
+		for (int l { 0 }; l < Lanes; ++l) {
+			const double r1 { b0[l] + b1[l] };
+			const double i1 { b0i[l] + b1i[l] };
+			const double r3 { b0i[l] - b1i[l] };
+			const double i3 { b1[l] - b0[l] };
+			const double r0 { a0[l] + a1[l] };
+			const double i0 { a0i[l] + a1i[l] };
+			const double r2 { a0[l] - a1[l] };
+			const double i2 { a0i[l] - a1i[l] };
+			a0[l] = r0 + r1;
+			a0i[l] = i0 + i1;
+			b0[l] = r0 - r1;
+			b0i[l] = i0 - i1;
+			a1[l] = r2 + r3;
+			a1i[l] = i2 + i3;
+			b1[l] = r2 - r3;
+			b1i[l] = i2 - i3;
+		}
+	}
+
+	/** Radix-4 butterfly with twiddles `w1`, `w2` and `w3` */
+	static void
+	radix4(double *re, double *im, const int i, const int nx,
+	    const double *w1, const double *w2, const double *w3)
+	{
+		double *a0 = re + (i * Lanes), *a0i = im + (i * Lanes);
+		double *a1 = a0 + (nx * Lanes), *a1i = a0i + (nx * Lanes);
+		double *b0 = a1 + (nx * Lanes), *b0i = a1i + (nx * Lanes);
+		double *b1 = b0 + (nx * Lanes), *b1i = b0i + (nx * Lanes);
+		for (int l { 0 }; l < Lanes; ++l) {
+			double r2 { (a1[l] * w2[0]) - (a1i[l] * w2[1]) };
+			double i2 { (a1[l] * w2[1]) + (a1i[l] * w2[0]) };
+			double r0 { (b0[l] * w1[1]) + (b0i[l] * w1[0]) };
+			double i0 { (b0[l] * w1[0]) - (b0i[l] * w1[1]) };
+			double r3 { (b1[l] * w3[1]) + (b1i[l] * w3[0]) };
+			double i3 { (b1[l] * w3[0]) - (b1i[l] * w3[1]) };
+
+			const double r1 { i0 + i3 };
+			const double i1 { r0 + r3 };
+			r3 = r0 - r3;
+			i3 = i3 - i0;
+
+			r0 = a0[l] + r2;
+			i0 = a0i[l] + i2;
+			r2 = a0[l] - r2;
+			i2 = a0i[l] - i2;
+
+			a0[l] = r0 + r1;
+			a0i[l] = i0 + i1;
+			b0[l] = r0 - r1;
+			b0i[l] = i0 - i1;
+			a1[l] = r2 + r3;
+			a1i[l] = i2 + i3;
+			b1[l] = r2 - r3;
+			b1i[l] = i2 - i3;
+		}
+	}
+
+	/** Radix-2 butterfly with twiddle `w` (none for the first element) */
+	static void
+	radix2(double *re, double *im, const int j, const int nx,
+	    const double *w)
+	{
+		double *a = re + (j * Lanes), *ai = im + (j * Lanes);
+		double *b = a + (nx * Lanes), *bi = ai + (nx * Lanes);
+		if (j == 0) {
+			for (int l { 0 }; l < Lanes; ++l) {
+				const double r0 { a[l] + b[l] };
+				const double i0 { ai[l] + bi[l] };
+				const double r1 { a[l] - b[l] };
+				const double i1 { ai[l] - bi[l] };
+				a[l] = r0;
+				ai[l] = i0;
+				b[l] = r1;
+				bi[l] = i1;
+			}
+			return;
+		}
+
+		for (int l { 0 }; l < Lanes; ++l) {
+			const double r1 { (b[l] * w[0]) - (bi[l] * w[1]) };
+			const double i1 { (bi[l] * w[0]) + (b[l] * w[1]) };
+			const double r0 { a[l] };
+			const double i0 { ai[l] };
+			a[l] = r0 + r1;
+			ai[l] = i0 + i1;
+			b[l] = r0 - r1;
+			bi[l] = i0 - i1;
+		}
+	}
+
+	/** @return Input index of every element of the transform */
+	static const std::array<int, N> &
+	bitReversal()
+	{
+		static const std::array<int, N> reversed = []() {
+			std::array<int, N> r {};
+			for (int k { 0 }; k < N; ++k) {
+				for (int bit { 1 }, rbit { N / 2 }; bit < N;
+				     bit <<= 1, rbit >>= 1) {
+					if ((k & bit) != 0) {
+						r[k] |= rbit;
+					}
+				}
+			}
+			return r;
+		}();
+		return reversed;
+	}
+
+	/**
+	 * @return
+	 * Twiddle factors exp(-2 pi i k / N), interleaved real and imaginary,
+	 * computed the way OpenCV's DFTInit() does.
+	 */
+	static const std::array<double, 2 * N> &
+	twiddles()
+	{
+		static const std::array<double, 2 * N> wave = []() {
+			/* cos and sin of 2 pi / N from OpenCV's DFTTab */
+			static const double DFTTab[][2] {
+				{ 0.70710678118654757, 0.70710678118654746 },
+				{ 0.92387953251128674, 0.38268343236508978 },
+				{ 0.98078528040323043, 0.19509032201612825 },
+				{ 0.99518472667219693, 0.09801714032956060 },
+				{ 0.99879545620517241, 0.04906767432741802 },
+				{ 0.99969881869620425, 0.02454122852291229 },
+				{ 0.99992470183914450, 0.01227153828571993 },
+				{ 0.99998117528260111, 0.00613588464915448 },
+			};
+			int m { 0 };
+			while ((1 << m) < N) {
+				++m;
+			}
+
+			const double w1re { DFTTab[m - 3][0] };
+			const double w1im { -DFTTab[m - 3][1] };
+			double wre { w1re }, wim { w1im };
+
+			std::array<double, 2 * N> w {};
+			w[0] = 1;
+			w[1] = 0;
+			w[N] = -1;
+			w[N + 1] = 0;
+			for (int i { 1 }; i < (N / 2); ++i) {
+				w[2 * i] = wre;
+				w[(2 * i) + 1] = wim;
+				w[2 * (N - i)] = wre;
+				w[(2 * (N - i)) + 1] = -wim;
+
+				const double t { (wre * w1re) - (wim * w1im) };
+				wim = (wre * w1im) + (wim * w1re);
+				wre = t;
+			}
+			return w;
+		}();
+		return wave;
+	}
+
+	std::array<double, N * Lanes> re_ {};
+	std::array<double, N * Lanes> im_ {};
+	std::array<double, N * Lanes> amplitude_ {};
+	int count_ { 0 };
+};
+
+}}
+
+#endif /* NFIQ2_QUALITYMODULES_AMPLITUDESPECTRUM_H_ */
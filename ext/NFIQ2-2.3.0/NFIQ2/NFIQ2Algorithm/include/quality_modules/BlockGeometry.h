@@ -0,0 +1,105 @@
+#ifndef NFIQ2_QUALITYMODULES_BLOCKGEOMETRY_H_
+#define NFIQ2_QUALITYMODULES_BLOCKGEOMETRY_H_
+
+#include <nfiq2_constants.hpp>
+#include <opencv2/core.hpp>
+
+/**
+******************************************************************************
+* @class BlockGeometry
+* @brief Ridge segmentation and per-block orientation of a fingerprint image
+*
+* FDA, LCS, OF and RVUPHistogram all segment the image with
+* ridgesegment() and walk the same grid of local regions (with an
+* overlapping border wide enough to extract a rotated slanted block),
+* estimating the ridge orientation of every region. This class performs
+* that work once so it can be shared by all of those modules.
+******************************************************************************/
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+class BlockGeometry {
+    public:
+	/**
+	 * @brief
+	 * Segment `img` and compute the orientation of every local region.
+	 *
+	 * @param img
+	 * 8-bit grayscale fingerprint image.
+	 * @param blocksize
+	 * Size of a (square) local region in pixels.
+	 * @param threshold
+	 * Standard deviation threshold separating foreground from background.
+	 * @param slantedBlockSizeX
+	 * Width of the slanted block extracted from each local region.
+	 * @param slantedBlockSizeY
+	 * Height of the slanted block extracted from each local region.
+	 *
+	 * @throw cv::Exception
+	 * Error during segmentation or orientation estimation.
+	 */
+	BlockGeometry(const cv::Mat &img, const int blocksize,
+	    const double threshold, const int slantedBlockSizeX,
+	    const int slantedBlockSizeY);
+
+	/**
+	 * @return
+	 * true if this geometry was computed for an image of size
+	 * `rows` x `cols` with the given parameters, false otherwise.
+	 */
+	bool isCompatible(const int rows, const int cols, const int blocksize,
+	    const double threshold, const int slantedBlockSizeX,
+	    const int slantedBlockSizeY) const;
+
+	/** @return Size of a local region in pixels */
+	int getBlockSize() const;
+	/** @return Overlapping border around each local region in pixels */
+	int getBlockOffset() const;
+	/** @return Number of rows of local regions */
+	int getMapRows() const;
+	/** @return Number of columns of local regions */
+	int getMapCols() const;
+
+	/** @return Foreground mask of the image (CV_8UC1, 0 or 255) */
+	const cv::Mat &getPixelMask() const;
+	/**
+	 * @return
+	 * 1 for local regions entirely in the foreground, 0 otherwise
+	 * (CV_8UC1, getMapRows() x getMapCols())
+	 */
+	const cv::Mat &getBlockMask() const;
+	/**
+	 * @return
+	 * Covariance coefficients (a, b, c) of the gradients of each local
+	 * region, computed with centered differences
+	 * (CV_64FC3, getMapRows() x getMapCols())
+	 */
+	const cv::Mat &getCovariance() const;
+	/**
+	 * @return
+	 * Ridge orientation of each local region in radians
+	 * (CV_64F, getMapRows() x getMapCols())
+	 */
+	const cv::Mat &getBlockOrientation() const;
+
+    private:
+	int rows_ {};
+	int cols_ {};
+	int blocksize_ {};
+	double threshold_ {};
+	int slantedBlockSizeX_ {};
+	int slantedBlockSizeY_ {};
+
+	int blkoffset_ {};
+	int mapRows_ {};
+	int mapCols_ {};
+
+	cv::Mat maskim_ {};
+	cv::Mat maskBseg_ {};
+	cv::Mat covariance_ {};
+	cv::Mat blkorient_ {};
+};
+
+}}
+
+#endif /* NFIQ2_QUALITYMODULES_BLOCKGEOMETRY_H_ */
@@ -0,0 +1,43 @@
+#ifndef NFIQ2_QUALITYMODULES_CPUDISPATCH_H_
+#define NFIQ2_QUALITYMODULES_CPUDISPATCH_H_
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief
+ * Compile a function for each instruction set that NFIQ2 dispatches to.
+ *
+ * @details
+ * The dynamic loader resolves the function once, to the variant for the
+ * best instruction set of the CPU (AVX-512, AVX2, else the baseline the
+ * library was compiled for). Only available for x86-64 ELF targets of GNU
+ * C libraries and when the build enables NFIQ2_CPU_DISPATCH_ENABLED; empty
+ * otherwise. Variants compute identical results as long as floating-point
+ * contraction is disabled (-ffp-contract=off).
+ */
+#if defined(NFIQ2_CPU_DISPATCH_ENABLED) && defined(__GNUC__) && \
+    defined(__x86_64__) && defined(__ELF__) && defined(__GLIBC__) && \
+    !defined(__ANDROID__)
+#define NFIQ2_CPU_DISPATCH \
+	__attribute__((target_clones("avx512f", "avx2", "default")))
+#define NFIQ2_CPU_DISPATCH_AVAILABLE 1
+#else
+#define NFIQ2_CPU_DISPATCH
+#define NFIQ2_CPU_DISPATCH_AVAILABLE 0
+#endif
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+/**
+ * @brief
+ * Obtain the variant of NFIQ2_CPU_DISPATCH functions used on this CPU.
+ *
+ * @return
+ * "avx512f", "avx2" or "default", chosen the way the loader chooses.
+ */
+std::string getCPUDispatchTarget();
+
+}}
+
+#endif /* NFIQ2_QUALITYMODULES_CPUDISPATCH_H_ */
@@ -2,6 +2,7 @@
 #define NFIQ2_QUALITYMODULES_FDA_H_
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
+#include <quality_modules/BlockGeometry.h>
 #include <quality_modules/Module.h>
 
 #include <string>
@@ -21,6 +22,9 @@ static double FDAHISTLIMITS[9] = { 0.268, 0.304, 0.33, 0.355, 0.38, 0.407, 0.44,
 class FDA : public Algorithm {
     public:
 	FDA(const NFIQ2::FingerprintImageData &fingerprintImage);
+	/** Reuse segmentation and orientation shared with other modules */
+	FDA(const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry &blockGeometry);
 	virtual ~FDA();
 
 	std::string getName() const override;
@@ -29,8 +33,9 @@ class FDA : public Algorithm {
 	static const char moduleName[];
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
-	    const NFIQ2::FingerprintImageData &fingerprintImage);
+	QualityMeasureValues computeFeatureData(
+	    const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry *blockGeometry);
 
 	const int blocksize { Sizes::LocalRegionSquare };
 	const double threshold { .1 };
@@ -43,7 +43,7 @@ class FJFXMinutiaeQuality : public Algorithm {
 	std::vector<FingerJetFX::Minutia> getMinutiaData() const;
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 
 	std::vector<FingerJetFX::Minutia> minutiaData_ {};
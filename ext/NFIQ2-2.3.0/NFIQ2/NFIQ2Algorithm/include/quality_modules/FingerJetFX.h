@@ -114,12 +114,9 @@ class FingerJetFX : public Algorithm {
 	std::vector<FingerJetFX::Minutia> getMinutiaData() const;
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 
-	FRFXLL_RESULT
-	createContext(FRFXLL_HANDLE_PT phContext);
-
 	std::vector<FingerJetFX::Minutia> minutiaData_ {};
 
 	FJFXROIResults computeROI(int bs,
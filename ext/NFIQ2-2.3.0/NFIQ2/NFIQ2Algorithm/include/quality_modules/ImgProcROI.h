@@ -6,6 +6,7 @@
 #include <opencv2/core.hpp>
 #include <quality_modules/Module.h>
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -25,6 +26,13 @@ class ImgProcROI : public Algorithm {
 		unsigned int noOfAllBlocks {};
 		/** detected ROI blocks with position and size */
 		std::vector<cv::Rect> vecROIBlocks {};
+		/** number of block columns in the image */
+		unsigned int noOfBlockColumns {};
+		/**
+		 * index into vecROIBlocks of every block in the image, row
+		 * by row, or -1 for blocks outside the ROI
+		 */
+		std::vector<int> roiBlockIndex {};
 		/** number of ROI pixels detected in the image (not blocks) */
 		unsigned int noOfROIPixels {};
 		/** number of pixels of the image */
@@ -33,6 +41,19 @@ class ImgProcROI : public Algorithm {
 		double meanOfROIPixels {};
 		/** standard deviation of all grayvalues of all ROI pixels */
 		double stdDevOfROIPixels {};
+
+		/**
+		 * @brief
+		 * Determine whether a block is one of vecROIBlocks, in
+		 * constant time.
+		 *
+		 * @param block
+		 * Position and size of the block.
+		 *
+		 * @return
+		 * true if vecROIBlocks contains `block`.
+		 */
+		bool isROIBlock(const cv::Rect &block) const;
 	};
 
 	ImgProcROI(const NFIQ2::FingerprintImageData &fingerprintImage);
@@ -50,12 +71,43 @@ class ImgProcROI : public Algorithm {
 	ImgProcROIResults getImgProcResults();
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 
 	ImgProcROIResults imgProcResults_ {};
 	bool imgProcComputed_ { false };
-	static bool isBlackPixelAvailable(cv::Mat &img, cv::Point &point);
+
+	/** 4-connected region of black pixels of a binary image */
+	struct BlackRegion {
+		/** number of the region this one was merged into, or its own */
+		int parent;
+		/** bounding box of the pixels */
+		int minX, minY, maxX, maxY;
+		/** number of pixels */
+		unsigned int pixels;
+		/** sum of the grayvalues of the pixels in the original image */
+		uint64_t graySum;
+	};
+
+	/**
+	 * @brief
+	 * Label the black regions of a binary image in one union-find pass.
+	 *
+	 * @param binImg
+	 * CV_8UC1 binary image, black (0) or white.
+	 * @param img
+	 * Original image, of the size of `binImg`.
+	 * @param labels
+	 * Receives, for every pixel, the index into `regions` of a region
+	 * it belongs to, or -1 for white pixels.
+	 * @param regions
+	 * Receives the regions, in the order a raster scan first meets
+	 * them. `parent` is the index of the whole region, which holds its
+	 * bounding box, size and grayvalue sum.
+	 */
+	static void labelBlackRegions(const cv::Mat &binImg,
+	    const cv::Mat &img, cv::Mat &labels,
+	    std::vector<BlackRegion> &regions);
 };
 
 }}
@@ -0,0 +1,101 @@
+#ifndef NFIQ2_QUALITYMODULES_INSTRUMENTATIONRECORD_H_
+#define NFIQ2_QUALITYMODULES_INSTRUMENTATIONRECORD_H_
+
+#include <nfiq2_instrumentation.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+******************************************************************************
+* @class InstrumentationRecord
+* @brief Measurements of the computations of an Instrumentation::Scope
+*
+* A record is current on the thread that created the scope, and on the
+* threads that thread hands work to while it is current. Quality modules
+* and prediction add to the current record, if any, so code that is not
+* measured only checks a thread-local pointer. Measurements may be added
+* from several threads at once.
+******************************************************************************/
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+class InstrumentationRecord {
+    public:
+	/**
+	 * @brief
+	 * Times a stage of the calling thread's current record, if any,
+	 * until destroyed.
+	 */
+	class StageTimer {
+	    public:
+		explicit StageTimer(const Instrumentation::Stage::Stage stage);
+		~StageTimer();
+
+		StageTimer(const StageTimer &) = delete;
+		StageTimer &operator=(const StageTimer &) = delete;
+
+	    private:
+		InstrumentationRecord *record_ {};
+		Instrumentation::Stage::Stage stage_ {};
+		std::chrono::steady_clock::time_point start_ {};
+	};
+
+	InstrumentationRecord();
+
+	InstrumentationRecord(const InstrumentationRecord &) = delete;
+	InstrumentationRecord &operator=(
+	    const InstrumentationRecord &) = delete;
+
+	/** @return Record of the calling thread, or nullptr if not measured */
+	static InstrumentationRecord *current();
+
+	/**
+	 * @brief
+	 * Make `record` (possibly nullptr) current on the calling thread.
+	 *
+	 * @return
+	 * The record that was current before.
+	 */
+	static InstrumentationRecord *setCurrent(
+	    InstrumentationRecord *record);
+
+	/** @brief Add `duration` to the time of `stage`. */
+	void addStage(const Instrumentation::Stage::Stage stage,
+	    const std::chrono::steady_clock::duration duration);
+
+	/**
+	 * @brief
+	 * Add `milliseconds` to the time of the algorithm at `position` in
+	 * getNativeQualityMeasureAlgorithmIDs().
+	 */
+	void addAlgorithm(const unsigned int position,
+	    const double milliseconds);
+
+	/** @brief Count scratch and system allocations. */
+	void addAllocations(const uint64_t scratchAllocations,
+	    const uint64_t systemAllocations);
+
+	/** @brief Record the number of local regions in the foreground. */
+	void setForegroundBlocks(const int64_t foregroundBlocks);
+
+	/** @return Measurements so far, `totalMilliseconds` excepted */
+	Instrumentation::Measurements getMeasurements() const;
+
+    private:
+	/** Nanoseconds, or -1 if not run */
+	std::array<std::atomic<int64_t>, Instrumentation::AlgorithmCount>
+	    algorithmNanoseconds_;
+	/** Nanoseconds, or -1 if not run */
+	std::array<std::atomic<int64_t>, Instrumentation::StageCount>
+	    stageNanoseconds_;
+	std::atomic<uint64_t> scratchAllocations_ { 0 };
+	std::atomic<uint64_t> systemAllocations_ { 0 };
+	std::atomic<int64_t> foregroundBlocks_ { -1 };
+};
+
+}}
+
+#endif /* NFIQ2_QUALITYMODULES_INSTRUMENTATIONRECORD_H_ */
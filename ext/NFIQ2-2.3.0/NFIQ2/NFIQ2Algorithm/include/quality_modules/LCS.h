@@ -3,6 +3,7 @@
 
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
+#include <quality_modules/BlockGeometry.h>
 #include <quality_modules/Module.h>
 
 #include <string>
@@ -16,6 +17,9 @@ static double LCSHISTLIMITS[9] = { 0, 0.70, 0.74, 0.77, 0.79, 0.81, 0.83, 0.85,
 class LCS : public Algorithm {
     public:
 	LCS(const NFIQ2::FingerprintImageData &fingerprintImage);
+	/** Reuse segmentation and orientation shared with other modules */
+	LCS(const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry &blockGeometry);
 	virtual ~LCS();
 
 	std::string getName() const override;
@@ -23,8 +27,9 @@ class LCS : public Algorithm {
 	static std::vector<std::string> getNativeQualityMeasureIDs();
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
-	    const NFIQ2::FingerprintImageData &fingerprintImage);
+	QualityMeasureValues computeFeatureData(
+	    const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry *blockGeometry);
 
 	const int blocksize { Sizes::LocalRegionSquare };
 	const double threshold { .1 };
@@ -3,12 +3,57 @@
 
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
+#include <nfiq2_qualitymeasures.hpp>
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace NFIQ2 { namespace QualityMeasures {
+
+/**
+ * Values of the native quality measures computed by one module, which are
+ * consecutive in a NativeQualityMeasureVector.
+ */
+class QualityMeasureValues {
+    public:
+	/** Most measures of one module: histogram bins, mean, and std. dev. */
+	static constexpr unsigned int MaxCount { 12 };
+
+	/**
+	 * @param first
+	 * Position of the first measure.
+	 * @param count
+	 * Number of measures, at most MaxCount.
+	 */
+	QualityMeasureValues(
+	    const NativeQualityMeasure::Index first = NativeQualityMeasure::
+		FrequencyDomainAnalysisBin0,
+	    const unsigned int count = 0);
+
+	/** @return Position of the first measure */
+	NativeQualityMeasure::Index getFirst() const;
+
+	/** @return Number of measures */
+	unsigned int getCount() const;
+
+	/**
+	 * @return Value of `measure`
+	 * @throw Exception `measure` is not one of these measures
+	 */
+	double &at(const NativeQualityMeasure::Index measure);
+	double at(const NativeQualityMeasure::Index measure) const;
+
+	/** Copy the values to their positions in `vector` */
+	void copyTo(NativeQualityMeasureVector &vector) const;
+
+    private:
+	NativeQualityMeasure::Index first;
+	unsigned int count;
+	std::array<double, MaxCount> values {};
+};
+
 class Algorithm {
     public:
 	Algorithm();
@@ -21,19 +66,21 @@ class Algorithm {
 	/** @return computed quality feature speed */
 	virtual double getSpeed() const;
 
-	/** @return computed quality features */
+	/** @return computed quality features, by identifier */
 	virtual std::unordered_map<std::string, double> getFeatures() const;
 
+	/** @return computed quality features, by position */
+	const QualityMeasureValues &getFeatureValues() const;
+
     protected:
 	void setSpeed(const double featureSpeed);
 
-	void setFeatures(
-	    const std::unordered_map<std::string, double> &featureResult);
+	void setFeatures(const QualityMeasureValues &featureResult);
 
     private:
 	double speed {};
 
-	std::unordered_map<std::string, double> features {};
+	QualityMeasureValues features {};
 };
 
 }}
@@ -25,7 +25,7 @@ class Mu : public Algorithm {
 	static std::vector<std::string> getNativeQualityMeasureIDs();
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 
 	bool sigmaComputed { false };
@@ -29,7 +29,7 @@ class OCLHistogram : public Algorithm {
 	static bool getOCLValueOfBlock(const cv::Mat &block, double &ocl);
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 };
 
@@ -3,6 +3,7 @@
 
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
+#include <quality_modules/BlockGeometry.h>
 #include <quality_modules/Module.h>
 
 #include <string>
@@ -22,6 +23,9 @@ static double OFHISTLIMITS[9] = { 1.715e-2, 3.5e-2, 5.57e-2, 8.1e-2, 1.15e-1,
 class OF : public Algorithm {
     public:
 	OF(const NFIQ2::FingerprintImageData &fingerprintImage);
+	/** Reuse segmentation and orientation shared with other modules */
+	OF(const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry &blockGeometry);
 	virtual ~OF();
 
 	std::string getName() const override;
@@ -32,8 +36,9 @@ class OF : public Algorithm {
 	static constexpr double angleMin { 4.0 };
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
-	    const NFIQ2::FingerprintImageData &fingerprintImage);
+	QualityMeasureValues computeFeatureData(
+	    const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry *blockGeometry);
 
 	/** Processing is done in subblocks of this size. */
 	const int blocksize { Sizes::LocalRegionSquare };
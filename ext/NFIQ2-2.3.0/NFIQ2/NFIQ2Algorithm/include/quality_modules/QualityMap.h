@@ -44,7 +44,7 @@ class QualityMap : public Algorithm {
 	// compute orientation map
 	static cv::Mat computeOrientationMap(cv::Mat &img, bool bFilterByROI,
 	    double &coherenceSum, double &coherenceRel, unsigned int bs,
-	    ImgProcROI::ImgProcROIResults roiResults);
+	    const ImgProcROI::ImgProcROIResults &roiResults);
 
 	// static helper functions for numberical gradient computation
 	static cv::Mat computeNumericalGradientX(const cv::Mat &mat);
@@ -52,7 +52,7 @@ class QualityMap : public Algorithm {
 	    cv::Mat &grad_x, cv::Mat &grad_y);
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
+	QualityMeasureValues computeFeatureData(
 	    const NFIQ2::FingerprintImageData &fingerprintImage);
 
 	ImgProcROI::ImgProcROIResults imgProcResults_ {};
@@ -3,6 +3,7 @@
 
 #include <nfiq2_constants.hpp>
 #include <nfiq2_fingerprintimagedata.hpp>
+#include <quality_modules/BlockGeometry.h>
 #include <quality_modules/Module.h>
 
 #include <string>
@@ -15,6 +16,9 @@ static double RVUPHISTLIMITS[9] = { 0.5, 0.667, 0.8, 1, 1.25, 1.5, 2, 24, 30 };
 class RVUPHistogram : public Algorithm {
     public:
 	RVUPHistogram(const NFIQ2::FingerprintImageData &fingerprintImage);
+	/** Reuse segmentation and orientation shared with other modules */
+	RVUPHistogram(const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry &blockGeometry);
 	virtual ~RVUPHistogram();
 
 	std::string getName() const override;
@@ -22,8 +26,9 @@ class RVUPHistogram : public Algorithm {
 	static std::vector<std::string> getNativeQualityMeasureIDs();
 
     private:
-	std::unordered_map<std::string, double> computeFeatureData(
-	    const NFIQ2::FingerprintImageData &fingerprintImage);
+	QualityMeasureValues computeFeatureData(
+	    const NFIQ2::FingerprintImageData &fingerprintImage,
+	    const BlockGeometry *blockGeometry);
 
 	const int blocksize { Sizes::LocalRegionSquare };
 	const double threshold { .1 };
@@ -0,0 +1,179 @@
+#ifndef NFIQ2_QUALITYMODULES_SCRATCHARENA_H_
+#define NFIQ2_QUALITYMODULES_SCRATCHARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+******************************************************************************
+* @class ScratchArena
+* @brief Per-thread bump allocator for the scratch memory of quality modules
+*
+* Quality modules allocate many small temporaries for every local region
+* (cv::Mat blocks, rotated and cropped blocks, DFT planes, ridge/valley
+* runs). While a ScratchArena::Scope is active on a thread, the cv::Mat
+* data and ScratchVector storage allocated on that thread are carved from
+* large blocks owned by the thread's arena instead of the system allocator.
+*
+* Every block counts the allocations that still use it. A block is reused
+* from its start once all of them are released, so per-region temporaries
+* recycle the same memory and blocks may safely outlive the scope, the
+* arena or the thread (e.g., cv::Mat shared between threads).
+******************************************************************************/
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+class ScratchArena {
+    public:
+	/** Allocation counters, accumulated over all threads */
+	struct Statistics {
+		/** Scratch allocations made while a scope was active */
+		uint64_t allocations {};
+		/**
+		 * System allocations made for those, including the blocks of
+		 * the arenas. Equal to `allocations` when disabled.
+		 */
+		uint64_t systemAllocations {};
+	};
+
+	/**
+	 * @brief
+	 * Makes the calling thread's arena current until destroyed.
+	 *
+	 * @details
+	 * When the outermost scope of a thread ends, blocks no longer in use
+	 * beyond a small reserve are returned to the system.
+	 */
+	class Scope {
+	    public:
+		Scope();
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	    private:
+		ScratchArena *previous_ {};
+	};
+
+	ScratchArena() = default;
+	~ScratchArena();
+
+	ScratchArena(const ScratchArena &) = delete;
+	ScratchArena &operator=(const ScratchArena &) = delete;
+
+	/**
+	 * @brief
+	 * Allocate scratch memory.
+	 *
+	 * @details
+	 * Memory comes from the current arena when there is one and `size`
+	 * is small enough, otherwise from the system allocator.
+	 *
+	 * @param size
+	 * Size in bytes.
+	 *
+	 * @return
+	 * Pointer aligned to Alignment bytes, to be released with release().
+	 *
+	 * @throw std::bad_alloc
+	 * Out of memory.
+	 */
+	static void *allocate(const size_t size);
+
+	/**
+	 * @brief
+	 * Release memory obtained from allocate(), on any thread.
+	 */
+	static void release(void *data);
+
+	/** @return Arena of the calling thread, or nullptr outside a scope */
+	static ScratchArena *current();
+
+	/**
+	 * @brief
+	 * Enable or disable arena allocation for all threads.
+	 *
+	 * @details
+	 * When disabled, scopes still count allocations, but all of them are
+	 * served by the system allocator.
+	 */
+	static void setEnabled(const bool enabled);
+
+	/** @return Counters accumulated since the last resetStatistics() */
+	static Statistics getStatistics();
+
+	/** @brief Zero the counters returned by getStatistics(). */
+	static void resetStatistics();
+
+	/** Alignment of all scratch allocations (cache line size) */
+	static const size_t Alignment { 64 };
+	/** Allocations larger than this are made by the system allocator */
+	static const size_t LargeAllocation { 32 * 1024 };
+
+    private:
+	struct Block;
+
+	/** Return unused blocks beyond the reserve to the system. */
+	void trim();
+
+	void *allocateFromBlock(const size_t size);
+
+	/** Block allocations are carved from */
+	Block *head_ {};
+	/** All blocks owned by this arena, including head_ */
+	std::vector<Block *> blocks_ {};
+};
+
+/**
+ * @brief
+ * Standard allocator drawing from the current ScratchArena.
+ */
+template <typename T> class ScratchAllocator {
+    public:
+	using value_type = T;
+
+	ScratchAllocator() = default;
+	template <typename U>
+	ScratchAllocator(const ScratchAllocator<U> &)
+	{
+	}
+
+	T *
+	allocate(const size_t n)
+	{
+		if (n > static_cast<size_t>(-1) / sizeof(T)) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(ScratchArena::allocate(n * sizeof(T)));
+	}
+
+	void
+	deallocate(T *p, const size_t)
+	{
+		ScratchArena::release(p);
+	}
+};
+
+template <typename T, typename U>
+bool
+operator==(const ScratchAllocator<T> &, const ScratchAllocator<U> &)
+{
+	return (true);
+}
+
+template <typename T, typename U>
+bool
+operator!=(const ScratchAllocator<T> &, const ScratchAllocator<U> &)
+{
+	return (false);
+}
+
+/** Vector of temporaries drawn from the current ScratchArena */
+template <typename T> using ScratchVector = std::vector<T, ScratchAllocator<T>>;
+
+}}
+
+#endif /* NFIQ2_QUALITYMODULES_SCRATCHARENA_H_ */
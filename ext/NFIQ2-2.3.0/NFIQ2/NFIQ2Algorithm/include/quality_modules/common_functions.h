@@ -3,11 +3,39 @@
 
 #include <nfiq2_constants.hpp>
 #include <opencv2/core.hpp>
+#include <quality_modules/Module.h>
+#include <quality_modules/ScratchArena.h>
 
+#include <array>
 #include <unordered_map>
 
 namespace NFIQ2 { namespace QualityMeasures {
 
+/**
+ * @brief
+ * Segment the ridge region of an image, one value per block.
+ *
+ * @details
+ * Same blocks and decisions as ridgesegment(), computed from integral
+ * images instead of per-block passes over a normalized copy of the image.
+ * Blocks whose standard deviation lies within rounding distance of
+ * `thresh` are measured the way ridgesegment() originally did, so the
+ * result is identical.
+ *
+ * @param Image
+ * Grayscale image.
+ * @param blksze
+ * Size of the square blocks; blocks of the last row and column may be
+ * smaller.
+ * @param thresh
+ * Threshold on the standard deviation of a block of the image normalized
+ * to zero mean and unit standard deviation.
+ * @param BlockMask
+ * Receives one CV_8UC1 value per block: 255 for ridge blocks, else 0.
+ */
+void ridgesegmentBlocks(const cv::Mat &Image, int blksze, double thresh,
+    cv::Mat &BlockMask);
+
 void ridgesegment(const cv::Mat &Image, int blksze, double thresh,
     cv::OutputArray NormImage, cv::Mat &MaskImage, cv::OutputArray MaskIndex);
 
@@ -27,11 +55,163 @@ double ocl(double a, double b, double c);
 
 uint8_t allfun(const cv::Mat &image);
 
+/**
+ * @brief
+ * Compute every element of a block map from its 3x3 neighbourhood.
+ *
+ * @details
+ * The map is padded once with `border`, then `op(above, row, below, c)`
+ * is called for every element with the padded rows above, through and
+ * below it, offset so that indices `c - 1` to `c + 1` are its
+ * neighbourhood. The whole map is one pass of plain loops, so operators
+ * simple enough to inline are vectorized across columns.
+ *
+ * @param map
+ * Single-channel block map with elements of type T.
+ * @param border
+ * Value of the neighbours outside of the map.
+ * @param result
+ * Receives the value of `op` (of type R) for every element of the map.
+ * @param op
+ * Neighbourhood operator.
+ */
+template <typename T, typename R, typename Op>
+void
+forEachNeighbourhood(const cv::Mat &map, const T border, cv::Mat &result,
+    Op op)
+{
+	cv::Mat padded;
+	cv::copyMakeBorder(map, padded, 1, 1, 1, 1, cv::BORDER_CONSTANT,
+	    cv::Scalar::all(border));
+	result.create(map.rows, map.cols, cv::DataType<R>::type);
+	for (int r = 0; r < map.rows; r++) {
+		const T *above = padded.ptr<T>(r) + 1;
+		const T *row = padded.ptr<T>(r + 1) + 1;
+		const T *below = padded.ptr<T>(r + 2) + 1;
+		R *out = result.ptr<R>(r);
+		for (int c = 0; c < map.cols; c++) {
+			out[c] = op(above, row, below, c);
+		}
+	}
+}
+
+/**
+ * @brief
+ * Mean difference between the orientation of every block and those of
+ * its 8 neighbours (0 outside the map), as
+ * `blockproc(blkorient, [1 1], @orientangdiff, 'BorderSize', [1 1])`.
+ *
+ * @param blkorient
+ * CV_64F block orientations in radians.
+ * @param loqall
+ * Receives the CV_64F mean differences, each taken the short way around
+ * the circle.
+ */
+void orientangdiff(const cv::Mat &blkorient, cv::Mat &loqall);
+
+/**
+ * @brief
+ * allfun() of the 3x3 neighbourhood of every block (0 outside the map).
+ *
+ * @param mask
+ * CV_8UC1 block mask.
+ * @param neighbourhoodMask
+ * Receives CV_8UC1 1 where a block and its 8 neighbours are nonzero,
+ * else 0.
+ */
+void allfunNeighbourhood(const cv::Mat &mask, cv::Mat &neighbourhoodMask);
+
 void getRotatedBlock(const cv::Mat &block, const double orientation,
     bool padFlag, cv::Mat &rotatedBlock);
 
-void getRidgeValleyStructure(const cv::Mat &blockCropped,
-    std::vector<uint8_t> &ridval, std::vector<double> &dt);
+typedef enum {
+	ROW_MEANS = 0,
+	COLUMN_MEANS,
+} projection_type;
+
+/**
+ * @brief
+ * Project a slanted block of a rotated block onto one of its axes.
+ *
+ * @details
+ * Same values as cropping the output of getRotatedBlock() to `rows` and
+ * `cols` and taking the cv::mean() of every row or column, without
+ * rotating the rest of the block: the nearest neighbour of every pixel of
+ * the crop is read straight from `block`, rounded the way
+ * cv::warpAffine() rounds it.
+ *
+ * @param block
+ * Square block with an even number of rows.
+ * @param orientation
+ * Rotation angle in radians.
+ * @param padFlag
+ * Whether the block is padded with 2 pixels of 0 before rotation.
+ * @param rows
+ * Rows of the rotated block to project.
+ * @param cols
+ * Columns of the rotated block to project.
+ * @param projection
+ * ROW_MEANS for one mean per row, COLUMN_MEANS for one per column.
+ * @param profile
+ * Receives the means.
+ * @param slantedBlock
+ * Receives the cropped pixels when needed, else cv::noArray().
+ */
+void getRotatedBlockProfile(const cv::Mat &block, const double orientation,
+    bool padFlag, const cv::Range &rows, const cv::Range &cols,
+    projection_type projection, ScratchVector<double> &profile,
+    cv::OutputArray slantedBlock);
+
+/**
+ * @brief
+ * Ridge/valley structure of a slanted block, from
+ * getRidgeValleyStructure().
+ *
+ * @details
+ * Sized for slanted blocks of at most `MaxLength` columns, so it needs no
+ * memory beyond its own.
+ */
+template <int MaxLength> struct RidgeValleyStructure {
+	/** Number of columns of the slanted block */
+	int length {};
+	/** Linear trend of the column means */
+	std::array<double, MaxLength> dt;
+	/** 1 for ridge columns, 0 for valley columns */
+	std::array<uint8_t, MaxLength> ridval;
+
+	/** Number of changes between ridge and valley columns */
+	int changes {};
+	/** Column after which each change occurs, increasing */
+	std::array<uint8_t, MaxLength> changeIndex;
+	/**
+	 * Columns between a change and the previous one, or changeIndex[0]
+	 * for the first: the ridge and valley widths.
+	 */
+	std::array<uint8_t, MaxLength> widths;
+};
+
+/**
+ * @brief
+ * Segment a slanted block into ridges and valleys.
+ *
+ * @details
+ * Columns darker than the least-squares line through the column means are
+ * ridges. The line is fitted with the Householder reflections that
+ * cv::solve(cv::DECOMP_QR) derives from the (constant) abscissas, which
+ * are computed once per length, and rounded to 10 decimal places.
+ *
+ * @param profile
+ * Column means of the slanted block, from getRotatedBlockProfile().
+ * @param structure
+ * Receives the trend, the ridge columns and their changes.
+ *
+ * @throw NFIQ2::Exception
+ * Fewer than two or more than `MaxLength` column means.
+ */
+template <int MaxLength>
+void getRidgeValleyStructure(const ScratchVector<double> &profile,
+    RidgeValleyStructure<MaxLength> &structure);
+
 void Conv2D(const cv::Mat &im, const cv::Mat &filter, cv::Mat &ConvOut,
     const cv::Size &imageSize, const cv::Size &dftSize);
 void GaborFilterCx(const int ksize, const double theta, const double freq,
@@ -45,10 +225,14 @@ cv::Mat computeNumericalGradientX(const cv::Mat &mat);
 void computeNumericalGradients(const cv::Mat &mat, cv::Mat &grad_x,
     cv::Mat &grad_y);
 
-void
-addHistogramFeatures(std::unordered_map<std::string, double> &featureDataList,
-    std::string featurePrefix, std::vector<double> &binBoundaries,
-    std::vector<double> &dataVector, int binCount);
+/**
+ * Add the histogram of `dataVector`, then its mean and standard deviation,
+ * to the consecutive measures starting at `firstBin`.
+ */
+void addHistogramFeatures(QualityMeasureValues &featureDataList,
+    const NativeQualityMeasure::Index firstBin,
+    std::vector<double> &binBoundaries, ScratchVector<double> &dataVector,
+    int binCount);
 void addSamplingFeatureNames(std::vector<std::string> &featureNames,
     const char *prefix);
 void addHistogramFeatureNames(std::vector<std::string> &featureNames,
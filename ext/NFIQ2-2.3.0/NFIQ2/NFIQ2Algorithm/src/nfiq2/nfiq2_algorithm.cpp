@@ -54,6 +54,13 @@ NFIQ2::Algorithm::computeUnifiedQualityScore(
 	return (this->pimpl->computeUnifiedQualityScore(features));
 }
 
+unsigned int
+NFIQ2::Algorithm::computeUnifiedQualityScore(
+    const QualityMeasures::NativeQualityMeasureVector &features) const
+{
+	return (this->pimpl->computeUnifiedQualityScore(features));
+}
+
 std::unordered_map<std::string, unsigned int>
 NFIQ2::Algorithm::getQualityBlockValues(
     const std::unordered_map<std::string, double> &nativeQualityMeasureValues)
@@ -93,6 +100,18 @@ NFIQ2::Algorithm::getEmbeddedFCT() const
 	return (this->pimpl->getEmbeddedFCT());
 }
 
+void
+NFIQ2::Algorithm::setQualityMeasureThreadCount(const unsigned int threadCount)
+{
+	this->pimpl->setQualityMeasureThreadCount(threadCount);
+}
+
+unsigned int
+NFIQ2::Algorithm::getQualityMeasureThreadCount() const
+{
+	return (this->pimpl->getQualityMeasureThreadCount());
+}
+
 NFIQ2::Algorithm::~Algorithm() = default;
 NFIQ2::Algorithm::Algorithm(NFIQ2::Algorithm &&) noexcept = default;
 NFIQ2::Algorithm &NFIQ2::Algorithm::operator=(Algorithm &&) noexcept = default;
@@ -6,6 +6,7 @@
 #include <quality_modules/FJFXMinutiaeQuality.h>
 #include <quality_modules/FingerJetFX.h>
 #include <quality_modules/ImgProcROI.h>
+#include <quality_modules/InstrumentationRecord.h>
 #include <quality_modules/LCS.h>
 #include <quality_modules/Mu.h>
 #include <quality_modules/OCLHistogram.h>
@@ -15,6 +16,7 @@
 #include <quality_modules/common_functions.h>
 
 #include "nfiq2_algorithm_impl.hpp"
+#include "nfiq2_threadpool.hpp"
 #include <iomanip>
 #include <string>
 #include <vector>
@@ -70,6 +72,24 @@ NFIQ2::Algorithm::Impl::getQualityPrediction(
 {
 	this->throwIfUninitialized();
 
+	const NFIQ2::QualityMeasures::InstrumentationRecord::StageTimer timer {
+		NFIQ2::Instrumentation::Stage::RandomForestPrediction
+	};
+	double quality {};
+	m_RandomForestML.evaluate(features, quality);
+
+	return quality;
+}
+
+double
+NFIQ2::Algorithm::Impl::getQualityPrediction(
+    const NFIQ2::QualityMeasures::NativeQualityMeasureVector &features) const
+{
+	this->throwIfUninitialized();
+
+	const NFIQ2::QualityMeasures::InstrumentationRecord::StageTimer timer {
+		NFIQ2::Instrumentation::Stage::RandomForestPrediction
+	};
 	double quality {};
 	m_RandomForestML.evaluate(features, quality);
 
@@ -83,16 +103,16 @@ NFIQ2::Algorithm::Impl::computeUnifiedQualityScore(
 {
 	this->throwIfUninitialized();
 
-	const std::unordered_map<std::string, double> quality =
-	    NFIQ2::QualityMeasures::getNativeQualityMeasures(features);
-
-	if (quality.size() == 0) {
+	if (features.empty()) {
 		// no features have been computed
 		throw NFIQ2::Exception(
 		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
 		    "No features have been computed");
 	}
 
+	const NFIQ2::QualityMeasures::NativeQualityMeasureVector quality =
+	    NFIQ2::QualityMeasures::getNativeQualityMeasureVector(features);
+
 	// ---------------------
 	// compute quality score
 	// ---------------------
@@ -121,7 +141,8 @@ NFIQ2::Algorithm::Impl::computeUnifiedQualityScore(
 	    modules {};
 	try {
 		modules = NFIQ2::QualityMeasures::
-		    computeNativeQualityMeasureAlgorithms(rawImage);
+		    computeNativeQualityMeasureAlgorithms(rawImage,
+			this->m_qualityMeasureThreadCount);
 	} catch (const NFIQ2::Exception &) {
 		throw;
 	} catch (const std::exception &e) {
@@ -134,15 +155,8 @@ NFIQ2::Algorithm::Impl::computeUnifiedQualityScore(
 		    e.what());
 	}
 
-	const std::unordered_map<std::string, double> quality =
-	    NFIQ2::QualityMeasures::getNativeQualityMeasures(modules);
-
-	if (quality.size() == 0) {
-		// no features have been computed
-		throw NFIQ2::Exception(
-		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
-		    "No features have been computed");
-	}
+	const NFIQ2::QualityMeasures::NativeQualityMeasureVector quality =
+	    NFIQ2::QualityMeasures::getNativeQualityMeasureVector(modules);
 
 	// ---------------------
 	// compute quality score
@@ -167,6 +181,15 @@ NFIQ2::Algorithm::Impl::computeUnifiedQualityScore(
 	return (unsigned int)getQualityPrediction(features);
 }
 
+unsigned int
+NFIQ2::Algorithm::Impl::computeUnifiedQualityScore(
+    const NFIQ2::QualityMeasures::NativeQualityMeasureVector &features) const
+{
+	this->throwIfUninitialized();
+
+	return (unsigned int)getQualityPrediction(features);
+}
+
 std::unordered_map<std::string, unsigned int>
 NFIQ2::Algorithm::Impl::getQualityBlockValues(
     const std::unordered_map<std::string, double> &nativeQualityMeasureValues)
@@ -234,3 +257,21 @@ NFIQ2::Algorithm::Impl::getEmbeddedFCT() const
 		"Random forest parameters did not specify FCT" };
 #endif
 }
+
+void
+NFIQ2::Algorithm::Impl::setQualityMeasureThreadCount(
+    const unsigned int threadCount)
+{
+	/* Start the workers now rather than while scoring the first image */
+	if (threadCount > 1) {
+		NFIQ2::QualityMeasures::Impl::ThreadPool::shared().reserve(
+		    threadCount - 1);
+	}
+	this->m_qualityMeasureThreadCount = threadCount;
+}
+
+unsigned int
+NFIQ2::Algorithm::Impl::getQualityMeasureThreadCount() const
+{
+	return (this->m_qualityMeasureThreadCount);
+}
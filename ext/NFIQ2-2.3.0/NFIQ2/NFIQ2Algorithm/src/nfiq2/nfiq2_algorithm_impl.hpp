@@ -59,6 +59,10 @@ class Algorithm::Impl {
 	unsigned int computeUnifiedQualityScore(
 	    const std::unordered_map<std::string, double> &algorithms) const;
 
+	unsigned int computeUnifiedQualityScore(
+	    const NFIQ2::QualityMeasures::NativeQualityMeasureVector &features)
+	    const;
+
 	std::string getParameterHash() const;
 
 	bool isEmbedded() const;
@@ -67,6 +71,10 @@ class Algorithm::Impl {
 
 	unsigned int getEmbeddedFCT() const;
 
+	void setQualityMeasureThreadCount(const unsigned int threadCount);
+
+	unsigned int getQualityMeasureThreadCount() const;
+
     private:
 	/** Indicates whether random forest parameters have been loaded. */
 	bool initialized { false };
@@ -91,6 +99,25 @@ class Algorithm::Impl {
 	    const std::unordered_map<std::string, double>
 		&nativeQualityMeasureValues) const;
 
+	/**
+	 * @brief
+	 * Retrieves unified quality score from native quality measures, by
+	 * position.
+	 *
+	 * @param nativeQualityMeasureValues
+	 * Values of all native quality measures.
+	 *
+	 * @return
+	 * Computed unified quality score.
+	 *
+	 * @throws Exception
+	 * Failure to compute (OpenCV reason contained within message string) or
+	 * called before random forest parameters loaded.
+	 */
+	double getQualityPrediction(
+	    const NFIQ2::QualityMeasures::NativeQualityMeasureVector
+		&nativeQualityMeasureValues) const;
+
 	/**
 	 * @brief
 	 * Throw an exception if random forest parameters have not been
@@ -106,6 +133,9 @@ class Algorithm::Impl {
 
 	/** RandomForest parameter md5 hash. */
 	std::string m_parameterHash {};
+
+	/** Maximum threads used to compute native quality measures. */
+	unsigned int m_qualityMeasureThreadCount { 1 };
 };
 } // namespace NFIQ2
 
@@ -2,12 +2,16 @@
 
 int debug = 0;
 
-#include <opencv2/imgproc.hpp>
+#include <nfiq2_exception.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 
 #include <cstring>
+#include <string>
+#include <vector>
 
-static double computeMuFromRow(unsigned int rowIndex, const cv::Mat &img);
-static double computeMuFromColumn(unsigned int columnIndex, const cv::Mat &img);
+static void sumRowsAndColumns(const uint8_t *pixels, uint32_t width,
+    uint32_t height, uint32_t stride, std::vector<uint32_t> &rowSums,
+    std::vector<uint32_t> &columnSums);
 
 NFIQ2::FingerprintImageData::FingerprintImageData()
     : Data()
@@ -47,12 +51,71 @@ NFIQ2::FingerprintImageData::FingerprintImageData(
 	height = otherData.height;
 	fingerCode = otherData.fingerCode;
 	ppi = otherData.ppi;
+	viewData = otherData.viewData;
+	viewSize = otherData.viewSize;
+	viewStride = otherData.viewStride;
+}
+
+NFIQ2::FingerprintImageData
+NFIQ2::FingerprintImageData::view(const uint8_t *pData, uint32_t dataSize,
+    uint32_t width, uint32_t height, uint8_t fingerCode, uint16_t ppi)
+{
+	NFIQ2::FingerprintImageData image(width, height, fingerCode, ppi);
+	image.viewData = pData;
+	image.viewSize = dataSize;
+	return image;
+}
+
+bool
+NFIQ2::FingerprintImageData::isView() const
+{
+	return (this->viewData != nullptr);
+}
+
+const uint8_t *
+NFIQ2::FingerprintImageData::pixels() const
+{
+	return (this->isView() ? this->viewData : this->data());
+}
+
+NFIQ2::FingerprintImageData::size_type
+NFIQ2::FingerprintImageData::pixelsSize() const
+{
+	return (this->isView() ? this->viewSize : this->size());
+}
+
+uint32_t
+NFIQ2::FingerprintImageData::stride() const
+{
+	return (this->viewStride != 0 ? this->viewStride : this->width);
 }
 
 NFIQ2::FingerprintImageData::~FingerprintImageData() = default;
 
 NFIQ2::FingerprintImageData
 NFIQ2::FingerprintImageData::copyRemovingNearWhiteFrame() const
+{
+	const NFIQ2::FingerprintImageData croppedView =
+	    this->viewRemovingNearWhiteFrame();
+
+	NFIQ2::FingerprintImageData croppedImage(croppedView.width,
+	    croppedView.height, croppedView.fingerCode, croppedView.ppi);
+	// copy data now
+	croppedImage.resize(
+	    static_cast<size_type>(croppedView.width) * croppedView.height);
+	for (uint32_t i = 0; i < croppedView.height; i++) {
+		std::memcpy(&croppedImage[static_cast<size_type>(i) *
+			croppedView.width],
+		    croppedView.pixels() +
+			(static_cast<size_type>(i) * croppedView.stride()),
+		    croppedView.width);
+	}
+
+	return croppedImage;
+}
+
+NFIQ2::FingerprintImageData
+NFIQ2::FingerprintImageData::viewRemovingNearWhiteFrame() const
 {
 	/**
 	 * Pixel intensity threshold used for determining whitespace
@@ -61,39 +124,39 @@ NFIQ2::FingerprintImageData::copyRemovingNearWhiteFrame() const
 	 */
 	static const double MU_THRESHOLD { 250 };
 
-	cv::Mat img;
-	try {
-		// get matrix from fingerprint image
-		img = cv::Mat(this->height, this->width, CV_8UC1,
-		    (void *)this->data());
-	} catch (const cv::Exception &e) {
-		std::stringstream ssErr;
-		ssErr << "Cannot get matrix from fingerprint image: "
-		      << e.what();
-		throw NFIQ2::Exception(
-		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
-		    ssErr.str());
-	}
+	// sum gray values (0 = black, 255 = white) of all rows and columns
+	std::vector<uint32_t> rowSums {}, columnSums {};
+	sumRowsAndColumns(this->pixels(), this->width, this->height,
+	    this->stride(), rowSums, columnSums);
+	const auto muOfRow = [&](const int rowIndex) {
+		return static_cast<double>(rowSums[rowIndex]) /
+		    static_cast<double>(this->width);
+	};
+	const auto muOfColumn = [&](const int columnIndex) {
+		return static_cast<double>(columnSums[columnIndex]) /
+		    static_cast<double>(this->height);
+	};
+	const int rows = static_cast<int>(this->height);
+	const int cols = static_cast<int>(this->width);
 
 	// start from top of image and find top row index that is already part
 	// of the fingerprint image
-	int topRowIndex { 0 }, bottomRowIndex { img.rows - 1 };
-	for (; topRowIndex < img.rows; ++topRowIndex) {
-		if (computeMuFromRow(topRowIndex, img) <= MU_THRESHOLD) {
+	int topRowIndex { 0 }, bottomRowIndex { rows - 1 };
+	for (; topRowIndex < rows; ++topRowIndex) {
+		if (muOfRow(topRowIndex) <= MU_THRESHOLD) {
 			break;
 		}
 	}
 
 	// If we traversed all rows and never found data, we can stop
-	if (topRowIndex >= img.rows) {
+	if (topRowIndex >= rows) {
 		throw NFIQ2::Exception { NFIQ2::ErrorCode::InvalidImageSize,
 			"All image rows appear to be blank" };
 	} else {
 		// start from bottom of image and find bottom row index that is
 		// already part of the fingerprint image
 		for (; bottomRowIndex >= topRowIndex; --bottomRowIndex) {
-			if (computeMuFromRow(bottomRowIndex, img) <=
-			    MU_THRESHOLD) {
+			if (muOfRow(bottomRowIndex) <= MU_THRESHOLD) {
 				break;
 			}
 		}
@@ -106,16 +169,16 @@ NFIQ2::FingerprintImageData::copyRemovingNearWhiteFrame() const
 
 	// start from left of image and find left index that is already part of
 	// the fingerprint image
-	int leftIndex { 0 }, rightIndex { img.cols - 1 };
-	for (; leftIndex < img.cols; ++leftIndex) {
-		if (computeMuFromColumn(leftIndex, img) <= MU_THRESHOLD) {
+	int leftIndex { 0 }, rightIndex { cols - 1 };
+	for (; leftIndex < cols; ++leftIndex) {
+		if (muOfColumn(leftIndex) <= MU_THRESHOLD) {
 			break;
 		}
 	}
 
 	// If we traversed all the columns, then we don't need to check starting
 	// from the other side.
-	if (leftIndex >= img.cols) {
+	if (leftIndex >= cols) {
 		// If we traversed all columns and never found data, we can stop
 		throw NFIQ2::Exception { NFIQ2::ErrorCode::InvalidImageSize,
 			"All image columns appear to be blank" };
@@ -123,8 +186,7 @@ NFIQ2::FingerprintImageData::copyRemovingNearWhiteFrame() const
 		// start from right of image and find right index that is
 		// already part of the fingerprint image
 		for (; rightIndex >= leftIndex; --rightIndex) {
-			if (computeMuFromColumn(rightIndex, img) <=
-			    MU_THRESHOLD) {
+			if (muOfColumn(rightIndex) <= MU_THRESHOLD) {
 				break;
 			}
 		}
@@ -141,75 +203,94 @@ NFIQ2::FingerprintImageData::copyRemovingNearWhiteFrame() const
 			    std::to_string(rightIndex) + ',' +
 			    std::to_string(bottomRowIndex) + ')' };
 
-	// OpenCV range upper boundaries are not included, so add 1 to index
-	const cv::Mat roiImg = img(cv::Range(topRowIndex, bottomRowIndex + 1),
-	    cv::Range(leftIndex, rightIndex + 1));
+	// upper boundaries are included, so add 1 to index
+	const uint32_t croppedWidth = rightIndex - leftIndex + 1;
+	const uint32_t croppedHeight = bottomRowIndex - topRowIndex + 1;
 
 	static const uint16_t fingerJetMaxWidth = 800;
 	static const uint16_t fingerJetMaxHeight = 1000;
 
 	// Values are from FJFX image size thresholds
-	if (roiImg.cols > fingerJetMaxWidth) {
+	if (croppedWidth > fingerJetMaxWidth) {
 		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidImageSize,
 		    "Width is too large after trimming whitespace. WxH: " +
-			std::to_string(roiImg.cols) + "x" +
-			std::to_string(roiImg.rows) +
+			std::to_string(croppedWidth) + "x" +
+			std::to_string(croppedHeight) +
 			", but maximum width is " +
 			std::to_string(fingerJetMaxWidth));
-	} else if (roiImg.rows > fingerJetMaxHeight) {
+	} else if (croppedHeight > fingerJetMaxHeight) {
 		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidImageSize,
 		    "Height is too large after trimming whitespace. WxH: " +
-			std::to_string(roiImg.cols) + "x" +
-			std::to_string(roiImg.rows) +
+			std::to_string(croppedWidth) + "x" +
+			std::to_string(croppedHeight) +
 			", but maximum height is " +
 			std::to_string(fingerJetMaxHeight));
 	}
 
-	NFIQ2::FingerprintImageData croppedImage;
-	croppedImage.height = roiImg.rows;
-	croppedImage.width = roiImg.cols;
-	croppedImage.fingerCode = this->fingerCode;
-	croppedImage.ppi = this->ppi;
-	// copy data now
-	const unsigned int size = roiImg.rows * roiImg.cols;
-	croppedImage.resize(size);
-	unsigned int counter = 0;
-	for (int i = 0; i < roiImg.rows; i++) {
-		for (int j = 0; j < roiImg.cols; j++) {
-			croppedImage.at(counter) = roiImg.at<uchar>(i, j);
-			counter++;
-		}
+	// refer to the cropped rows in place
+	const uint32_t stride = this->stride();
+	NFIQ2::FingerprintImageData croppedImage = view(this->pixels() +
+		(static_cast<size_type>(topRowIndex) * stride) + leftIndex,
+	    static_cast<uint32_t>(
+		(static_cast<size_type>(croppedHeight - 1) * stride) +
+		croppedWidth),
+	    croppedWidth, croppedHeight, this->fingerCode, this->ppi);
+	if (stride != croppedWidth) {
+		croppedImage.viewStride = stride;
 	}
 
 	return croppedImage;
 }
 
-double
-computeMuFromRow(unsigned int rowIndex, const cv::Mat &img)
+/**
+ * Sum the gray values of every row and every column of an image in a single
+ * pass over its pixels.
+ */
+void
+sumRowsAndColumns(const uint8_t *pixels, uint32_t width, uint32_t height,
+    uint32_t stride, std::vector<uint32_t> &rowSums,
+    std::vector<uint32_t> &columnSums)
 {
-	// As of last test with OpenCV 4.5.3, this is significantly faster than
-	// std::accumulate of img.row(rowIndex)
-	unsigned int mu { 0 };
-	for (int j = 0; j < img.cols; ++j) {
-		// get gray value of image (0 = black, 255 = white)
-		mu += *img.ptr<uchar>(rowIndex, j);
-	}
+	rowSums.assign(height, 0);
+	columnSums.assign(width, 0);
+	uint32_t *columns = columnSums.data();
 
-	return static_cast<double>(
-	    static_cast<double>(mu) / static_cast<double>(img.cols));
-}
+	for (uint32_t i = 0; i < height; ++i) {
+		const uint8_t *row = pixels + (static_cast<size_t>(i) * stride);
+		uint32_t rowSum { 0 };
+		uint32_t j { 0 };
+#if CV_SIMD
+		// widen 8-bit pixels to 32 bits and add them to the column
+		// sums and to per-lane row sums
+		const uint32_t lanes = cv::VTraits<cv::v_uint8>::vlanes();
+		const uint32_t quarter = lanes / 4;
+		cv::v_uint32 rowLanes = cv::vx_setzero_u32();
+		for (; j + lanes <= width; j += lanes) {
+			cv::v_uint16 low, high;
+			cv::v_expand(cv::vx_load(row + j), low, high);
+			cv::v_uint32 s0, s1, s2, s3;
+			cv::v_expand(low, s0, s1);
+			cv::v_expand(high, s2, s3);
 
-double
-computeMuFromColumn(unsigned int columnIndex, const cv::Mat &img)
-{
-	// As of last test with OpenCV 4.5.3, this is significantly faster than
-	// std::accumulate of img.col(columnIndex)
-	unsigned int mu { 0 };
-	for (int i = 0; i < img.rows; ++i) {
-		// get gray value of image (0 = black, 255 = white)
-		mu += *img.ptr<uchar>(i, columnIndex);
+			uint32_t *c = columns + j;
+			cv::v_store(c, cv::v_add(cv::vx_load(c), s0));
+			cv::v_store(c + quarter,
+			    cv::v_add(cv::vx_load(c + quarter), s1));
+			cv::v_store(c + (2 * quarter),
+			    cv::v_add(cv::vx_load(c + (2 * quarter)), s2));
+			cv::v_store(c + (3 * quarter),
+			    cv::v_add(cv::vx_load(c + (3 * quarter)), s3));
+			rowLanes = cv::v_add(rowLanes, s0, s1, s2, s3);
+		}
+		rowSum = cv::v_reduce_sum(rowLanes);
+#endif
+		for (; j < width; ++j) {
+			columns[j] += row[j];
+			rowSum += row[j];
+		}
+		rowSums[i] = rowSum;
 	}
-
-	return static_cast<double>(
-	    static_cast<double>(mu) / static_cast<double>(img.rows));
+#if CV_SIMD
+	cv::vx_cleanup();
+#endif
 }
@@ -0,0 +1,274 @@
+#include <nfiq2_instrumentation.hpp>
+#include <nfiq2_qualitymeasures.hpp>
+#include <quality_modules/InstrumentationRecord.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Distribution of one measurement. Bucket i counts values in
+ * (2^(i - 1 + MinExponent), 2^(i + MinExponent)], the first bucket values up
+ * to 2^MinExponent, and the last one everything larger.
+ */
+struct Histogram {
+	static const int MinExponent { -4 };
+	static const int BucketCount { 30 };
+
+	uint64_t count {};
+	double sum {};
+	double min { std::numeric_limits<double>::infinity() };
+	double max { -std::numeric_limits<double>::infinity() };
+	std::array<uint64_t, BucketCount> buckets {};
+
+	void
+	add(const double value)
+	{
+		++this->count;
+		this->sum += value;
+		this->min = std::min(this->min, value);
+		this->max = std::max(this->max, value);
+
+		int bucket { 0 };
+		if (value > std::ldexp(1.0, MinExponent)) {
+			bucket = std::min(BucketCount - 1,
+			    static_cast<int>(std::ceil(std::log2(value))) -
+				MinExponent);
+		}
+		++this->buckets[bucket];
+	}
+
+	/** @return Upper bound of `bucket`, infinity for the last one */
+	static double
+	upperBound(const int bucket)
+	{
+		if (bucket == BucketCount - 1) {
+			return (std::numeric_limits<double>::infinity());
+		}
+		return (std::ldexp(1.0, bucket + MinExponent));
+	}
+};
+
+/** Position of the measurements in Histograms::histograms */
+const unsigned int TotalPosition { 0 };
+const unsigned int AlgorithmPosition { 1 };
+const unsigned int StagePosition { AlgorithmPosition +
+	NFIQ2::Instrumentation::AlgorithmCount };
+const unsigned int ScratchAllocationsPosition { StagePosition +
+	NFIQ2::Instrumentation::StageCount };
+const unsigned int SystemAllocationsPosition { ScratchAllocationsPosition +
+	1 };
+const unsigned int ForegroundBlocksPosition { SystemAllocationsPosition +
+	1 };
+const unsigned int HistogramCount { ForegroundBlocksPosition + 1 };
+
+/** Process-wide histograms of the measurements of every Scope */
+struct Histograms {
+	std::mutex lock {};
+	std::array<Histogram, HistogramCount> histograms {};
+};
+
+Histograms &
+processHistograms()
+{
+	static Histograms histograms {};
+	return (histograms);
+}
+
+/** @return Names of Histograms::histograms, by position */
+const std::vector<std::string> &
+histogramNames()
+{
+	static const std::vector<std::string> names = []() {
+		std::vector<std::string> names { "Total" };
+		for (const auto &id : NFIQ2::QualityMeasures::
+			 getNativeQualityMeasureAlgorithmIDs()) {
+			names.push_back(id);
+		}
+		for (const char *id :
+		    NFIQ2::Instrumentation::StageIdentifiers) {
+			names.push_back(id);
+		}
+		names.push_back("ScratchAllocations");
+		names.push_back("SystemAllocations");
+		names.push_back("ForegroundBlocks");
+		return (names);
+	}();
+
+	return (names);
+}
+
+/** @brief Add `measurements` to the process-wide histograms. */
+void
+addToHistograms(const NFIQ2::Instrumentation::Measurements &measurements)
+{
+	Histograms &histograms = processHistograms();
+	const std::lock_guard<std::mutex> guard(histograms.lock);
+
+	/* NaN and negative values were not measured */
+	const auto add = [&](const unsigned int position, const double value) {
+		if (value >= 0) {
+			histograms.histograms[position].add(value);
+		}
+	};
+
+	add(TotalPosition, measurements.totalMilliseconds);
+	for (unsigned int i { 0 }; i < NFIQ2::Instrumentation::AlgorithmCount;
+	     ++i) {
+		add(AlgorithmPosition + i,
+		    measurements.algorithmMilliseconds[i]);
+	}
+	for (unsigned int i { 0 }; i < NFIQ2::Instrumentation::StageCount;
+	     ++i) {
+		add(StagePosition + i, measurements.stageMilliseconds[i]);
+	}
+	add(ScratchAllocationsPosition,
+	    static_cast<double>(measurements.scratchAllocations));
+	add(SystemAllocationsPosition,
+	    static_cast<double>(measurements.systemAllocations));
+	add(ForegroundBlocksPosition,
+	    static_cast<double>(measurements.foregroundBlocks));
+}
+
+/** @return Copy of the process-wide histograms */
+std::array<Histogram, HistogramCount>
+copyHistograms()
+{
+	Histograms &histograms = processHistograms();
+	const std::lock_guard<std::mutex> guard(histograms.lock);
+
+	return (histograms.histograms);
+}
+
+}
+
+/** Internal implementation of NFIQ2::Instrumentation::Scope */
+class NFIQ2::Instrumentation::Scope::Impl {
+    public:
+	NFIQ2::QualityMeasures::InstrumentationRecord record {};
+	NFIQ2::QualityMeasures::InstrumentationRecord *previous {};
+	std::chrono::steady_clock::time_point start {
+		std::chrono::steady_clock::now()
+	};
+};
+
+NFIQ2::Instrumentation::Scope::Scope()
+    : pimpl { new NFIQ2::Instrumentation::Scope::Impl() }
+{
+	this->pimpl->previous =
+	    NFIQ2::QualityMeasures::InstrumentationRecord::setCurrent(
+		&this->pimpl->record);
+}
+
+NFIQ2::Instrumentation::Scope::~Scope()
+{
+	NFIQ2::QualityMeasures::InstrumentationRecord::setCurrent(
+	    this->pimpl->previous);
+	try {
+		addToHistograms(this->getMeasurements());
+	} catch (...) {
+		/* measurements are best effort */
+	}
+}
+
+NFIQ2::Instrumentation::Measurements
+NFIQ2::Instrumentation::Scope::getMeasurements() const
+{
+	Measurements measurements = this->pimpl->record.getMeasurements();
+	measurements.totalMilliseconds =
+	    std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - this->pimpl->start)
+		.count();
+
+	return (measurements);
+}
+
+std::string
+NFIQ2::Instrumentation::getHistogramsText()
+{
+	const auto histograms = copyHistograms();
+	const auto &names = histogramNames();
+
+	std::ostringstream text {};
+	for (unsigned int i { 0 }; i < HistogramCount; ++i) {
+		const Histogram &histogram = histograms[i];
+		text << names[i] << " count=" << histogram.count;
+		if (histogram.count > 0) {
+			text << " sum=" << histogram.sum
+			     << " min=" << histogram.min
+			     << " max=" << histogram.max << " mean="
+			     << histogram.sum /
+				static_cast<double>(histogram.count);
+		}
+		for (int b { 0 }; b < Histogram::BucketCount; ++b) {
+			if (histogram.buckets[b] > 0) {
+				text << " le" << Histogram::upperBound(b) << "="
+				     << histogram.buckets[b];
+			}
+		}
+		text << "\n";
+	}
+
+	return (text.str());
+}
+
+std::string
+NFIQ2::Instrumentation::getHistogramsJSON()
+{
+	const auto histograms = copyHistograms();
+	const auto &names = histogramNames();
+
+	/* JSON has no infinity */
+	const auto number = [](const double value) {
+		std::ostringstream text {};
+		if (std::isfinite(value)) {
+			text << value;
+		} else {
+			text << "null";
+		}
+		return (text.str());
+	};
+
+	std::ostringstream json {};
+	json << "{";
+	for (unsigned int i { 0 }; i < HistogramCount; ++i) {
+		const Histogram &histogram = histograms[i];
+		json << (i == 0 ? "" : ",") << "\"" << names[i] << "\":{"
+		     << "\"count\":" << histogram.count
+		     << ",\"sum\":" << number(histogram.sum)
+		     << ",\"min\":" << number(histogram.min)
+		     << ",\"max\":" << number(histogram.max)
+		     << ",\"buckets\":[";
+		bool first { true };
+		for (int b { 0 }; b < Histogram::BucketCount; ++b) {
+			if (histogram.buckets[b] == 0) {
+				continue;
+			}
+			json << (first ? "" : ",")
+			     << "{\"le\":" << number(Histogram::upperBound(b))
+			     << ",\"count\":" << histogram.buckets[b] << "}";
+			first = false;
+		}
+		json << "]}";
+	}
+	json << "}";
+
+	return (json.str());
+}
+
+void
+NFIQ2::Instrumentation::resetHistograms()
+{
+	Histograms &histograms = processHistograms();
+	const std::lock_guard<std::mutex> guard(histograms.lock);
+
+	histograms.histograms = {};
+}
@@ -0,0 +1,68 @@
+#include <nfiq2_lazyqualitymeasures.hpp>
+
+#include "nfiq2_lazyqualitymeasures_impl.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::LazyQualityMeasures(
+    const NFIQ2::FingerprintImageData &rawImage)
+    : pimpl { new NFIQ2::QualityMeasures::LazyQualityMeasures::Impl(
+	  rawImage, true) }
+{
+}
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::LazyQualityMeasures(
+    LazyQualityMeasures &&) noexcept = default;
+
+NFIQ2::QualityMeasures::LazyQualityMeasures &
+NFIQ2::QualityMeasures::LazyQualityMeasures::operator=(
+    LazyQualityMeasures &&) noexcept = default;
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::~LazyQualityMeasures() =
+    default;
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::LazyQualityMeasures::computeAlgorithms(
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount)
+{
+	return (this->pimpl->computeAlgorithms(algorithmIDs, threadCount));
+}
+
+std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::LazyQualityMeasures::computeNativeQualityMeasures(
+    const std::vector<std::string> &qualityMeasureIDs,
+    const unsigned int threadCount)
+{
+	return (this->pimpl->computeNativeQualityMeasures(qualityMeasureIDs,
+	    threadCount));
+}
+
+std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::LazyQualityMeasures::computeActionableQualityFeedback(
+    const unsigned int threadCount)
+{
+	return (this->pimpl->computeActionableQualityFeedback(threadCount));
+}
+
+bool
+NFIQ2::QualityMeasures::LazyQualityMeasures::triage(
+    const TriagePolicy &policy)
+{
+	return (this->pimpl->triage(policy));
+}
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::LazyQualityMeasures::getComputedAlgorithms() const
+{
+	return (this->pimpl->getComputedAlgorithms());
+}
+
+NFIQ2::QualityMeasures::NativeQualityMeasureVector
+NFIQ2::QualityMeasures::LazyQualityMeasures::getComputedNativeQualityMeasures()
+    const
+{
+	return (this->pimpl->getComputedNativeQualityMeasures());
+}
@@ -0,0 +1,492 @@
+#include <nfiq2_exception.hpp>
+#include <nfiq2_fingerprintimagedata.hpp>
+#include <nfiq2_lazyqualitymeasures.hpp>
+#include <quality_modules/BlockGeometry.h>
+#include <quality_modules/FDA.h>
+#include <quality_modules/FJFXMinutiaeQuality.h>
+#include <quality_modules/FingerJetFX.h>
+#include <quality_modules/ImgProcROI.h>
+#include <quality_modules/InstrumentationRecord.h>
+#include <quality_modules/LCS.h>
+#include <quality_modules/Module.h>
+#include <quality_modules/Mu.h>
+#include <quality_modules/OCLHistogram.h>
+#include <quality_modules/OF.h>
+#include <quality_modules/QualityMap.h>
+#include <quality_modules/RVUPHistogram.h>
+#include <quality_modules/ScratchArena.h>
+
+#include "nfiq2_lazyqualitymeasures_impl.hpp"
+#include "nfiq2_qualitymeasures_impl.hpp"
+#include "nfiq2_taskgraph.hpp"
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static_assert(NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::SlotCount ==
+	NFIQ2::Instrumentation::AlgorithmCount,
+    "Instrumentation must measure every native quality measure algorithm");
+
+/**
+ * @return
+ * `image` without its near-white frame, timed as Stage::Crop, or a view of
+ * the whole of `image` if it cannot be cropped, the exception being stored
+ * in `error`.
+ */
+static NFIQ2::FingerprintImageData
+cropNearWhiteFrame(const NFIQ2::FingerprintImageData &image,
+    std::exception_ptr &error)
+{
+	const NFIQ2::QualityMeasures::InstrumentationRecord::StageTimer timer {
+		NFIQ2::Instrumentation::Stage::Crop
+	};
+	try {
+		return (image.viewRemovingNearWhiteFrame());
+	} catch (const NFIQ2::Exception &) {
+		error = std::current_exception();
+		return (NFIQ2::FingerprintImageData::view(image.pixels(),
+		    static_cast<uint32_t>(image.pixelsSize()), image.width,
+		    image.height, image.fingerCode, image.ppi));
+	}
+}
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::Impl(
+    const NFIQ2::FingerprintImageData &rawImage, const bool copyImage)
+    : ownedImage { copyImage ? rawImage : NFIQ2::FingerprintImageData {} }
+    , croppedImage { cropNearWhiteFrame(copyImage ? ownedImage : rawImage,
+	  cropError) }
+{
+}
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::Slot
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::getSlot(
+    const std::string &algorithmID)
+{
+	static const std::vector<std::string> ids =
+	    NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithmIDs();
+	for (unsigned int slot { 0 }; slot < ids.size(); ++slot) {
+		if (ids[slot] == algorithmID) {
+			return (static_cast<Slot>(slot));
+		}
+	}
+
+	throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+	    "Unknown quality measure algorithm: " + algorithmID);
+}
+
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::Slot
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::getQualityMeasureSlot(
+    const std::string &qualityMeasureID)
+{
+	static const std::unordered_map<std::string, Slot> slots = []() {
+		const std::array<std::vector<std::string>, SlotCount> ids {
+			FDA::getNativeQualityMeasureIDs(),
+			FingerJetFX::getNativeQualityMeasureIDs(),
+			FJFXMinutiaeQuality::getNativeQualityMeasureIDs(),
+			ImgProcROI::getNativeQualityMeasureIDs(),
+			LCS::getNativeQualityMeasureIDs(),
+			Mu::getNativeQualityMeasureIDs(),
+			OCLHistogram::getNativeQualityMeasureIDs(),
+			OF::getNativeQualityMeasureIDs(),
+			QualityMap::getNativeQualityMeasureIDs(),
+			RVUPHistogram::getNativeQualityMeasureIDs()
+		};
+
+		std::unordered_map<std::string, Slot> map {};
+		for (unsigned int slot { 0 }; slot < SlotCount; ++slot) {
+			for (const auto &id : ids[slot]) {
+				map[id] = static_cast<Slot>(slot);
+			}
+		}
+		return (map);
+	}();
+
+	const auto slot = slots.find(qualityMeasureID);
+	if (slot == slots.cend()) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+		    "Unknown native quality measure: " + qualityMeasureID);
+	}
+
+	return (slot->second);
+}
+
+/**
+ * @brief
+ * Segment and orient the local regions of `croppedImage` once for FDA, LCS,
+ * OF, and RVUPHistogram, which all use the same block grid.
+ */
+static std::unique_ptr<NFIQ2::QualityMeasures::BlockGeometry>
+computeSharedBlockGeometry(const NFIQ2::FingerprintImageData &croppedImage)
+{
+	if (croppedImage.ppi != NFIQ2::FingerprintImageData::Resolution500PPI) {
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
+		    "Only 500 dpi fingerprint images are supported!");
+	}
+
+	try {
+		const cv::Mat img(croppedImage.height, croppedImage.width,
+		    CV_8UC1, (void *)croppedImage.pixels(),
+		    croppedImage.stride());
+
+		std::unique_ptr<NFIQ2::QualityMeasures::BlockGeometry>
+		    blockGeometry {};
+		{
+			const NFIQ2::QualityMeasures::InstrumentationRecord::
+			    StageTimer timer {
+				    NFIQ2::Instrumentation::Stage::BlockGeometry
+			    };
+			blockGeometry.reset(
+			    new NFIQ2::QualityMeasures::BlockGeometry(img,
+				NFIQ2::Sizes::LocalRegionSquare, .1,
+				NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth,
+				NFIQ2::Sizes::
+				    VerticallyAlignedLocalRegionHeight));
+		}
+
+		auto *const record =
+		    NFIQ2::QualityMeasures::InstrumentationRecord::current();
+		if (record != nullptr) {
+			record->setForegroundBlocks(
+			    cv::countNonZero(blockGeometry->getBlockMask()));
+		}
+
+		return (blockGeometry);
+	} catch (const cv::Exception &e) {
+		std::stringstream ssErr;
+		ssErr << "Cannot compute block geometry: " << e.what();
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
+		    ssErr.str());
+	}
+}
+
+/** @return Whether the algorithm of `slot` uses the shared local regions */
+static bool
+usesBlockGeometry(
+    const NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::Slot slot)
+{
+	using Impl = NFIQ2::QualityMeasures::LazyQualityMeasures::Impl;
+	return ((slot == Impl::FDASlot) || (slot == Impl::LCSSlot) ||
+	    (slot == Impl::OFSlot) || (slot == Impl::RVUPHistogramSlot));
+}
+
+void
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::computeSlot(
+    const Slot slot)
+{
+	auto *const record = InstrumentationRecord::current();
+	if (record == nullptr) {
+		constructSlot(slot);
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	constructSlot(slot);
+	record->addAlgorithm(slot,
+	    std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start)
+		.count());
+}
+
+void
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::constructSlot(
+    const Slot slot)
+{
+	switch (slot) {
+	case FDASlot:
+		algorithms[slot] = std::make_shared<FDA>(croppedImage,
+		    *blockGeometry);
+		break;
+	case FingerJetFXSlot:
+		fjfxFeatureModule = std::make_shared<FingerJetFX>(croppedImage);
+		algorithms[slot] = fjfxFeatureModule;
+		break;
+	case FJFXMinutiaeQualitySlot:
+		algorithms[slot] = std::make_shared<FJFXMinutiaeQuality>(
+		    croppedImage, fjfxFeatureModule->getMinutiaData());
+		break;
+	case ImgProcROISlot:
+		roiFeatureModule = std::make_shared<ImgProcROI>(croppedImage);
+		algorithms[slot] = roiFeatureModule;
+		break;
+	case LCSSlot:
+		algorithms[slot] = std::make_shared<LCS>(croppedImage,
+		    *blockGeometry);
+		break;
+	case MuSlot:
+		algorithms[slot] = std::make_shared<Mu>(croppedImage);
+		break;
+	case OCLHistogramSlot:
+		algorithms[slot] = std::make_shared<OCLHistogram>(croppedImage);
+		break;
+	case OFSlot:
+		algorithms[slot] = std::make_shared<OF>(croppedImage,
+		    *blockGeometry);
+		break;
+	case QualityMapSlot:
+		algorithms[slot] = std::make_shared<QualityMap>(croppedImage,
+		    roiFeatureModule->getImgProcResults());
+		break;
+	case RVUPHistogramSlot:
+		algorithms[slot] = std::make_shared<RVUPHistogram>(
+		    croppedImage, *blockGeometry);
+		break;
+	case SlotCount:
+		break;
+	}
+}
+
+void
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::compute(SlotSet slots,
+    const unsigned int threadCount)
+{
+	if (slots[FJFXMinutiaeQualitySlot]) {
+		slots[FingerJetFXSlot] = true;
+	}
+	if (slots[QualityMapSlot]) {
+		slots[ImgProcROISlot] = true;
+	}
+
+	/* no algorithm runs on an image that could not be cropped */
+	if (cropError) {
+		std::rethrow_exception(cropError);
+	}
+
+	/* only what was not computed by earlier requests */
+	bool missing { false };
+	bool missingGeometry { false };
+	for (unsigned int slot { 0 }; slot < SlotCount; ++slot) {
+		slots[slot] = slots[slot] && !algorithms[slot];
+		missing = missing || slots[slot];
+		missingGeometry = missingGeometry ||
+		    (slots[slot] && !blockGeometry &&
+			usesBlockGeometry(static_cast<Slot>(slot)));
+	}
+	if (!missing) {
+		return;
+	}
+
+	/* draw module temporaries from the arena of the executing thread */
+	const ScratchArena::Scope scratchScope {};
+
+	/* use double-precision rounding for 32-bit linux */
+	NFIQ2::QualityMeasures::Impl::setFPU(0x27F);
+
+	if (threadCount < 2) {
+		/* in Slot order, so dependencies come first */
+		for (unsigned int slot { 0 }; slot < SlotCount; ++slot) {
+			if (!slots[slot]) {
+				continue;
+			}
+			if (usesBlockGeometry(static_cast<Slot>(slot)) &&
+			    !blockGeometry) {
+				blockGeometry =
+				    computeSharedBlockGeometry(croppedImage);
+			}
+			computeSlot(static_cast<Slot>(slot));
+		}
+		return;
+	}
+
+	/*
+	 * Only FJFXMinutiaeQuality (on FingerJetFX), QualityMap (on
+	 * ImgProcROI) and the modules sharing the block geometry need to wait
+	 * on another task, and only if it is computed in this request.
+	 */
+	NFIQ2::QualityMeasures::Impl::TaskGraph graph {};
+	std::vector<std::size_t> geometryTask {};
+	if (missingGeometry) {
+		geometryTask.push_back(graph.add([this]() {
+			blockGeometry =
+			    computeSharedBlockGeometry(croppedImage);
+		}));
+	}
+	std::vector<std::size_t> fjfxTask {};
+	if (slots[FingerJetFXSlot]) {
+		fjfxTask.push_back(
+		    graph.add([this]() { computeSlot(FingerJetFXSlot); }));
+	}
+	std::vector<std::size_t> roiTask {};
+	if (slots[ImgProcROISlot]) {
+		roiTask.push_back(
+		    graph.add([this]() { computeSlot(ImgProcROISlot); }));
+	}
+
+	for (unsigned int s { 0 }; s < SlotCount; ++s) {
+		const Slot slot { static_cast<Slot>(s) };
+		if (!slots[slot] || (slot == FingerJetFXSlot) ||
+		    (slot == ImgProcROISlot)) {
+			continue;
+		}
+		std::vector<std::size_t> dependencies {};
+		if (usesBlockGeometry(slot)) {
+			dependencies = geometryTask;
+		} else if (slot == FJFXMinutiaeQualitySlot) {
+			dependencies = fjfxTask;
+		} else if (slot == QualityMapSlot) {
+			dependencies = roiTask;
+		}
+		graph.add([this, slot]() { computeSlot(slot); }, dependencies);
+	}
+
+	/* helper threads add to the measurements of the calling thread */
+	auto *const record = InstrumentationRecord::current();
+	graph.run(threadCount, [record](const std::function<void()> &work) {
+		NFIQ2::QualityMeasures::Impl::setFPU(0x27F);
+		const ScratchArena::Scope scratchScope {};
+		auto *const previous = InstrumentationRecord::setCurrent(
+		    record);
+		work();
+		InstrumentationRecord::setCurrent(previous);
+	});
+}
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::computeAlgorithms(
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount)
+{
+	SlotSet slots {};
+	for (const auto &id : algorithmIDs) {
+		slots[getSlot(id)] = true;
+	}
+	compute(slots, threadCount);
+
+	return (getAlgorithms(slots));
+}
+
+std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::
+    computeNativeQualityMeasures(
+	const std::vector<std::string> &qualityMeasureIDs,
+	const unsigned int threadCount)
+{
+	SlotSet slots {};
+	for (const auto &id : qualityMeasureIDs) {
+		slots[getQualityMeasureSlot(id)] = true;
+	}
+	compute(slots, threadCount);
+
+	const NativeQualityMeasureVector values =
+	    getComputedNativeQualityMeasures();
+	std::unordered_map<std::string, double> measures {};
+	for (const auto &id : qualityMeasureIDs) {
+		for (unsigned int i { 0 }; i < NativeQualityMeasureCount; ++i) {
+			if (id == NativeQualityMeasureIdentifiers[i]) {
+				measures[id] = values[i];
+				break;
+			}
+		}
+	}
+
+	return (measures);
+}
+
+std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::
+    computeActionableQualityFeedback(const unsigned int threadCount)
+{
+	SlotSet slots {};
+	for (const auto &id : NFIQ2::QualityMeasures::Impl::
+		 getActionableQualityFeedbackAlgorithmIDs()) {
+		slots[getSlot(id)] = true;
+	}
+	compute(slots, threadCount);
+
+	return (NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
+	    getAlgorithms(slots)));
+}
+
+bool
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::triage(
+    const TriagePolicy &policy)
+{
+	/*
+	 * An image whose rows or columns are all near-white, like an empty
+	 * platen, has no frame to crop: Mu of the whole image tells whether it
+	 * meets the uniform or empty image conditions. Otherwise it fails as
+	 * it would without triage.
+	 */
+	if (cropError) {
+		if (!algorithms[MuSlot]) {
+			const ScratchArena::Scope scratchScope {};
+			NFIQ2::QualityMeasures::Impl::setFPU(0x27F);
+			computeSlot(MuSlot);
+		}
+		if (NFIQ2::QualityMeasures::Impl::isTriaged(policy,
+			NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
+			    getComputedAlgorithms()))) {
+			return (true);
+		}
+		std::rethrow_exception(cropError);
+	}
+
+	/*
+	 * Mu, which is cheap, for the uniform and empty image conditions,
+	 * then ImgProcROI, the most expensive module, only if the foreground
+	 * condition needs it.
+	 */
+	SlotSet slots {};
+	slots[MuSlot] = true;
+	compute(slots, 1);
+	if (NFIQ2::QualityMeasures::Impl::isTriaged(policy,
+		NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
+		    getComputedAlgorithms()))) {
+		return (true);
+	}
+
+	if (policy.stopOnInsufficientForeground) {
+		slots[ImgProcROISlot] = true;
+		compute(slots, 1);
+	}
+
+	return (NFIQ2::QualityMeasures::Impl::isTriaged(policy,
+	    NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
+		getComputedAlgorithms())));
+}
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::getAlgorithms(
+    const SlotSet &slots) const
+{
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	    computed {};
+	for (unsigned int slot { 0 }; slot < SlotCount; ++slot) {
+		if (slots[slot] && algorithms[slot]) {
+			computed.push_back(algorithms[slot]);
+		}
+	}
+
+	return (computed);
+}
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::getComputedAlgorithms()
+    const
+{
+	SlotSet slots {};
+	slots.fill(true);
+
+	return (getAlgorithms(slots));
+}
+
+NFIQ2::QualityMeasures::NativeQualityMeasureVector
+NFIQ2::QualityMeasures::LazyQualityMeasures::Impl::
+    getComputedNativeQualityMeasures() const
+{
+	NativeQualityMeasureVector values {};
+	values.fill(std::numeric_limits<double>::quiet_NaN());
+	for (const auto &algorithm : algorithms) {
+		if (algorithm) {
+			algorithm->getFeatureValues().copyTo(values);
+		}
+	}
+
+	return (values);
+}
@@ -0,0 +1,120 @@
+#ifndef NFIQ2_LAZYQUALITYMEASURES_IMPL_HPP_
+#define NFIQ2_LAZYQUALITYMEASURES_IMPL_HPP_
+
+#include <nfiq2_fingerprintimagedata.hpp>
+#include <nfiq2_lazyqualitymeasures.hpp>
+#include <nfiq2_qualitymeasures.hpp>
+#include <quality_modules/BlockGeometry.h>
+#include <quality_modules/FingerJetFX.h>
+#include <quality_modules/ImgProcROI.h>
+#include <quality_modules/Module.h>
+
+#include <array>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NFIQ2 { namespace QualityMeasures {
+
+/** Internal implementation of NFIQ2::QualityMeasures::LazyQualityMeasures */
+class LazyQualityMeasures::Impl {
+    public:
+	/** Positions of algorithms, in getNativeQualityMeasureAlgorithmIDs() */
+	enum Slot : unsigned int {
+		FDASlot,
+		FingerJetFXSlot,
+		FJFXMinutiaeQualitySlot,
+		ImgProcROISlot,
+		LCSSlot,
+		MuSlot,
+		OCLHistogramSlot,
+		OFSlot,
+		QualityMapSlot,
+		RVUPHistogramSlot,
+		SlotCount
+	};
+
+	/** Algorithms to compute, by Slot */
+	using SlotSet = std::array<bool, SlotCount>;
+
+	/**
+	 * @param rawImage
+	 * Fingerprint image in raw format.
+	 * @param copyImage
+	 * Whether to keep a copy of `rawImage`. Otherwise, `rawImage` must
+	 * outlive this object.
+	 */
+	Impl(const NFIQ2::FingerprintImageData &rawImage,
+	    const bool copyImage);
+
+	/** @return Slot of algorithm `algorithmID` */
+	static Slot getSlot(const std::string &algorithmID);
+
+	/** @return Slot of the algorithm computing `qualityMeasureID` */
+	static Slot getQualityMeasureSlot(const std::string &qualityMeasureID);
+
+	/**
+	 * @brief
+	 * Compute the algorithms of `slots` and those they depend on, unless
+	 * already computed.
+	 */
+	void compute(SlotSet slots, const unsigned int threadCount);
+
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	computeAlgorithms(const std::vector<std::string> &algorithmIDs,
+	    const unsigned int threadCount);
+
+	std::unordered_map<std::string, double> computeNativeQualityMeasures(
+	    const std::vector<std::string> &qualityMeasureIDs,
+	    const unsigned int threadCount);
+
+	std::unordered_map<std::string, double>
+	computeActionableQualityFeedback(const unsigned int threadCount);
+
+	bool triage(const TriagePolicy &policy);
+
+	/** @return Computed algorithms of `slots`, in Slot order */
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	getAlgorithms(const SlotSet &slots) const;
+
+	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	getComputedAlgorithms() const;
+
+	NativeQualityMeasureVector getComputedNativeQualityMeasures() const;
+
+    private:
+	/**
+	 * Compute the algorithm of `slot`, whose dependencies are ready,
+	 * timing it for the current InstrumentationRecord, if any.
+	 */
+	void computeSlot(const Slot slot);
+
+	/** Construct the algorithm of `slot`, whose dependencies are ready */
+	void constructSlot(const Slot slot);
+
+	/** Copy of the raw image, when requested */
+	const NFIQ2::FingerprintImageData ownedImage;
+	/**
+	 * Why the raw image could not be cropped, in which case algorithms
+	 * fail with it, and only triage() computes Mu of the whole image
+	 */
+	std::exception_ptr cropError {};
+	/** Cropped region of the raw image (or all of it), viewed in place */
+	const NFIQ2::FingerprintImageData croppedImage;
+
+	/** Local regions shared by FDA, LCS, OF and RVUPHistogram */
+	std::unique_ptr<BlockGeometry> blockGeometry {};
+	/** Computed algorithms, by Slot */
+	std::array<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>,
+	    SlotCount>
+	    algorithms {};
+	/** Same as algorithms[FingerJetFXSlot], for its minutiae */
+	std::shared_ptr<FingerJetFX> fjfxFeatureModule {};
+	/** Same as algorithms[ImgProcROISlot], for its region of interest */
+	std::shared_ptr<ImgProcROI> roiFeatureModule {};
+};
+}}
+
+#endif /* NFIQ2_LAZYQUALITYMEASURES_IMPL_HPP_ */
@@ -23,6 +23,21 @@ NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs()
 	    getNativeQualityMeasureAlgorithmIDs();
 }
 
+std::vector<std::string>
+NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs(
+    const std::vector<std::string> &qualityMeasureIDs)
+{
+	return NFIQ2::QualityMeasures::Impl::
+	    getNativeQualityMeasureAlgorithmIDs(qualityMeasureIDs);
+}
+
+std::vector<std::string>
+NFIQ2::QualityMeasures::getActionableQualityFeedbackAlgorithmIDs()
+{
+	return NFIQ2::QualityMeasures::Impl::
+	    getActionableQualityFeedbackAlgorithmIDs();
+}
+
 std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 NFIQ2::QualityMeasures::computeNativeQualityMeasureAlgorithms(
     const NFIQ2::FingerprintImageData &rawImage)
@@ -31,6 +46,45 @@ NFIQ2::QualityMeasures::computeNativeQualityMeasureAlgorithms(
 	    computeNativeQualityMeasureAlgorithms(rawImage);
 }
 
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const unsigned int threadCount)
+{
+	return NFIQ2::QualityMeasures::Impl::
+	    computeNativeQualityMeasureAlgorithms(rawImage, threadCount);
+}
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount)
+{
+	return NFIQ2::QualityMeasures::Impl::
+	    computeNativeQualityMeasureAlgorithms(rawImage, algorithmIDs,
+		threadCount);
+}
+
+bool
+NFIQ2::QualityMeasures::isTriaged(const TriagePolicy &policy,
+    const std::unordered_map<std::string, double> &actionableQualityFeedback)
+{
+	return NFIQ2::QualityMeasures::Impl::isTriaged(policy,
+	    actionableQualityFeedback);
+}
+
+bool
+NFIQ2::QualityMeasures::triageNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const TriagePolicy &policy,
+    const unsigned int threadCount,
+    std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms)
+{
+	return NFIQ2::QualityMeasures::Impl::
+	    triageNativeQualityMeasureAlgorithms(rawImage, policy, threadCount,
+		algorithms);
+}
+
 std::unordered_map<std::string, double>
 NFIQ2::QualityMeasures::getActionableQualityFeedback(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
@@ -56,6 +110,15 @@ NFIQ2::QualityMeasures::getNativeQualityMeasures(
 	return NFIQ2::QualityMeasures::Impl::getNativeQualityMeasures(modules);
 }
 
+NFIQ2::QualityMeasures::NativeQualityMeasureVector
+NFIQ2::QualityMeasures::getNativeQualityMeasureVector(
+    const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&modules)
+{
+	return NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureVector(
+	    modules);
+}
+
 std::unordered_map<std::string, double>
 NFIQ2::QualityMeasures::computeNativeQualityMeasures(
     const NFIQ2::FingerprintImageData &rawImage)
@@ -82,3 +145,21 @@ NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithms(
 	return NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithms(
 	    modules);
 }
+
+NFIQ2::QualityMeasures::ScratchMemoryStatistics
+NFIQ2::QualityMeasures::getScratchMemoryStatistics()
+{
+	return NFIQ2::QualityMeasures::Impl::getScratchMemoryStatistics();
+}
+
+void
+NFIQ2::QualityMeasures::resetScratchMemoryStatistics()
+{
+	NFIQ2::QualityMeasures::Impl::resetScratchMemoryStatistics();
+}
+
+void
+NFIQ2::QualityMeasures::setScratchArenaEnabled(const bool enabled)
+{
+	NFIQ2::QualityMeasures::Impl::setScratchArenaEnabled(enabled);
+}
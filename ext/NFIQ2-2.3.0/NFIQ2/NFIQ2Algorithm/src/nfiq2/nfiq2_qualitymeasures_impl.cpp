@@ -12,9 +12,14 @@
 #include <quality_modules/OF.h>
 #include <quality_modules/QualityMap.h>
 #include <quality_modules/RVUPHistogram.h>
+#include <quality_modules/ScratchArena.h>
 
+#include "nfiq2_lazyqualitymeasures_impl.hpp"
 #include "nfiq2_qualitymeasures_impl.hpp"
+#include <algorithm>
+#include <array>
 #include <iomanip>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -47,14 +52,11 @@ NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithmSpeeds(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&features)
 {
-	std::vector<std::string> speedIdentifiers =
-	    NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs();
-
+	/* by name, since triaged images only have some algorithms */
 	std::unordered_map<std::string, double> speedMap {};
 
-	for (std::vector<std::string>::size_type i = 0;
-	     i < speedIdentifiers.size(); i++) {
-		speedMap[speedIdentifiers.at(i)] = features.at(i)->getSpeed();
+	for (const auto &feature : features) {
+		speedMap[feature->getName()] = feature->getSpeed();
 	}
 
 	return speedMap;
@@ -84,6 +86,34 @@ NFIQ2::QualityMeasures::Impl::getNativeQualityMeasures(
 	return quality;
 }
 
+NFIQ2::QualityMeasures::NativeQualityMeasureVector
+NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureVector(
+    const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&features)
+{
+	NativeQualityMeasureVector quality {};
+	std::array<bool, NativeQualityMeasureCount> computed {};
+
+	for (const auto &feature : features) {
+		const QualityMeasureValues &values =
+		    feature->getFeatureValues();
+		values.copyTo(quality);
+		std::fill_n(computed.begin() + values.getFirst(),
+		    values.getCount(), true);
+	}
+
+	for (unsigned int i = 0; i < NativeQualityMeasureCount; i++) {
+		if (!computed[i]) {
+			throw NFIQ2::Exception(
+			    NFIQ2::ErrorCode::QualityMeasureCalculationError,
+			    std::string("Native quality measure not computed: ") +
+				NativeQualityMeasureIdentifiers[i]);
+		}
+	}
+
+	return quality;
+}
+
 std::unordered_map<std::string, double>
 NFIQ2::QualityMeasures::Impl::computeActionableQualityFeedback(
     const NFIQ2::FingerprintImageData &rawImage)
@@ -127,27 +157,16 @@ NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
 
 			// Mu is computed always since it is used as feature
 			// anyway
-			bool isEmptyImage = false;
-			for (const auto &muFeature :
-			    muFeatureModule->getFeatures()) {
-				if (muFeature.first ==
-				    Identifiers::QualityMeasures::Contrast::
-					ImageMean) {
-					actionableMap[Identifiers::
-						ActionableQualityFeedback::
-						    EmptyImageOrContrastTooLow] =
-					    muFeature.second;
-					isEmptyImage =
-					    (actionableMap[Identifiers::
-						     ActionableQualityFeedback::
-							 EmptyImageOrContrastTooLow] >
-							Thresholds::
-							    ActionableQualityFeedback::
-								EmptyImageOrContrastTooLow ?
-						    true :
-						    false);
-				}
-			}
+			actionableMap[Identifiers::ActionableQualityFeedback::
+				EmptyImageOrContrastTooLow] =
+			    muFeatureModule->getFeatureValues().at(
+				NativeQualityMeasure::ContrastImageMean);
+			const bool isEmptyImage =
+			    (actionableMap[Identifiers::
+				     ActionableQualityFeedback::
+					 EmptyImageOrContrastTooLow] >
+				Thresholds::ActionableQualityFeedback::
+				    EmptyImageOrContrastTooLow);
 
 			if (isEmptyImage || isUniformImage) {
 				// empty image or uniform image has been
@@ -162,19 +181,11 @@ NFIQ2::QualityMeasures::Impl::getActionableQualityFeedback(
 			const std::shared_ptr<FingerJetFX> fjfxFeatureModule =
 			    std::dynamic_pointer_cast<FingerJetFX>(feature);
 
-			for (const auto &fjfxFeature :
-			    fjfxFeatureModule->getFeatures()) {
-				if (fjfxFeature.first ==
-				    Identifiers::QualityMeasures::Minutiae::
-					Count) {
-					// return informative feature about
-					// number of minutiae
-					actionableMap[Identifiers::
-						ActionableQualityFeedback::
-						    FingerprintImageWithMinutiae] =
-					    fjfxFeature.second;
-				}
-			}
+			// return informative feature about number of minutiae
+			actionableMap[Identifiers::ActionableQualityFeedback::
+				FingerprintImageWithMinutiae] =
+			    fjfxFeatureModule->getFeatureValues().at(
+				NativeQualityMeasure::MinutiaeCount);
 
 		} else if (feature->getName().compare(
 			       Identifiers::QualityMeasureAlgorithms::
@@ -213,42 +224,88 @@ std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 NFIQ2::QualityMeasures::Impl::computeNativeQualityMeasureAlgorithms(
     const NFIQ2::FingerprintImageData &rawImage)
 {
-	/* use double-precision rounding for 32-bit linux */
-	setFPU(0x27F);
-
-	const NFIQ2::FingerprintImageData croppedImage =
-	    rawImage.copyRemovingNearWhiteFrame();
-
-	std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
-	    features {};
+	return (computeNativeQualityMeasureAlgorithms(rawImage, 1));
+}
 
-	features.push_back(std::make_shared<FDA>(croppedImage));
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::Impl::computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const unsigned int threadCount)
+{
+	/* modules read the cropped region of rawImage in place */
+	LazyQualityMeasures::Impl lazy { rawImage, false };
 
-	std::shared_ptr<FingerJetFX> fjfxFeatureModule =
-	    std::make_shared<FingerJetFX>(croppedImage);
-	features.push_back(fjfxFeatureModule);
+	LazyQualityMeasures::Impl::SlotSet slots {};
+	slots.fill(true);
+	lazy.compute(slots, threadCount);
 
-	features.push_back(std::make_shared<FJFXMinutiaeQuality>(croppedImage,
-	    fjfxFeatureModule->getMinutiaData()));
+	return (lazy.getAlgorithms(slots));
+}
 
-	std::shared_ptr<ImgProcROI> roiFeatureModule =
-	    std::make_shared<ImgProcROI>(croppedImage);
-	features.push_back(roiFeatureModule);
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+NFIQ2::QualityMeasures::Impl::computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount)
+{
+	LazyQualityMeasures::Impl lazy { rawImage, false };
 
-	features.push_back(std::make_shared<LCS>(croppedImage));
+	return (lazy.computeAlgorithms(algorithmIDs, threadCount));
+}
 
-	features.push_back(std::make_shared<Mu>(croppedImage));
+bool
+NFIQ2::QualityMeasures::Impl::isTriaged(const TriagePolicy &policy,
+    const std::unordered_map<std::string, double> &actionableQualityFeedback)
+{
+	/* NaN (not computed) never meets a condition */
+	const auto value = [&](const char *id) {
+		const auto it = actionableQualityFeedback.find(id);
+		return (it == actionableQualityFeedback.cend() ?
+			std::numeric_limits<double>::quiet_NaN() :
+			it->second);
+	};
 
-	features.push_back(std::make_shared<OCLHistogram>(croppedImage));
+	if (policy.stopOnUniformImage &&
+	    (value(Identifiers::ActionableQualityFeedback::UniformImage) <
+		policy.uniformImageThreshold)) {
+		return (true);
+	}
+	if (policy.stopOnEmptyImage &&
+	    (value(Identifiers::ActionableQualityFeedback::
+		     EmptyImageOrContrastTooLow) >
+		policy.emptyImageThreshold)) {
+		return (true);
+	}
+	if (policy.stopOnInsufficientForeground &&
+	    (value(Identifiers::ActionableQualityFeedback::
+		     SufficientFingerprintForeground) <
+		policy.foregroundThreshold)) {
+		return (true);
+	}
 
-	features.push_back(std::make_shared<OF>(croppedImage));
+	return (false);
+}
 
-	features.push_back(std::make_shared<QualityMap>(croppedImage,
-	    roiFeatureModule->getImgProcResults()));
+bool
+NFIQ2::QualityMeasures::Impl::triageNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const TriagePolicy &policy,
+    const unsigned int threadCount,
+    std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms)
+{
+	/* modules read the cropped region of rawImage in place */
+	LazyQualityMeasures::Impl lazy { rawImage, false };
+	if (lazy.triage(policy)) {
+		algorithms = lazy.getComputedAlgorithms();
+		return (true);
+	}
 
-	features.push_back(std::make_shared<RVUPHistogram>(croppedImage));
+	/* everything else, reusing the modules triage computed */
+	LazyQualityMeasures::Impl::SlotSet slots {};
+	slots.fill(true);
+	lazy.compute(slots, threadCount);
+	algorithms = lazy.getAlgorithms(slots);
 
-	return features;
+	return (false);
 }
 
 std::unordered_map<std::string,
@@ -266,6 +323,19 @@ NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithms(
 	return ret;
 }
 
+std::vector<std::string>
+NFIQ2::QualityMeasures::Impl::getActionableQualityFeedbackAlgorithmIDs()
+{
+	/* those getActionableQualityFeedback() reads */
+	static const std::vector<std::string> ids {
+		Identifiers::QualityMeasureAlgorithms::MinutiaeCount,
+		Identifiers::QualityMeasureAlgorithms::RegionOfInterestMean,
+		Identifiers::QualityMeasureAlgorithms::Contrast
+	};
+
+	return ids;
+}
+
 std::vector<std::string>
 NFIQ2::QualityMeasures::Impl::getActionableQualityFeedbackIDs()
 {
@@ -327,3 +397,50 @@ NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithmIDs()
 
 	return ids;
 }
+
+std::vector<std::string>
+NFIQ2::QualityMeasures::Impl::getNativeQualityMeasureAlgorithmIDs(
+    const std::vector<std::string> &qualityMeasureIDs)
+{
+	LazyQualityMeasures::Impl::SlotSet slots {};
+	for (const auto &id : qualityMeasureIDs) {
+		slots[LazyQualityMeasures::Impl::getQualityMeasureSlot(id)] =
+		    true;
+	}
+
+	static const std::vector<std::string> allIDs =
+	    getNativeQualityMeasureAlgorithmIDs();
+	std::vector<std::string> ids {};
+	for (unsigned int slot { 0 }; slot < slots.size(); ++slot) {
+		if (slots[slot]) {
+			ids.push_back(allIDs[slot]);
+		}
+	}
+
+	return (ids);
+}
+
+NFIQ2::QualityMeasures::ScratchMemoryStatistics
+NFIQ2::QualityMeasures::Impl::getScratchMemoryStatistics()
+{
+	const ScratchArena::Statistics arenaStatistics =
+	    ScratchArena::getStatistics();
+
+	ScratchMemoryStatistics statistics {};
+	statistics.allocations = arenaStatistics.allocations;
+	statistics.systemAllocations = arenaStatistics.systemAllocations;
+
+	return (statistics);
+}
+
+void
+NFIQ2::QualityMeasures::Impl::resetScratchMemoryStatistics()
+{
+	ScratchArena::resetStatistics();
+}
+
+void
+NFIQ2::QualityMeasures::Impl::setScratchArenaEnabled(const bool enabled)
+{
+	ScratchArena::setEnabled(enabled);
+}
@@ -18,6 +18,11 @@ std::vector<std::string> getNativeQualityMeasureIDs();
 
 std::vector<std::string> getNativeQualityMeasureAlgorithmIDs();
 
+std::vector<std::string> getNativeQualityMeasureAlgorithmIDs(
+    const std::vector<std::string> &qualityMeasureIDs);
+
+std::vector<std::string> getActionableQualityFeedbackAlgorithmIDs();
+
 /**
  * @brief
  * Updates the floating point precision mode used on 32-bit Linux
@@ -40,6 +45,26 @@ std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 computeNativeQualityMeasureAlgorithms(
     const NFIQ2::FingerprintImageData &rawImage);
 
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const unsigned int threadCount);
+
+std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+computeNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage,
+    const std::vector<std::string> &algorithmIDs,
+    const unsigned int threadCount);
+
+bool isTriaged(const TriagePolicy &policy,
+    const std::unordered_map<std::string, double> &actionableQualityFeedback);
+
+bool triageNativeQualityMeasureAlgorithms(
+    const NFIQ2::FingerprintImageData &rawImage, const TriagePolicy &policy,
+    const unsigned int threadCount,
+    std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms);
+
 std::unordered_map<std::string, double> getActionableQualityFeedback(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&algorithms);
@@ -54,6 +79,10 @@ std::unordered_map<std::string, double> getNativeQualityMeasures(
 std::unordered_map<std::string, double> computeNativeQualityMeasures(
     const NFIQ2::FingerprintImageData &rawImage);
 
+NativeQualityMeasureVector getNativeQualityMeasureVector(
+    const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
+	&algorithms);
+
 std::unordered_map<std::string, double> getNativeQualityMeasureAlgorithmSpeeds(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&algorithms);
@@ -63,6 +92,24 @@ std::unordered_map<std::string,
 getNativeQualityMeasureAlgorithms(
     const std::vector<std::shared_ptr<NFIQ2::QualityMeasures::Algorithm>>
 	&algorithms);
+
+/**
+ * @brief
+ * Obtain scratch memory allocation counters.
+ */
+NFIQ2::QualityMeasures::ScratchMemoryStatistics getScratchMemoryStatistics();
+
+/**
+ * @brief
+ * Zero the scratch memory allocation counters.
+ */
+void resetScratchMemoryStatistics();
+
+/**
+ * @brief
+ * Enable or disable the per-thread scratch arena.
+ */
+void setScratchArenaEnabled(const bool enabled);
 }}}
 
 #endif /* NFIQ2_QUALITYMEASURES_IMPL_HPP_ */
@@ -0,0 +1,158 @@
+#include <nfiq2_exception.hpp>
+
+#include "nfiq2_taskgraph.hpp"
+#include "nfiq2_threadpool.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+std::size_t
+NFIQ2::QualityMeasures::Impl::TaskGraph::add(const Task &task,
+    const std::vector<std::size_t> &dependencies)
+{
+	const std::size_t id = this->nodes_.size();
+	for (const auto dependency : dependencies) {
+		if (dependency >= id) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Task dependency must be added before the task "
+			    "that depends on it");
+		}
+	}
+
+	this->nodes_.push_back(Node { task, {},
+	    static_cast<unsigned int>(dependencies.size()) });
+	for (const auto dependency : dependencies) {
+		this->nodes_[dependency].dependents.push_back(id);
+	}
+
+	return (id);
+}
+
+/** State of one run(), shared with the pool jobs helping it */
+struct NFIQ2::QualityMeasures::Impl::TaskGraph::RunState {
+	std::mutex mutex {};
+	std::condition_variable cv {};
+	std::deque<std::size_t> ready {};
+	std::vector<unsigned int> pending {};
+	std::size_t remaining {};
+	std::exception_ptr error {};
+	/** Number of pool workers inside work() */
+	unsigned int running {};
+	/** run() returned; jobs starting now must not touch the graph */
+	bool closed {};
+};
+
+void
+NFIQ2::QualityMeasures::Impl::TaskGraph::work(RunState &state)
+{
+	std::unique_lock<std::mutex> lock(state.mutex);
+	for (;;) {
+		state.cv.wait(lock, [&]() {
+			return (!state.ready.empty() ||
+			    (state.remaining == 0) || state.error);
+		});
+		if ((state.remaining == 0) || state.error) {
+			return;
+		}
+
+		const std::size_t id = state.ready.front();
+		state.ready.pop_front();
+
+		lock.unlock();
+		std::exception_ptr taskError {};
+		try {
+			this->nodes_[id].task();
+		} catch (...) {
+			taskError = std::current_exception();
+		}
+		lock.lock();
+
+		if (taskError) {
+			if (!state.error) {
+				state.error = taskError;
+			}
+			state.cv.notify_all();
+			return;
+		}
+
+		state.remaining--;
+		for (const auto dependent : this->nodes_[id].dependents) {
+			if (--state.pending[dependent] == 0) {
+				state.ready.push_back(dependent);
+			}
+		}
+		state.cv.notify_all();
+	}
+}
+
+void
+NFIQ2::QualityMeasures::Impl::TaskGraph::run(const unsigned int threadCount,
+    const ThreadScope &threadScope)
+{
+	if ((threadCount < 2) || (this->nodes_.size() < 2)) {
+		for (const auto &node : this->nodes_) {
+			node.task();
+		}
+		return;
+	}
+
+	const auto state = std::make_shared<RunState>();
+	state->pending.resize(this->nodes_.size());
+	state->remaining = this->nodes_.size();
+	for (std::size_t i = 0; i < this->nodes_.size(); i++) {
+		state->pending[i] = this->nodes_[i].dependencyCount;
+		if (state->pending[i] == 0) {
+			state->ready.push_back(i);
+		}
+	}
+
+	/*
+	 * The calling thread always executes tasks, so the graph completes
+	 * even if every pool worker is busy with other images.
+	 */
+	auto &pool = ThreadPool::shared();
+	const std::size_t helperCount = std::min<std::size_t>(
+	    pool.reserve(threadCount - 1), this->nodes_.size() - 1);
+	for (std::size_t i = 0; i < helperCount; i++) {
+		pool.submit([this, state, threadScope]() {
+			{
+				const std::lock_guard<std::mutex> lock(
+				    state->mutex);
+				if (state->closed) {
+					return;
+				}
+				state->running++;
+			}
+
+			const std::function<void()> help { [&]() {
+				this->work(*state);
+			} };
+			try {
+				if (threadScope) {
+					threadScope(help);
+				} else {
+					help();
+				}
+			} catch (...) {
+				// Task errors are caught by work()
+			}
+
+			const std::lock_guard<std::mutex> lock(state->mutex);
+			state->running--;
+			state->cv.notify_all();
+		});
+	}
+
+	this->work(*state);
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv.wait(lock, [&]() { return (state->running == 0); });
+	state->closed = true;
+
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef NFIQ2_TASKGRAPH_HPP_
+#define NFIQ2_TASKGRAPH_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace NFIQ2 { namespace QualityMeasures { namespace Impl {
+
+/**
+ * @brief
+ * Small dependency graph of tasks executed on a bounded set of threads.
+ *
+ * @details
+ * The calling thread executes tasks itself, helped by workers of the
+ * process-wide ThreadPool, so running a graph does not start threads.
+ * Tasks may only depend on tasks added before them, so insertion order is
+ * always a valid sequential execution order. Results should be written to
+ * storage owned by the caller (e.g., fixed slots in a vector) so that
+ * output order does not depend on scheduling.
+ */
+class TaskGraph {
+    public:
+	/** Unit of work */
+	using Task = std::function<void()>;
+
+	/**
+	 * Executes `work` on a pool worker, e.g. inside thread-local state
+	 * the tasks need. Must call `work` exactly once.
+	 */
+	using ThreadScope = std::function<void(const std::function<void()> &)>;
+
+	/**
+	 * @brief
+	 * Add a task to the graph.
+	 *
+	 * @param task
+	 * Work to perform.
+	 * @param dependencies
+	 * Identifiers (returned by add()) of tasks that must complete
+	 * before `task` may start.
+	 *
+	 * @return
+	 * Identifier of the added task.
+	 *
+	 * @throw NFIQ2::Exception
+	 * A dependency refers to a task that has not been added.
+	 */
+	std::size_t add(const Task &task,
+	    const std::vector<std::size_t> &dependencies = {});
+
+	/**
+	 * @brief
+	 * Execute all tasks and wait for them to complete.
+	 *
+	 * @param threadCount
+	 * Maximum number of threads executing tasks, including the calling
+	 * thread. Values less than 2 execute tasks on the calling thread in
+	 * insertion order. The shared pool grows to `threadCount - 1`
+	 * workers (at most one per hardware thread) the first time it is
+	 * needed.
+	 * @param threadScope
+	 * Optional scope in which pool workers execute tasks. The calling
+	 * thread executes its tasks in its current state.
+	 *
+	 * @throw
+	 * The first exception thrown by a task. Once a task throws, no further
+	 * tasks are started.
+	 */
+	void run(const unsigned int threadCount,
+	    const ThreadScope &threadScope = {});
+
+    private:
+	struct RunState;
+
+	/** Execute ready tasks of `state` until none is left */
+	void work(RunState &state);
+
+	struct Node {
+		/** Work to perform */
+		Task task;
+		/** Tasks waiting on this task */
+		std::vector<std::size_t> dependents;
+		/** Number of dependencies */
+		unsigned int dependencyCount;
+	};
+
+	std::vector<Node> nodes_ {};
+};
+
+}}}
+
+#endif /* NFIQ2_TASKGRAPH_HPP_ */
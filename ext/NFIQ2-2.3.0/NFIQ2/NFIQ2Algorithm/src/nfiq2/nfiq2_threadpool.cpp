@@ -0,0 +1,87 @@
+#include "nfiq2_threadpool.hpp"
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+NFIQ2::QualityMeasures::Impl::ThreadPool &
+NFIQ2::QualityMeasures::Impl::ThreadPool::shared()
+{
+	/*
+	 * Never destroyed: workers may still be waiting for jobs while
+	 * static objects are destroyed at exit.
+	 */
+	static ThreadPool *const pool = new ThreadPool();
+	return (*pool);
+}
+
+NFIQ2::QualityMeasures::Impl::ThreadPool::~ThreadPool()
+{
+	{
+		const std::lock_guard<std::mutex> lock(this->mutex_);
+		this->stopping_ = true;
+	}
+	this->cv_.notify_all();
+
+	for (auto &worker : this->workers_) {
+		worker.join();
+	}
+}
+
+unsigned int
+NFIQ2::QualityMeasures::Impl::ThreadPool::reserve(
+    const unsigned int workerCount)
+{
+	const unsigned int bound { std::max(1u,
+	    std::thread::hardware_concurrency()) };
+	const unsigned int wanted { std::min(workerCount, bound) };
+
+	const std::lock_guard<std::mutex> lock(this->mutex_);
+	while (this->workers_.size() < wanted) {
+		try {
+			this->workers_.emplace_back([this]() { this->work(); });
+		} catch (const std::system_error &) {
+			// Could not start a thread; continue with fewer
+			break;
+		}
+	}
+
+	return (static_cast<unsigned int>(this->workers_.size()));
+}
+
+unsigned int
+NFIQ2::QualityMeasures::Impl::ThreadPool::getWorkerCount() const
+{
+	const std::lock_guard<std::mutex> lock(this->mutex_);
+	return (static_cast<unsigned int>(this->workers_.size()));
+}
+
+void
+NFIQ2::QualityMeasures::Impl::ThreadPool::submit(const Job &job)
+{
+	{
+		const std::lock_guard<std::mutex> lock(this->mutex_);
+		this->jobs_.push_back(job);
+	}
+	this->cv_.notify_one();
+}
+
+void
+NFIQ2::QualityMeasures::Impl::ThreadPool::work()
+{
+	std::unique_lock<std::mutex> lock(this->mutex_);
+	for (;;) {
+		this->cv_.wait(lock, [this]() {
+			return (!this->jobs_.empty() || this->stopping_);
+		});
+		if (this->jobs_.empty()) {
+			return;
+		}
+
+		const Job job { std::move(this->jobs_.front()) };
+		this->jobs_.pop_front();
+
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
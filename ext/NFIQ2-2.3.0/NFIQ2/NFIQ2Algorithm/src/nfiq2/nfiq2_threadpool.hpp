@@ -0,0 +1,76 @@
+#ifndef NFIQ2_THREADPOOL_HPP_
+#define NFIQ2_THREADPOOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NFIQ2 { namespace QualityMeasures { namespace Impl {
+
+/**
+ * @brief
+ * Long-lived worker threads executing queued jobs in submission order.
+ *
+ * @details
+ * Workers are only started by reserve(), and then live as long as the
+ * pool, so computing an image never starts a thread. Jobs must not wait
+ * on other jobs of the pool to be started, since every worker may be
+ * busy.
+ */
+class ThreadPool {
+    public:
+	/** Unit of work */
+	using Job = std::function<void()>;
+
+	/**
+	 * @return
+	 * Process-wide pool used by TaskGraph. It has no worker until
+	 * reserve() is called.
+	 */
+	static ThreadPool &shared();
+
+	ThreadPool() = default;
+
+	/** Finish the queued jobs and stop the workers. */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/**
+	 * @brief
+	 * Start workers until there are at least `workerCount`.
+	 *
+	 * @param workerCount
+	 * Number of workers wanted, bounded by the number of hardware
+	 * threads.
+	 *
+	 * @return
+	 * Number of workers, which may be less than `workerCount` if the
+	 * bound was reached or a thread could not be started.
+	 */
+	unsigned int reserve(const unsigned int workerCount);
+
+	/** @return Number of workers */
+	unsigned int getWorkerCount() const;
+
+	/** @brief Queue `job`, which must not throw, for the next worker. */
+	void submit(const Job &job);
+
+    private:
+	/** Execute jobs until the pool is destroyed */
+	void work();
+
+	mutable std::mutex mutex_ {};
+	std::condition_variable cv_ {};
+	std::deque<Job> jobs_ {};
+	std::vector<std::thread> workers_ {};
+	bool stopping_ { false };
+};
+
+}}}
+
+#endif /* NFIQ2_THREADPOOL_HPP_ */
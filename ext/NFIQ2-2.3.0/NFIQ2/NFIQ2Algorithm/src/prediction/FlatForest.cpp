@@ -0,0 +1,328 @@
+#include <nfiq2_exception.hpp>
+#include <prediction/FlatForest.h>
+
+#include <cstring>
+#include <deque>
+#include <utility>
+
+namespace {
+
+const char BinaryMagic[8] { 'N', 'F', 'I', 'Q', '2', 'R', 'F', '\0' };
+const uint32_t BinaryVersion { 1 };
+/* Written in host byte order; reads back as 1 only on the same order */
+const uint32_t BinaryByteOrder { 1 };
+
+template <typename T>
+void
+append(std::vector<uint8_t> &out, const T *values, size_t count)
+{
+	const auto *bytes = reinterpret_cast<const uint8_t *>(values);
+	out.insert(out.end(), bytes, bytes + (count * sizeof(T)));
+}
+
+template <typename T>
+void
+extract(const uint8_t *&data, size_t &remaining, T *values, size_t count)
+{
+	const size_t size { count * sizeof(T) };
+	if (remaining < size) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Binary random forest is truncated");
+	}
+	std::memcpy(values, data, size);
+	data += size;
+	remaining -= size;
+}
+
+}
+
+NFIQ2::Prediction::FlatForest::FlatForest(const cv::ml::RTrees &forest,
+    const cv::FileNode &params)
+{
+	if (!forest.isTrained() || !forest.isClassifier()) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Only trained random forest classifiers can be "
+		    "flattened");
+	}
+	this->featureCount = static_cast<unsigned int>(forest.getVarCount());
+
+	/*
+	 * RAW_OUTPUT only sums leaf values for two-class forests; with more
+	 * classes it returns the index of the majority class. The first row
+	 * of the vote matrix lists the class labels.
+	 */
+	cv::Mat votes {};
+	forest.getVotes(cv::Mat::zeros(1, static_cast<int>(this->featureCount),
+			    CV_32FC1),
+	    votes, cv::ml::DTrees::PREDICT_MAX_VOTE);
+	if (votes.cols != 2) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Only two-class random forests can be flattened");
+	}
+
+	/*
+	 * Splits refer to variables by their index among all variables of
+	 * the training data. When the model lists the variables it was
+	 * trained on, a sample only holds those, in that order.
+	 */
+	std::vector<int> varIdx {};
+	const cv::FileNode varIdxNode = params["var_idx"];
+	if (varIdxNode.isMap()) {
+		cv::Mat varIdxMat {};
+		varIdxNode >> varIdxMat;
+		varIdxMat.reshape(1, 1).convertTo(varIdx, CV_32S);
+	} else {
+		varIdxNode >> varIdx;
+	}
+	std::vector<int32_t> columns {};
+	for (size_t i { 0 }; i < varIdx.size(); ++i) {
+		if (varIdx[i] < 0) {
+			throw NFIQ2::Exception(
+			    NFIQ2::ErrorCode::InvalidConfiguration,
+			    "Random forest has an invalid variable index");
+		}
+		if (static_cast<size_t>(varIdx[i]) >= columns.size()) {
+			columns.resize(varIdx[i] + 1, -1);
+		}
+		columns[varIdx[i]] = static_cast<int32_t>(i);
+	}
+
+	// Every split on a categorical variable stores a category subset
+	if (!forest.getSubsets().empty()) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Random forests splitting on categorical variables cannot "
+		    "be flattened");
+	}
+
+	// Models older than format 3 never substitute missing values
+	std::vector<float> missingSubstitutes {};
+	int format { 0 };
+	params["format"] >> format;
+	if (params["format"].empty() || format >= 3) {
+		params["missing_subst"] >> missingSubstitutes;
+	}
+
+	const std::vector<cv::ml::DTrees::Node> &nodes = forest.getNodes();
+	const std::vector<cv::ml::DTrees::Split> &splits = forest.getSplits();
+
+	/*
+	 * Lay out each tree breadth first, giving the two children of a
+	 * split node consecutive slots.
+	 */
+	std::deque<std::pair<int, int32_t>> pending {};
+	for (const int root : forest.getRoots()) {
+		this->roots.push_back(
+		    static_cast<int32_t>(this->features.size()));
+		this->features.push_back(-1);
+		this->thresholds.push_back(0);
+		this->children.push_back(-1);
+		this->missingDirections.push_back(0);
+		this->values.push_back(0);
+		pending.emplace_back(root, this->roots.back());
+
+		while (!pending.empty()) {
+			const cv::ml::DTrees::Node &node =
+			    nodes[pending.front().first];
+			const int32_t slot = pending.front().second;
+			pending.pop_front();
+
+			if (node.split < 0) {
+				this->values[slot] = node.value;
+				continue;
+			}
+
+			// Only the first (primary) split decides the direction
+			const cv::ml::DTrees::Split &split = splits[node.split];
+			const int vi = split.varIdx;
+			int32_t column { vi };
+			if (!varIdx.empty()) {
+				column = ((vi >= 0) &&
+					     (static_cast<size_t>(vi) <
+						 columns.size())) ?
+				    columns[vi] :
+				    -1;
+			}
+			if ((column < 0) ||
+			    (static_cast<unsigned int>(column) >=
+				this->featureCount)) {
+				throw NFIQ2::Exception(
+				    NFIQ2::ErrorCode::InvalidConfiguration,
+				    "Random forest splits on a variable it was "
+				    "not trained on");
+			}
+
+			const int32_t left = static_cast<int32_t>(
+			    this->features.size());
+			this->features[slot] = column;
+			this->thresholds[slot] = split.c;
+			this->children[slot] = left;
+			if (static_cast<size_t>(vi) <
+			    missingSubstitutes.size()) {
+				this->missingDirections[slot] =
+				    !(missingSubstitutes[vi] <= split.c);
+			} else {
+				this->missingDirections[slot] =
+				    node.defaultDir >= 0;
+			}
+
+			for (int i { 0 }; i < 2; ++i) {
+				this->features.push_back(-1);
+				this->thresholds.push_back(0);
+				this->children.push_back(-1);
+				this->missingDirections.push_back(0);
+				this->values.push_back(0);
+			}
+			pending.emplace_back(node.left, left);
+			pending.emplace_back(node.right, left + 1);
+		}
+	}
+}
+
+NFIQ2::Prediction::FlatForest::FlatForest(const uint8_t *data, size_t size)
+{
+	char magic[sizeof(BinaryMagic)] {};
+	uint32_t header[5] {};
+	extract(data, size, magic, sizeof(magic));
+	extract(data, size, header, 5);
+	if ((std::memcmp(magic, BinaryMagic, sizeof(magic)) != 0) ||
+	    (header[0] != BinaryVersion) || (header[1] != BinaryByteOrder)) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Binary random forest has an unsupported format");
+	}
+	this->featureCount = header[2];
+	const uint32_t treeCount { header[3] };
+	const uint32_t nodeCount { header[4] };
+	/* Bound the counts by the buffer before allocating anything */
+	if ((treeCount > size / sizeof(int32_t)) ||
+	    (nodeCount > size / sizeof(double))) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Binary random forest is truncated");
+	}
+
+	this->roots.resize(treeCount);
+	this->features.resize(nodeCount);
+	this->thresholds.resize(nodeCount);
+	this->children.resize(nodeCount);
+	this->missingDirections.resize(nodeCount);
+	this->values.resize(nodeCount);
+	extract(data, size, this->roots.data(), treeCount);
+	extract(data, size, this->features.data(), nodeCount);
+	extract(data, size, this->thresholds.data(), nodeCount);
+	extract(data, size, this->children.data(), nodeCount);
+	extract(data, size, this->missingDirections.data(), nodeCount);
+	extract(data, size, this->values.data(), nodeCount);
+	if (size != 0) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
+		    "Binary random forest has trailing data");
+	}
+
+	/*
+	 * Children always follow their parent, so walks terminate as long
+	 * as every index stays in range.
+	 */
+	for (const int32_t root : this->roots) {
+		if ((root < 0) || (static_cast<uint32_t>(root) >= nodeCount)) {
+			throw NFIQ2::Exception(
+			    NFIQ2::ErrorCode::InvalidConfiguration,
+			    "Binary random forest is corrupt");
+		}
+	}
+	for (uint32_t i { 0 }; i < nodeCount; ++i) {
+		if (this->features[i] < 0) {
+			continue;
+		}
+		if ((static_cast<uint32_t>(this->features[i]) >=
+			this->featureCount) ||
+		    (this->children[i] <= static_cast<int32_t>(i)) ||
+		    (static_cast<uint32_t>(this->children[i]) + 1 >=
+			nodeCount) ||
+		    (this->missingDirections[i] > 1)) {
+			throw NFIQ2::Exception(
+			    NFIQ2::ErrorCode::InvalidConfiguration,
+			    "Binary random forest is corrupt");
+		}
+	}
+}
+
+std::vector<uint8_t>
+NFIQ2::Prediction::FlatForest::serialize() const
+{
+	const uint32_t header[5] { BinaryVersion, BinaryByteOrder,
+		this->featureCount, static_cast<uint32_t>(this->roots.size()),
+		static_cast<uint32_t>(this->features.size()) };
+
+	std::vector<uint8_t> out {};
+	append(out, BinaryMagic, sizeof(BinaryMagic));
+	append(out, header, 5);
+	append(out, this->roots.data(), this->roots.size());
+	append(out, this->features.data(), this->features.size());
+	append(out, this->thresholds.data(), this->thresholds.size());
+	append(out, this->children.data(), this->children.size());
+	append(out, this->missingDirections.data(),
+	    this->missingDirections.size());
+	append(out, this->values.data(), this->values.size());
+
+	return (out);
+}
+
+unsigned int
+NFIQ2::Prediction::FlatForest::getFeatureCount() const
+{
+	return (this->featureCount);
+}
+
+unsigned int
+NFIQ2::Prediction::FlatForest::getTreeCount() const
+{
+	return (static_cast<unsigned int>(this->roots.size()));
+}
+
+int32_t
+NFIQ2::Prediction::FlatForest::findLeaf(int32_t node,
+    const float *sample) const
+{
+	const int32_t *features = this->features.data();
+	const float *thresholds = this->thresholds.data();
+	const int32_t *children = this->children.data();
+
+	for (int32_t feature = features[node]; feature >= 0;
+	     feature = features[node]) {
+		const float value = sample[feature];
+		/* Written as !(<=) so NaN goes right, as it does in OpenCV */
+		int32_t direction = !(value <= thresholds[node]);
+		if (value == cv::ml::TrainData::missingValue()) {
+			direction = this->missingDirections[node];
+		}
+		node = children[node] + direction;
+	}
+
+	return (node);
+}
+
+float
+NFIQ2::Prediction::FlatForest::predict(const float *sample) const
+{
+	double sum { 0 };
+	for (const int32_t root : this->roots) {
+		sum += this->values[this->findLeaf(root, sample)];
+	}
+
+	return (static_cast<float>(sum));
+}
+
+void
+NFIQ2::Prediction::FlatForest::predict(const float *samples, size_t count,
+    size_t stride, float *results) const
+{
+	std::vector<double> sums(count, 0);
+	for (const int32_t root : this->roots) {
+		for (size_t i { 0 }; i < count; ++i) {
+			sums[i] += this->values[this->findLeaf(root,
+			    samples + (i * stride))];
+		}
+	}
+
+	for (size_t i { 0 }; i < count; ++i) {
+		results[i] = static_cast<float>(sums[i]);
+	}
+}
@@ -6,7 +6,10 @@
  * provided FRCT.
  */
 #ifdef NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS
-#ifdef NFIQ2_EMBEDDED_RANDOM_FOREST_PARAMETERS_FCT
+#ifdef NFIQ2_EMBED_COMPILED_RANDOM_FOREST_PARAMETERS
+/* Generated at build time by nfiq2-compile-model */
+#include <prediction/RandomForestCompiledParams.h>
+#elif defined(NFIQ2_EMBEDDED_RANDOM_FOREST_PARAMETERS_FCT)
 /* FRCT == Unknown */
 #if NFIQ2_EMBEDDED_RANDOM_FOREST_PARAMETERS_FCT == 0
 #include <prediction/RandomForestTrainedParams.h>
@@ -26,6 +29,7 @@
 #endif /* NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS */
 
 #include "digestpp.hpp"
+#include <array>
 #include <cmath>
 #include <ctime>
 #include <numeric> // std::accumulate
@@ -54,9 +58,18 @@ NFIQ2::Prediction::RandomForestML::initModule(const std::string &params)
 	// now import data structures
 	m_pTrainedRF = cv::ml::RTrees::create();
 	m_pTrainedRF->read(cv::FileNode(fs["my_random_trees"]));
+
+	// predict through the flattened forest when it can reproduce RTrees
+	try {
+		m_flatForest = std::make_shared<const FlatForest>(
+		    *m_pTrainedRF, fs["my_random_trees"]);
+	} catch (const NFIQ2::Exception &) {
+		m_flatForest.reset();
+	}
 }
 
-#ifdef NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS
+#if defined(NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS) && \
+    !defined(NFIQ2_EMBED_COMPILED_RANDOM_FOREST_PARAMETERS)
 std::string
 NFIQ2::Prediction::RandomForestML::joinRFTrainedParamsString()
 {
@@ -82,6 +95,15 @@ NFIQ2::Prediction::RandomForestML::~RandomForestML()
 std::string
 NFIQ2::Prediction::RandomForestML::initModule()
 {
+#ifdef NFIQ2_EMBED_COMPILED_RANDOM_FOREST_PARAMETERS
+	/*
+	 * The model was flattened and hashed at build time, so neither the
+	 * YAML nor RTrees are needed.
+	 */
+	m_flatForest = std::make_shared<const FlatForest>(
+	    g_randomForestCompiledParams, sizeof(g_randomForestCompiledParams));
+	return g_strRandomForestCompiledParamsHash;
+#else
 	try {
 		// get parameters from string
 		// accumulate it to a single string
@@ -99,6 +121,7 @@ NFIQ2::Prediction::RandomForestML::initModule()
 	} catch (...) {
 		throw;
 	}
+#endif /* NFIQ2_EMBED_COMPILED_RANDOM_FOREST_PARAMETERS */
 }
 #endif
 
@@ -114,6 +137,7 @@ NFIQ2::Prediction::RandomForestML::initModule(const std::string &fileName,
 	std::string hash = calculateHashString(params);
 	if (fileHash.compare(hash) != 0) {
 		m_pTrainedRF->clear();
+		m_flatForest.reset();
 		throw NFIQ2::Exception(NFIQ2::ErrorCode::InvalidConfiguration,
 		    "The trained network could not be initialized! "
 		    "Error: " +
@@ -127,145 +151,75 @@ NFIQ2::Prediction::RandomForestML::evaluate(
     const std::unordered_map<std::string, double> &features,
     double &qualityValue) const
 {
-	/**
-	   The following ordering of feature keys is critical to the
-	   correct computation of NFIQ 2 scores. Any modification to this
-	   ordering will result in incorrectly generated NFIQ 2 scores. This is
-	   based on the training model currently in use and may be updated in
-	   the future.
-	*/
-	static const std::vector<std::string> rfFeatureOrder {
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin0,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin1,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin2,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin3,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin4,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin5,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin6,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin7,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin8,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::
-		    Histogram::Bin9,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::Mean,
-		Identifiers::QualityMeasures::FrequencyDomainAnalysis::StdDev,
-
-		Identifiers::QualityMeasures::Minutiae::CountCOM,
-		Identifiers::QualityMeasures::Minutiae::Count,
-		Identifiers::QualityMeasures::Minutiae::PercentImageMean50,
-		Identifiers::QualityMeasures::Minutiae::
-		    PercentOrientationCertainty80,
-
-		Identifiers::QualityMeasures::RegionOfInterest::Mean,
-
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin0,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin1,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin2,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin3,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin4,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin5,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin6,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin7,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin8,
-		Identifiers::QualityMeasures::LocalClarity::Histogram::Bin9,
-		Identifiers::QualityMeasures::LocalClarity::Mean,
-		Identifiers::QualityMeasures::LocalClarity::StdDev,
-
-		Identifiers::QualityMeasures::Contrast::MeanOfBlockMeans,
-		Identifiers::QualityMeasures::Contrast::ImageMean,
-
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin0,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin1,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin2,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin3,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin4,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin5,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin6,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin7,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin8,
-		Identifiers::QualityMeasures::OrientationCertainty::Histogram::
-		    Bin9,
-		Identifiers::QualityMeasures::OrientationCertainty::Mean,
-		Identifiers::QualityMeasures::OrientationCertainty::StdDev,
-
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin0,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin1,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin2,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin3,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin4,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin5,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin6,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin7,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin8,
-		Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin9,
-		Identifiers::QualityMeasures::OrientationFlow::Mean,
-		Identifiers::QualityMeasures::OrientationFlow::StdDev,
-
-		Identifiers::QualityMeasures::RegionOfInterest::CoherenceMean,
-		Identifiers::QualityMeasures::RegionOfInterest::CoherenceSum,
+	QualityMeasures::NativeQualityMeasureVector sample {};
+	try {
+		for (unsigned int i { 0 };
+		     i < QualityMeasures::NativeQualityMeasureCount; ++i) {
+			sample[i] = features.at(
+			    QualityMeasures::NativeQualityMeasureIdentifiers[i]);
+		}
+	} catch (const std::out_of_range &e) {
+		throw Exception(
+		    NFIQ2::ErrorCode::QualityMeasureCalculationError, e.what());
+	}
 
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin0,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin1,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin2,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin3,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin4,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin5,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin6,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin7,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin8,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Histogram::
-		    Bin9,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::Mean,
-		Identifiers::QualityMeasures::RidgeValleyUniformity::StdDev
-	};
+	this->evaluate(sample, qualityValue);
+}
 
+void
+NFIQ2::Prediction::RandomForestML::evaluate(
+    const QualityMeasures::NativeQualityMeasureVector &features,
+    double &qualityValue) const
+{
+	/*
+	 * The model is trained on the native quality measures in the order
+	 * of QualityMeasures::NativeQualityMeasure::Index, which is therefore
+	 * critical to the correct computation of NFIQ 2 scores.
+	 */
 	try {
-		if (m_pTrainedRF.empty() || !m_pTrainedRF->isTrained() ||
-		    !m_pTrainedRF->isClassifier()) {
+		// copy data to structure
+		std::array<float, QualityMeasures::NativeQualityMeasureCount>
+		    sample;
+		for (unsigned int i { 0 }; i < sample.size(); ++i) {
+			sample[i] = static_cast<float>(features[i]);
+		}
+
+		/*
+		 * A flat forest trained on a different number of features
+		 * cannot be evaluated; fall back to the OpenCV model, which
+		 * is only kept when the flat forest was built from YAML.
+		 */
+		const bool useFlatForest { m_flatForest != nullptr &&
+			m_flatForest->getFeatureCount() == sample.size() };
+		if (!useFlatForest &&
+		    (m_pTrainedRF.empty() || !m_pTrainedRF->isTrained() ||
+			!m_pTrainedRF->isClassifier())) {
+			if (m_flatForest != nullptr) {
+				throw NFIQ2::Exception(
+				    NFIQ2::ErrorCode::InvalidConfiguration,
+				    "The random forest expects " +
+					std::to_string(
+					    m_flatForest->getFeatureCount()) +
+					" features, not " +
+					std::to_string(sample.size()));
+			}
 			throw NFIQ2::Exception(
 			    NFIQ2::ErrorCode::InvalidConfiguration,
 			    "The trained network could not be loaded for "
 			    "prediction!");
 		}
 
-		// copy data to structure
-		cv::Mat sample_data = cv::Mat(1, rfFeatureOrder.size(),
-		    CV_32FC1);
-
-		for (unsigned int i { 0 }; i < rfFeatureOrder.size(); ++i) {
-			sample_data.at<float>(0, i) = features.at(
-			    rfFeatureOrder[i]);
+		float raw_prediction {};
+		if (useFlatForest) {
+			raw_prediction = m_flatForest->predict(sample.data());
+		} else {
+			const cv::Mat sample_data(1,
+			    static_cast<int>(sample.size()), CV_32FC1,
+			    sample.data());
+			raw_prediction = m_pTrainedRF->predict(sample_data,
+			    cv::noArray(), cv::ml::StatModel::RAW_OUTPUT);
 		}
 
-		const float raw_prediction = m_pTrainedRF->predict(sample_data,
-		    cv::noArray(), cv::ml::StatModel::RAW_OUTPUT);
-
 		/*
 		 * raw_prediction is in the range of 0 to max_trees.
 		 * Scale to range required by ISO/IEC 29794-1 (i.e., 0-100).
@@ -274,7 +228,8 @@ NFIQ2::Prediction::RandomForestML::evaluate(
 		static const float max_quality { 100 };
 		static const float min_trees { 0 };
 		const float max_trees { static_cast<float>(
-		    m_pTrainedRF->getRoots().size()) };
+		    useFlatForest ? m_flatForest->getTreeCount() :
+				    m_pTrainedRF->getRoots().size()) };
 		const float scaled_prediction { ((raw_prediction - min_trees) /
 						    (max_trees - min_trees)) *
 			    (max_quality - min_quality) +
@@ -293,9 +248,6 @@ NFIQ2::Prediction::RandomForestML::evaluate(
 		}
 	} catch (const cv::Exception &e) {
 		throw Exception(NFIQ2::ErrorCode::MachineLearningError, e.msg);
-	} catch (const std::out_of_range &e) {
-		throw Exception(
-		    NFIQ2::ErrorCode::QualityMeasureCalculationError, e.what());
 	}
 }
 
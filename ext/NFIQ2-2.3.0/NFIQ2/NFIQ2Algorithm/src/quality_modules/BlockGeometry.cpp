@@ -0,0 +1,144 @@
+#include <quality_modules/BlockGeometry.h>
+#include <quality_modules/InstrumentationRecord.h>
+#include <quality_modules/common_functions.h>
+
+#include <cassert>
+#include <cmath>
+
+NFIQ2::QualityMeasures::BlockGeometry::BlockGeometry(const cv::Mat &img,
+    const int blocksize, const double threshold, const int slantedBlockSizeX,
+    const int slantedBlockSizeY)
+    : rows_ { img.rows }
+    , cols_ { img.cols }
+    , blocksize_ { blocksize }
+    , threshold_ { threshold }
+    , slantedBlockSizeX_ { slantedBlockSizeX }
+    , slantedBlockSizeY_ { slantedBlockSizeY }
+{
+	assert((blocksize > 0) && (threshold > 0));
+
+	{
+		const InstrumentationRecord::StageTimer timer {
+			Instrumentation::Stage::RidgeSegment
+		};
+		ridgesegment(img, blocksize, threshold, cv::noArray(),
+		    this->maskim_, cv::noArray());
+	}
+
+	const int rows = img.rows;
+	const int cols = img.cols;
+	const double blk = static_cast<double>(blocksize);
+
+	const double sumSQ = static_cast<double>(
+	    (slantedBlockSizeX * slantedBlockSizeX) +
+	    (slantedBlockSizeY * slantedBlockSizeY));
+	const double eblksz = ceil(
+	    sqrt(sumSQ)); // block size for extraction of slanted block
+	const double diff = (eblksz - blk);
+	this->blkoffset_ = static_cast<int>(
+	    ceil(diff / 2)); // overlapping border
+
+	this->mapRows_ = static_cast<int>(
+	    (static_cast<double>(rows) - diff) / blk);
+	this->mapCols_ = static_cast<int>(
+	    (static_cast<double>(cols) - diff) / blk);
+
+	this->maskBseg_ = cv::Mat::zeros(this->mapRows_, this->mapCols_,
+	    CV_8UC1);
+	this->covariance_ = cv::Mat::zeros(this->mapRows_, this->mapCols_,
+	    CV_64FC3);
+	this->blkorient_ = cv::Mat::zeros(this->mapRows_, this->mapCols_,
+	    CV_64F);
+
+	const int blkoffset = this->blkoffset_;
+	cv::Mat im_roi, maskB1;
+	double cova, covb, covc;
+	int br = 0;
+	int bc = 0;
+	for (int r = blkoffset; r < rows - (blocksize + blkoffset - 1);
+	     r += blocksize) {
+		for (int c = blkoffset; c < cols - (blocksize + blkoffset - 1);
+		     c += blocksize) {
+			im_roi = img(cv::Range(r, cv::min(r + blocksize, rows)),
+			    cv::Range(c, cv::min(c + blocksize, cols)));
+			maskB1 = this->maskim_(cv::Range(r,
+						   cv::min(r + blocksize,
+						       this->maskim_.rows)),
+			    cv::Range(c,
+				cv::min(c + blocksize, this->maskim_.cols)));
+			this->maskBseg_.at<uint8_t>(br, bc) = allfun(maskB1);
+
+			covcoef(im_roi, cova, covb, covc, CENTERED_DIFFERENCES);
+			this->covariance_.at<cv::Vec3d>(br, bc) = cv::Vec3d(
+			    cova, covb, covc);
+
+			// ridge ORIENT local
+			this->blkorient_.at<double>(br, bc) = ridgeorient(cova,
+			    covb, covc);
+
+			bc = bc + 1;
+		}
+		br = br + 1;
+		bc = 0;
+	}
+}
+
+bool
+NFIQ2::QualityMeasures::BlockGeometry::isCompatible(const int rows,
+    const int cols, const int blocksize, const double threshold,
+    const int slantedBlockSizeX, const int slantedBlockSizeY) const
+{
+	return ((this->rows_ == rows) && (this->cols_ == cols) &&
+	    (this->blocksize_ == blocksize) &&
+	    (this->threshold_ == threshold) &&
+	    (this->slantedBlockSizeX_ == slantedBlockSizeX) &&
+	    (this->slantedBlockSizeY_ == slantedBlockSizeY));
+}
+
+int
+NFIQ2::QualityMeasures::BlockGeometry::getBlockSize() const
+{
+	return (this->blocksize_);
+}
+
+int
+NFIQ2::QualityMeasures::BlockGeometry::getBlockOffset() const
+{
+	return (this->blkoffset_);
+}
+
+int
+NFIQ2::QualityMeasures::BlockGeometry::getMapRows() const
+{
+	return (this->mapRows_);
+}
+
+int
+NFIQ2::QualityMeasures::BlockGeometry::getMapCols() const
+{
+	return (this->mapCols_);
+}
+
+const cv::Mat &
+NFIQ2::QualityMeasures::BlockGeometry::getPixelMask() const
+{
+	return (this->maskim_);
+}
+
+const cv::Mat &
+NFIQ2::QualityMeasures::BlockGeometry::getBlockMask() const
+{
+	return (this->maskBseg_);
+}
+
+const cv::Mat &
+NFIQ2::QualityMeasures::BlockGeometry::getCovariance() const
+{
+	return (this->covariance_);
+}
+
+const cv::Mat &
+NFIQ2::QualityMeasures::BlockGeometry::getBlockOrientation() const
+{
+	return (this->blkorient_);
+}
@@ -1,17 +1,18 @@
 #include <nfiq2_exception.hpp>
 #include <nfiq2_timer.hpp>
 #include <opencv2/core.hpp>
+#include <quality_modules/AmplitudeSpectrum.h>
 #include <quality_modules/FDA.h>
 #include <quality_modules/common_functions.h>
 
 #include <cmath>
+#include <memory>
 #include <sstream>
 
 const char
     NFIQ2::Identifiers::QualityMeasureAlgorithms::FrequencyDomainAnalysis[] {
 	    "FrequencyDomainAnalysis"
     };
-static const char NFIQ2FDAPrefix[] { "FDA_Bin10_" };
 const char NFIQ2::Identifiers::QualityMeasures::FrequencyDomainAnalysis::
     Histogram::Bin0[] { "FDA_Bin10_0" };
 const char NFIQ2::Identifiers::QualityMeasures::FrequencyDomainAnalysis::
@@ -41,13 +42,30 @@ const char
 	    "FDA_Bin10_StdDev"
     };
 
-double fda(const cv::Mat &block, const double orientation, const int v1sz_x,
-    const int v1sz_y, const bool padFlag);
+namespace {
+/** Spectra of the slanted blocks, for the usual 32 pixel slanted width */
+using FDASpectrumBatch =
+    NFIQ2::QualityMeasures::AmplitudeSpectrumBatch<32, 16>;
+}
+
+void fdaProfile(const cv::Mat &block, const double orientation,
+    const int v1sz_x, const int v1sz_y, const bool padFlag,
+    NFIQ2::QualityMeasures::ScratchVector<double> &rowMeans);
+double fda(const NFIQ2::QualityMeasures::ScratchVector<double> &rowMeans);
+void fda(FDASpectrumBatch &batch,
+    NFIQ2::QualityMeasures::ScratchVector<double> &dataVector);
 
 NFIQ2::QualityMeasures::FDA::FDA(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	this->setFeatures(computeFeatureData(fingerprintImage));
+	this->setFeatures(computeFeatureData(fingerprintImage, nullptr));
+}
+
+NFIQ2::QualityMeasures::FDA::FDA(
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry &blockGeometry)
+{
+	this->setFeatures(computeFeatureData(fingerprintImage, &blockGeometry));
 }
 
 NFIQ2::QualityMeasures::FDA::~FDA() = default;
@@ -86,11 +104,14 @@ NFIQ2::QualityMeasures::FDA::getName() const
 	    FrequencyDomainAnalysis;
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::FDA::computeFeatureData(
-    const NFIQ2::FingerprintImageData &fingerprintImage)
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry *blockGeometry)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::FrequencyDomainAnalysisBin0, 12
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -102,7 +123,8 @@ NFIQ2::QualityMeasures::FDA::computeFeatureData(
 
 	// get matrix from fingerprint image
 	cv::Mat img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-	    CV_8UC1, (void *)fingerprintImage.data());
+	    CV_8UC1, (void *)fingerprintImage.pixels(),
+	    fingerprintImage.stride());
 
 	// ----------------------------
 	// compute Fda (taken from Rvu)
@@ -112,41 +134,42 @@ NFIQ2::QualityMeasures::FDA::computeFeatureData(
 	try {
 		timer.start();
 
-		cv::Mat maskim;
 		const int blksize = this->blocksize;
 		const int v1sz_x = this->slantedBlockSizeX;
 		const int v1sz_y = this->slantedBlockSizeY;
 
-		assert((blksize > 0) && (this->threshold > 0));
-
-		ridgesegment(img, blksize, this->threshold, cv::noArray(),
-		    maskim, cv::noArray());
+		// segment and orient locally unless shared with other modules
+		std::unique_ptr<BlockGeometry> localGeometry {};
+		if (blockGeometry == nullptr) {
+			localGeometry.reset(new BlockGeometry(img, blksize,
+			    this->threshold, v1sz_x, v1sz_y));
+			blockGeometry = localGeometry.get();
+		} else if (!blockGeometry->isCompatible(img.rows, img.cols,
+			       blksize, this->threshold, v1sz_x, v1sz_y)) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Cannot compute Frequency Domain Analysis (FDA): "
+			    "Block geometry does not match image or "
+			    "parameters");
+		}
 
 		int rows = img.rows;
 		int cols = img.cols;
-		double blk = static_cast<double>(blksize);
-
-		double sumSQ = static_cast<double>(
-		    (v1sz_x * v1sz_x) + (v1sz_y * v1sz_y));
-		double eblksz = ceil(
-		    sqrt(sumSQ)); // block size for extraction of slanted block
-		double diff = (eblksz - blk);
-		int blkoffset = static_cast<int>(
-		    ceil(diff / 2)); // overlapping border
-
-		int mapRows = static_cast<int>(
-		    (static_cast<double>(rows) - diff) / blk);
-		int mapCols = static_cast<int>(
-		    (static_cast<double>(cols) - diff) / blk);
-
-		cv::Mat fdas = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-		cv::Mat blkorient = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-		cv::Mat im_roi, blkwim;
-		cv::Mat maskB1;
-		double cova, covb, covc;
-
-		std::vector<double> dataVector;
-		dataVector.reserve(mapRows * mapCols);
+		const int blkoffset = blockGeometry->getBlockOffset();
+		const cv::Mat &maskBseg = blockGeometry->getBlockMask();
+		const cv::Mat &blkorient = blockGeometry->getBlockOrientation();
+
+		cv::Mat blkwim;
+		ScratchVector<double> rowMeans;
+
+		ScratchVector<double> dataVector;
+		dataVector.reserve(blockGeometry->getMapRows() *
+		    blockGeometry->getMapCols());
+
+		// Transform the profiles of many blocks at once when their
+		// padded length is the one of the specialized transform,
+		// flushing the batch before any other so that dataVector
+		// keeps the order of the blocks.
+		FDASpectrumBatch batch;
 
 		// Image processed NOT from beg to end but with a border around
 		// - can't be vectorized:(
@@ -157,24 +180,7 @@ NFIQ2::QualityMeasures::FDA::computeFeatureData(
 			for (int c = blkoffset;
 			     c < cols - (blksize + blkoffset - 1);
 			     c += blksize) {
-				im_roi = img(cv::Range(r,
-						 cv::min(r + blksize,
-						     img.rows)),
-				    cv::Range(c,
-					cv::min(c + blksize, img.cols)));
-				maskB1 = maskim(cv::Range(r,
-						    cv::min(r + blksize,
-							maskim.rows)),
-				    cv::Range(c,
-					cv::min(c + blksize, maskim.cols)));
-				uint8_t mask = allfun(maskB1);
-				if (mask == 1) {
-					covcoef(im_roi, cova, covb, covc,
-					    CENTERED_DIFFERENCES);
-
-					// ridge ORIENT local
-					blkorient.at<double>(br,
-					    bc) = ridgeorient(cova, covb, covc);
+				if (maskBseg.at<uint8_t>(br, bc) == 1) {
 					// overlapping windows (border =
 					// blkoffset)
 					blkwim = img(cv::Range(r - blkoffset,
@@ -184,17 +190,31 @@ NFIQ2::QualityMeasures::FDA::computeFeatureData(
 					    cv::Range(c - blkoffset,
 						cv::min(c + blksize + blkoffset,
 						    img.cols)));
-					fdas.at<double>(br, bc) = fda(blkwim,
+					fdaProfile(blkwim,
 					    blkorient.at<double>(br, bc),
-					    v1sz_x, v1sz_y, this->padFlag);
-					dataVector.push_back(
-					    fdas.at<double>(br, bc));
+					    v1sz_x, v1sz_y, this->padFlag,
+					    rowMeans);
+					const int length { static_cast<int>(
+					    rowMeans.size()) };
+					if (cv::getOptimalDFTSize(length) ==
+					    FDASpectrumBatch::Length) {
+						batch.push(rowMeans.data(),
+						    length);
+						if (batch.full()) {
+							fda(batch, dataVector);
+						}
+					} else {
+						fda(batch, dataVector);
+						dataVector.push_back(
+						    fda(rowMeans));
+					}
 				}
 				bc = bc + 1;
 			}
 			br = br + 1;
 			bc = 0;
 		}
+		fda(batch, dataVector);
 
 		const int binCount { 10 };
 		if (dataVector.size() < binCount) {
@@ -216,7 +236,8 @@ NFIQ2::QualityMeasures::FDA::computeFeatureData(
 		histogramBins10.push_back(FDAHISTLIMITS[6]);
 		histogramBins10.push_back(FDAHISTLIMITS[7]);
 		histogramBins10.push_back(FDAHISTLIMITS[8]);
-		addHistogramFeatures(featureDataList, NFIQ2FDAPrefix,
+		addHistogramFeatures(featureDataList,
+		    NativeQualityMeasure::FrequencyDomainAnalysisBin0,
 		    histogramBins10, dataVector, binCount);
 
 		this->setSpeed(timer.stop());
@@ -264,9 +285,10 @@ perpendicular to the ridge direction %                     within the block
 % 2011 Biometric Systems, Kenneth Skovhus Andersen & Lasse Bach Nielsen
 % The Technical University of Denmark, DTU
 */
-double
-fda(const cv::Mat &block, const double orientation, const int v1sz_x,
-    const int v1sz_y, const bool padFlag)
+void
+fdaProfile(const cv::Mat &block, const double orientation, const int v1sz_x,
+    const int v1sz_y, const bool padFlag,
+    NFIQ2::QualityMeasures::ScratchVector<double> &rowMeans)
 {
 	// sanity check: check block size
 	float cBlock = static_cast<float>(block.rows) / 2; // square block
@@ -280,39 +302,33 @@ fda(const cv::Mat &block, const double orientation, const int v1sz_x,
 		};
 	}
 
-	// rotate image to get the ridges horizontal using nearest-neighbor
-	// interpolation
-	cv::Mat blockRotated;
-	NFIQ2::QualityMeasures::getRotatedBlock(block, orientation + (M_PI / 2),
-	    padFlag, blockRotated);
-
 	//% set x and y
 	int xoff = v1sz_x / 2;
 	int yoff = v1sz_y / 2;
 
-	// extract slanted block by cropping the rotated image: To ensure that
-	// rotated image does not contain any invalid regions.
+	// rotate image to get the ridges horizontal using nearest-neighbor
+	// interpolation and extract slanted block by cropping the rotated
+	// image: To ensure that rotated image does not contain any invalid
+	// regions. Only the average of each row of the cropped block is
+	// needed, so the block is projected without rotating all of it.
 	//     Matlab:  blockCropped =
 	//     blockRotated(cBlock-(xoff-1):cBlock+xoff,cBlock-(yoff-1):cBlock+yoff);
 	//     % v2
 	// Note: Matlab uses matrix indices starting at 1, OpenCV starts at
 	// 0. Also, OpenCV ranges are open-ended on the upper end.
-
-	cv::Mat blockCropped = blockRotated(
+	NFIQ2::QualityMeasures::getRotatedBlockProfile(block,
+	    orientation + (M_PI / 2), padFlag,
 	    cv::Range((icBlock - (xoff - 1) - 1), (icBlock + xoff)),
-	    cv::Range((icBlock - (yoff - 1) - 1), (icBlock + yoff))); // v2
-
-	cv::Mat t = cv::Mat::zeros(blockCropped.rows, 1, CV_64F);
-	for (int r = 0; r < blockCropped.rows; r++) {
-		// get ROI for current row
-		cv::Mat roi = cv::Mat(blockCropped,
-		    cv::Rect(0, r, blockCropped.cols,
-			1)); // x,y, width, height
-		cv::Scalar s = mean(roi);
-		t.at<double>(r, 0) = s.val[0];
-		roi.release(); // is this required or does it auto clean when
-			       // done?
-	}
+	    cv::Range((icBlock - (yoff - 1) - 1), (icBlock + yoff)),
+	    NFIQ2::QualityMeasures::ROW_MEANS, rowMeans, cv::noArray()); // v2
+}
+
+/** FDA IQM of one block from the row means of its slanted block */
+double
+fda(const NFIQ2::QualityMeasures::ScratchVector<double> &rowMeans)
+{
+	const cv::Mat t(static_cast<int>(rowMeans.size()), 1, CV_64F,
+	    const_cast<double *>(rowMeans.data()));
 
 	// compute dft on transposed t (so using transposed dimensions)
 	cv::Mat tmpM;
@@ -352,3 +368,58 @@ fda(const cv::Mat &block, const double orientation, const int v1sz_x,
 			   amp.at<double>(0, mLoc.x + 1))) /
 	    iqmDenom.val[0];
 }
+
+/**
+ * FDA IQM of every block in `batch`, appended to `dataVector` in the order
+ * the blocks were added, which empties the batch. Same arithmetic as
+ * fda(rowMeans), including the order of the sum in the denominator
+ * (cv::sum() adds four elements at a time).
+ */
+void
+fda(FDASpectrumBatch &batch,
+    NFIQ2::QualityMeasures::ScratchVector<double> &dataVector)
+{
+	if (batch.size() == 0) {
+		return;
+	}
+	batch.compute();
+
+	// amplitudes without DC: bins 1 to N - 1
+	const int ampCols { FDASpectrumBatch::Length - 1 };
+	const int denomCols { ampCols / 2 };
+	for (int lane { 0 }; lane < batch.size(); ++lane) {
+		auto amp = [&](const int x) {
+			return batch.amplitude(lane, x + 1);
+		};
+
+		// first maximum, as cv::minMaxLoc()
+		int mLoc { 0 };
+		double mVal { amp(0) };
+		for (int x { 1 }; x < ampCols; ++x) {
+			if (amp(x) > mVal) {
+				mVal = amp(x);
+				mLoc = x;
+			}
+		}
+
+		double iqmDenom { 0 };
+		int x { 0 };
+		for (; x <= denomCols - 4; x += 4) {
+			iqmDenom += amp(x) + amp(x + 1) + amp(x + 2) +
+			    amp(x + 3);
+		}
+		for (; x < denomCols; ++x) {
+			iqmDenom += amp(x);
+		}
+
+		if (mLoc == 0 || mLoc + 1 >= ampCols) {
+			// ?????? FIXME
+			dataVector.push_back(1.0);
+		} else {
+			dataVector.push_back(
+			    (mVal + 0.3 * (amp(mLoc - 1) + amp(mLoc + 1))) /
+			    iqmDenom);
+		}
+	}
+	batch.clear();
+}
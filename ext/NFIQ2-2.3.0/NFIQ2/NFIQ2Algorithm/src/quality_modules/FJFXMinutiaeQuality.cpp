@@ -30,20 +30,13 @@ NFIQ2::QualityMeasures::FJFXMinutiaeQuality::getMinutiaData() const
 	return (this->minutiaData_);
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::FJFXMinutiaeQuality::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
-
-	std::pair<std::string, double> fd_mu;
-	fd_mu = std::make_pair(
-	    Identifiers::QualityMeasures::Minutiae::PercentImageMean50, -1);
-
-	std::pair<std::string, double> fd_ocl;
-	fd_ocl = std::make_pair(Identifiers::QualityMeasures::Minutiae::
-				    PercentOrientationCertainty80,
-	    -1);
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::MinutiaePercentImageMean50, 2
+	};
 
 	try {
 		NFIQ2::Timer timer;
@@ -77,9 +70,9 @@ NFIQ2::QualityMeasures::FJFXMinutiaeQuality::computeFeatureData(
 
 		// return mu_2 quality value
 		// return relative value in relation to minutiae count
-		fd_mu.second = (double)vecRanges.at(2) /
-		    (double)this->minutiaData_.size();
-		featureDataList[fd_mu.first] = fd_mu.second;
+		featureDataList.at(
+		    NativeQualityMeasure::MinutiaePercentImageMean50) =
+		    (double)vecRanges.at(2) / (double)this->minutiaData_.size();
 
 		// compute minutiae quality based on OCL feature computed at
 		// minutiae positions
@@ -110,9 +103,10 @@ NFIQ2::QualityMeasures::FJFXMinutiaeQuality::computeFeatureData(
 		}
 
 		// return relative value in relation to minutiae count
-		fd_ocl.second = (double)vecRangesOCL.at(4) /
+		featureDataList.at(
+		    NativeQualityMeasure::MinutiaePercentOrientationCertainty80) =
+		    (double)vecRangesOCL.at(4) /
 		    (double)this->minutiaData_.size();
-		featureDataList[fd_ocl.first] = fd_ocl.second;
 
 		this->setSpeed(timer.stop());
 	} catch (const cv::Exception &e) {
@@ -155,7 +149,8 @@ NFIQ2::QualityMeasures::FJFXMinutiaeQuality::computeMuMinQuality(int bs,
 
 	// get matrix from fingerprint image
 	cv::Mat img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-	    CV_8UC1, (void *)fingerprintImage.data());
+	    CV_8UC1, (void *)fingerprintImage.pixels(),
+	    fingerprintImage.stride());
 
 	// compute overall mean and stddev
 	cv::Scalar me;
@@ -209,7 +204,8 @@ NFIQ2::QualityMeasures::FJFXMinutiaeQuality::computeOCLMinQuality(int bs,
 
 	// get matrix from fingerprint image
 	cv::Mat img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-	    CV_8UC1, (void *)fingerprintImage.data());
+	    CV_8UC1, (void *)fingerprintImage.pixels(),
+	    fingerprintImage.stride());
 
 	// iterate through all minutiae positions and
 	// compute own minutiae quality values
@@ -2,10 +2,15 @@
 #include <nfiq2_timer.hpp>
 #include <opencv2/core.hpp>
 #include <quality_modules/FingerJetFX.h>
+#include <quality_modules/InstrumentationRecord.h>
+#include <quality_modules/ScratchArena.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <tuple>
 
@@ -19,6 +24,261 @@ const char NFIQ2::Identifiers::QualityMeasures::Minutiae::CountCOM[] {
 	"FingerJetFX_MinCount_COMMinRect200x200"
 };
 
+/*
+ * FRFXLL deprecates the entry points taking heap functions and working in
+ * place, which are exactly the ones needed to avoid its allocations.
+ */
+#if defined(__GNUC__)
+#define FJFX_ALLOW_DEPRECATED_BEGIN \
+	_Pragma("GCC diagnostic push") \
+	_Pragma("GCC diagnostic ignored \"-Wdeprecated-declarations\"")
+#define FJFX_ALLOW_DEPRECATED_END _Pragma("GCC diagnostic pop")
+#elif defined(_MSC_VER)
+#define FJFX_ALLOW_DEPRECATED_BEGIN \
+	__pragma(warning(push)) __pragma(warning(disable : 4996))
+#define FJFX_ALLOW_DEPRECATED_END __pragma(warning(pop))
+#else
+#define FJFX_ALLOW_DEPRECATED_BEGIN
+#define FJFX_ALLOW_DEPRECATED_END
+#endif
+
+namespace {
+
+/**
+ * @brief
+ * FRFXLL library context with a private heap, reused across images.
+ *
+ * @details
+ * For every image, FRFXLL allocates the same few objects (the feature
+ * extractor with its working buffer, the feature set and their handles)
+ * through the heap functions of the context. Blocks released by FRFXLL are
+ * kept and handed out again, so once a context has processed an image,
+ * extraction no longer reaches the system allocator.
+ *
+ * A context is only used by one thread at a time (see ContextLease).
+ */
+class PooledContext {
+    public:
+	PooledContext();
+	~PooledContext();
+
+	PooledContext(const PooledContext &) = delete;
+	PooledContext &operator=(const PooledContext &) = delete;
+
+	FRFXLL_HANDLE
+	getHandle() const
+	{
+		return (this->handle_);
+	}
+
+	/**
+	 * @return
+	 * Buffer of at least `size` bytes owned by this context, valid until
+	 * the next call.
+	 */
+	uint8_t *getImageBuffer(const size_t size);
+
+    private:
+	/** FRFXLL_CONTEXT_INIT::malloc */
+	static void *allocate(size_t size, void *heap);
+	/** FRFXLL_CONTEXT_INIT::free */
+	static void release(void *block, void *heap);
+
+	/** Precedes every block handed to FRFXLL */
+	struct alignas(std::max_align_t) BlockHeader {
+		size_t capacity;
+	};
+
+	/** Released blocks kept for reuse; more are returned to the system */
+	static const size_t MaxIdleBlocks { 16 };
+
+	FRFXLL_HANDLE handle_ {};
+	std::vector<BlockHeader *> idle_ {};
+	std::vector<uint8_t> imageBuffer_ {};
+};
+
+PooledContext::PooledContext()
+{
+	this->idle_.reserve(MaxIdleBlocks);
+
+	/*
+	 * The optional interlocked functions are left to FRFXLL's
+	 * non-atomic defaults: the objects of a context are never used by
+	 * two threads at once.
+	 */
+	FRFXLL_CONTEXT_INIT init {};
+	init.length = sizeof(init);
+	init.heapContext = this;
+	init.malloc = &PooledContext::allocate;
+	init.free = &PooledContext::release;
+
+	/*
+	 * FRFXLLCreateLibraryContext() cannot take heap functions. Context
+	 * settings are overridden for NFIQ2 by both.
+	 */
+	FJFX_ALLOW_DEPRECATED_BEGIN
+	const FRFXLL_RESULT rc = FRFXLLCreateContext(&init, &this->handle_);
+	FJFX_ALLOW_DEPRECATED_END
+
+	if (!FRFXLL_SUCCESS(rc)) {
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::FJFX_CannotCreateContext,
+		    "Cannot create context of feature extraction (create "
+		    "context failed).");
+	}
+	if (this->handle_ == NULL) {
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::FJFX_CannotCreateContext,
+		    "Cannot create context of feature extraction (hCtx is "
+		    "NULL).");
+	}
+}
+
+PooledContext::~PooledContext()
+{
+	/* Releases the context object itself into idle_ */
+	FRFXLLCloseHandle(&this->handle_);
+
+	for (BlockHeader *block : this->idle_) {
+		std::free(block);
+	}
+}
+
+uint8_t *
+PooledContext::getImageBuffer(const size_t size)
+{
+	if (this->imageBuffer_.size() < size) {
+		this->imageBuffer_.resize(size);
+	}
+
+	return (this->imageBuffer_.data());
+}
+
+void *
+PooledContext::allocate(size_t size, void *heap)
+{
+	PooledContext *context = static_cast<PooledContext *>(heap);
+
+	/* Smallest idle block that fits */
+	auto best = context->idle_.end();
+	for (auto it = context->idle_.begin(); it != context->idle_.end();
+	     ++it) {
+		if (((*it)->capacity >= size) &&
+		    ((best == context->idle_.end()) ||
+			((*it)->capacity < (*best)->capacity))) {
+			best = it;
+		}
+	}
+
+	BlockHeader *block {};
+	if (best != context->idle_.end()) {
+		block = *best;
+		*best = context->idle_.back();
+		context->idle_.pop_back();
+	} else {
+		if (size > static_cast<size_t>(-1) - sizeof(BlockHeader)) {
+			return (nullptr);
+		}
+		block = static_cast<BlockHeader *>(
+		    std::malloc(sizeof(BlockHeader) + size));
+		if (block == nullptr) {
+			return (nullptr);
+		}
+		block->capacity = size;
+	}
+
+	return (block + 1);
+}
+
+void
+PooledContext::release(void *block, void *heap)
+{
+	if (block == nullptr) {
+		return;
+	}
+
+	PooledContext *context = static_cast<PooledContext *>(heap);
+	BlockHeader *header = static_cast<BlockHeader *>(block) - 1;
+	if (context->idle_.size() < MaxIdleBlocks) {
+		context->idle_.push_back(header);
+	} else {
+		std::free(header);
+	}
+}
+
+/**
+ * @brief
+ * Exclusive use of a PooledContext while the lease exists.
+ *
+ * @details
+ * Idle contexts are shared by all threads rather than owned by one: the
+ * persistent workers of the module thread pool and the callers' threads
+ * (including any they start per batch) all reuse the contexts (and heaps)
+ * of earlier images, whichever Algorithm computed them. Only as many
+ * contexts exist as extractions ever ran at once, instead of one per
+ * thread that ever ran one, kept until that thread exits.
+ */
+class ContextLease {
+    public:
+	ContextLease();
+	~ContextLease();
+
+	ContextLease(const ContextLease &) = delete;
+	ContextLease &operator=(const ContextLease &) = delete;
+
+	PooledContext *
+	operator->() const
+	{
+		return (this->context_.get());
+	}
+
+    private:
+	struct IdleContexts {
+		std::mutex mutex {};
+		std::vector<std::unique_ptr<PooledContext>> contexts {};
+	};
+
+	static IdleContexts &getIdleContexts();
+
+	std::unique_ptr<PooledContext> context_ {};
+};
+
+ContextLease::IdleContexts &
+ContextLease::getIdleContexts()
+{
+	static IdleContexts idle {};
+	return (idle);
+}
+
+ContextLease::ContextLease()
+{
+	IdleContexts &idle = getIdleContexts();
+	{
+		const std::lock_guard<std::mutex> lock(idle.mutex);
+		if (!idle.contexts.empty()) {
+			this->context_ = std::move(idle.contexts.back());
+			idle.contexts.pop_back();
+		}
+	}
+
+	if (this->context_ == nullptr) {
+		this->context_.reset(new PooledContext());
+	}
+}
+
+ContextLease::~ContextLease()
+{
+	IdleContexts &idle = getIdleContexts();
+	try {
+		const std::lock_guard<std::mutex> lock(idle.mutex);
+		idle.contexts.push_back(std::move(this->context_));
+	} catch (...) {
+		/* Not kept for reuse, destroyed with the lease */
+	}
+}
+
+}
+
 NFIQ2::QualityMeasures::FingerJetFX::FingerJetFX(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
@@ -84,11 +344,20 @@ NFIQ2::QualityMeasures::FingerJetFX::getMinutiaData() const
 	return (this->minutiaData_);
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList { NativeQualityMeasure::
+						   MinutiaeCountCOM,
+		2 };
+
+	NFIQ2::Timer timer;
+	timer.start();
+
+	// borrow a context for feature extraction, creating it if all are in
+	// use. Context settings are overridden for NFIQ2 on creation.
+	const ContextLease context {};
 
 	/*
 	 * FingerJet FX has a minimum image size, but it doesn't mind extra
@@ -98,76 +367,76 @@ NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
 	 */
 	static const uint32_t fingerJetMinWidth { 196 };
 	static const uint32_t fingerJetMinHeight { 196 };
-	cv::Mat biggerImageCV {};
 	const bool imageTooSmall { (fingerprintImage.width <
 				       fingerJetMinWidth) ||
 		(fingerprintImage.height < fingerJetMinHeight) };
-	if (imageTooSmall) {
+	const uint32_t imageWidth { std::max(fingerprintImage.width,
+	    fingerJetMinWidth) };
+	const uint32_t imageHeight { std::max(fingerprintImage.height,
+	    fingerJetMinHeight) };
+
+	/* FingerJet FX also needs rows without gaps; pack views with gaps */
+	const bool imageStrided { fingerprintImage.stride() !=
+		fingerprintImage.width };
+	uint8_t *imageCopy {};
+	if (imageTooSmall || imageStrided) {
 		const cv::Mat originalImage(fingerprintImage.height,
 		    fingerprintImage.width, CV_8UC1,
-		    (uint8_t *)fingerprintImage.data());
-
-		biggerImageCV = cv::Mat(std::max(fingerprintImage.height,
-					    fingerJetMinHeight),
-		    std::max(fingerprintImage.width, fingerJetMinWidth),
-		    CV_8UC1);
-		static const uint8_t whitePixel { 255 };
-		biggerImageCV = whitePixel;
-		originalImage.copyTo(biggerImageCV(cv::Rect(0, 0,
+		    (uint8_t *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
+
+		imageCopy = context->getImageBuffer(
+		    static_cast<size_t>(imageWidth) * imageHeight);
+		cv::Mat imageCopyCV(imageHeight, imageWidth, CV_8UC1,
+		    imageCopy);
+		if (imageTooSmall) {
+			static const uint8_t whitePixel { 255 };
+			imageCopyCV = whitePixel;
+		}
+		originalImage.copyTo(imageCopyCV(cv::Rect(0, 0,
 		    fingerprintImage.width, fingerprintImage.height)));
 	}
 
-	std::pair<std::string, double> fd_min_cnt;
-	fd_min_cnt =
-	    std::make_pair(Identifiers::QualityMeasures::Minutiae::Count, 0);
-
-	std::pair<std::string, double> fd_min_cnt_comrect200x200;
-	fd_min_cnt_comrect200x200 =
-	    std::make_pair(Identifiers::QualityMeasures::Minutiae::CountCOM, 0);
-
-	NFIQ2::Timer timer;
-	timer.start();
-
-	// create context for feature extraction
-	// the created context function is modified to override default settings
-	FRFXLL_HANDLE hCtx = NULL, hFeatureSet = NULL;
-	if (!FRFXLL_SUCCESS(createContext(&hCtx))) {
-		throw NFIQ2::Exception(
-		    NFIQ2::ErrorCode::FJFX_CannotCreateContext,
-		    "Cannot create context of feature extraction (create "
-		    "context failed).");
-	}
-	if (hCtx == NULL) {
-		throw NFIQ2::Exception(
-		    NFIQ2::ErrorCode::FJFX_CannotCreateContext,
-		    "Cannot create context of feature extraction (hCtx is "
-		    "NULL).");
+	const uint64_t imageDataSize { imageCopy != nullptr ?
+		    static_cast<uint64_t>(imageWidth) * imageHeight :
+		    fingerprintImage.pixelsSize() };
+
+	// extract feature set. A padded or packed copy belongs to this
+	// extraction, so FRFXLL may use it as its working buffer (500 PPI
+	// only).
+	FRFXLL_HANDLE hFeatureSet = NULL;
+	const bool inPlace { (imageCopy != nullptr) &&
+		(fingerprintImage.ppi ==
+		    NFIQ2::FingerprintImageData::Resolution500PPI) };
+	FRFXLL_RESULT fxRes {};
+	{
+		const InstrumentationRecord::StageTimer timer {
+			Instrumentation::Stage::FingerJetFXExtraction
+		};
+		if (inPlace) {
+			FJFX_ALLOW_DEPRECATED_BEGIN
+			fxRes = FRFXLLCreateFeatureSetInPlaceFromRaw(
+			    context->getHandle(), imageCopy, imageDataSize,
+			    imageWidth, imageHeight, fingerprintImage.ppi,
+			    FRFXLL_FEX_ENABLE_ENHANCEMENT, &hFeatureSet);
+			FJFX_ALLOW_DEPRECATED_END
+		} else {
+			fxRes = FRFXLLCreateFeatureSetFromRaw(
+			    context->getHandle(),
+			    imageCopy != nullptr ? imageCopy :
+						   fingerprintImage.pixels(),
+			    imageDataSize, imageWidth, imageHeight,
+			    fingerprintImage.ppi,
+			    FRFXLL_FEX_ENABLE_ENHANCEMENT, &hFeatureSet);
+		}
 	}
-
-	const uint8_t *imageDataPtr { imageTooSmall ? biggerImageCV.ptr() :
-						      fingerprintImage.data() };
-	const uint32_t imageWidth { imageTooSmall ? biggerImageCV.cols :
-						    fingerprintImage.width };
-	const uint32_t imageHeight { imageTooSmall ? biggerImageCV.rows :
-						     fingerprintImage.height };
-	const uint64_t imageDataSize { imageTooSmall ?
-		    imageWidth * imageHeight :
-		    fingerprintImage.size() };
-
-	// extract feature set
-	const FRFXLL_RESULT fxRes = FRFXLLCreateFeatureSetFromRaw(hCtx,
-	    imageDataPtr, imageDataSize, imageWidth, imageHeight,
-	    fingerprintImage.ppi, FRFXLL_FEX_ENABLE_ENHANCEMENT, &hFeatureSet);
 	if (!FRFXLL_SUCCESS(fxRes)) {
-		FRFXLLCloseHandle(&hCtx);
 		throw NFIQ2::Exception(
 		    NFIQ2::ErrorCode::FJFX_CannotCreateFeatureSet,
 		    "Could not create feature set from raw data: " +
 			FingerJetFX::parseFRFXLLError(fxRes));
 	}
 
-	// close handle
-	FRFXLLCloseHandle(&hCtx);
 	if (hFeatureSet == NULL) {
 		throw NFIQ2::Exception(
 		    NFIQ2::ErrorCode::FJFX_CannotCreateFeatureSet,
@@ -185,9 +454,9 @@ NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
 			FingerJetFX::parseFRFXLLError(fxResMin));
 	}
 
-	std::unique_ptr<FRFXLL_Basic_19794_2_Minutia[]> mdata {};
+	ScratchVector<FRFXLL_Basic_19794_2_Minutia> mdata {};
 	try {
-		mdata.reset(new FRFXLL_Basic_19794_2_Minutia[minCnt]);
+		mdata.resize(minCnt);
 	} catch (const std::bad_alloc &) {
 		FRFXLLCloseHandle(&hFeatureSet);
 		throw NFIQ2::Exception(NFIQ2::ErrorCode::NotEnoughMemory,
@@ -195,7 +464,7 @@ NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
 	}
 
 	const FRFXLL_RESULT fxResData = FRFXLLGetMinutiae(hFeatureSet,
-	    BASIC_19794_2_MINUTIA_STRUCT, &minCnt, mdata.get());
+	    BASIC_19794_2_MINUTIA_STRUCT, &minCnt, mdata.data());
 	if (!FRFXLL_SUCCESS(fxResData)) {
 		FRFXLLCloseHandle(&hFeatureSet);
 		throw NFIQ2::Exception(
@@ -229,12 +498,10 @@ NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
 
 	if (minCnt == 0) {
 		// return features
-		fd_min_cnt_comrect200x200.second = 0; // no minutiae found
-		featureDataList[fd_min_cnt_comrect200x200.first] =
-		    fd_min_cnt_comrect200x200.second;
-
-		fd_min_cnt.second = 0; // no minutiae found
-		featureDataList[fd_min_cnt.first] = fd_min_cnt.second;
+		featureDataList.at(NativeQualityMeasure::MinutiaeCountCOM) =
+		    0; // no minutiae found
+		featureDataList.at(NativeQualityMeasure::MinutiaeCount) =
+		    0; // no minutiae found
 
 		this->setSpeed(timer.stop());
 
@@ -269,12 +536,9 @@ NFIQ2::QualityMeasures::FingerJetFX::computeFeatureData(
 	}
 
 	// return features
-	fd_min_cnt_comrect200x200.second = noOfMinInRect200x200;
-	featureDataList[fd_min_cnt_comrect200x200.first] =
-	    fd_min_cnt_comrect200x200.second;
-
-	fd_min_cnt.second = minCnt;
-	featureDataList[fd_min_cnt.first] = fd_min_cnt.second;
+	featureDataList.at(NativeQualityMeasure::MinutiaeCountCOM) =
+	    noOfMinInRect200x200;
+	featureDataList.at(NativeQualityMeasure::MinutiaeCount) = minCnt;
 
 	this->setSpeed(timer.stop());
 
@@ -294,21 +558,6 @@ NFIQ2::QualityMeasures::FingerJetFX::getNativeQualityMeasureIDs()
 		Identifiers::QualityMeasures::Minutiae::Count };
 }
 
-FRFXLL_RESULT
-NFIQ2::QualityMeasures::FingerJetFX::createContext(FRFXLL_HANDLE_PT phContext)
-{
-	FRFXLL_RESULT rc = FRFXLL_OK;
-
-	FRFXLL_HANDLE h_context = NULL;
-
-	rc = FRFXLLCreateLibraryContext(&h_context);
-	if (FRFXLL_SUCCESS(rc)) {
-		*phContext = h_context;
-	}
-
-	return rc;
-}
-
 NFIQ2::QualityMeasures::FingerJetFX::FJFXROIResults
 NFIQ2::QualityMeasures::FingerJetFX::computeROI(int bs,
     const NFIQ2::FingerprintImageData &fingerprintImage,
@@ -3,6 +3,7 @@
 #include <opencv2/imgproc.hpp>
 #include <quality_modules/ImgProcROI.h>
 
+#include <algorithm>
 #include <sstream>
 
 const char
@@ -32,11 +33,13 @@ NFIQ2::QualityMeasures::ImgProcROI::getImgProcResults()
 	return (this->imgProcResults_);
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::ImgProcROI::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::RegionOfInterestMean, 1
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -50,7 +53,8 @@ NFIQ2::QualityMeasures::ImgProcROI::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -70,12 +74,8 @@ NFIQ2::QualityMeasures::ImgProcROI::computeFeatureData(
 		this->imgProcResults_ = computeROI(img,
 		    Sizes::LocalRegionSquare);
 
-		std::pair<std::string, double> fd_roi_pixel_area_mean;
-		fd_roi_pixel_area_mean = std::make_pair(
-		    Identifiers::QualityMeasures::RegionOfInterest::Mean,
-		    this->imgProcResults_.meanOfROIPixels);
-		featureDataList[fd_roi_pixel_area_mean.first] =
-		    fd_roi_pixel_area_mean.second;
+		featureDataList.at(NativeQualityMeasure::RegionOfInterestMean) =
+		    this->imgProcResults_.meanOfROIPixels;
 
 		this->setSpeed(timer.stop());
 	} catch (const cv::Exception &e) {
@@ -157,41 +157,25 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 	}
 
 	// 7. remove smaller blobs at the edges that are not part of the
-	// fingerprint
-	cv::Mat ffImg = threshImg2.clone();
-	cv::Point point;
-	std::vector<cv::Rect> vecRects;
-	std::vector<cv::Point> vecPoints;
-	while (isBlackPixelAvailable(ffImg, point)) {
-		// execute flood fill algorithm starting with discovered seed
-		// and save flooded area on copied image
-		cv::Rect rect;
-		cv::floodFill(ffImg, point, cv::Scalar(255, 255, 255, 0),
-		    &rect);
-		vecRects.push_back(rect);
-		vecPoints.push_back(point);
-	}
-
-	// find largest region based on returned area
-	unsigned int maxIdx = 0;
+	// fingerprint: keep the black region with the largest bounding box
+	// (the first found in raster order on ties), as flood filling every
+	// region would, and whiten the others
+	cv::Mat labels;
+	std::vector<BlackRegion> regions;
+	labelBlackRegions(threshImg2, img, labels, regions);
+
+	int largest = -1;
 	int maxSize = 0;
-	for (unsigned int i = 0; i < vecRects.size(); i++) {
-		if ((vecRects.at(i).width * vecRects.at(i).height) > maxSize) {
-			maxIdx = i;
-			maxSize = (vecRects.at(i).width *
-			    vecRects.at(i).height);
+	for (int i = 0; i < static_cast<int>(regions.size()); i++) {
+		const BlackRegion &region = regions[i];
+		if (region.parent != i) {
+			continue;
 		}
-	}
-
-	// now apply floodfill algorithm on all areas that are not the biggest
-	// one
-	for (unsigned int i = 0; i < vecRects.size(); i++) {
-		if (i != maxIdx) {
-			// apply floodfill on original image
-			// start seed first detected point
-			cv::floodFill(threshImg2,
-			    cv::Point(vecPoints.at(i).x, vecPoints.at(i).y),
-			    cv::Scalar(255, 255, 255, 0));
+		const int size = (region.maxX - region.minX + 1) *
+		    (region.maxY - region.minY + 1);
+		if (size > maxSize) {
+			largest = i;
+			maxSize = size;
 		}
 	}
 
@@ -199,15 +183,10 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 	// and get mean value of ROI pixels
 	unsigned int noOfROIPixels = 0;
 	double meanOfROIPixels = 0.0;
-	for (int i = 0; i < threshImg2.rows; i++) {
-		for (int j = 0; j < threshImg2.cols; j++) {
-			if (((int)threshImg2.at<uchar>(i, j)) == 0) {
-				noOfROIPixels++;
-				// get gray value of original image (0 = black,
-				// 255 = white)
-				meanOfROIPixels += (int)img.at<uchar>(i, j);
-			}
-		}
+	if (largest >= 0) {
+		noOfROIPixels = regions[largest].pixels;
+		meanOfROIPixels = static_cast<double>(
+		    regions[largest].graySum);
 	}
 	// divide value by absolute number of ROI pixels to get mean
 	if (noOfROIPixels <= 0) {
@@ -216,18 +195,26 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 		meanOfROIPixels = (meanOfROIPixels / (double)noOfROIPixels);
 	}
 
-	// get standard deviation of ORI pixels
+	// clear the other regions and get standard deviation of ROI pixels,
+	// summed in raster order
 	double sumSquare = 0.0;
 	for (int i = 0; i < threshImg2.rows; i++) {
+		const int *labelRow = labels.ptr<int>(i);
+		const uchar *imgRow = img.ptr<uchar>(i);
+		uchar *roiRow = threshImg2.ptr<uchar>(i);
 		for (int j = 0; j < threshImg2.cols; j++) {
-			if (((int)threshImg2.at<uchar>(i, j)) == 0) {
-				// get gray value of original image (0 = black,
-				// 255 = white)
-				unsigned int x = (unsigned int)img.at<uchar>(i,
-				    j);
-				sumSquare += (((double)x - meanOfROIPixels) *
-				    ((double)x - meanOfROIPixels));
+			if (labelRow[j] < 0) {
+				continue;
+			}
+			if (regions[labelRow[j]].parent != largest) {
+				roiRow[j] = 255;
+				continue;
 			}
+			// get gray value of original image (0 = black,
+			// 255 = white)
+			const double x = imgRow[j];
+			sumSquare += ((x - meanOfROIPixels) *
+			    (x - meanOfROIPixels));
 		}
 	}
 	sumSquare = (1.0 / ((double)noOfROIPixels - 1.0) * sumSquare);
@@ -243,6 +230,10 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 
 	unsigned int noOfAllBlocks = 0;
 	unsigned int noOfCompleteBlocks = 0;
+	const unsigned int noOfBlockColumns = (width + bs - 1) / bs;
+	const unsigned int noOfBlockRows = (height + bs - 1) / bs;
+	roiResults.roiBlockIndex.assign(
+	    static_cast<size_t>(noOfBlockColumns) * noOfBlockRows, -1);
 	for (unsigned int i = 0; i < height; i += bs) {
 		for (unsigned int j = 0; j < width; j += bs) {
 			unsigned int takenBS_X = bs;
@@ -267,6 +258,12 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 				cv::rectangle(bsImg, cv::Point(j, i),
 				    cv::Point(j + takenBS_X, i + takenBS_Y),
 				    cv::Scalar(0, 0, 0, 0), cv::FILLED);
+				const unsigned int cell = ((i / bs) *
+							      noOfBlockColumns) +
+				    (j / bs);
+				roiResults.roiBlockIndex[cell] =
+				    static_cast<int>(
+					roiResults.vecROIBlocks.size());
 				roiResults.vecROIBlocks.push_back(
 				    cv::Rect(j, i, takenBS_X, takenBS_Y));
 			}
@@ -274,6 +271,7 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 	}
 
 	roiResults.chosenBlockSize = bs;
+	roiResults.noOfBlockColumns = noOfBlockColumns;
 	roiResults.noOfAllBlocks = noOfAllBlocks;
 	roiResults.noOfCompleteBlocks = noOfCompleteBlocks;
 	roiResults.noOfImagePixels = (img.cols * img.rows);
@@ -285,22 +283,103 @@ NFIQ2::QualityMeasures::ImgProcROI::computeROI(cv::Mat &img, unsigned int bs)
 }
 
 bool
-NFIQ2::QualityMeasures::ImgProcROI::isBlackPixelAvailable(cv::Mat &img,
-    cv::Point &point)
+NFIQ2::QualityMeasures::ImgProcROI::ImgProcROIResults::isROIBlock(
+    const cv::Rect &block) const
 {
-	bool found = false;
-	for (int i = 0; i < img.rows; i++) {
-		for (int j = 0; j < img.cols; j++) {
-			if (((int)img.at<uchar>(i, j)) == 0) {
-				point.x = j;
-				point.y = i;
-				found = true;
-				break;
+	// vecROIBlocks only contains blocks of the grid
+	const int bs = static_cast<int>(this->chosenBlockSize);
+	if ((bs <= 0) || (block.x < 0) || (block.y < 0) ||
+	    ((block.x % bs) != 0) || ((block.y % bs) != 0)) {
+		return false;
+	}
+
+	const size_t column = static_cast<size_t>(block.x / bs);
+	const size_t cell = (static_cast<size_t>(block.y / bs) *
+				this->noOfBlockColumns) +
+	    column;
+	if ((column >= this->noOfBlockColumns) ||
+	    (cell >= this->roiBlockIndex.size())) {
+		return false;
+	}
+
+	const int index = this->roiBlockIndex[cell];
+	return ((index >= 0) && (this->vecROIBlocks[index] == block));
+}
+
+void
+NFIQ2::QualityMeasures::ImgProcROI::labelBlackRegions(const cv::Mat &binImg,
+    const cv::Mat &img, cv::Mat &labels, std::vector<BlackRegion> &regions)
+{
+	// regions are numbered in the order their first pixel is scanned, and
+	// merged regions always keep the lower number, so roots are found in
+	// the same order as a raster search for seeds would find them
+	const auto findRoot = [&regions](int label) {
+		while (regions[label].parent != label) {
+			regions[label].parent =
+			    regions[regions[label].parent].parent;
+			label = regions[label].parent;
+		}
+		return label;
+	};
+
+	labels.create(binImg.rows, binImg.cols, CV_32SC1);
+	regions.clear();
+	for (int i = 0; i < binImg.rows; i++) {
+		const uchar *binRow = binImg.ptr<uchar>(i);
+		const uchar *imgRow = img.ptr<uchar>(i);
+		const int *aboveRow = (i > 0) ? labels.ptr<int>(i - 1) :
+						nullptr;
+		int *labelRow = labels.ptr<int>(i);
+		for (int j = 0; j < binImg.cols; j++) {
+			if (binRow[j] != 0) {
+				labelRow[j] = -1;
+				continue;
+			}
+
+			// 4-connected, like cv::floodFill()
+			const int above = (aboveRow != nullptr) ? aboveRow[j] :
+								  -1;
+			const int left = (j > 0) ? labelRow[j - 1] : -1;
+			int label;
+			if ((above < 0) && (left < 0)) {
+				label = static_cast<int>(regions.size());
+				regions.push_back({ label, j, i, j, i, 0, 0 });
+			} else if (above < 0) {
+				label = left;
+			} else if ((left < 0) || (left == above)) {
+				label = above;
+			} else {
+				const int aboveRoot = findRoot(above);
+				const int leftRoot = findRoot(left);
+				label = std::min(aboveRoot, leftRoot);
+				regions[std::max(aboveRoot, leftRoot)].parent =
+				    label;
 			}
+			labelRow[j] = label;
+
+			BlackRegion &region = regions[label];
+			region.minX = std::min(region.minX, j);
+			region.maxX = std::max(region.maxX, j);
+			region.maxY = i;
+			region.pixels++;
+			region.graySum += imgRow[j];
 		}
-		if (found) {
-			break;
+	}
+
+	// fold every region into its root, lowest numbers first, so that
+	// parent is the root of every region afterwards
+	for (int i = 0; i < static_cast<int>(regions.size()); i++) {
+		const int root = findRoot(i);
+		if (root == i) {
+			continue;
 		}
+		BlackRegion &region = regions[root];
+		region.minX = std::min(region.minX, regions[i].minX);
+		region.minY = std::min(region.minY, regions[i].minY);
+		region.maxX = std::max(region.maxX, regions[i].maxX);
+		region.maxY = std::max(region.maxY, regions[i].maxY);
+		region.pixels += regions[i].pixels;
+		region.graySum += regions[i].graySum;
+		regions[i].parent = root;
 	}
-	return found;
 }
@@ -0,0 +1,133 @@
+#include <quality_modules/InstrumentationRecord.h>
+
+#include <limits>
+
+namespace {
+
+using NFIQ2::QualityMeasures::InstrumentationRecord;
+
+thread_local InstrumentationRecord *currentRecord { nullptr };
+
+/** Add `value` to a measurement that is -1 until first added to */
+void
+accumulate(std::atomic<int64_t> &measurement, const int64_t value)
+{
+	int64_t previous = measurement.load(std::memory_order_relaxed);
+	while (!measurement.compare_exchange_weak(previous,
+	    (previous < 0 ? 0 : previous) + value,
+	    std::memory_order_relaxed)) { }
+}
+
+/** @return `nanoseconds` in milliseconds, NaN if negative (not run) */
+double
+toMilliseconds(const int64_t nanoseconds)
+{
+	if (nanoseconds < 0) {
+		return (std::numeric_limits<double>::quiet_NaN());
+	}
+	return (static_cast<double>(nanoseconds) / 1e6);
+}
+
+}
+
+NFIQ2::QualityMeasures::InstrumentationRecord::StageTimer::StageTimer(
+    const Instrumentation::Stage::Stage stage)
+    : record_ { currentRecord }
+    , stage_ { stage }
+{
+	if (this->record_ != nullptr) {
+		this->start_ = std::chrono::steady_clock::now();
+	}
+}
+
+NFIQ2::QualityMeasures::InstrumentationRecord::StageTimer::~StageTimer()
+{
+	if (this->record_ != nullptr) {
+		this->record_->addStage(this->stage_,
+		    std::chrono::steady_clock::now() - this->start_);
+	}
+}
+
+NFIQ2::QualityMeasures::InstrumentationRecord::InstrumentationRecord()
+{
+	for (auto &nanoseconds : this->algorithmNanoseconds_) {
+		nanoseconds.store(-1, std::memory_order_relaxed);
+	}
+	for (auto &nanoseconds : this->stageNanoseconds_) {
+		nanoseconds.store(-1, std::memory_order_relaxed);
+	}
+}
+
+NFIQ2::QualityMeasures::InstrumentationRecord *
+NFIQ2::QualityMeasures::InstrumentationRecord::current()
+{
+	return (currentRecord);
+}
+
+NFIQ2::QualityMeasures::InstrumentationRecord *
+NFIQ2::QualityMeasures::InstrumentationRecord::setCurrent(
+    InstrumentationRecord *record)
+{
+	InstrumentationRecord *previous = currentRecord;
+	currentRecord = record;
+	return (previous);
+}
+
+void
+NFIQ2::QualityMeasures::InstrumentationRecord::addStage(
+    const Instrumentation::Stage::Stage stage,
+    const std::chrono::steady_clock::duration duration)
+{
+	accumulate(this->stageNanoseconds_.at(stage),
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+		.count());
+}
+
+void
+NFIQ2::QualityMeasures::InstrumentationRecord::addAlgorithm(
+    const unsigned int position, const double milliseconds)
+{
+	accumulate(this->algorithmNanoseconds_.at(position),
+	    static_cast<int64_t>(milliseconds * 1e6));
+}
+
+void
+NFIQ2::QualityMeasures::InstrumentationRecord::addAllocations(
+    const uint64_t scratchAllocations, const uint64_t systemAllocations)
+{
+	this->scratchAllocations_.fetch_add(scratchAllocations,
+	    std::memory_order_relaxed);
+	this->systemAllocations_.fetch_add(systemAllocations,
+	    std::memory_order_relaxed);
+}
+
+void
+NFIQ2::QualityMeasures::InstrumentationRecord::setForegroundBlocks(
+    const int64_t foregroundBlocks)
+{
+	this->foregroundBlocks_.store(foregroundBlocks,
+	    std::memory_order_relaxed);
+}
+
+NFIQ2::Instrumentation::Measurements
+NFIQ2::QualityMeasures::InstrumentationRecord::getMeasurements() const
+{
+	Instrumentation::Measurements measurements {};
+	for (unsigned int i { 0 }; i < Instrumentation::AlgorithmCount; ++i) {
+		measurements.algorithmMilliseconds[i] = toMilliseconds(
+		    this->algorithmNanoseconds_[i].load(
+			std::memory_order_relaxed));
+	}
+	for (unsigned int i { 0 }; i < Instrumentation::StageCount; ++i) {
+		measurements.stageMilliseconds[i] = toMilliseconds(
+		    this->stageNanoseconds_[i].load(std::memory_order_relaxed));
+	}
+	measurements.scratchAllocations = this->scratchAllocations_.load(
+	    std::memory_order_relaxed);
+	measurements.systemAllocations = this->systemAllocations_.load(
+	    std::memory_order_relaxed);
+	measurements.foregroundBlocks = this->foregroundBlocks_.load(
+	    std::memory_order_relaxed);
+
+	return (measurements);
+}
@@ -4,12 +4,13 @@
 #include <quality_modules/LCS.h>
 #include <quality_modules/common_functions.h>
 
+#include <array>
+#include <memory>
 #include <sstream>
 
 const char NFIQ2::Identifiers::QualityMeasureAlgorithms::LocalClarity[] {
 	"LocalClarity"
 };
-static const char NFIQ2LCSPrefix[] { "LCS_Bin10_" };
 const char
     NFIQ2::Identifiers::QualityMeasures::LocalClarity::Histogram::Bin0[] {
 	    "LCS_Bin10_0"
@@ -63,7 +64,14 @@ double loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 NFIQ2::QualityMeasures::LCS::LCS(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	this->setFeatures(computeFeatureData(fingerprintImage));
+	this->setFeatures(computeFeatureData(fingerprintImage, nullptr));
+}
+
+NFIQ2::QualityMeasures::LCS::LCS(
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry &blockGeometry)
+{
+	this->setFeatures(computeFeatureData(fingerprintImage, &blockGeometry));
 }
 
 NFIQ2::QualityMeasures::LCS::~LCS() = default;
@@ -91,11 +99,14 @@ NFIQ2::QualityMeasures::LCS::getNativeQualityMeasureIDs()
 		Identifiers::QualityMeasures::LocalClarity::StdDev };
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::LCS::computeFeatureData(
-    const NFIQ2::FingerprintImageData &fingerprintImage)
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry *blockGeometry)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::LocalClarityBin0, 12
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -109,7 +120,8 @@ NFIQ2::QualityMeasures::LCS::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -129,39 +141,34 @@ NFIQ2::QualityMeasures::LCS::computeFeatureData(
 		const int v1sz_x = blocksize;
 		const int v1sz_y = blocksize / 2;
 
-		cv::Mat maskim;
-		ridgesegment(img, blocksize, threshold, cv::noArray(), maskim,
-		    cv::noArray());
+		// segment and orient locally unless shared with other modules
+		std::unique_ptr<BlockGeometry> localGeometry {};
+		if (blockGeometry == nullptr) {
+			localGeometry.reset(new BlockGeometry(img, blocksize,
+			    threshold, v1sz_x, v1sz_y));
+			blockGeometry = localGeometry.get();
+		} else if (!blockGeometry->isCompatible(rows, cols, blocksize,
+			       threshold, v1sz_x, v1sz_y)) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Cannot compute LCS: Block geometry does not match "
+			    "image or parameters");
+		}
 
 		// ----------
 		// compute LCS
 		// ----------
 
-		double blk = static_cast<double>(blocksize);
+		const int blkoffset = blockGeometry->getBlockOffset();
+		const int mapRows = blockGeometry->getMapRows();
+		const int mapCols = blockGeometry->getMapCols();
+		const cv::Mat &maskBseg = blockGeometry->getBlockMask();
+		const cv::Mat &blkorient = blockGeometry->getBlockOrientation();
 
-		double sumSQ = static_cast<double>(
-		    (v1sz_x * v1sz_x) + (v1sz_y * v1sz_y));
-		double eblksz = ceil(
-		    sqrt(sumSQ)); // block size for extraction of slanted block
-		double diff = (eblksz - blk);
-		int blkoffset = static_cast<int>(
-		    ceil(diff / 2)); // overlapping border
-
-		int mapRows = static_cast<int>(
-		    (static_cast<double>(rows) - diff) / blk);
-		int mapCols = static_cast<int>(
-		    (static_cast<double>(cols) - diff) / blk);
-
-		cv::Mat maskBseg = cv::Mat::zeros(mapRows, mapCols, CV_8UC1);
-		cv::Mat blkorient = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-
-		std::vector<double> dataVector;
+		ScratchVector<double> dataVector;
 		dataVector.reserve(mapRows * mapCols);
 
-		cv::Mat im_roi, blkwim;
-		cv::Mat maskB1;
+		cv::Mat blkwim;
 		cv::Mat lcs = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-		double cova, covb, covc;
 		// Image processed NOT from beg to end but with a border around
 		// - can't be vectorized:(
 		int br = 0;
@@ -172,26 +179,6 @@ NFIQ2::QualityMeasures::LCS::computeFeatureData(
 			for (int c = blkoffset;
 			     c < cols - (blocksize + blkoffset - 1);
 			     c += blocksize) {
-				im_roi = img(cv::Range(r,
-						 cv::min(r + blocksize,
-						     img.rows)),
-				    cv::Range(c,
-					cv::min(c + blocksize, img.cols)));
-				//      blkim = im(r:r+blksz-1, c:c+blksz-1);
-				maskB1 = maskim(cv::Range(r,
-						    cv::min(r + blocksize,
-							maskim.rows)),
-				    cv::Range(c,
-					cv::min(c + blocksize, maskim.cols)));
-				//      maskB1 = maskim(r:r+blksz-1,
-				//      c:c+blksz-1);
-				maskBseg.at<uint8_t>(br, bc) = allfun(maskB1);
-				covcoef(im_roi, cova, covb, covc,
-				    CENTERED_DIFFERENCES);
-
-				// ridge ORIENT local
-				blkorient.at<double>(br, bc) = ridgeorient(cova,
-				    covb, covc);
 				// overlapping windows (border = blkoffset)
 				blkwim = img(cv::Range(r - blkoffset,
 						 cv::min(r + blocksize +
@@ -223,7 +210,8 @@ NFIQ2::QualityMeasures::LCS::computeFeatureData(
 		histogramBins10.push_back(LCSHISTLIMITS[6]);
 		histogramBins10.push_back(LCSHISTLIMITS[7]);
 		histogramBins10.push_back(LCSHISTLIMITS[8]);
-		addHistogramFeatures(featureDataList, NFIQ2LCSPrefix,
+		addHistogramFeatures(featureDataList,
+		    NativeQualityMeasure::LocalClarityBin0,
 		    histogramBins10, dataVector, 10);
 
 		this->setSpeed(timerLCS.stop());
@@ -285,16 +273,13 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 		};
 	}
 
-	cv::Mat blockRotated;
-	NFIQ2::QualityMeasures::getRotatedBlock(block, orientation, padFlag,
-	    blockRotated);
-
 	//% set x and y
 	int xoff = v1sz_x / 2;
 	int yoff = v1sz_y / 2;
 
-	// extract slanted block by cropping the rotated image: To ensure that
-	// rotated image does not contain any invalid regions.
+	// rotate the block and extract slanted block by cropping the rotated
+	// image: To ensure that rotated image does not contain any invalid
+	// regions. Only the cropped block is rotated.
 	//     Matlab:  blockCropped =
 	//     blockRotated(cBlock-(yoff-1):cBlock+yoff,cBlock-(xoff-1):cBlock+xoff);
 	//     % v2
@@ -305,12 +290,18 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 	int rowend = icBlock + yoff;
 	int colstart = icBlock - (xoff - 1) - 1;
 	int colend = icBlock + xoff;
-	cv::Mat v2 = blockRotated(cv::Range(rowstart, rowend),
-	    cv::Range(colstart, colend));
-
-	std::vector<uint8_t> ridval;
-	std::vector<double> dt;
-	NFIQ2::QualityMeasures::getRidgeValleyStructure(v2, ridval, dt);
+	cv::Mat v2;
+	NFIQ2::QualityMeasures::ScratchVector<double> colMeans;
+	NFIQ2::QualityMeasures::getRotatedBlockProfile(block, orientation,
+	    padFlag, cv::Range(rowstart, rowend), cv::Range(colstart, colend),
+	    NFIQ2::QualityMeasures::COLUMN_MEANS, colMeans, v2);
+
+	NFIQ2::QualityMeasures::RidgeValleyStructure<
+	    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth>
+	    structure;
+	NFIQ2::QualityMeasures::getRidgeValleyStructure(colMeans, structure);
+	const auto &ridval = structure.ridval;
+	const auto &dt = structure.dt;
 
 	// Ridge-valley thickness
 	//  begrid = ridval(1); % begining with ridge?
@@ -318,42 +309,14 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 	//  change(1) = []; % there can't be change in 1. element (circshift)
 	//  change = find(change == 1);    % find indices where changes
 	uint8_t begrid = ridval[0]; //% begining with ridge?
-	std::vector<uint8_t> change;
-	size_t j;
-	for (unsigned int i = 0; i < ridval.size(); i++) {
-		// circular shift from back to front
-		if (i == 0) {
-			j = ridval.size() - 1;
-		} else {
-			j = i - 1;
-		}
-		if (ridval[i] != ridval[j]) {
-			change.push_back(1);
-		} else {
-			change.push_back(0);
-		}
-	}
-
-	std::vector<uint8_t> changeIndex;
-	for (unsigned int i = 1; i < change.size();
-	     i++) // skip the first element, same effect
-	{
-		// as "change(1) = []" in Matlab.
-		if (change[i] == 1) {
-			changeIndex.push_back(i - 1);
-		}
-	}
 
 	//  if ~isempty(changeIndex) ==> changes found = ridge-val structure
 	double lcsNOTISO = 0.0;
-	if (!changeIndex.empty()) {
+	if (structure.changes != 0) {
 		//    change1r = circshift(change,1); change1r(1) = 0;
 		//    Wrv = change - change1r; % ridge and valley thickness
-		std::vector<uint8_t> Wrv;
-		Wrv.push_back(changeIndex[0]);
-		for (unsigned int i = 1; i < changeIndex.size(); i++) {
-			Wrv.push_back(changeIndex[i] - changeIndex[i - 1]);
-		}
+		const auto &Wrv = structure.widths;
+		const unsigned int WrvSize = structure.changes;
 
 		// Matlab:
 		// if begrid
@@ -384,29 +347,32 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 		    RscaleNorm; // Should this be Wvmin/VscaleNorm???
 		double NWvmax = Wvmax / RscaleNorm;
 
-		std::vector<double> NWr, NWv;
+		std::array<double,
+		    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth>
+		    NWr, NWv;
+		int NWrSize = 0, NWvSize = 0;
 		double rtemp, vtemp;
 		if (begrid) {
-			for (unsigned int i = 0; i < Wrv.size(); i += 2) {
+			for (unsigned int i = 0; i < WrvSize; i += 2) {
 				rtemp = static_cast<double>(Wrv[i]) /
 				    RscaleNorm;
-				NWr.push_back(rtemp); // Matlab "odd" indices
+				NWr[NWrSize++] = rtemp; // Matlab "odd" indices
 			}
-			for (unsigned int i = 0; i < Wrv.size() - 1; i += 2) {
+			for (unsigned int i = 0; i < WrvSize - 1; i += 2) {
 				vtemp = static_cast<double>(Wrv[i + 1]) /
 				    VscaleNorm;
-				NWv.push_back(vtemp); // Matlab "even" indices
+				NWv[NWvSize++] = vtemp; // Matlab "even" indices
 			}
 		} else {
-			for (unsigned int i = 0; i < Wrv.size(); i += 2) {
+			for (unsigned int i = 0; i < WrvSize; i += 2) {
 				vtemp = static_cast<double>(Wrv[i]) /
 				    VscaleNorm;
-				NWv.push_back(vtemp); // Matlab "odd" indices
+				NWv[NWvSize++] = vtemp; // Matlab "odd" indices
 			}
-			for (unsigned int i = 0; i < Wrv.size() - 1; i += 2) {
+			for (unsigned int i = 0; i < WrvSize - 1; i += 2) {
 				rtemp = static_cast<double>(Wrv[i + 1]) /
 				    RscaleNorm;
-				NWr.push_back(rtemp); // Matlab "even" indices
+				NWr[NWrSize++] = rtemp; // Matlab "even" indices
 			}
 		}
 
@@ -419,11 +385,13 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 		// >= NWvmin) && all(NWv <= NWvmax)
 
 		cv::Scalar muNWr {}, muNWv {};
-		if (!NWr.empty()) {
-			muNWr = cv::mean(NWr, cv::noArray());
+		if (NWrSize != 0) {
+			muNWr = cv::mean(
+			    cv::Mat(1, NWrSize, CV_64F, NWr.data()));
 		}
-		if (!NWv.empty()) {
-			muNWv = cv::mean(NWv, cv::noArray());
+		if (NWvSize != 0) {
+			muNWv = cv::mean(
+			    cv::Mat(1, NWvSize, CV_64F, NWv.data()));
 		}
 
 		if ((muNWr.val[0] >= NWrmin) && (muNWr.val[0] <= NWrmax) &&
@@ -437,28 +405,29 @@ loclar(cv::Mat &block, const double orientation, const int v1sz_x,
 			// exceed their threshold Likewise, compute the number
 			// of pixels in valley regions that are below their
 			// threshold
-			cv::Mat ridgecol, valleycol;
 			int ridgeGood = 0, valleyGood = 0;
 			int ridgePixelCount = 0, valleyPixelCount = 0;
 			for (int i = 0; i < v2.cols; i++) {
-				if (ridval[i] == 1) // ridges
-				{
-					ridgecol = (v2.col(i) >= dt[i]);
-					ridgeGood += countNonZero(
-					    ridgecol); // no. pixels in
-						       // column that are
-						       // above the
-						       // threshold
-					ridgePixelCount +=
-					    v2.rows; // number of pixels in
-						     // the column
-				} else		     // valleys
-				{
-					valleycol = (v2.col(i) < dt[i]);
-					valleyGood += countNonZero(valleycol);
+				if (ridval[i] == 1) { // ridges
+					// number of pixels in the column
+					ridgePixelCount += v2.rows;
+				} else { // valleys
 					valleyPixelCount += v2.rows;
 				}
 			}
+			for (int r = 0; r < v2.rows; r++) {
+				const uint8_t *row = v2.ptr<uint8_t>(r);
+				for (int i = 0; i < v2.cols; i++) {
+					if (ridval[i] == 1) {
+						// ridge pixels above the
+						// threshold
+						ridgeGood += (row[i] >= dt[i]);
+					} else {
+						// valley pixels below it
+						valleyGood += (row[i] < dt[i]);
+					}
+				}
+			}
 			// alpha = ratio of pixels below the threshold in valley
 			// regions beta = ratio of pixels above the threshold in
 			// ridge regions
@@ -1,8 +1,64 @@
 #include <nfiq2_constants.hpp>
+#include <nfiq2_exception.hpp>
 #include <quality_modules/Module.h>
 
+#include <algorithm>
 #include <vector>
 
+constexpr unsigned int NFIQ2::QualityMeasures::QualityMeasureValues::MaxCount;
+
+NFIQ2::QualityMeasures::QualityMeasureValues::QualityMeasureValues(
+    const NativeQualityMeasure::Index first, const unsigned int count)
+    : first { first }
+    , count { count }
+{
+	if ((count > MaxCount) ||
+	    (first + count > NFIQ2::QualityMeasures::NativeQualityMeasureCount)) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+		    "Invalid range of native quality measures");
+	}
+}
+
+NFIQ2::QualityMeasures::NativeQualityMeasure::Index
+NFIQ2::QualityMeasures::QualityMeasureValues::getFirst() const
+{
+	return (this->first);
+}
+
+unsigned int
+NFIQ2::QualityMeasures::QualityMeasureValues::getCount() const
+{
+	return (this->count);
+}
+
+double &
+NFIQ2::QualityMeasures::QualityMeasureValues::at(
+    const NativeQualityMeasure::Index measure)
+{
+	if ((measure < this->first) || (measure >= this->first + this->count)) {
+		throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+		    std::string("Native quality measure not computed by this "
+				"module: ") +
+			NativeQualityMeasureIdentifiers[measure]);
+	}
+	return (this->values[measure - this->first]);
+}
+
+double
+NFIQ2::QualityMeasures::QualityMeasureValues::at(
+    const NativeQualityMeasure::Index measure) const
+{
+	return (const_cast<QualityMeasureValues *>(this)->at(measure));
+}
+
+void
+NFIQ2::QualityMeasures::QualityMeasureValues::copyTo(
+    NativeQualityMeasureVector &vector) const
+{
+	std::copy(this->values.cbegin(), this->values.cbegin() + this->count,
+	    vector.begin() + this->first);
+}
+
 NFIQ2::QualityMeasures::Algorithm::Algorithm() = default;
 
 NFIQ2::QualityMeasures::Algorithm::~Algorithm() = default;
@@ -15,6 +71,19 @@ NFIQ2::QualityMeasures::Algorithm::getSpeed() const
 
 std::unordered_map<std::string, double>
 NFIQ2::QualityMeasures::Algorithm::getFeatures() const
+{
+	std::unordered_map<std::string, double> featureMap {};
+	for (unsigned int i = 0; i < this->features.getCount(); i++) {
+		const auto measure = static_cast<NativeQualityMeasure::Index>(
+		    this->features.getFirst() + i);
+		featureMap[NativeQualityMeasureIdentifiers[measure]] =
+		    this->features.at(measure);
+	}
+	return featureMap;
+}
+
+const NFIQ2::QualityMeasures::QualityMeasureValues &
+NFIQ2::QualityMeasures::Algorithm::getFeatureValues() const
 {
 	return this->features;
 }
@@ -27,7 +96,7 @@ NFIQ2::QualityMeasures::Algorithm::setSpeed(const double featureSpeed)
 
 void
 NFIQ2::QualityMeasures::Algorithm::setFeatures(
-    const std::unordered_map<std::string, double> &featureResult)
+    const QualityMeasureValues &featureResult)
 {
 	this->features = featureResult;
 }
@@ -21,11 +21,13 @@ NFIQ2::QualityMeasures::Mu::Mu(
 
 NFIQ2::QualityMeasures::Mu::~Mu() = default;
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::Mu::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::ContrastMeanOfBlockMeans, 2
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -39,7 +41,8 @@ NFIQ2::QualityMeasures::Mu::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -91,12 +94,8 @@ NFIQ2::QualityMeasures::Mu::computeFeatureData(
 		}
 
 		// return MMB value
-		std::pair<std::string, double> fd_mmb;
-		fd_mmb = std::make_pair(
-		    Identifiers::QualityMeasures::Contrast::MeanOfBlockMeans,
-		    avg);
-
-		featureDataList[fd_mmb.first] = fd_mmb.second;
+		featureDataList.at(
+		    NativeQualityMeasure::ContrastMeanOfBlockMeans) = avg;
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot compute feature Mu Mu Block (MMB): "
@@ -126,12 +125,8 @@ NFIQ2::QualityMeasures::Mu::computeFeatureData(
 		this->sigmaComputed = true;
 
 		// return mu value
-		std::pair<std::string, double> fd_mu;
-		fd_mu = std::make_pair(
-		    Identifiers::QualityMeasures::Contrast::ImageMean,
-		    mu.val[0]);
-
-		featureDataList[fd_mu.first] = fd_mu.second;
+		featureDataList.at(NativeQualityMeasure::ContrastImageMean) =
+		    mu.val[0];
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot compute feature Sigma (stddev) and Mu (mean): "
@@ -9,7 +9,6 @@ const char
     NFIQ2::Identifiers::QualityMeasureAlgorithms::OrientationCertainty[] {
 	    "OrientationCertainty"
     };
-static const char NFIQ2OCLFeaturePrefix[] { "OCL_Bin10_" };
 const char NFIQ2::Identifiers::QualityMeasures::OrientationCertainty::
     Histogram::Bin0[] { "OCL_Bin10_0" };
 const char NFIQ2::Identifiers::QualityMeasures::OrientationCertainty::
@@ -45,11 +44,13 @@ NFIQ2::QualityMeasures::OCLHistogram::OCLHistogram(
 
 NFIQ2::QualityMeasures::OCLHistogram::~OCLHistogram() = default;
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::OCLHistogram::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::OrientationCertaintyBin0, 12
+	};
 
 	cv::Mat img;
 
@@ -64,7 +65,8 @@ NFIQ2::QualityMeasures::OCLHistogram::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -76,7 +78,7 @@ NFIQ2::QualityMeasures::OCLHistogram::computeFeatureData(
 
 	// compute OCL
 	NFIQ2::Timer timerOCL;
-	std::vector<double> oclres;
+	ScratchVector<double> oclres;
 	try {
 		timerOCL.start();
 
@@ -123,7 +125,8 @@ NFIQ2::QualityMeasures::OCLHistogram::computeFeatureData(
 		histogramBins10.push_back(OCLPHISTLIMITS[6]);
 		histogramBins10.push_back(OCLPHISTLIMITS[7]);
 		histogramBins10.push_back(OCLPHISTLIMITS[8]);
-		addHistogramFeatures(featureDataList, NFIQ2OCLFeaturePrefix,
+		addHistogramFeatures(featureDataList,
+		    NativeQualityMeasure::OrientationCertaintyBin0,
 		    histogramBins10, oclres, 10);
 
 		this->setSpeed(timerOCL.stop());
@@ -6,12 +6,12 @@
 #include <quality_modules/common_functions.h>
 
 #include <cmath>
+#include <memory>
 #include <sstream>
 
 const char NFIQ2::Identifiers::QualityMeasureAlgorithms::OrientationFlow[] {
 	"OrientationFlow"
 };
-static const char NFIQ2OFPrefix[] { "OF_Bin10_" };
 const char
     NFIQ2::Identifiers::QualityMeasures::OrientationFlow::Histogram::Bin0[] {
 	    "OF_Bin10_0"
@@ -62,7 +62,14 @@ const char NFIQ2::Identifiers::QualityMeasures::OrientationFlow::StdDev[] {
 NFIQ2::QualityMeasures::OF::OF(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	this->setFeatures(computeFeatureData(fingerprintImage));
+	this->setFeatures(computeFeatureData(fingerprintImage, nullptr));
+}
+
+NFIQ2::QualityMeasures::OF::OF(
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry &blockGeometry)
+{
+	this->setFeatures(computeFeatureData(fingerprintImage, &blockGeometry));
 }
 
 NFIQ2::QualityMeasures::OF::~OF() = default;
@@ -90,11 +97,14 @@ NFIQ2::QualityMeasures::OF::getNativeQualityMeasureIDs()
 		Identifiers::QualityMeasures::OrientationFlow::StdDev };
 }
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::OF::computeFeatureData(
-    const NFIQ2::FingerprintImageData &fingerprintImage)
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry *blockGeometry)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::OrientationFlowBin0, 12
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -108,7 +118,8 @@ NFIQ2::QualityMeasures::OF::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -128,117 +139,37 @@ NFIQ2::QualityMeasures::OF::computeFeatureData(
 		const int v1sz_x = slantedBlockSizeX;
 		const int v1sz_y = slantedBlockSizeY;
 
-		cv::Mat maskim;
-		ridgesegment(img, blocksize, threshold, cv::noArray(), maskim,
-		    cv::noArray());
+		// segment and orient locally unless shared with other modules
+		std::unique_ptr<BlockGeometry> localGeometry {};
+		if (blockGeometry == nullptr) {
+			localGeometry.reset(new BlockGeometry(img, blocksize,
+			    threshold, v1sz_x, v1sz_y));
+			blockGeometry = localGeometry.get();
+		} else if (!blockGeometry->isCompatible(rows, cols, blocksize,
+			       threshold, v1sz_x, v1sz_y)) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Cannot compute Orientation Flow (OF): Block "
+			    "geometry does not match image or parameters");
+		}
 
 		// ----------
 		// compute Of
 		// ----------
 
-		double blk = static_cast<double>(blocksize);
-
-		double sumSQ = static_cast<double>(
-		    (v1sz_x * v1sz_x) + (v1sz_y * v1sz_y));
-		double eblksz = ceil(
-		    sqrt(sumSQ)); // block size for extraction of slanted block
-		double diff = (eblksz - blk);
-		int blkoffset = static_cast<int>(
-		    ceil(diff / 2)); // overlapping border
-
-		int mapRows = static_cast<int>(
-		    (static_cast<double>(rows) - diff) / blk);
-		int mapCols = static_cast<int>(
-		    (static_cast<double>(cols) - diff) / blk);
-
-		cv::Mat maskBseg = cv::Mat::zeros(mapRows, mapCols, CV_8UC1);
-		cv::Mat blkorient = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-
-		cv::Mat im_roi, blkwim;
-		cv::Mat maskB1;
-		double cova, covb, covc;
-		// Image processed NOT from beg to end but with a border around
-		// - can't be vectorized:(
-		int br = 0;
-		int bc = 0;
-
-		for (int r = blkoffset; r < rows - (blocksize + blkoffset - 1);
-		     r += blocksize) {
-			for (int c = blkoffset;
-			     c < cols - (blocksize + blkoffset - 1);
-			     c += blocksize) {
-				im_roi = img(cv::Range(r,
-						 cv::min(r + blocksize,
-						     img.rows)),
-				    cv::Range(c,
-					cv::min(c + blocksize, img.cols)));
-				maskB1 = maskim(cv::Range(r,
-						    cv::min(r + blocksize,
-							maskim.rows)),
-				    cv::Range(c,
-					cv::min(c + blocksize, maskim.cols)));
-				maskBseg.at<uint8_t>(br, bc) = allfun(maskB1);
-				covcoef(im_roi, cova, covb, covc,
-				    CENTERED_DIFFERENCES);
-
-				// ridge ORIENT local
-				blkorient.at<double>(br, bc) = ridgeorient(cova,
-				    covb, covc);
-				bc = bc + 1;
-			}
-			br = br + 1;
-			bc = 0;
-		}
+		const cv::Mat &maskBseg = blockGeometry->getBlockMask();
+		const cv::Mat &blkorient = blockGeometry->getBlockOrientation();
 
 		// % get the diff of orient. angles from neighbouring blocks
 		// loqall = blockproc(blkorient, [1 1], @orientangdiff,
-		// 'BorderSize', [border border], 'TrimBorder', false); add a
-		// border of zeros around the blkorient array, since the matlab
-		// blockproc function pads with zeros at the edges.
-		cv::Mat paddedBlkorient;
-		cv::copyMakeBorder(blkorient, paddedBlkorient, 1, 1, 1, 1,
-		    cv::BORDER_CONSTANT, 0);
-
-		// for each point in the original blkorient array, compute the
-		// orientation angle difference with its immediate neighbors all
-		// around.
-
-		cv::Mat loqall(blkorient.rows, blkorient.cols, CV_64F);
-		const double bsize = 9; // The center point plus its immediate
-					// neighbors forms a 3x3 block
-
-		constexpr double Deg2Rad = M_PI / 180.0;
-		constexpr double ThreeSixtyRad = Deg2Rad * 360.0;
-		for (int i = 1; i <= blkorient.rows; i++) {
-			for (int j = 1; j <= blkorient.cols; j++) {
-				// remember: OpenCV ranges are open-ended on the
-				// upper end
-				cv::Mat blkROI =
-				    paddedBlkorient(cv::Range(i - 1, i + 2),
-					cv::Range(j - 1, j + 2));
-				// Subtract the input block from the center
-				// value and get its absolute value.
-				cv::Mat blockAbsDiff;
-				cv::Scalar centerVal = blkROI.at<double>(1, 1);
-				absdiff(centerVal, blkROI, blockAbsDiff);
-
-				// Account for circularity of angles
-				blockAbsDiff.forEach<double>(
-				    [&](double &angleDiff,
-					const int *position) {
-					    angleDiff = std::min(angleDiff,
-						ThreeSixtyRad - angleDiff);
-				    });
-
-				cv::Scalar loq = sum(blockAbsDiff) /
-				    (bsize - 1);
-				loqall.at<double>(i - 1, j - 1) = loq.val[0];
-			}
-		}
+		// 'BorderSize', [border border], 'TrimBorder', false); the
+		// matlab blockproc function pads with zeros at the edges.
+		cv::Mat loqall;
+		orientangdiff(blkorient, loqall);
 
 		// angdiff     = deg2rad(90-angmin);
 		// angmin      = deg2rad(angmin);
 		// loqs        = zeros(size(loqall));
+		constexpr double Deg2Rad = M_PI / 180.0;
 		constexpr double PI4 = 90.0;
 		constexpr double angdiff = (PI4 - angleMin) * Deg2Rad;
 		constexpr double angmin = angleMin * Deg2Rad;
@@ -247,41 +178,29 @@ NFIQ2::QualityMeasures::OF::computeFeatureData(
 		// which the anglediff was computed % is in background, exclude
 		// whole window from comp. maskBloqseg =
 		// logical(blkproc(maskBseg, [1 1], [border border], allfun));
-		cv::Mat paddedMaskBseg;
-		cv::copyMakeBorder(maskBseg, paddedMaskBseg, 1, 1, 1, 1,
-		    cv::BORDER_CONSTANT, 0);
-		cv::Mat maskBloqseg(maskBseg.rows, maskBseg.cols, CV_8UC1);
-		for (int i = 1; i <= maskBseg.rows; i++) {
-			for (int j = 1; j <= maskBseg.cols; j++) {
-				cv::Mat blkROI = paddedMaskBseg(cv::Range(i - 1,
-								    i + 2),
-				    cv::Range(j - 1, j + 2));
-				maskBloqseg.at<uint8_t>(i - 1, j - 1) = allfun(
-				    blkROI);
-			}
-		}
+		cv::Mat maskBloqseg;
+		allfunNeighbourhood(maskBseg, maskBloqseg);
 
-		std::vector<double> dataVector;
+		ScratchVector<double> dataVector;
 		dataVector.reserve(loqall.rows * loqall.cols);
 
 		// % (angle) mask - only blocks with angle change > angmin
 		// maskBang = loqall > angmin;
-		cv::Mat maskBang = loqall > angmin;
 		// % (local orientation quality) mask of FOREGROUND blocks >
 		// angmin deg maskBloq = maskBang & maskBloqseg;
-		cv::Mat maskBloq = maskBang & maskBloqseg;
 		// % map of local orientation quality scores
 		// loqs(maskBloq) = (loqall(maskBloq) - angmin) ./ angdiff;
 		cv::Mat loqs = cv::Mat::zeros(loqall.rows, loqall.cols, CV_64F);
 		for (int i = 0; i < loqall.rows; i++) {
+			const double *loqallRow = loqall.ptr<double>(i);
+			const uint8_t *maskRow = maskBloqseg.ptr<uint8_t>(i);
+			double *loqsRow = loqs.ptr<double>(i);
 			for (int j = 0; j < loqall.cols; j++) {
-				if (maskBloq.at<uint8_t>(i, j) == 1) {
-					loqs.at<double>(i,
-					    j) = (loqall.at<double>(i, j) -
-						     angmin) /
+				if ((maskRow[j] == 1) &&
+				    (loqallRow[j] > angmin)) {
+					loqsRow[j] = (loqallRow[j] - angmin) /
 					    angdiff;
-					dataVector.push_back(
-					    loqs.at<double>(i, j));
+					dataVector.push_back(loqsRow[j]);
 				}
 			}
 		}
@@ -307,7 +226,8 @@ NFIQ2::QualityMeasures::OF::computeFeatureData(
 		histogramBins10.push_back(OFHISTLIMITS[6]);
 		histogramBins10.push_back(OFHISTLIMITS[7]);
 		histogramBins10.push_back(OFHISTLIMITS[8]);
-		addHistogramFeatures(featureDataList, NFIQ2OFPrefix,
+		addHistogramFeatures(featureDataList,
+		    NativeQualityMeasure::OrientationFlowBin0,
 		    histogramBins10, dataVector, 10);
 
 		this->setSpeed(timerOF.stop());
@@ -29,11 +29,13 @@ NFIQ2::QualityMeasures::QualityMap::QualityMap(
 
 NFIQ2::QualityMeasures::QualityMap::~QualityMap() = default;
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::QualityMap::computeFeatureData(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::RegionOfInterestCoherenceMean, 2
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -50,7 +52,8 @@ NFIQ2::QualityMeasures::QualityMap::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -73,19 +76,12 @@ NFIQ2::QualityMeasures::QualityMap::computeFeatureData(
 		    Sizes::LocalRegionSquare, this->imgProcResults_);
 
 		// return features based on coherence values of orientation map
-		std::pair<std::string, double> fd_om_2;
-		fd_om_2 = std::make_pair(Identifiers::QualityMeasures::
-					     RegionOfInterest::CoherenceMean,
-		    coherenceRelFilter);
-
-		featureDataList[fd_om_2.first] = fd_om_2.second;
-
-		std::pair<std::string, double> fd_om_1;
-		fd_om_1 = std::make_pair(Identifiers::QualityMeasures::
-					     RegionOfInterest::CoherenceSum,
-		    coherenceSumFilter);
-
-		featureDataList[fd_om_1.first] = fd_om_1.second;
+		featureDataList.at(
+		    NativeQualityMeasure::RegionOfInterestCoherenceMean) =
+		    coherenceRelFilter;
+		featureDataList.at(
+		    NativeQualityMeasure::RegionOfInterestCoherenceSum) =
+		    coherenceSumFilter;
 
 		this->setSpeed(timer.stop());
 	} catch (const cv::Exception &e) {
@@ -104,7 +100,7 @@ NFIQ2::QualityMeasures::QualityMap::computeFeatureData(
 cv::Mat
 NFIQ2::QualityMeasures::QualityMap::computeOrientationMap(cv::Mat &img,
     bool bFilterByROI, double &coherenceSum, double &coherenceRel,
-    unsigned int bs, ImgProcROI::ImgProcROIResults roiResults)
+    unsigned int bs, const ImgProcROI::ImgProcROIResults &roiResults)
 {
 	coherenceSum = 0.0;
 	coherenceRel = 0.0;
@@ -127,23 +123,9 @@ NFIQ2::QualityMeasures::QualityMap::computeOrientationMap(cv::Mat &img,
 
 			// check if block is vector of ROI blocks
 			if (bFilterByROI) {
-				// search for ROI block
-				bool bBlockFound = false;
-				for (unsigned int k = 0;
-				     k < roiResults.vecROIBlocks.size(); k++) {
-					if (roiResults.vecROIBlocks.at(k).x ==
-						j &&
-					    roiResults.vecROIBlocks.at(k).y ==
-						i &&
-					    roiResults.vecROIBlocks.at(k)
-						    .width == actualBS_X &&
-					    roiResults.vecROIBlocks.at(k)
-						    .height == actualBS_Y) {
-						// block found
-						bBlockFound = true;
-						break;
-					}
-				}
+				// look up ROI block
+				const bool bBlockFound = roiResults.isROIBlock(
+				    cv::Rect(j, i, actualBS_X, actualBS_Y));
 
 				if (!bBlockFound) {
 					for (int k = i; k < (i + actualBS_Y);
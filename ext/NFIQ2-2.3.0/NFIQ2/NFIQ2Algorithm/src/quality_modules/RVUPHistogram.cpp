@@ -4,14 +4,15 @@
 #include <quality_modules/RVUPHistogram.h>
 #include <quality_modules/common_functions.h>
 
+#include <array>
 #include <cmath>
+#include <memory>
 #include <sstream>
 
 const char
     NFIQ2::Identifiers::QualityMeasureAlgorithms::RidgeValleyUniformity[] {
 	    "RidgeValleyUniformity"
     };
-const char NFIQ2RVUPFeaturePrefix[] { "RVUP_Bin10_" };
 const char NFIQ2::Identifiers::QualityMeasures::RidgeValleyUniformity::
     Histogram::Bin0[] { "RVUP_Bin10_0" };
 const char NFIQ2::Identifiers::QualityMeasures::RidgeValleyUniformity::
@@ -41,22 +42,33 @@ const char
     };
 
 void rvuhist(cv::Mat block, const double orientation, const int v1sz_x,
-    const int v1sz_y, bool padFlag, std::vector<double> &ratios,
-    std::vector<uint8_t> &Nans);
+    const int v1sz_y, bool padFlag,
+    NFIQ2::QualityMeasures::ScratchVector<double> &ratios,
+    NFIQ2::QualityMeasures::ScratchVector<uint8_t> &Nans);
 
 NFIQ2::QualityMeasures::RVUPHistogram::RVUPHistogram(
     const NFIQ2::FingerprintImageData &fingerprintImage)
 {
-	this->setFeatures(computeFeatureData(fingerprintImage));
+	this->setFeatures(computeFeatureData(fingerprintImage, nullptr));
+}
+
+NFIQ2::QualityMeasures::RVUPHistogram::RVUPHistogram(
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry &blockGeometry)
+{
+	this->setFeatures(computeFeatureData(fingerprintImage, &blockGeometry));
 }
 
 NFIQ2::QualityMeasures::RVUPHistogram::~RVUPHistogram() = default;
 
-std::unordered_map<std::string, double>
+NFIQ2::QualityMeasures::QualityMeasureValues
 NFIQ2::QualityMeasures::RVUPHistogram::computeFeatureData(
-    const NFIQ2::FingerprintImageData &fingerprintImage)
+    const NFIQ2::FingerprintImageData &fingerprintImage,
+    const BlockGeometry *blockGeometry)
 {
-	std::unordered_map<std::string, double> featureDataList;
+	QualityMeasureValues featureDataList {
+		NativeQualityMeasure::RidgeValleyUniformityBin0, 12
+	};
 
 	// check if input image has 500 dpi
 	if (fingerprintImage.ppi !=
@@ -70,7 +82,8 @@ NFIQ2::QualityMeasures::RVUPHistogram::computeFeatureData(
 	try {
 		// get matrix from fingerprint image
 		img = cv::Mat(fingerprintImage.height, fingerprintImage.width,
-		    CV_8UC1, (void *)fingerprintImage.data());
+		    CV_8UC1, (void *)fingerprintImage.pixels(),
+		    fingerprintImage.stride());
 	} catch (const cv::Exception &e) {
 		std::stringstream ssErr;
 		ssErr << "Cannot get matrix from fingerprint image: "
@@ -88,77 +101,53 @@ NFIQ2::QualityMeasures::RVUPHistogram::computeFeatureData(
 	try {
 		timerRVU.start();
 
-		cv::Mat maskim;
 		const int blksize = this->blocksize;
 		const int v1sz_x = this->slantedBlockSizeX;
 		const int v1sz_y = this->slantedBlockSizeY;
 
-		assert((blksize > 0) && (this->threshold > 0));
-
-		ridgesegment(img, blksize, this->threshold, cv::noArray(),
-		    maskim, cv::noArray());
-
 		int rows = img.rows;
 		int cols = img.cols;
-		double blk = static_cast<double>(blksize);
-
-		double sumSQ = static_cast<double>(
-		    (v1sz_x * v1sz_x) + (v1sz_y * v1sz_y));
-		double eblksz = ceil(
-		    sqrt(sumSQ)); // block size for extraction of slanted block
-		double diff = (eblksz - blk);
-		int blkoffset = static_cast<int>(
-		    ceil(diff / 2)); // overlapping border
-
-		int mapRows = static_cast<int>(
-		    (static_cast<double>(rows) - diff) / blk);
-		int mapCols = static_cast<int>(
-		    (static_cast<double>(cols) - diff) / blk);
-
-		cv::Mat maskBseg = cv::Mat::zeros(mapRows, mapCols, CV_8UC1);
-		cv::Mat blkorient = cv::Mat::zeros(mapRows, mapCols, CV_64F);
-
-		cv::Mat im_roi, blkwim;
-		cv::Mat maskB1;
-		double cova, covb, covc;
+
+		// segment and orient locally unless shared with other modules
+		std::unique_ptr<BlockGeometry> localGeometry {};
+		if (blockGeometry == nullptr) {
+			localGeometry.reset(new BlockGeometry(img, blksize,
+			    this->threshold, v1sz_x, v1sz_y));
+			blockGeometry = localGeometry.get();
+		} else if (!blockGeometry->isCompatible(rows, cols, blksize,
+			       this->threshold, v1sz_x, v1sz_y)) {
+			throw NFIQ2::Exception(NFIQ2::ErrorCode::BadArguments,
+			    "Cannot compute RVU: Block geometry does not match "
+			    "image or parameters");
+		}
+
+		const int blkoffset = blockGeometry->getBlockOffset();
+		const cv::Mat &maskBseg = blockGeometry->getBlockMask();
+		const cv::Mat &blkorient = blockGeometry->getBlockOrientation();
+
+		cv::Mat blkwim;
 		// Image processed NOT from beg to end but with a border around
 		// - can't be vectorized:(
 		int br = 0;
 		int bc = 0;
 
-		std::vector<double> rvures;
-		std::vector<uint8_t> NanVec;
+		ScratchVector<double> rvures;
+		ScratchVector<uint8_t> NanVec;
 		for (int r = blkoffset; r < rows - (blksize + blkoffset - 1);
 		     r += blksize) {
 			for (int c = blkoffset;
 			     c < cols - (blksize + blkoffset - 1);
 			     c += blksize) {
-				im_roi = img(cv::Range(r,
-						 cv::min(r + blksize,
-						     img.rows)),
-				    cv::Range(c,
-					cv::min(c + blksize, img.cols)));
-				maskB1 = maskim(cv::Range(r,
-						    cv::min(r + blksize,
-							maskim.rows)),
-				    cv::Range(c,
-					cv::min(c + blksize, maskim.cols)));
-				maskBseg.at<uint8_t>(br, bc) = allfun(maskB1);
-				covcoef(im_roi, cova, covb, covc,
-				    CENTERED_DIFFERENCES);
-
-				// ridge ORIENT local
-				blkorient.at<double>(br, bc) = ridgeorient(cova,
-				    covb, covc);
-				// overlapping windows (border = blkoffset)
-				blkwim = img(cv::Range(r - blkoffset,
-						 cv::min(r + blksize +
-							 blkoffset,
-						     img.rows)),
-				    cv::Range(c - blkoffset,
-					cv::min(c + blksize + blkoffset,
-					    img.cols)));
 				if (maskBseg.at<uint8_t>(br, bc) == 1) {
+					// overlapping windows (border =
+					// blkoffset)
+					blkwim = img(cv::Range(r - blkoffset,
+							 cv::min(r + blksize +
+								 blkoffset,
+							     img.rows)),
+					    cv::Range(c - blkoffset,
+						cv::min(c + blksize + blkoffset,
+						    img.cols)));
 					rvuhist(blkwim,
 					    blkorient.at<double>(br, bc),
 					    v1sz_x, v1sz_y, this->padFlag,
@@ -181,7 +170,8 @@ NFIQ2::QualityMeasures::RVUPHistogram::computeFeatureData(
 		histogramBins10.push_back(RVUPHISTLIMITS[6]);
 		histogramBins10.push_back(RVUPHISTLIMITS[7]);
 		histogramBins10.push_back(RVUPHISTLIMITS[8]);
-		addHistogramFeatures(featureDataList, NFIQ2RVUPFeaturePrefix,
+		addHistogramFeatures(featureDataList,
+		    NativeQualityMeasure::RidgeValleyUniformityBin0,
 		    histogramBins10, rvures, 10);
 
 		this->setSpeed(timerRVU.stop());
@@ -265,8 +255,9 @@ perpendicular to the ridge direction %                     within the block
 
 void
 rvuhist(cv::Mat block, const double orientation, const int v1sz_x,
-    const int v1sz_y, bool padFlag, std::vector<double> &rvures,
-    std::vector<uint8_t> &NaNvec)
+    const int v1sz_y, bool padFlag,
+    NFIQ2::QualityMeasures::ScratchVector<double> &rvures,
+    NFIQ2::QualityMeasures::ScratchVector<uint8_t> &NaNvec)
 {
 	// sanity check: check block size
 	float cBlock = static_cast<float>(block.rows) / 2; // square block
@@ -280,103 +271,80 @@ rvuhist(cv::Mat block, const double orientation, const int v1sz_x,
 		};
 	}
 
-	cv::Mat blockRotated;
-	NFIQ2::QualityMeasures::getRotatedBlock(block, orientation, padFlag,
-	    blockRotated);
-
 	//% set x and y
 	int xoff = v1sz_x / 2;
 	int yoff = v1sz_y / 2;
 
-	// extract slanted block by cropping the rotated image: To ensure that
-	// rotated image does not contain any invalid regions.
+	// rotate the block and extract slanted block by cropping the rotated
+	// image: To ensure that rotated image does not contain any invalid
+	// regions. Only the average of each column of the cropped block is
+	// needed, so the block is projected without rotating all of it.
 	//     Matlab:  blockCropped =
 	//     blockRotated(cBlock-(yoff-1):cBlock+yoff,cBlock-(xoff-1):cBlock+xoff);
 	//     % v2
 	// Note: Matlab uses matrix indices starting at 1, OpenCV starts at 0.
 	// Also, OpenCV ranges are open-ended on the upper end.
 
-	cv::Mat blockCropped = blockRotated(
-	    cv::Range((icBlock - (yoff - 1) - 1), (icBlock + yoff)),
-	    cv::Range((icBlock - (xoff - 1) - 1), (icBlock + xoff))); // v2
+	NFIQ2::QualityMeasures::ScratchVector<double> colMeans;
+	NFIQ2::QualityMeasures::getRotatedBlockProfile(block, orientation,
+	    padFlag, cv::Range((icBlock - (yoff - 1) - 1), (icBlock + yoff)),
+	    cv::Range((icBlock - (xoff - 1) - 1), (icBlock + xoff)),
+	    NFIQ2::QualityMeasures::COLUMN_MEANS, colMeans, cv::noArray()); // v2
 
-	std::vector<uint8_t> ridval;
-	std::vector<double> dt;
-	NFIQ2::QualityMeasures::getRidgeValleyStructure(blockCropped, ridval,
-	    dt);
+	NFIQ2::QualityMeasures::RidgeValleyStructure<
+	    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth>
+	    structure;
+	NFIQ2::QualityMeasures::getRidgeValleyStructure(colMeans, structure);
+	const auto &ridval = structure.ridval;
 
 	// Ridge-valley thickness
 	//  change = xor(ridval,circshift(ridval,1)); // find the bin change
 	// change(1) = []; % there can't be change in 1. element (circshift)
 	// changeIndex = find(change == 1);    % find indices where changes
-	std::vector<uint8_t> change;
-	size_t j;
-	for (unsigned int i = 0; i < ridval.size() - 1; i++) {
-		// circular shift from back to front
-		if (i == 0) {
-			j = ridval.size() - 1;
-		} else {
-			j = i - 1;
-		}
-		if (ridval[i] != ridval[j]) {
-			change.push_back(1);
-		} else {
-			change.push_back(0);
-		}
-	}
-
-	std::vector<uint8_t> changeIndex;
-	for (unsigned int i = 1; i < change.size();
-	     i++) // skip the first element, same effect
-	{
-		// as "change(1) = []" in Matlab.
-		if (change[i] == 1) {
-			changeIndex.push_back(i - 1);
-		}
+	// The last column is left out of change, so a change into it does
+	// not count.
+	const auto &changeIndex = structure.changeIndex;
+	int changeCount = structure.changes;
+	if ((changeCount != 0) &&
+	    (changeIndex[changeCount - 1] == structure.length - 2)) {
+		changeCount--;
 	}
 
 	//  if ~isempty(changeIndex) ==> changes found = ridge-val structure
-	if (!changeIndex.empty()) {
+	if (changeCount != 0) {
 		//% non complete ridges/valleys are removed from ridval and
 		// changeIndex
 		//  ridvalComplete = ridval(changeIndex(1)+1:changeIndex(end));
 		// That is, remove the first and last parts to remove incomplete
 		// ridges/valleys occurring at the border of the original block.
-		std::vector<uint8_t> ridvalComplete;
-		for (int i = changeIndex[0] + 1;
-		     i < changeIndex[changeIndex.size() - 1]; i++) {
-			ridvalComplete.push_back(ridval[i]);
-		}
 		//  Likewise, remove corresponding changes from the change index
 		//  vector. Matlab: changeIndexComplete = changeIndex -
 		//  changeIndex(1);
 		//          changeIndexComplete(1) = [];// % removing first
 		//          value
-		std::vector<uint8_t> changeIndexComplete;
-		for (unsigned int i = 1; i < changeIndex.size();
-		     i++) // skip the first value
-		{
-			changeIndexComplete.push_back(
-			    changeIndex[i] - changeIndex[0]);
-		}
 
 		// if isempty(ridvalComplete)
 		//% not ridge/valley structure, skip computation
 		//     return
 		// end;
-		if (ridvalComplete.empty()) {
+		// (ridvalComplete is empty unless there are two changes)
+		if (changeCount < 2) {
 			return;
 		} else {
-			std::vector<double> ratios;
-			uint8_t begrid =
-			    ridvalComplete[0]; //% begining with ridge?
+			std::array<double,
+			    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth>
+			    ratios;
+			int ratioCount = 0;
+			uint8_t begrid = ridval[changeIndex[0] +
+			    1]; //% begining with ridge?
 
 			//% do the magic
 			//% changeIndex now represents the change values...
 			// changeIndexComplete(end:-1:2) =
 			// changeIndexComplete(end:-1:2)-changeIndexComplete(end-1:-1:1);
+			// These are the widths between changes, last first.
 
-			auto changesize = changeIndexComplete.size();
+			const int changesize = changeCount - 1;
 			// If there is only one change index at this point, then
 			// there aren't any ridge/valley structures to compare,
 			// so leave the ratios vector empty. (This is the same
@@ -385,26 +353,19 @@ rvuhist(cv::Mat block, const double orientation, const int v1sz_x,
 			// within the operations themselves, rather than testing
 			// the length of changeIndexComplete directly.
 			if (changesize > 1) {
-				std::vector<uint8_t> changeComplete2;
-				uint8_t tmpc;
-				for (auto i = changesize - 1; i > 0; i--) {
-					tmpc = changeIndexComplete[i] -
-					    changeIndexComplete[i - 1];
-					changeComplete2.push_back(tmpc);
-				}
+				const auto &widths = structure.widths;
 				// for m=1:length(changeIndexComplete)-1,
 				//  ratios(m) =
 				//  changeIndexComplete(m)/changeIndexComplete(m+1);
 				// end;
 
 				double r;
-				for (unsigned int m = 0;
-				     m < changeComplete2.size() - 1; m++) {
+				for (int m = 0; m < changesize - 2; m++) {
 					r = static_cast<double>(
-						changeComplete2[m]) /
+						widths[changesize - m]) /
 					    static_cast<double>(
-						changeComplete2[m + 1]);
-					ratios.push_back(r);
+						widths[changesize - m - 1]);
+					ratios[ratioCount++] = r;
 					// Create a mask vector that is a 1 if r
 					// is not a NaN, 0 if it is.
 					if (std::isnan(r)) {
@@ -416,17 +377,13 @@ rvuhist(cv::Mat block, const double orientation, const int v1sz_x,
 
 				//    ratios(begrid+1:2:end) = 1 ./
 				//    ratios(begrid+1:2:end);
-				for (unsigned int i = begrid; i < ratios.size();
-				     i += 2) {
+				for (int i = begrid; i < ratioCount; i += 2) {
 					ratios[i] = 1 / ratios[i];
 				}
 			}
 
-			if (!ratios.empty()) {
-				for (unsigned int i = 0; i < ratios.size();
-				     i++) {
-					rvures.push_back(ratios[i]);
-				}
+			for (int i = 0; i < ratioCount; i++) {
+				rvures.push_back(ratios[i]);
 			}
 		}
 	}
@@ -0,0 +1,385 @@
+#include <quality_modules/InstrumentationRecord.h>
+#include <quality_modules/ScratchArena.h>
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+/** Memory an arena carves allocations from */
+struct NFIQ2::QualityMeasures::ScratchArena::Block {
+	/** Allocations using this block, plus one held by the owning arena */
+	std::atomic<size_t> references;
+	size_t capacity;
+	size_t used;
+
+	unsigned char *
+	data()
+	{
+		return (reinterpret_cast<unsigned char *>(this + 1));
+	}
+};
+
+namespace {
+
+using NFIQ2::QualityMeasures::ScratchArena;
+
+/** Size of the blocks arenas allocate from the system */
+const size_t BlockSize { 256 * 1024 };
+/** Unused blocks an arena keeps once its outermost scope ends */
+const size_t ReservedBlocks { 4 };
+/** CV_AUTOSTEP of the OpenCV C API: step computed from the sizes */
+const size_t AutoStep { 0x7fffffff };
+
+/** Precedes every allocation made by ScratchArena::allocate() */
+struct AllocationHeader {
+	/** Arena block holding the allocation, nullptr for system memory */
+	void *block;
+	/** Start of the system allocation when `block` is nullptr */
+	void *system;
+};
+
+std::atomic<bool> enabled { true };
+std::atomic<uint64_t> allocationCount { 0 };
+std::atomic<uint64_t> systemAllocationCount { 0 };
+
+thread_local ScratchArena *currentArena { nullptr };
+
+/** Count allocations, also in the calling thread's instrumentation record */
+void
+countAllocations(const uint64_t allocations,
+    const uint64_t systemAllocations)
+{
+	if (allocations != 0) {
+		allocationCount.fetch_add(allocations,
+		    std::memory_order_relaxed);
+	}
+	if (systemAllocations != 0) {
+		systemAllocationCount.fetch_add(systemAllocations,
+		    std::memory_order_relaxed);
+	}
+
+	NFIQ2::QualityMeasures::InstrumentationRecord *record =
+	    NFIQ2::QualityMeasures::InstrumentationRecord::current();
+	if (record != nullptr) {
+		record->addAllocations(allocations, systemAllocations);
+	}
+}
+
+ScratchArena &
+threadArena()
+{
+	static thread_local ScratchArena arena {};
+	return (arena);
+}
+
+unsigned char *
+alignUp(unsigned char *p)
+{
+	const uintptr_t mask { ScratchArena::Alignment - 1 };
+	return (reinterpret_cast<unsigned char *>(
+	    (reinterpret_cast<uintptr_t>(p) + mask) & ~mask));
+}
+
+/** Space needed for an allocation of `size` bytes, in the worst case */
+size_t
+footprint(const size_t size)
+{
+	return (size + sizeof(AllocationHeader) + ScratchArena::Alignment - 1);
+}
+
+void *
+allocateFromSystem(const size_t size)
+{
+	if (size > static_cast<size_t>(-1) - footprint(0)) {
+		throw std::bad_alloc();
+	}
+	void *system = std::malloc(footprint(size));
+	if (system == nullptr) {
+		throw std::bad_alloc();
+	}
+	unsigned char *data = alignUp(
+	    static_cast<unsigned char *>(system) + sizeof(AllocationHeader));
+	*(reinterpret_cast<AllocationHeader *>(data) - 1) = { nullptr,
+		system };
+	return (data);
+}
+
+/**
+ * @brief
+ * cv::Mat allocator drawing from the current ScratchArena.
+ *
+ * @details
+ * Outside of a scope, everything is forwarded to the allocator that was the
+ * default before this one was installed. The UMatData is placed in front of
+ * the matrix data so a cv::Mat takes a single scratch allocation.
+ */
+class ScratchMatAllocator : public cv::MatAllocator {
+    public:
+	explicit ScratchMatAllocator(cv::MatAllocator *fallback)
+	    : fallback_ { fallback }
+	{
+	}
+
+	cv::UMatData *
+	allocate(int dims, const int *sizes, int type, void *data0,
+	    size_t *step, cv::AccessFlag flags,
+	    cv::UMatUsageFlags usageFlags) const override
+	{
+		if (ScratchArena::current() == nullptr) {
+			return (this->fallback_->allocate(dims, sizes, type,
+			    data0, step, flags, usageFlags));
+		}
+		if (!enabled.load(std::memory_order_relaxed)) {
+			/* UMatData and data are separate system allocations */
+			countAllocations(1, data0 ? 1 : 2);
+			return (this->fallback_->allocate(dims, sizes, type,
+			    data0, step, flags, usageFlags));
+		}
+
+		/* Same layout as cv::Mat::getStdAllocator() */
+		size_t total = CV_ELEM_SIZE(type);
+		for (int i = dims - 1; i >= 0; i--) {
+			if (step) {
+				if (data0 && step[i] != AutoStep) {
+					CV_Assert(total <= step[i]);
+					total = step[i];
+				} else {
+					step[i] = total;
+				}
+			}
+			total *= sizes[i];
+		}
+
+		const size_t header = (sizeof(cv::UMatData) +
+					  ScratchArena::Alignment - 1) &
+		    ~(ScratchArena::Alignment - 1);
+		unsigned char *memory = static_cast<unsigned char *>(
+		    ScratchArena::allocate(header + (data0 ? 0 : total)));
+		cv::UMatData *u = new (memory) cv::UMatData(this);
+		u->data = u->origdata = data0 ? static_cast<uchar *>(data0) :
+						memory + header;
+		u->size = total;
+		if (data0) {
+			u->flags |= cv::UMatData::USER_ALLOCATED;
+		}
+
+		return (u);
+	}
+
+	bool
+	allocate(cv::UMatData *u, cv::AccessFlag,
+	    cv::UMatUsageFlags) const override
+	{
+		return (u != nullptr);
+	}
+
+	void
+	deallocate(cv::UMatData *u) const override
+	{
+		if (u == nullptr) {
+			return;
+		}
+
+		CV_Assert(u->urefcount == 0);
+		CV_Assert(u->refcount == 0);
+		u->~UMatData();
+		ScratchArena::release(u);
+	}
+
+    private:
+	cv::MatAllocator *fallback_;
+};
+
+/**
+ * Make ScratchMatAllocator the default cv::Mat allocator. Done once, before
+ * the first scope, so matrices allocated before remain with their
+ * allocator.
+ */
+void
+installMatAllocator()
+{
+	static std::once_flag installed {};
+	std::call_once(installed, []() {
+		static ScratchMatAllocator allocator {
+			cv::Mat::getDefaultAllocator()
+		};
+		cv::Mat::setDefaultAllocator(&allocator);
+	});
+}
+
+}
+
+NFIQ2::QualityMeasures::ScratchArena::Scope::Scope()
+    : previous_ { currentArena }
+{
+	installMatAllocator();
+	currentArena = &threadArena();
+}
+
+NFIQ2::QualityMeasures::ScratchArena::Scope::~Scope()
+{
+	currentArena = this->previous_;
+	if (this->previous_ == nullptr) {
+		threadArena().trim();
+	}
+}
+
+NFIQ2::QualityMeasures::ScratchArena::~ScratchArena()
+{
+	if (currentArena == this) {
+		currentArena = nullptr;
+	}
+
+	/* Blocks still in use are freed by their last release() */
+	for (Block *block : this->blocks_) {
+		if (block->references.fetch_sub(1,
+			std::memory_order_acq_rel) == 1) {
+			std::free(block);
+		}
+	}
+}
+
+void *
+NFIQ2::QualityMeasures::ScratchArena::allocate(const size_t size)
+{
+	ScratchArena *arena = currentArena;
+	if (arena == nullptr) {
+		return (allocateFromSystem(size));
+	}
+
+	if ((size > LargeAllocation) ||
+	    !enabled.load(std::memory_order_relaxed)) {
+		countAllocations(1, 1);
+		return (allocateFromSystem(size));
+	}
+	countAllocations(1, 0);
+
+	return (arena->allocateFromBlock(size));
+}
+
+void *
+NFIQ2::QualityMeasures::ScratchArena::allocateFromBlock(const size_t size)
+{
+	Block *block = this->head_;
+
+	/* Start over while nothing uses the head block, keeping it in cache */
+	if ((block != nullptr) &&
+	    (block->references.load(std::memory_order_acquire) == 1)) {
+		block->used = 0;
+	}
+
+	if ((block == nullptr) ||
+	    (block->used + footprint(size) > block->capacity)) {
+		block = nullptr;
+		for (Block *candidate : this->blocks_) {
+			if ((candidate != this->head_) &&
+			    (candidate->references.load(
+				 std::memory_order_acquire) == 1) &&
+			    (footprint(size) <= candidate->capacity)) {
+				block = candidate;
+				block->used = 0;
+				break;
+			}
+		}
+	}
+
+	if (block == nullptr) {
+		const size_t capacity = std::max(BlockSize, footprint(size));
+		void *memory = std::malloc(sizeof(Block) + capacity);
+		if (memory == nullptr) {
+			throw std::bad_alloc();
+		}
+		countAllocations(0, 1);
+
+		block = new (memory) Block();
+		block->references.store(1, std::memory_order_relaxed);
+		block->capacity = capacity;
+		block->used = 0;
+		this->blocks_.push_back(block);
+	}
+	this->head_ = block;
+
+	unsigned char *data = alignUp(
+	    block->data() + block->used + sizeof(AllocationHeader));
+	*(reinterpret_cast<AllocationHeader *>(data) - 1) = { block, nullptr };
+	block->used = static_cast<size_t>((data + size) - block->data());
+	block->references.fetch_add(1, std::memory_order_relaxed);
+
+	return (data);
+}
+
+void
+NFIQ2::QualityMeasures::ScratchArena::release(void *data)
+{
+	if (data == nullptr) {
+		return;
+	}
+
+	const AllocationHeader &header =
+	    *(reinterpret_cast<const AllocationHeader *>(data) - 1);
+	if (header.block == nullptr) {
+		std::free(header.system);
+		return;
+	}
+
+	Block *block = static_cast<Block *>(header.block);
+	if (block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		/* Last use of a block whose arena is gone */
+		std::free(block);
+	}
+}
+
+void
+NFIQ2::QualityMeasures::ScratchArena::trim()
+{
+	size_t reserved { 0 };
+	std::vector<Block *> kept {};
+	for (Block *block : this->blocks_) {
+		if (block->references.load(std::memory_order_acquire) != 1) {
+			kept.push_back(block);
+		} else if (reserved < ReservedBlocks) {
+			block->used = 0;
+			kept.push_back(block);
+			++reserved;
+		} else if (block->references.fetch_sub(1,
+			       std::memory_order_acq_rel) == 1) {
+			std::free(block);
+		}
+	}
+	this->blocks_.swap(kept);
+	this->head_ = this->blocks_.empty() ? nullptr : this->blocks_.front();
+}
+
+NFIQ2::QualityMeasures::ScratchArena *
+NFIQ2::QualityMeasures::ScratchArena::current()
+{
+	return (currentArena);
+}
+
+void
+NFIQ2::QualityMeasures::ScratchArena::setEnabled(const bool enable)
+{
+	enabled.store(enable, std::memory_order_relaxed);
+}
+
+NFIQ2::QualityMeasures::ScratchArena::Statistics
+NFIQ2::QualityMeasures::ScratchArena::getStatistics()
+{
+	Statistics statistics {};
+	statistics.allocations = allocationCount.load(
+	    std::memory_order_relaxed);
+	statistics.systemAllocations = systemAllocationCount.load(
+	    std::memory_order_relaxed);
+
+	return (statistics);
+}
+
+void
+NFIQ2::QualityMeasures::ScratchArena::resetStatistics()
+{
+	allocationCount.store(0, std::memory_order_relaxed);
+	systemAllocationCount.store(0, std::memory_order_relaxed);
+}
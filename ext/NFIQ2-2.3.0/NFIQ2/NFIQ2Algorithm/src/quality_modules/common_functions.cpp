@@ -1,6 +1,8 @@
 
 #include <nfiq2_exception.hpp>
+#include <opencv2/core/hal/hal.hpp>
 #include <opencv2/imgproc.hpp>
+#include <quality_modules/CPUDispatch.h>
 #include <quality_modules/FDA.h>
 #include <quality_modules/LCS.h>
 #include <quality_modules/OCLHistogram.h>
@@ -9,10 +11,12 @@
 #include <quality_modules/common_functions.h>
 
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <complex>
 #include <cstring>
 #include <limits>
+#include <string>
 
 static const int maxSampleCount = 50;
 
@@ -48,50 +52,142 @@ From the matlab code:
 % specify is relative to a unit standard deviation.
 ***/
 
-void
-NFIQ2::QualityMeasures::ridgesegment(const cv::Mat &img, int blksze,
-    double thresh, cv::OutputArray _normImage, cv::Mat &maskImage,
-    cv::OutputArray _maskIndex)
+namespace {
+
+/**
+ * Relative distance to the threshold below which the standard deviation of
+ * a block is measured again the way the MATLAB port does, in addition to
+ * the worst-case rounding error of that measurement.
+ */
+const double BlockStdDevTolerance { 1e-6 };
+
+/** Largest block whose statistics fit exactly in 64-bit integers */
+const int64_t MaxExactBlockArea { 1 << 20 };
+
+/** Largest side of a slanted block projected without a rotated copy */
+const int MaxProfileLength { 64 };
 
+}
+
+void
+NFIQ2::QualityMeasures::ridgesegmentBlocks(const cv::Mat &img, int blksze,
+    double thresh, cv::Mat &blockMask)
 {
-	/***Convert the input image to double.
-	Matlab: im = double(im);
-	***/
-	cv::Mat double_im;
-	img.convertTo(double_im, CV_64F);
+	const int blockRows = (img.rows + blksze - 1) / blksze;
+	const int blockCols = (img.cols + blksze - 1) / blksze;
+	blockMask.create(blockRows, blockCols, CV_8UC1);
 
-	/***Normalize the image to have zero mean, unit standard deviation
-	Matlab: im = (im-mean(im(:))) ./ std(im(:));
+	/***Reference: std(x(:)) of the block of the normalised image. Only
+	computed (once) for blocks that cannot be decided otherwise.
 	***/
-	cv::Scalar imMean = 0, imStd = 0;
-	cv::meanStdDev(double_im, imMean, imStd, cv::noArray());
-	double_im = (double_im - imMean.val[0]) / imStd.val[0];
-	/***For each block in the image, compute the standard deviation. Replace
-	each element of the block with its standard deviation value. Matlab: fun
-	= inline('std(x(:))*ones(size(x))'); stddevim = blkproc(im, [blksze
-	blksze], fun);
+	cv::Mat double_im {};
+	const auto referenceStdDev = [&](const cv::Range &rows,
+					 const cv::Range &cols) {
+		cv::Scalar imMean = 0, imStd = 0;
+		if (double_im.empty()) {
+			img.convertTo(double_im, CV_64F);
+			cv::meanStdDev(double_im, imMean, imStd, cv::noArray());
+			double_im = (double_im - imMean.val[0]) / imStd.val[0];
+		}
+		cv::meanStdDev(double_im(rows, cols), imMean, imStd,
+		    cv::noArray());
+		return (imStd.val[0]);
+	};
+
+	/***The standard deviation of a block of the normalised image is the
+	standard deviation of the block of the original image divided by that of
+	the whole image. Block statistics are exact integer sums read from
+	integral images of the sum and the sum of squares, computed one row of
+	blocks at a time.
 	***/
+	bool exact = (img.type() == CV_8UC1) && (thresh > 0) &&
+	    (static_cast<int64_t>(blksze) * blksze <= MaxExactBlockArea) &&
+	    (static_cast<int64_t>(blksze) * img.cols * 255 <=
+		std::numeric_limits<int32_t>::max());
+	double variance { 0 }, tolerance { 0 };
+	if (exact) {
+		cv::Scalar imMean = 0, imStd = 0;
+		cv::meanStdDev(img, imMean, imStd, cv::noArray());
+		variance = imStd.val[0] * imStd.val[0];
+
+		/* Bound the rounding error of the reference and of variance */
+		const double meanSquare = (imMean.val[0] * imMean.val[0]) +
+		    variance;
+		tolerance = thresh *
+		    (BlockStdDevTolerance +
+			(std::numeric_limits<double>::epsilon() *
+			    ((static_cast<double>(img.total()) * meanSquare /
+				 variance) +
+				(static_cast<double>(blksze) * blksze * 255 *
+				    255 / (variance * thresh * thresh)))));
+		/* Uniform image: the reference divides by zero */
+		exact = (variance > 0) && std::isfinite(tolerance);
+	}
+
+	cv::Mat sum {}, sqsum {};
+	for (int br = 0; br < blockRows; br++) {
+		const cv::Range rows(br * blksze,
+		    cv::min((br + 1) * blksze, img.rows));
+		if (exact) {
+			cv::integral(img(rows, cv::Range::all()), sum, sqsum,
+			    CV_32S, CV_64F);
+		}
+		uint8_t *mask = blockMask.ptr<uint8_t>(br);
+
+		for (int bc = 0; bc < blockCols; bc++) {
+			const cv::Range cols(bc * blksze,
+			    cv::min((bc + 1) * blksze, img.cols));
+
+			double stdDev {
+				std::numeric_limits<double>::quiet_NaN()
+			};
+			if (exact) {
+				const int h = rows.size();
+				const int64_t n = static_cast<int64_t>(h) *
+				    cols.size();
+				const int64_t s = sum.at<int32_t>(h, cols.end) -
+				    sum.at<int32_t>(h, cols.start);
+				const int64_t sq = static_cast<int64_t>(
+				    sqsum.at<double>(h, cols.end) -
+				    sqsum.at<double>(h, cols.start));
+				/* n^2 times the variance of the block */
+				const int64_t scaled = (n * sq) - (s * s);
+				stdDev = std::sqrt(static_cast<double>(scaled) /
+				    (static_cast<double>(n) * n) / variance);
+			}
+			if (!(std::abs(stdDev - thresh) > tolerance)) {
+				stdDev = referenceStdDev(rows, cols);
+			}
 
-	cv::Mat stddevim = double_im.clone();
-	cv::Mat im_roi;
-
-	for (int r = 0; r < stddevim.rows; r += blksze) {
-		for (int c = 0; c < stddevim.cols; c += blksze) {
-			// cv::Range is open-ended on the upper end: r <= i < r
-			// + blksze
-			im_roi = stddevim(
-			    cv::Range(r, cv::min(r + blksze, stddevim.rows)),
-			    cv::Range(c, cv::min(c + blksze, stddevim.cols)));
-			cv::meanStdDev(im_roi, imMean, imStd, cv::noArray());
-			im_roi = imStd.val[0];
+			// Matlab: result of comparison is 1 or 0; OpenCV: 255
+			mask[bc] = (stdDev > thresh) ? 255 : 0;
 		}
 	}
+}
+
+void
+NFIQ2::QualityMeasures::ridgesegment(const cv::Mat &img, int blksze,
+    double thresh, cv::OutputArray _normImage, cv::Mat &maskImage,
+    cv::OutputArray _maskIndex)
+
+{
+	/***For each block in the image, compute the standard deviation of the
+	normalised image and compare it to the threshold. Matlab: fun =
+	inline('std(x(:))*ones(size(x))'); stddevim = blkproc(im, [blksze
+	blksze], fun); mask = stddevim > thresh;
+	***/
+	cv::Mat blockMask;
+	ridgesegmentBlocks(img, blksze, thresh, blockMask);
 
 	maskImage.create(img.size(), CV_8UC1);
-	// OpenCV: Result of comparison is an 8-bit single channel mask whose
-	// elements are set to 255 (if the particular element satisfies the
-	// condition) or 0. Matlab: result of comparison is 1 or 0;
-	maskImage = (stddevim > thresh);
+	for (int i = 0; i < maskImage.rows; i++) {
+		const uint8_t *blocks = blockMask.ptr<uint8_t>(i / blksze);
+		uint8_t *row = maskImage.ptr<uint8_t>(i);
+		for (int c = 0; c < maskImage.cols; c += blksze) {
+			std::memset(row + c, blocks[c / blksze],
+			    cv::min(blksze, maskImage.cols - c));
+		}
+	}
 
 	if (_maskIndex.needed()) {
 		/***Create the mask vector indicating ridge-like regions: get
@@ -115,6 +211,16 @@ NFIQ2::QualityMeasures::ridgesegment(const cv::Mat &img, int blksze,
 	}
 
 	if (_normImage.needed()) {
+		/***Convert the input image to double and normalize it to have
+		zero mean, unit standard deviation. Matlab: im = double(im);
+		im = (im-mean(im(:))) ./ std(im(:));
+		***/
+		cv::Mat double_im;
+		cv::Scalar imMean = 0, imStd = 0;
+		img.convertTo(double_im, CV_64F);
+		cv::meanStdDev(double_im, imMean, imStd, cv::noArray());
+		double_im = (double_im - imMean.val[0]) / imStd.val[0];
+
 		_normImage.create(double_im.size(), double_im.type());
 		cv::Mat normImage = _normImage.getMat();
 
@@ -129,7 +235,71 @@ NFIQ2::QualityMeasures::ridgesegment(const cv::Mat &img, int blksze,
 	return;
 }
 
+std::string
+NFIQ2::QualityMeasures::getCPUDispatchTarget()
+{
+#if NFIQ2_CPU_DISPATCH_AVAILABLE
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return ("avx512f");
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return ("avx2");
+	}
+#endif
+	return ("default");
+}
+
 /////////////////////////////////////////////////////////////////////////
+namespace {
+
+/** Widest block whose squared gradients sum exactly to a 32-bit row sum */
+const int MaxExactGradientCols { 8192 };
+
+/**
+ * Sums of the squares and of the product of twice the gradients of an 8-bit
+ * block, twice the centered differences being integers: the difference of
+ * the neighbours inside the block, twice the forward difference at its
+ * edges. One pass, no floating-point and no copies of the block.
+ */
+NFIQ2_CPU_DISPATCH void
+gradientCovarianceSums(const cv::Mat &block, int64_t &xx, int64_t &yy,
+    int64_t &xy)
+{
+	const int cols = block.cols;
+	xx = yy = xy = 0;
+	for (int r = 0; r < block.rows; r++) {
+		const uint8_t *row = block.ptr<uint8_t>(r);
+		const uint8_t *above = block.ptr<uint8_t>(std::max(r - 1, 0));
+		const uint8_t *below = block.ptr<uint8_t>(
+		    std::min(r + 1, block.rows - 1));
+		const int yScale = ((r == 0) || (r == block.rows - 1)) ? 2 : 1;
+
+		int32_t rowXX = 0, rowYY = 0, rowXY = 0;
+		for (int c = 1; c < cols - 1; c++) {
+			const int32_t gx = row[c + 1] - row[c - 1];
+			const int32_t gy = (below[c] - above[c]) * yScale;
+			rowXX += gx * gx;
+			rowYY += gy * gy;
+			rowXY += gx * gy;
+		}
+		for (const int c : { 0, cols - 1 }) {
+			const int32_t gx = (row[std::min(c + 1, cols - 1)] -
+					       row[std::max(c - 1, 0)]) *
+			    2;
+			const int32_t gy = (below[c] - above[c]) * yScale;
+			rowXX += gx * gx;
+			rowYY += gy * gy;
+			rowXY += gx * gy;
+		}
+		xx += rowXX;
+		yy += rowYY;
+		xy += rowXY;
+	}
+}
+
+}
+
 /***function [a b c] = covcoef(blk)
 %COVCOEF Computes covariance coefficients of grey level gradients
 %   Computes coefficients of covariance matrix [a c; c b] of grey level
@@ -167,6 +337,25 @@ NFIQ2::QualityMeasures::covcoef(const cv::Mat &imblock, double &a, double &b,
 	comMethod parameter controls which gradient estimation method is used.
 	***/
 
+	/***The centered differences of an 8-bit block are multiples of 1/2,
+	so their squares and products are multiples of 1/4 and all the sums
+	below are exact. Summing them as integers gives the same means.
+	***/
+	if ((compMethod == CENTERED_DIFFERENCES) &&
+	    (imblock.type() == CV_8UC1) && (imblock.rows >= 2) &&
+	    (imblock.cols >= 2) && (imblock.cols <= MaxExactGradientCols) &&
+	    (static_cast<int64_t>(imblock.rows) * imblock.cols <=
+		MaxExactBlockArea)) {
+		int64_t xx, yy, xy;
+		gradientCovarianceSums(imblock, xx, yy, xy);
+		// as cv::mean(): sum scaled by the reciprocal of the count
+		const double scale = 1. / static_cast<double>(imblock.total());
+		a = (static_cast<double>(xx) * 0.25) * scale;
+		b = (static_cast<double>(yy) * 0.25) * scale;
+		c = (static_cast<double>(xy) * 0.25) * scale;
+		return;
+	}
+
 	cv::Mat dfx, dfy, dfxT;
 	cv::Mat doubleIm;
 
@@ -279,6 +468,62 @@ allfun = inline('all(x(:))');
 	return (allNonZero);
 }
 
+void
+NFIQ2::QualityMeasures::orientangdiff(const cv::Mat &blkorient,
+    cv::Mat &loqall)
+{
+	constexpr double Deg2Rad = M_PI / 180.0;
+	constexpr double ThreeSixtyRad = Deg2Rad * 360.0;
+	const double bsize = 9; // The center point plus its immediate
+				// neighbors forms a 3x3 block
+
+	// cv::sum() of the continuous 3x3 absdiff() adds four elements at a
+	// time, then the last one; keep that order so results are identical
+	forEachNeighbourhood<double, double>(blkorient, 0.0, loqall,
+	    [&](const double *above, const double *row, const double *below,
+		const int c) {
+		    // Subtract the neighbourhood from the center value and
+		    // get its absolute value, accounting for circularity
+		    const double center = row[c];
+		    const double d[9] = { std::abs(center - above[c - 1]),
+			    std::abs(center - above[c]),
+			    std::abs(center - above[c + 1]),
+			    std::abs(center - row[c - 1]),
+			    std::abs(center - row[c]),
+			    std::abs(center - row[c + 1]),
+			    std::abs(center - below[c - 1]),
+			    std::abs(center - below[c]),
+			    std::abs(center - below[c + 1]) };
+		    double sum = 0;
+		    sum += std::min(d[0], ThreeSixtyRad - d[0]) +
+			std::min(d[1], ThreeSixtyRad - d[1]) +
+			std::min(d[2], ThreeSixtyRad - d[2]) +
+			std::min(d[3], ThreeSixtyRad - d[3]);
+		    sum += std::min(d[4], ThreeSixtyRad - d[4]) +
+			std::min(d[5], ThreeSixtyRad - d[5]) +
+			std::min(d[6], ThreeSixtyRad - d[6]) +
+			std::min(d[7], ThreeSixtyRad - d[7]);
+		    sum += std::min(d[8], ThreeSixtyRad - d[8]);
+		    return sum / (bsize - 1);
+	    });
+}
+
+void
+NFIQ2::QualityMeasures::allfunNeighbourhood(const cv::Mat &mask,
+    cv::Mat &neighbourhoodMask)
+{
+	forEachNeighbourhood<uint8_t, uint8_t>(mask, 0, neighbourhoodMask,
+	    [](const uint8_t *above, const uint8_t *row, const uint8_t *below,
+		const int c) {
+		    // no short circuit, so that columns vectorize
+		    return static_cast<uint8_t>((above[c - 1] != 0) &
+			(above[c] != 0) & (above[c + 1] != 0) &
+			(row[c - 1] != 0) & (row[c] != 0) &
+			(row[c + 1] != 0) & (below[c - 1] != 0) &
+			(below[c] != 0) & (below[c + 1] != 0));
+	    });
+}
+
 //////////////////////////////////////////////////////////////
 /* This function computes the gradient across the rows of a 2D matrix using
 forward differences at the edges and central differences elsewhere.
@@ -354,24 +599,270 @@ NFIQ2::QualityMeasures::getRotatedBlock(const cv::Mat &block,
 	return;
 }
 //////////////////////////////////////////////////////////////////////////////
+namespace {
+
+/** Nearest neighbour mapping of a slanted block into the (padded) block */
+struct SlantedBlockMapping {
+	/** First pixel and row stride of the block */
+	const uint8_t *data;
+	ptrdiff_t step;
+	/** Pixels that can be read, relative to the block: the rest are 0 */
+	int left, top, right, bottom;
+	/** Padding of the block that the rotation is about */
+	int pad;
+	/** Fixed-point source coordinates of the first pixel of each row */
+	const int *X0, *Y0;
+	/** Fixed-point increments of the source coordinates along rows */
+	const int *adelta, *bdelta;
+	int rows, cols;
+};
+
+/**
+ * Gather the pixels of a slanted block as cv::warpAffine() does with
+ * cv::INTER_NEAREST, summing its rows and columns and optionally storing
+ * them in `slanted` (`rows` x `cols`, of row stride `slantedStep`).
+ */
+NFIQ2_CPU_DISPATCH void
+sampleSlantedBlock(const SlantedBlockMapping &m, int *rowSums, int *colSums,
+    uint8_t *slanted, const ptrdiff_t slantedStep)
+{
+	const int AB_BITS = MAX(10, (int)cv::INTER_BITS);
+	for (int y = 0; y < m.rows; y++) {
+		uint8_t *slantedRow = (slanted == nullptr) ?
+		    nullptr :
+		    slanted + (y * slantedStep);
+		int rowSum = 0;
+		for (int x = 0; x < m.cols; x++) {
+			const int X = cv::saturate_cast<short>(
+					  (m.X0[y] + m.adelta[x]) >> AB_BITS) -
+			    m.pad;
+			const int Y = cv::saturate_cast<short>(
+					  (m.Y0[y] + m.bdelta[x]) >> AB_BITS) -
+			    m.pad;
+			const int value = ((X >= m.left) && (X < m.right) &&
+					      (Y >= m.top) && (Y < m.bottom)) ?
+			    m.data[(Y * m.step) + X] :
+			    0;
+			if (slantedRow != nullptr) {
+				slantedRow[x] = static_cast<uint8_t>(value);
+			}
+			rowSum += value;
+			colSums[x] += value;
+		}
+		rowSums[y] = rowSum;
+	}
+}
+
+}
+
+void
+NFIQ2::QualityMeasures::getRotatedBlockProfile(const cv::Mat &block,
+    const double orientation, bool padFlag, const cv::Range &rows,
+    const cv::Range &cols, projection_type projection,
+    ScratchVector<double> &profile, cv::OutputArray _slantedBlock)
+{
+	const int count = (projection == ROW_MEANS) ? rows.size() :
+						      cols.size();
+	const int length = (projection == ROW_MEANS) ? cols.size() :
+						       rows.size();
+	profile.assign(count, 0);
+
+	if ((block.type() != CV_8UC1) || (rows.size() > MaxProfileLength) ||
+	    (cols.size() > MaxProfileLength)) {
+		cv::Mat rotatedBlock;
+		getRotatedBlock(block, orientation, padFlag, rotatedBlock);
+		const cv::Mat cropped = rotatedBlock(rows, cols);
+		if (_slantedBlock.needed()) {
+			cropped.copyTo(_slantedBlock);
+		}
+		for (int i = 0; i < count; i++) {
+			profile[i] = cv::mean((projection == ROW_MEANS) ?
+				cropped.row(i) :
+				cropped.col(i))
+					 .val[0];
+		}
+		return;
+	}
+
+	// sanity check: check block size
+	float cBlock = static_cast<float>(block.rows) / 2; // square block
+	int icBlock = static_cast<int>(cBlock);
+	if (icBlock != cBlock) {
+		throw NFIQ2::Exception {
+			NFIQ2::ErrorCode::QualityMeasureCalculationError,
+			"Wrong block size! Consider block with size of even number "
+			"(block rows = " +
+			    std::to_string(block.rows) + ')'
+		};
+	}
+	if ((rows.start < 0) || (rows.end > block.rows) || (cols.start < 0) ||
+	    (cols.end > block.cols) || (count <= 0) || (length <= 0)) {
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
+		    "Slanted block is not within the rotated block");
+	}
+
+	/***Same mapping as getRotatedBlock(): the rotation matrix about the
+	center of the (padded) block, inverted, and the fixed-point nearest
+	neighbour coordinates of cv::warpAffine(). cv::copyMakeBorder() pads a
+	block that is part of a larger image with the pixels around it, so
+	pixels mapped into the padding are read from there when the image has
+	them. All others are 0 (constant padding and border).
+	***/
+	const double Rad2Deg = 180.0 / M_PI;
+	const int pad = padFlag ? 2 : 0;
+	cv::Size wholeSize;
+	cv::Point offset;
+	block.locateROI(wholeSize, offset);
+	const int left = std::max(-pad, -offset.x);
+	const int top = std::max(-pad, -offset.y);
+	const int right = std::min(block.cols + pad,
+	    wholeSize.width - offset.x);
+	const int bottom = std::min(block.rows + pad,
+	    wholeSize.height - offset.y);
+	const cv::Point2f center(((float)(block.cols + (2 * pad)) / 2.0f),
+	    ((float)(block.rows + (2 * pad)) / 2.0f));
+	const cv::Matx23d rot_mat = cv::getRotationMatrix2D_(center,
+	    orientation * Rad2Deg, 1);
+
+	double M[6];
+	std::copy(rot_mat.val, rot_mat.val + 6, M);
+	double D = M[0] * M[4] - M[1] * M[3];
+	D = D != 0 ? 1. / D : 0;
+	double A11 = M[4] * D, A22 = M[0] * D;
+	M[0] = A11;
+	M[1] *= -D;
+	M[3] *= -D;
+	M[4] = A22;
+	double b1 = -M[0] * M[2] - M[1] * M[5];
+	double b2 = -M[3] * M[2] - M[4] * M[5];
+	M[2] = b1;
+	M[5] = b2;
+
+	const int AB_BITS = MAX(10, (int)cv::INTER_BITS);
+	const int AB_SCALE = 1 << AB_BITS;
+	const int round_delta = AB_SCALE / 2;
+
+	cv::Mat slantedBlock;
+	if (_slantedBlock.needed()) {
+		_slantedBlock.create(rows.size(), cols.size(), CV_8UC1);
+		slantedBlock = _slantedBlock.getMat();
+	}
+
+	int adelta[MaxProfileLength], bdelta[MaxProfileLength];
+	int X0[MaxProfileLength], Y0[MaxProfileLength];
+	int rowSums[MaxProfileLength] {}, colSums[MaxProfileLength] {};
+	for (int x = cols.start; x < cols.end; x++) {
+		adelta[x - cols.start] = cv::saturate_cast<int>(
+		    M[0] * x * AB_SCALE);
+		bdelta[x - cols.start] = cv::saturate_cast<int>(
+		    M[3] * x * AB_SCALE);
+	}
+	for (int y = rows.start; y < rows.end; y++) {
+		X0[y - rows.start] = cv::saturate_cast<int>(
+					 (M[1] * y + M[2]) * AB_SCALE) +
+		    round_delta;
+		Y0[y - rows.start] = cv::saturate_cast<int>(
+					 (M[4] * y + M[5]) * AB_SCALE) +
+		    round_delta;
+	}
+
+	const SlantedBlockMapping mapping { block.data,
+		static_cast<ptrdiff_t>(block.step[0]), left, top, right, bottom,
+		pad, X0, Y0, adelta, bdelta, rows.size(), cols.size() };
+	sampleSlantedBlock(mapping, rowSums, colSums,
+	    slantedBlock.empty() ? nullptr : slantedBlock.data,
+	    static_cast<ptrdiff_t>(slantedBlock.step[0]));
+
+	// as cv::mean(): exact sum scaled by the reciprocal of the count
+	const double scale = 1. / length;
+	for (int i = 0; i < count; i++) {
+		profile[i] = ((projection == ROW_MEANS) ? rowSums[i] :
+							  colSums[i]) *
+		    scale;
+	}
+
+	return;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+namespace {
+
+/**
+ * QR decomposition of [ones(n,1) (1:n)'] by cv::hal::QR64f(): Householder
+ * vectors (scaled to a leading 1), their factors and R.
+ */
+struct LineFitDecomposition {
+	std::array<double, MaxProfileLength> u0 {}, u1 {};
+	double h0 {}, h1 {};
+	double r00 {}, r01 {}, r11 {};
+	bool solvable {};
+};
+
+/** @return Decomposition for fitting a line to `n` points (n >= 2) */
+const LineFitDecomposition &
+lineFitDecomposition(const int n)
+{
+	static const std::array<LineFitDecomposition, MaxProfileLength + 1>
+	    decompositions = []() {
+		    std::array<LineFitDecomposition, MaxProfileLength + 1> d {};
+		    for (int m = 2; m <= MaxProfileLength; m++) {
+			    cv::Mat a(m, 2, CV_64F);
+			    for (int i = 0; i < m; i++) {
+				    a.at<double>(i, 0) = 1;
+				    a.at<double>(i, 1) = i + 1;
+			    }
+			    double hFactors[2];
+			    const bool solvable = cv::hal::QR64f(
+				a.ptr<double>(), a.step, m, 2, 1, nullptr, 0,
+				hFactors) != 0;
+
+			    LineFitDecomposition &qr = d[m];
+			    qr.u0[0] = qr.u1[0] = 1;
+			    for (int i = 1; i < m; i++) {
+				    qr.u0[i] = a.at<double>(i, 0);
+			    }
+			    for (int i = 1; i < m - 1; i++) {
+				    qr.u1[i] = a.at<double>(i + 1, 1);
+			    }
+			    qr.h0 = hFactors[0];
+			    qr.h1 = hFactors[1];
+			    qr.r00 = a.at<double>(0, 0);
+			    qr.r01 = a.at<double>(0, 1);
+			    qr.r11 = a.at<double>(1, 1);
+			    // back substitution gives up on a singular R
+			    qr.solvable = solvable &&
+				(std::abs(qr.r11) >= DBL_EPSILON * 100) &&
+				(std::abs(qr.r00) >= DBL_EPSILON * 100);
+		    }
+		    return d;
+	    }();
+
+	return decompositions[n];
+}
+
+}
+
+template <int MaxLength>
 void
-NFIQ2::QualityMeasures::getRidgeValleyStructure(const cv::Mat &blockCropped,
-    std::vector<uint8_t> &ridval, std::vector<double> &dt)
+NFIQ2::QualityMeasures::getRidgeValleyStructure(
+    const ScratchVector<double> &profile,
+    RidgeValleyStructure<MaxLength> &structure)
 {
-	// average profile of blockCropped: Compute average of each column to
-	// get a projection of the grey values down the ridges.
+	static_assert(MaxLength <= MaxProfileLength,
+	    "Slanted block too wide for the line fit");
+
+	// average profile of blockCropped: average of each column, a
+	// projection of the grey values down the ridges.
 	//    Matlab:  v3 = mean(blockCropped);
-	//    Note: If A is a matrix, mean(A) treats the columns of A as
-	//    vectors, returning
-	//          a row vector of mean values.
-	cv::Mat v3 = cv::Mat::zeros(blockCropped.cols, 1, CV_64F);
-	cv::Mat blockCol;
-	cv::Scalar colMean;
-	for (int i = 0; i < blockCropped.cols; i++) {
-		// extract a column from blockCropped
-		blockCol = blockCropped.col(i);
-		colMean = cv::mean(blockCol, cv::noArray());
-		v3.at<double>(i, 0) = colMean.val[0];
+	const double *v3 = profile.data();
+	const int n = static_cast<int>(profile.size());
+	if ((n < 2) || (n > MaxLength)) {
+		throw NFIQ2::Exception(
+		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
+		    "Exception during ridge/valley processing: cannot fit "
+		    "a line to " +
+			std::to_string(n) + " column means");
 	}
 
 	// %% Linear regression using least square
@@ -382,49 +873,62 @@ NFIQ2::QualityMeasures::getRidgeValleyStructure(const cv::Mat &blockCropped,
 	// % Append a column of ones before dividing to include an intercept,
 	// dt1 = [intercept coefficient]
 	//  dt1 = [ones(length(x),1) x'] \ v3';
-	cv::Mat dttemp(v3.rows, 2, CV_64F);
-	for (int i = 0; i < v3.rows; i++) {
-		dttemp.at<double>(i, 0) = 1;
-		dttemp.at<double>(i, 1) = i + 1;
+	// The decomposition only depends on x, so only the reflections of v3
+	// and the back substitution of cv::solve(cv::DECOMP_QR) are left,
+	// in the same order of operations.
+	const LineFitDecomposition &qr = lineFitDecomposition(n);
+	double s0 = 0;
+	for (int i = 0; i < n; i++) {
+		s0 += qr.u0[i] * v3[i];
 	}
-
-	cv::Mat dt1;
-	try {
-		cv::solve(dttemp, v3, dt1, cv::DECOMP_QR);
-	} catch (const cv::Exception &e) {
-		throw NFIQ2::Exception(
-		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
-		    "Exception during ridge/valley processing: "
-		    "cv::solve(cv::DECOMP_QR) " +
-			std::string(e.what()));
+	double s1 = 0;
+	for (int i = 1; i < n; i++) {
+		s1 += qr.u1[i - 1] * (v3[i] - 2 * qr.u0[i] * s0 * qr.h0);
+	}
+	double dt1[2];
+	dt1[0] = v3[0] - 2 * qr.u0[0] * s0 * qr.h0;
+	dt1[1] = (v3[1] - 2 * qr.u0[1] * s0 * qr.h0) -
+	    2 * qr.u1[0] * s1 * qr.h1;
+	if (qr.solvable) {
+		dt1[1] /= qr.r11;
+		dt1[0] -= dt1[1] * qr.r01;
+		dt1[0] /= qr.r00;
 	}
 
 	// Round to 10 decimal points to preserve score consistency across
 	// platforms (10^10)
-
-	dt1.forEach<double>([&](double &val, const int *) {
+	for (double &val : dt1) {
 		val = round(val * 10000000000) / 10000000000;
-	});
+	}
 
 	//%% Block segmentation into ridge and valley regions
 	//  dt = x*dt1(2) + dt1(1);
-	double tmpx, tmpi;
-	for (int i = 0; i < v3.rows; i++) {
-		tmpi = static_cast<double>(i + 1);
-		tmpx = tmpi * dt1.at<double>(1, 0) + dt1.at<double>(0, 0);
-		dt.push_back(tmpx);
-	}
 	// ridval = (v3 < dt)'; % ridges = 1, valleys = 0
-
-	for (unsigned int i = 0; i < dt.size(); i++) {
-		if (v3.at<double>(i, 0) < dt[i]) {
-			ridval.push_back(1);
-		} else {
-			ridval.push_back(0);
+	structure.length = n;
+	structure.changes = 0;
+	for (int i = 0; i < n; i++) {
+		structure.dt[i] = static_cast<double>(i + 1) * dt1[1] + dt1[0];
+		structure.ridval[i] = (v3[i] < structure.dt[i]) ? 1 : 0;
+
+		// change = xor(ridval,circshift(ridval,1)); change(1) = [];
+		// changeIndex = find(change == 1);
+		if ((i > 0) &&
+		    (structure.ridval[i] != structure.ridval[i - 1])) {
+			const int c = structure.changes++;
+			structure.changeIndex[c] = static_cast<uint8_t>(i - 1);
+			structure.widths[c] = static_cast<uint8_t>((c == 0) ?
+				(i - 1) :
+				(i - 1 - structure.changeIndex[c - 1]));
 		}
 	}
+
 	return;
 }
+
+template void NFIQ2::QualityMeasures::getRidgeValleyStructure<
+    NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth>(
+    const ScratchVector<double> &,
+    RidgeValleyStructure<NFIQ2::Sizes::VerticallyAlignedLocalRegionWidth> &);
 //////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -549,9 +1053,10 @@ NFIQ2::QualityMeasures::computeNumericalGradients(const cv::Mat &mat,
 
 void
 NFIQ2::QualityMeasures::addHistogramFeatures(
-    std::unordered_map<std::string, double> &featureDataList,
-    std::string featurePrefix, std::vector<double> &binBoundaries,
-    std::vector<double> &dataVector, int binCount)
+    QualityMeasureValues &featureDataList,
+    const NativeQualityMeasure::Index firstBin,
+    std::vector<double> &binBoundaries, ScratchVector<double> &dataVector,
+    int binCount)
 {
 	binBoundaries.push_back(std::numeric_limits<double>::infinity());
 
@@ -560,7 +1065,8 @@ NFIQ2::QualityMeasures::addHistogramFeatures(
 	if (myBinCount != binCount) {
 		throw NFIQ2::Exception(
 		    NFIQ2::ErrorCode::QualityMeasureCalculationError,
-		    "Wrong histogram bin count for " + featurePrefix +
+		    std::string("Wrong histogram bin count for ") +
+			NativeQualityMeasureIdentifiers[firstBin] +
 			". "
 			"Should be " +
 			std::to_string(binCount) + " but is " +
@@ -569,7 +1075,7 @@ NFIQ2::QualityMeasures::addHistogramFeatures(
 
 	std::sort(dataVector.begin(), dataVector.end());
 
-	std::vector<int> bins(binCount, 0);
+	ScratchVector<int> bins(binCount, 0);
 	int currentBucket = 0;
 	double currentBound = binBoundaries.at(currentBucket);
 
@@ -582,17 +1088,19 @@ NFIQ2::QualityMeasures::addHistogramFeatures(
 	}
 
 	for (int i = 0; i < binCount; i++) {
-		featureDataList[featurePrefix + std::to_string(i)] = bins[i];
+		featureDataList.at(static_cast<NativeQualityMeasure::Index>(
+		    firstBin + i)) = bins[i];
 	}
 
-	cv::Mat dataMat(dataVector);
+	cv::Mat dataMat(static_cast<int>(dataVector.size()), 1, CV_64F,
+	    dataVector.data());
 	cv::Scalar mean, stdDev;
 	cv::meanStdDev(dataMat, mean, stdDev);
 
-	featureDataList[featurePrefix + FeatureFunctionsMeanSuffix] =
-	    mean.val[0];
-	featureDataList[featurePrefix + FeatureFunctionsStdDevSuffix] =
-	    stdDev.val[0];
+	featureDataList.at(static_cast<NativeQualityMeasure::Index>(
+	    firstBin + binCount)) = mean.val[0];
+	featureDataList.at(static_cast<NativeQualityMeasure::Index>(
+	    firstBin + binCount + 1)) = stdDev.val[0];
 }
 
 void
@@ -328,7 +328,10 @@ NFIQ2UI::printUsage()
 		     "NFIQ 2: "
 		  << NFIQ2::Version::Pretty
 		  << " (Date: " << NFIQ2::Version::BuildDate
-		  << ", Commit: " << NFIQ2::Version::Commit << ")\n";
+		  << ", Commit: " << NFIQ2::Version::Commit << ")\n"
+		  << "Kernels: " << NFIQ2::Version::CPUDispatch() << "\n"
+		  << "OpenCV CPU features: "
+		  << NFIQ2::Version::OpenCVCPUFeatures() << "\n";
 #ifdef NFIQ2_EMBED_RANDOM_FOREST_PARAMETERS
 	std::cout << "Embedded model present\n";
 #endif
@@ -0,0 +1,98 @@
+/*
+ * Converts the embedded random forest parameters into the FlatForest
+ * binary format and writes them as a C++ header, together with the hash
+ * RandomForestML::initModule() would have computed from the YAML text.
+ *
+ * Usage: nfiq2-compile-model <output.h> [model.yaml]
+ *
+ * Without a model file, the parameters embedded through
+ * RandomForestTrainedParams.h are converted.
+ */
+
+#include <nfiq2_data.hpp>
+#include <nfiq2_exception.hpp>
+#include <prediction/FlatForest.h>
+#include <prediction/RandomForestTrainedParams.h>
+
+#include "digestpp.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+int
+main(int argc, char **argv)
+{
+	if ((argc < 2) || (argc > 3)) {
+		std::cerr << "Usage: " << argv[0] << " <output.h> [model.yaml]\n";
+		return (EXIT_FAILURE);
+	}
+
+	try {
+		std::string params {};
+		if (argc == 3) {
+			std::ifstream input(argv[2]);
+			if (!input) {
+				std::cerr << "Cannot open " << argv[2] << "\n";
+				return (EXIT_FAILURE);
+			}
+			params.assign(std::istreambuf_iterator<char>(input),
+			    std::istreambuf_iterator<char>());
+		} else {
+			std::string base64 {};
+			for (const auto &chunk : g_strRandomForestTrainedParams) {
+				base64.append(chunk);
+			}
+			NFIQ2::Data data;
+			data.fromBase64String(base64);
+			params.assign(reinterpret_cast<const char *>(data.data()),
+			    data.size());
+		}
+
+		cv::FileStorage fs(params, cv::FileStorage::READ |
+			cv::FileStorage::MEMORY | cv::FileStorage::FORMAT_YAML);
+		cv::Ptr<cv::ml::RTrees> rtrees = cv::ml::RTrees::create();
+		rtrees->read(fs["my_random_trees"]);
+		const std::vector<uint8_t> binary =
+		    NFIQ2::Prediction::FlatForest(*rtrees, fs["my_random_trees"])
+			.serialize();
+
+		digestpp::md5 hasher;
+		const std::string hash =
+		    hasher.absorb(params.c_str(), params.length()).hexdigest();
+
+		std::ofstream output(argv[1]);
+		output << "/* Generated by nfiq2-compile-model. Do not edit. */\n"
+		       << "#ifndef NFIQ2_PREDICTION_RANDOMFORESTCOMPILEDPARAMS_H_\n"
+		       << "#define NFIQ2_PREDICTION_RANDOMFORESTCOMPILEDPARAMS_H_\n"
+		       << "\n#include <cstdint>\n\n"
+		       << "static const char g_strRandomForestCompiledParamsHash[] "
+			  "{ \""
+		       << hash << "\" };\n\n"
+		       << "static const uint8_t g_randomForestCompiledParams[] {";
+		output << std::hex << std::setfill('0');
+		for (size_t i { 0 }; i < binary.size(); ++i) {
+			output << ((i % 12) == 0 ? "\n\t" : " ") << "0x"
+			       << std::setw(2) << static_cast<int>(binary[i])
+			       << ",";
+		}
+		output << "\n};\n\n"
+		       << "#endif /* NFIQ2_PREDICTION_RANDOMFORESTCOMPILEDPARAMS_H_ "
+			  "*/\n";
+		if (!output) {
+			std::cerr << "Cannot write " << argv[1] << "\n";
+			return (EXIT_FAILURE);
+		}
+	} catch (const cv::Exception &e) {
+		std::cerr << e.msg << "\n";
+		return (EXIT_FAILURE);
+	} catch (const NFIQ2::Exception &e) {
+		std::cerr << e.what() << "\n";
+		return (EXIT_FAILURE);
+	}
+
+	return (EXIT_SUCCESS);
+}
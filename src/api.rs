@@ -1,37 +1,240 @@
 use std::{
-    ffi::CStr,
-    os::raw::{c_char, c_uint, c_ushort},
+    ffi::{c_void, CStr},
+    os::raw::{c_char, c_int, c_uint, c_ushort},
+    panic::AssertUnwindSafe,
     ptr,
+    sync::{Mutex, OnceLock},
 };
 
+use image::GrayImage;
+
 use crate::{
     ffi::{
-        nfiq2wrapper_compute, nfiq2wrapper_create, nfiq2wrapper_destroy, nfiq2wrapper_free_results,
-        Nfiq2ResultsT, Nfiq2WrapperOpaque,
+        nfiq2wrapper_actionable_names, nfiq2wrapper_algorithm_names, nfiq2wrapper_clone,
+        nfiq2wrapper_compute, nfiq2wrapper_compute_batch_from, nfiq2wrapper_compute_instrumented,
+        nfiq2wrapper_compute_request, nfiq2wrapper_cpu_dispatch, nfiq2wrapper_create,
+        nfiq2wrapper_default_triage_policy, nfiq2wrapper_destroy, nfiq2wrapper_feature_names,
+        nfiq2wrapper_free_string, nfiq2wrapper_histograms, nfiq2wrapper_model,
+        nfiq2wrapper_reset_histograms, nfiq2wrapper_set_module_threads,
+        nfiq2wrapper_set_opencv_threads, nfiq2wrapper_set_triage_policy, nfiq2wrapper_stage_names,
+        Nfiq2ImageT, Nfiq2InstrumentationT, Nfiq2RequestT, Nfiq2ResultsT, Nfiq2TriagePolicyT,
+        Nfiq2WrapperOpaque,
     },
     Nfiq2Error,
 };
 
+/// PPI passed to NFIQ2 for decoded images
+const DEFAULT_PPI: u16 = 500; // hardcoded PPI, can be adjusted as needed
+
+/// Number of native quality features, see `feature_names`
+pub const FEATURE_COUNT: usize = crate::ffi::FEATURE_COUNT;
+
+/// Number of actionable feedback values, see `actionable_names`
+pub const ACTIONABLE_COUNT: usize = crate::ffi::ACTIONABLE_COUNT;
+
+/// `score` of results without one (triaged images, requests not asking for
+/// it). Scores range from 0 to 100, so 0 is a valid score.
+pub const NO_SCORE: u32 = crate::ffi::NO_SCORE;
+
 #[derive(Debug, uniffi::Record)]
 pub struct Nfiq2Value {
     pub name: String,
     pub value: f64,
 }
 
-/// Safe Rust view of the results
+/// Safe Rust view of the results. A `triaged` image (see
+/// `set_triage_policy`) has score `NO_SCORE` and NaN for every value that
+/// was not computed.
 #[derive(Debug, uniffi::Record)]
 pub struct Nfiq2Result {
     pub score: u32,
+    pub triaged: bool,
     pub actionable: Vec<Nfiq2Value>,
     pub features: Vec<Nfiq2Value>,
 }
 
-/// The high‐level Rust handle
-#[derive(Debug, Clone, uniffi::Object)]
+/// Outcome of one image of a batch: exactly one of `result` and `error` is set
+#[derive(Debug, uniffi::Record)]
+pub struct Nfiq2BatchItem {
+    pub result: Option<Nfiq2Result>,
+    pub error: Option<Nfiq2Error>,
+}
+
+impl From<Result<Nfiq2Result, Nfiq2Error>> for Nfiq2BatchItem {
+    fn from(r: Result<Nfiq2Result, Nfiq2Error>) -> Self {
+        match r {
+            Ok(result) => Nfiq2BatchItem {
+                result: Some(result),
+                error: None,
+            },
+            Err(error) => Nfiq2BatchItem {
+                result: None,
+                error: Some(error),
+            },
+        }
+    }
+}
+
+/// Conditions of actionable feedback under which an image is triaged: only
+/// the quality modules needed to check them run, and no score is computed.
+/// The default stops on uniform and on empty images, at the thresholds of
+/// NFIQ2's actionable feedback. Checking the foreground runs the ROI module,
+/// one of the most expensive, so it is off by default.
+#[derive(Debug, Clone, Copy, PartialEq, uniffi::Record)]
+pub struct Nfiq2TriagePolicy {
+    /// Stop if `UniformImage` is below `uniform_image_threshold`
+    pub stop_on_uniform_image: bool,
+    pub uniform_image_threshold: f64,
+    /// Stop if `EmptyImageOrContrastTooLow` is above `empty_image_threshold`
+    pub stop_on_empty_image: bool,
+    pub empty_image_threshold: f64,
+    /// Stop if `SufficientFingerprintForeground` is below
+    /// `foreground_threshold`
+    pub stop_on_insufficient_foreground: bool,
+    pub foreground_threshold: f64,
+}
+
+impl Default for Nfiq2TriagePolicy {
+    fn default() -> Self {
+        let mut raw: Nfiq2TriagePolicyT = unsafe { std::mem::zeroed() };
+        unsafe { nfiq2wrapper_default_triage_policy(&mut raw) };
+        Nfiq2TriagePolicy {
+            stop_on_uniform_image: raw.stop_on_uniform_image != 0,
+            uniform_image_threshold: raw.uniform_image_threshold,
+            stop_on_empty_image: raw.stop_on_empty_image != 0,
+            empty_image_threshold: raw.empty_image_threshold,
+            stop_on_insufficient_foreground: raw.stop_on_insufficient_foreground != 0,
+            foreground_threshold: raw.foreground_threshold,
+        }
+    }
+}
+
+impl From<&Nfiq2TriagePolicy> for Nfiq2TriagePolicyT {
+    fn from(policy: &Nfiq2TriagePolicy) -> Self {
+        Nfiq2TriagePolicyT {
+            stop_on_uniform_image: policy.stop_on_uniform_image as u8,
+            uniform_image_threshold: policy.uniform_image_threshold,
+            stop_on_empty_image: policy.stop_on_empty_image as u8,
+            empty_image_threshold: policy.empty_image_threshold,
+            stop_on_insufficient_foreground: policy.stop_on_insufficient_foreground as u8,
+            foreground_threshold: policy.foreground_threshold,
+        }
+    }
+}
+
+/// What `compute_request` computes. Only the quality modules a request
+/// needs run, each at most once; values it does not ask for are NaN, and
+/// `score` is `NO_SCORE` unless it is asked for.
+#[derive(Debug, Clone, PartialEq, uniffi::Enum)]
+pub enum Nfiq2Request {
+    /// Score, actionable feedback and every feature, as `compute`. The
+    /// score needs every feature, so this is also the score-only request.
+    Full,
+    /// Actionable feedback only (contrast, minutiae and ROI modules)
+    FeedbackOnly,
+    /// The named features only, e.g. `FJFXPos_Mu_MinutiaeQuality_2` and
+    /// `OCL_Bin10_Mean`, see `feature_names`
+    Features { names: Vec<String> },
+}
+
+impl Nfiq2Request {
+    /// Indices of the requested features in `feature_names`, or Err for an
+    /// unknown name.
+    fn feature_indices(&self) -> Result<Vec<c_uint>, Nfiq2Error> {
+        match self {
+            Nfiq2Request::Features { names } => names
+                .iter()
+                .map(|name| {
+                    feature_names()
+                        .iter()
+                        .position(|&n| n == name)
+                        .map(|i| i as c_uint)
+                        // same code the wrapper returns for a bad index
+                        .ok_or(Nfiq2Error::ComputeFailed(1))
+                })
+                .collect(),
+            _ => Ok(Vec::new()),
+        }
+    }
+}
+
+/// Where one `compute_instrumented` call spent its time and memory. Times
+/// are wall-clock milliseconds, NaN for modules and stages that did not
+/// run; modules running concurrently (see `set_module_threads`) overlap.
+#[derive(Debug, uniffi::Record)]
+pub struct Nfiq2Instrumentation {
+    /// The whole call, decoding excepted
+    pub total_ms: f64,
+    /// Each quality module, named as in `module_names`
+    pub modules: Vec<Nfiq2Value>,
+    /// Stages inside the modules and the score prediction, named as in
+    /// `stage_names`
+    pub stages: Vec<Nfiq2Value>,
+    /// Scratch buffers the modules asked for
+    pub scratch_allocations: u64,
+    /// Calls to the system allocator made for them
+    pub system_allocations: u64,
+    /// Local regions in the fingerprint foreground, -1 if not segmented
+    pub foreground_blocks: i64,
+}
+
+impl Nfiq2Instrumentation {
+    fn from_raw(raw: &Nfiq2InstrumentationT) -> Self {
+        fn values(names: &[&str], values: &[f64]) -> Vec<Nfiq2Value> {
+            names
+                .iter()
+                .zip(values)
+                .map(|(&name, &value)| Nfiq2Value {
+                    name: name.to_string(),
+                    value,
+                })
+                .collect()
+        }
+
+        Nfiq2Instrumentation {
+            total_ms: raw.total_ms,
+            modules: values(module_names(), &raw.algorithm_ms),
+            stages: values(stage_names(), &raw.stage_ms),
+            scratch_allocations: raw.scratch_allocations,
+            system_allocations: raw.system_allocations,
+            foreground_blocks: raw.foreground_blocks,
+        }
+    }
+}
+
+/// Results of `compute_instrumented`, with its measurements
+#[derive(Debug, uniffi::Record)]
+pub struct Nfiq2InstrumentedResult {
+    pub result: Nfiq2Result,
+    pub instrumentation: Nfiq2Instrumentation,
+}
+
+/// NFIQ2's default triage policy, to adjust before `set_triage_policy`.
+#[uniffi::export]
+pub fn default_triage_policy() -> Nfiq2TriagePolicy {
+    Nfiq2TriagePolicy::default()
+}
+
+/// The high‐level Rust handle. Handles are cheap: they all share one
+/// read-only model, loaded by the first `create_nfiq2` in the process.
+#[derive(Debug, uniffi::Object)]
 pub struct Nfiq2 {
     ctx: *mut Nfiq2WrapperOpaque,
 }
 
+/// Clones get their own native handle (sharing the model), so each clone
+/// can be dropped independently.
+impl Clone for Nfiq2 {
+    fn clone(&self) -> Self {
+        let ctx = if self.ctx.is_null() {
+            ptr::null_mut()
+        } else {
+            unsafe { nfiq2wrapper_clone(self.ctx) }
+        };
+        Nfiq2 { ctx }
+    }
+}
+
 unsafe impl Send for Nfiq2 {}
 unsafe impl Sync for Nfiq2 {}
 
@@ -46,98 +249,588 @@ pub fn create_nfiq2() -> Result<Nfiq2, Nfiq2Error> {
     }
 }
 
+/// Let OpenCV split each of its operations (blurs, erosions, DFTs, ...)
+/// across up to `threads` threads: `0` (OpenCV's default) for one per core,
+/// `1` to keep them on the calling thread, e.g. in your own worker pool.
+///
+/// The budget is process-wide, not per handle: OpenCV has a single pool,
+/// which this resizes, so call it once at startup rather than between
+/// computations. `compute_batch` with several workers keeps OpenCV
+/// single-threaded while it runs, for every computation of the process
+/// meanwhile, and restores the budget afterwards. Only has an effect when
+/// built with the `opencv-pthreads` feature; scores and features are
+/// identical either way.
+#[uniffi::export]
+pub fn set_opencv_threads(threads: u32) {
+    unsafe { nfiq2wrapper_set_opencv_threads(threads as c_uint) };
+}
+
+/// Describe the instruction sets used on this CPU: the variant of NFIQ2's
+/// dispatched kernels (`avx512f`, `avx2` or `default`), then OpenCV's
+/// baseline features and, marked with `*`, those it dispatches to (suffixed
+/// with `?` if this CPU lacks them). Scores and features do not depend on it.
+#[uniffi::export]
+pub fn cpu_dispatch_info() -> String {
+    let description = unsafe { nfiq2wrapper_cpu_dispatch() };
+    if description.is_null() {
+        return String::new();
+    }
+    unsafe { CStr::from_ptr(description) }
+        .to_string_lossy()
+        .into_owned()
+}
+
+/// Read and free a string from `nfiq2wrapper_histograms`.
+fn histograms(json: bool) -> String {
+    let histograms = unsafe { nfiq2wrapper_histograms(json as u8) };
+    if histograms.is_null() {
+        return String::new();
+    }
+    let copy = unsafe { CStr::from_ptr(histograms) }
+        .to_string_lossy()
+        .into_owned();
+    unsafe { nfiq2wrapper_free_string(histograms) };
+    copy
+}
+
+/// Histograms of every `compute_instrumented` measurement in the process
+/// since the last `reset_instrumentation_histograms`, one line per
+/// measurement, e.g. `MinutiaeCount count=4 sum=114.6 min=17.5 max=40.7
+/// mean=28.7 le32=2 le64=2`. Buckets are powers of 2: `le32=2` counts 2
+/// values in (16, 32].
+#[uniffi::export]
+pub fn instrumentation_histograms_text() -> String {
+    histograms(false)
+}
+
+/// `instrumentation_histograms_text` as a JSON object mapping each
+/// measurement to its `count`, `sum`, `min`, `max` and non-empty
+/// `buckets` (`le`, null for the last bucket, and `count`).
+#[uniffi::export]
+pub fn instrumentation_histograms_json() -> String {
+    histograms(true)
+}
+
+/// Empty the process-wide instrumentation histograms.
+#[uniffi::export]
+pub fn reset_instrumentation_histograms() {
+    unsafe { nfiq2wrapper_reset_histograms() }
+}
+
+/// Decode an encoded image and convert it to 8-bit grayscale.
+fn decode(image_bytes: &[u8]) -> Result<GrayImage, Nfiq2Error> {
+    let image = image::load_from_memory(image_bytes).map_err(|_| Nfiq2Error::ComputeFailed(-1))?;
+    Ok(image.to_luma8())
+}
+
+/// Read one of the wrapper's static name tables.
+unsafe fn static_names(
+    table: unsafe extern "C" fn(*mut c_uint) -> *const *const c_char,
+) -> Vec<&'static str> {
+    let mut count: c_uint = 0;
+    let names = table(&mut count);
+    if names.is_null() {
+        return Vec::new();
+    }
+    std::slice::from_raw_parts(names, count as usize)
+        .iter()
+        .map(|&name| CStr::from_ptr(name).to_str().unwrap_or(""))
+        .collect()
+}
+
+/// Names of `Nfiq2Scores::features`, in order (e.g. `FDA_Bin10_0`). They
+/// are read once from the native library and never copied afterwards.
+pub fn feature_names() -> &'static [&'static str] {
+    static NAMES: OnceLock<Vec<&'static str>> = OnceLock::new();
+    NAMES.get_or_init(|| unsafe { static_names(nfiq2wrapper_feature_names) })
+}
+
+/// Names of `Nfiq2Scores::actionable`, in order (e.g. `UniformImage`).
+pub fn actionable_names() -> &'static [&'static str] {
+    static NAMES: OnceLock<Vec<&'static str>> = OnceLock::new();
+    NAMES.get_or_init(|| unsafe { static_names(nfiq2wrapper_actionable_names) })
+}
+
+/// Names of `Nfiq2Instrumentation::modules`, in order (e.g. `MinutiaeCount`).
+pub fn module_names() -> &'static [&'static str] {
+    static NAMES: OnceLock<Vec<&'static str>> = OnceLock::new();
+    NAMES.get_or_init(|| unsafe { static_names(nfiq2wrapper_algorithm_names) })
+}
+
+/// Names of `Nfiq2Instrumentation::stages`, in order: `Crop`,
+/// `RidgeSegment`, `BlockGeometry` (which includes `RidgeSegment`),
+/// `FingerJetFXExtraction` (enhancement and minutiae extraction, a single
+/// call) and `RandomForestPrediction`.
+pub fn stage_names() -> &'static [&'static str] {
+    static NAMES: OnceLock<Vec<&'static str>> = OnceLock::new();
+    NAMES.get_or_init(|| unsafe { static_names(nfiq2wrapper_stage_names) })
+}
+
+/// Compact results of one image: values are stored by position, and names
+/// are only looked up (in `feature_names` and `actionable_names`) when asked
+/// for, so nothing is allocated per image.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Nfiq2Scores {
+    /// `NO_SCORE` if the image was triaged or the score was not requested
+    pub score: u32,
+    pub triaged: bool,
+    pub actionable: [f64; ACTIONABLE_COUNT],
+    pub features: [f64; FEATURE_COUNT],
+}
+
+impl Nfiq2Scores {
+    fn from_raw(raw: &Nfiq2ResultsT) -> Self {
+        Nfiq2Scores {
+            score: raw.score,
+            triaged: raw.triaged != 0,
+            actionable: raw.actionable_values,
+            features: raw.feature_values,
+        }
+    }
+
+    /// Value of the native feature `name`, e.g. `"FDA_Bin10_0"`
+    pub fn feature(&self, name: &str) -> Option<f64> {
+        let i = feature_names().iter().position(|&n| n == name)?;
+        self.features.get(i).copied()
+    }
+
+    /// Value of the actionable feedback `name`, e.g. `"UniformImage"`
+    pub fn actionable_value(&self, name: &str) -> Option<f64> {
+        let i = actionable_names().iter().position(|&n| n == name)?;
+        self.actionable.get(i).copied()
+    }
+
+    /// Native features with their names, in order
+    pub fn named_features(&self) -> impl Iterator<Item = (&'static str, f64)> + '_ {
+        feature_names()
+            .iter()
+            .copied()
+            .zip(self.features.iter().copied())
+    }
+
+    /// Actionable feedback with its names, in order
+    pub fn named_actionable(&self) -> impl Iterator<Item = (&'static str, f64)> + '_ {
+        actionable_names()
+            .iter()
+            .copied()
+            .zip(self.actionable.iter().copied())
+    }
+}
+
+impl From<Nfiq2Scores> for Nfiq2Result {
+    fn from(scores: Nfiq2Scores) -> Self {
+        fn values(pairs: impl Iterator<Item = (&'static str, f64)>) -> Vec<Nfiq2Value> {
+            pairs
+                .map(|(name, value)| Nfiq2Value {
+                    name: name.to_string(),
+                    value,
+                })
+                .collect()
+        }
+        Nfiq2Result {
+            score: scores.score,
+            triaged: scores.triaged,
+            actionable: values(scores.named_actionable()),
+            features: values(scores.named_features()),
+        }
+    }
+}
+
 #[uniffi::export]
 impl Nfiq2 {
+    /// Run independent quality modules of each image on up to `threads`
+    /// threads (including the calling one) in subsequent `compute` calls.
+    /// `0` or `1` (the default) computes them sequentially. Scores and
+    /// features are identical either way; this only lowers per-image latency.
+    pub fn set_module_threads(&self, threads: u32) {
+        if !self.ctx.is_null() {
+            unsafe { nfiq2wrapper_set_module_threads(self.ctx, threads as c_uint) };
+        }
+    }
+
+    /// Triage images in subsequent `compute` and `compute_batch` calls on
+    /// this handle: images meeting a condition of `policy` skip minutiae
+    /// extraction and the local region analyses, and come back `triaged`
+    /// with their actionable feedback and score `NO_SCORE`. `None` (the default)
+    /// computes every image in full. Images that are not triaged get the
+    /// same score and features either way.
+    pub fn set_triage_policy(&self, policy: Option<Nfiq2TriagePolicy>) {
+        if self.ctx.is_null() {
+            return;
+        }
+        match policy {
+            Some(policy) => {
+                let raw = Nfiq2TriagePolicyT::from(&policy);
+                unsafe { nfiq2wrapper_set_triage_policy(self.ctx, &raw) };
+            }
+            None => unsafe { nfiq2wrapper_set_triage_policy(self.ctx, ptr::null()) },
+        }
+    }
+
     /// Compute quality. Mirrors your C API.
     pub fn compute(&self, image_bytes: &[u8]) -> Result<Nfiq2Result, Nfiq2Error> {
+        self.compute_scores(image_bytes).map(Nfiq2Result::from)
+    }
+
+    /// Compute quality on 8-bit grayscale pixels (row major, `width *
+    /// height` bytes) that are already decoded, e.g. straight from a
+    /// capture SDK. Nothing is decoded, and Rust callers' pixels are read
+    /// in place by the quality modules. Foreign-language bindings copy
+    /// them when passing the argument through UniFFI.
+    pub fn compute_raw(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+    ) -> Result<Nfiq2Result, Nfiq2Error> {
+        self.compute_raw_scores(pixels, width, height, ppi)
+            .map(Nfiq2Result::from)
+    }
+
+    /// Compute only what `request` asks for, e.g. a few features for a
+    /// dashboard, skipping the quality modules it does not need. Values
+    /// are identical to those of `compute`; the others are NaN.
+    pub fn compute_request(
+        &self,
+        image_bytes: &[u8],
+        request: Nfiq2Request,
+    ) -> Result<Nfiq2Result, Nfiq2Error> {
+        self.compute_request_scores(image_bytes, &request)
+            .map(Nfiq2Result::from)
+    }
+
+    /// `compute_request` on 8-bit grayscale pixels, as `compute_raw`
+    pub fn compute_raw_request(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+        request: Nfiq2Request,
+    ) -> Result<Nfiq2Result, Nfiq2Error> {
+        self.compute_raw_request_scores(pixels, width, height, ppi, &request)
+            .map(Nfiq2Result::from)
+    }
+
+    /// `compute_request`, also measuring where the time and memory went.
+    /// The measurements are added to the process-wide histograms (see
+    /// `instrumentation_histograms_text`); other calls are not measured.
+    /// Results are identical to those of `compute_request`.
+    pub fn compute_instrumented(
+        &self,
+        image_bytes: &[u8],
+        request: Nfiq2Request,
+    ) -> Result<Nfiq2InstrumentedResult, Nfiq2Error> {
         if self.ctx.is_null() {
             return Err(Nfiq2Error::NullContext);
         }
 
-        // load the image from bytes
-        let image =
-            image::load_from_memory(image_bytes).map_err(|_| Nfiq2Error::ComputeFailed(-1))?;
+        let image = decode(image_bytes)?;
+        let (cols, rows) = image.dimensions();
+
+        self.compute_raw_instrumented(&image, cols, rows, DEFAULT_PPI, request)
+    }
+
+    /// `compute_instrumented` on 8-bit grayscale pixels, as `compute_raw`
+    pub fn compute_raw_instrumented(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+        request: Nfiq2Request,
+    ) -> Result<Nfiq2InstrumentedResult, Nfiq2Error> {
+        let mut raw: Nfiq2InstrumentationT = unsafe { std::mem::zeroed() };
+        let scores =
+            self.compute_raw_request_into(pixels, width, height, ppi, &request, Some(&mut raw))?;
+
+        Ok(Nfiq2InstrumentedResult {
+            result: scores.into(),
+            instrumentation: Nfiq2Instrumentation::from_raw(&raw),
+        })
+    }
 
-        // convert to grayscale and get dimensions
-        let image = image.to_luma8();
+    /// Compute quality for many encoded images at once.
+    ///
+    /// Images are decoded and scored on up to `threads` worker threads
+    /// (`0` = one per available core) sharing this handle's model. Each
+    /// worker decodes the image it scores next, so only about `threads`
+    /// decoded images are held at once, whatever the batch size. Results
+    /// are returned in input order; an image that fails to decode or score
+    /// only sets `error` on its own item.
+    pub fn compute_batch(
+        &self,
+        images: Vec<Vec<u8>>,
+        threads: u32,
+    ) -> Result<Vec<Nfiq2BatchItem>, Nfiq2Error> {
+        Ok(self
+            .compute_batch_scores(&images, threads)?
+            .into_iter()
+            .map(|scores| scores.map(Nfiq2Result::from).into())
+            .collect())
+    }
+}
 
+/// Encoded images of a batch, decoded by the native workers as they get to
+/// them (see `nfiq2wrapper_compute_batch_from`).
+struct BatchSource<'a, T> {
+    images: &'a [T],
+    /// decoded images being scored, dropped once scored
+    decoded: Vec<Mutex<Option<GrayImage>>>,
+}
+
+impl<T: AsRef<[u8]> + Sync> BatchSource<'_, T> {
+    /// nfiq2_image_source_t: decode image `index`, or return the status
+    /// `compute` fails with on undecodable images
+    unsafe extern "C" fn decode(
+        user: *mut c_void,
+        index: c_uint,
+        image: *mut Nfiq2ImageT,
+    ) -> c_int {
+        let source = &*(user as *const Self);
+        let index = index as usize;
+        // a panic must not unwind into the native pool
+        let decoded = match std::panic::catch_unwind(AssertUnwindSafe(|| {
+            decode(source.images[index].as_ref())
+        })) {
+            Ok(Ok(decoded)) => decoded,
+            _ => return -1,
+        };
+        let (cols, rows) = decoded.dimensions();
+        *image = Nfiq2ImageT {
+            data: decoded.as_ptr(),
+            size: decoded.len() as c_uint,
+            cols: cols as c_uint,
+            rows: rows as c_uint,
+            ppi: DEFAULT_PPI as c_ushort,
+        };
+        // the pixels stay put when the image moves into its slot
+        *source.decoded[index]
+            .lock()
+            .unwrap_or_else(|e| e.into_inner()) = Some(decoded);
+        0
+    }
+
+    /// nfiq2_image_release_t: drop decoded image `index`
+    unsafe extern "C" fn release(user: *mut c_void, index: c_uint) {
+        let source = &*(user as *const Self);
+        source.decoded[index as usize]
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .take();
+    }
+}
+
+/// Rust-only variants returning `Nfiq2Scores`, which allocate nothing per
+/// image for results.
+impl Nfiq2 {
+    /// `compute`, returning compact scores
+    pub fn compute_scores(&self, image_bytes: &[u8]) -> Result<Nfiq2Scores, Nfiq2Error> {
+        if self.ctx.is_null() {
+            return Err(Nfiq2Error::NullContext);
+        }
+
+        // load the image from bytes, convert to grayscale and get dimensions
+        let image = decode(image_bytes)?;
         let (cols, rows) = image.dimensions();
-        let ppi = 500; // hardcoded PPI, can be adjusted as needed
 
-        // zero the C struct
-        let mut raw: Nfiq2ResultsT = unsafe { std::mem::zeroed() };
+        self.compute_raw_scores(&image, cols, rows, DEFAULT_PPI)
+    }
 
-        let size = image.len() as c_uint;
+    /// `compute_raw`, returning compact scores
+    pub fn compute_raw_scores(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+    ) -> Result<Nfiq2Scores, Nfiq2Error> {
+        if self.ctx.is_null() {
+            return Err(Nfiq2Error::NullContext);
+        }
+        // same code the wrapper returns for inconsistent dimensions
+        if pixels.len() as u64 != width as u64 * height as u64
+            || pixels.len() > c_uint::MAX as usize
+        {
+            return Err(Nfiq2Error::ComputeFailed(1));
+        }
+
+        // plain values: the wrapper fills them in place, nothing to free
+        let mut raw: Nfiq2ResultsT = unsafe { std::mem::zeroed() };
 
         let rc = unsafe {
             nfiq2wrapper_compute(
                 self.ctx,
-                image.as_ptr(),
-                size as c_uint,
-                cols as c_uint,
-                rows as c_uint,
+                pixels.as_ptr(),
+                pixels.len() as c_uint,
+                width as c_uint,
+                height as c_uint,
                 ppi as c_ushort,
                 &mut raw,
             )
         };
         if rc != 0 {
-            // free any partial allocations before returning
-            unsafe { nfiq2wrapper_free_results(&mut raw) };
             return Err(Nfiq2Error::ComputeFailed(rc));
         }
 
-        // helper to turn C arrays into Vec<(String,f64)>
-        unsafe fn collect_pairs(
-            ids_ptr: *const *const c_char,
-            vals_ptr: *const f64,
-            count: usize,
-        ) -> Result<Vec<Nfiq2Value>, Nfiq2Error> {
-            let mut out = Vec::with_capacity(count);
-            let id_slice = std::slice::from_raw_parts(ids_ptr, count);
-            let val_slice = std::slice::from_raw_parts(vals_ptr, count);
-            for i in 0..count {
-                let s = CStr::from_ptr(id_slice[i])
-                    .to_str()
-                    .map_err(|_| Nfiq2Error::ComputeFailed(-1))?
-                    .to_string();
-
-                out.push(Nfiq2Value {
-                    name: s,
-                    value: val_slice[i],
-                });
-            }
-            Ok(out)
+        Ok(Nfiq2Scores::from_raw(&raw))
+    }
+
+    /// `compute_request`, returning compact scores
+    pub fn compute_request_scores(
+        &self,
+        image_bytes: &[u8],
+        request: &Nfiq2Request,
+    ) -> Result<Nfiq2Scores, Nfiq2Error> {
+        if self.ctx.is_null() {
+            return Err(Nfiq2Error::NullContext);
         }
 
-        let actionable_count = raw.actionable_count as usize;
-        let feature_count = raw.feature_count as usize;
+        let image = decode(image_bytes)?;
+        let (cols, rows) = image.dimensions();
+
+        self.compute_raw_request_scores(&image, cols, rows, DEFAULT_PPI, request)
+    }
 
-        // collect actionable + features
-        let actionable = unsafe {
-            collect_pairs(
-                raw.actionable_ids,
-                raw.actionable_values as *const f64,
-                actionable_count,
-            )?
+    /// `compute_raw_request`, returning compact scores
+    pub fn compute_raw_request_scores(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+        request: &Nfiq2Request,
+    ) -> Result<Nfiq2Scores, Nfiq2Error> {
+        self.compute_raw_request_into(pixels, width, height, ppi, request, None)
+    }
+
+    /// `compute_raw_request_scores`, measuring the computation into
+    /// `instrumentation` if it is set
+    fn compute_raw_request_into(
+        &self,
+        pixels: &[u8],
+        width: u32,
+        height: u32,
+        ppi: u16,
+        request: &Nfiq2Request,
+        instrumentation: Option<&mut Nfiq2InstrumentationT>,
+    ) -> Result<Nfiq2Scores, Nfiq2Error> {
+        if self.ctx.is_null() {
+            return Err(Nfiq2Error::NullContext);
+        }
+        if pixels.len() as u64 != width as u64 * height as u64
+            || pixels.len() > c_uint::MAX as usize
+        {
+            return Err(Nfiq2Error::ComputeFailed(1));
+        }
+
+        let features = request.feature_indices()?;
+        let raw_request = Nfiq2RequestT {
+            score: (*request == Nfiq2Request::Full) as u8,
+            actionable: (*request == Nfiq2Request::FeedbackOnly) as u8,
+            features: features.as_ptr(),
+            feature_count: features.len() as c_uint,
         };
-        let features = unsafe {
-            collect_pairs(
-                raw.feature_ids,
-                raw.feature_values as *const f64,
-                feature_count,
-            )?
+        let mut raw: Nfiq2ResultsT = unsafe { std::mem::zeroed() };
+
+        let rc = unsafe {
+            match instrumentation {
+                Some(instrumentation) => nfiq2wrapper_compute_instrumented(
+                    self.ctx,
+                    pixels.as_ptr(),
+                    pixels.len() as c_uint,
+                    width as c_uint,
+                    height as c_uint,
+                    ppi as c_ushort,
+                    &raw_request,
+                    &mut raw,
+                    instrumentation,
+                ),
+                None => nfiq2wrapper_compute_request(
+                    self.ctx,
+                    pixels.as_ptr(),
+                    pixels.len() as c_uint,
+                    width as c_uint,
+                    height as c_uint,
+                    ppi as c_ushort,
+                    &raw_request,
+                    &mut raw,
+                ),
+            }
         };
+        if rc != 0 {
+            return Err(Nfiq2Error::ComputeFailed(rc));
+        }
 
-        let score = raw.score;
+        Ok(Nfiq2Scores::from_raw(&raw))
+    }
 
-        // free C allocations
-        unsafe { nfiq2wrapper_free_results(&mut raw) };
+    /// `compute_batch`, returning compact scores in input order
+    pub fn compute_batch_scores<T: AsRef<[u8]> + Sync>(
+        &self,
+        images: &[T],
+        threads: u32,
+    ) -> Result<Vec<Result<Nfiq2Scores, Nfiq2Error>>, Nfiq2Error> {
+        if self.ctx.is_null() {
+            return Err(Nfiq2Error::NullContext);
+        }
+        let count = images.len();
+        if count == 0 {
+            return Ok(Vec::new());
+        }
 
-        Ok(Nfiq2Result {
-            score,
-            actionable,
-            features,
-        })
+        let workers = match threads as usize {
+            0 => std::thread::available_parallelism().map_or(1, |n| n.get()),
+            n => n,
+        }
+        .min(count);
+
+        // each native worker decodes the image it is about to score, and
+        // drops it right after, so decoding overlaps scoring and only about
+        // `workers` decoded images are held at once
+        let source = BatchSource {
+            images,
+            decoded: (0..count).map(|_| Mutex::new(None)).collect(),
+        };
+        let mut raw: Vec<Nfiq2ResultsT> =
+            (0..count).map(|_| unsafe { std::mem::zeroed() }).collect();
+        let mut status: Vec<c_int> = vec![0; count];
+        let rc = unsafe {
+            nfiq2wrapper_compute_batch_from(
+                self.ctx,
+                count as c_uint,
+                workers as c_uint,
+                BatchSource::<T>::decode,
+                Some(BatchSource::<T>::release),
+                &source as *const BatchSource<T> as *mut c_void,
+                raw.as_mut_ptr(),
+                status.as_mut_ptr(),
+            )
+        };
+        if rc != 0 {
+            return Err(Nfiq2Error::ComputeFailed(rc));
+        }
+
+        Ok(raw
+            .iter()
+            .zip(status)
+            .map(|(raw, rc)| {
+                if rc != 0 {
+                    Err(Nfiq2Error::ComputeFailed(rc))
+                } else {
+                    Ok(Nfiq2Scores::from_raw(raw))
+                }
+            })
+            .collect())
+    }
+
+    /// Address of the loaded model, equal for handles sharing it
+    fn model(&self) -> *const c_void {
+        if self.ctx.is_null() {
+            return ptr::null();
+        }
+        unsafe { nfiq2wrapper_model(self.ctx) }
     }
 }
 
@@ -179,4 +872,364 @@ mod tests {
             assert_eq!(res.score, expected_scores[i]);
         }
     }
+
+    #[test]
+    fn test_nfiq2_module_threads() {
+        let sequential = create_nfiq2().expect("failed to create wrapper");
+        let parallel = create_nfiq2().expect("failed to create wrapper");
+        parallel.set_module_threads(4);
+
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+
+        let expected = sequential.compute(&img_bytes).expect("compute failed");
+        let actual = parallel.compute(&img_bytes).expect("compute failed");
+
+        assert_eq!(actual.score, expected.score);
+        assert_eq!(actual.features.len(), expected.features.len());
+        for (a, e) in actual.features.iter().zip(expected.features.iter()) {
+            assert_eq!(a.name, e.name);
+            assert_eq!(a.value.to_bits(), e.value.to_bits());
+        }
+    }
+
+    #[test]
+    fn test_nfiq2_opencv_threads() {
+        let nfiq2 = create_nfiq2().expect("failed to create wrapper");
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test02.pgm")
+            .expect("failed to read test image");
+
+        set_opencv_threads(1);
+        let expected = nfiq2.compute(&img_bytes).expect("compute failed");
+        set_opencv_threads(0);
+        let actual = nfiq2.compute(&img_bytes).expect("compute failed");
+        // batches keep OpenCV single-threaded meanwhile, then restore it
+        let batch = nfiq2
+            .compute_batch(vec![img_bytes.clone(), img_bytes.clone()], 2)
+            .expect("batch failed");
+        let after = nfiq2.compute(&img_bytes).expect("compute failed");
+
+        let results = [actual, after].into_iter().chain(
+            batch
+                .into_iter()
+                .map(|item| item.result.expect("batch item failed")),
+        );
+        for actual in results {
+            assert_eq!(actual.score, expected.score);
+            assert_eq!(actual.features.len(), expected.features.len());
+            for (a, e) in actual.features.iter().zip(expected.features.iter()) {
+                assert_eq!(a.name, e.name);
+                assert_eq!(a.value.to_bits(), e.value.to_bits());
+            }
+        }
+    }
+
+    #[test]
+    fn test_cpu_dispatch_info() {
+        let info = cpu_dispatch_info();
+        let kernels = info
+            .strip_prefix("nfiq2: ")
+            .and_then(|rest| rest.split(';').next())
+            .expect("missing NFIQ2 kernels");
+        assert!(["avx512f", "avx2", "default"].contains(&kernels));
+        assert!(info.contains("; opencv: "));
+    }
+
+    #[test]
+    fn test_nfiq2_compute_batch() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+        let expected_scores = vec![54, 45, 53, 52, 57];
+        let mut images: Vec<Vec<u8>> = (1..=5)
+            .map(|i| {
+                std::fs::read(format!(
+                    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test0{}.pgm",
+                    i
+                ))
+                .expect("failed to read test image")
+            })
+            .collect();
+        // an undecodable item fails on its own without affecting the rest
+        images.insert(2, b"not an image".to_vec());
+
+        let results = nfiq.compute_batch(images, 3).expect("batch failed");
+        assert_eq!(results.len(), 6);
+        assert!(results[2].result.is_none());
+        assert!(results[2].error.is_some());
+
+        let scores: Vec<u32> = results
+            .iter()
+            .filter_map(|r| r.result.as_ref().map(|r| r.score))
+            .collect();
+        assert_eq!(scores, expected_scores);
+    }
+
+    #[test]
+    fn test_nfiq2_handles_share_model() {
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+
+        // the model is loaded once; later handles only take a reference
+        let first = create_nfiq2().expect("failed to create wrapper");
+        assert!(!first.model().is_null());
+        let handles: Vec<Nfiq2> = (0..8)
+            .map(|_| create_nfiq2().expect("failed to create wrapper"))
+            .collect();
+        for handle in &handles {
+            assert_eq!(handle.model(), first.model());
+        }
+
+        // clones are independent handles that outlive the original
+        let clone = first.clone();
+        assert_eq!(clone.model(), first.model());
+        drop(first);
+        drop(handles);
+        assert_eq!(clone.compute(&img_bytes).expect("compute failed").score, 54);
+    }
+
+    #[test]
+    fn test_nfiq2_scores() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+        assert_eq!(feature_names().len(), FEATURE_COUNT);
+        assert_eq!(feature_names()[0], "FDA_Bin10_0");
+        assert_eq!(actionable_names().len(), ACTIONABLE_COUNT);
+        assert!(actionable_names().contains(&"UniformImage"));
+
+        let images: Vec<Vec<u8>> = (1..=3)
+            .map(|i| {
+                std::fs::read(format!(
+                    "ext/NFIQ2-2.3.0/examples/images/SFinGe_Test0{}.pgm",
+                    i
+                ))
+                .expect("failed to read test image")
+            })
+            .collect();
+        let batch = nfiq.compute_batch_scores(&images, 2).expect("batch failed");
+
+        for (img_bytes, batched) in images.iter().zip(batch) {
+            let scores = nfiq.compute_scores(img_bytes).expect("compute failed");
+            assert_eq!(batched.expect("batch item failed"), scores);
+
+            // the owned result carries the same values under the same names
+            let result = nfiq.compute(img_bytes).expect("compute failed");
+            assert_eq!(result.score, scores.score);
+            assert_eq!(result.features.len(), FEATURE_COUNT);
+            for (named, (name, value)) in result.features.iter().zip(scores.named_features()) {
+                assert_eq!(named.name, name);
+                assert_eq!(named.value.to_bits(), value.to_bits());
+            }
+            for (named, (name, value)) in result.actionable.iter().zip(scores.named_actionable()) {
+                assert_eq!(named.name, name);
+                assert_eq!(named.value.to_bits(), value.to_bits());
+            }
+            assert_eq!(scores.feature("FDA_Bin10_0"), Some(scores.features[0]));
+            assert_eq!(scores.feature("no such feature"), None);
+        }
+    }
+
+    #[test]
+    fn test_nfiq2_triage() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+        // a blank, uniformly gray platen
+        let (width, height) = (400, 500);
+        let blank = vec![128u8; (width * height) as usize];
+
+        let policy = default_triage_policy();
+        assert!(policy.stop_on_uniform_image && policy.stop_on_empty_image);
+        assert!(!policy.stop_on_insufficient_foreground);
+        assert_eq!(policy.uniform_image_threshold, 1.0);
+        assert_eq!(policy.empty_image_threshold, 250.0);
+
+        // without triage, the local region analyses fail on it
+        assert!(nfiq.compute_raw(&blank, width, height, 500).is_err());
+
+        nfiq.set_triage_policy(Some(policy));
+        let triaged = nfiq
+            .compute_raw_scores(&blank, width, height, 500)
+            .expect("compute_raw failed");
+        assert!(triaged.triaged);
+        assert_eq!(triaged.score, NO_SCORE);
+        assert_eq!(triaged.actionable_value("UniformImage"), Some(0.0));
+        assert_eq!(
+            triaged.actionable_value("EmptyImageOrContrastTooLow"),
+            Some(128.0)
+        );
+        assert!(triaged.features.iter().all(|v| v.is_nan()));
+
+        // batches use the handle's policy too
+        let batch = nfiq
+            .compute_batch_scores(&[encode_pgm(&blank, width, height)], 1)
+            .expect("batch failed");
+        assert!(batch[0].as_ref().expect("batch item failed").triaged);
+
+        // an empty white platen, not uniform but near-white everywhere, so
+        // that it has no frame to crop: it fails without triage too
+        let white: Vec<u8> = (0..width * height)
+            .map(|i| if (i + i / width) % 2 == 0 { 252 } else { 255 })
+            .collect();
+        let full = nfiq.clone();
+        full.set_triage_policy(None);
+        assert!(full.compute_raw(&white, width, height, 500).is_err());
+        let triaged = nfiq
+            .compute_raw_scores(&white, width, height, 500)
+            .expect("compute_raw failed");
+        assert!(triaged.triaged);
+        assert_eq!(triaged.score, NO_SCORE);
+        assert!(triaged.actionable_value("UniformImage").unwrap() >= 1.0);
+        assert!(
+            triaged
+                .actionable_value("EmptyImageOrContrastTooLow")
+                .unwrap()
+                > 250.0
+        );
+
+        // fingerprints are not triaged and score as without a policy
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+        let expected = full.compute_scores(&img_bytes).expect("compute failed");
+        let actual = nfiq.compute_scores(&img_bytes).expect("compute failed");
+        assert!(!actual.triaged);
+        assert_eq!(actual, expected);
+
+        // a foreground condition no fingerprint can meet
+        nfiq.set_triage_policy(Some(Nfiq2TriagePolicy {
+            stop_on_insufficient_foreground: true,
+            foreground_threshold: f64::MAX,
+            ..policy
+        }));
+        let actual = nfiq.compute(&img_bytes).expect("compute failed");
+        assert!(actual.triaged);
+        assert!(actual
+            .actionable
+            .iter()
+            .any(|v| v.name == "SufficientFingerprintForeground" && v.value > 0.0));
+    }
+
+    #[test]
+    fn test_nfiq2_compute_request() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+        let expected = nfiq.compute_scores(&img_bytes).expect("compute failed");
+
+        let full = nfiq
+            .compute_request_scores(&img_bytes, &Nfiq2Request::Full)
+            .expect("compute_request failed");
+        assert_eq!(full, expected);
+
+        // requested values match the full computation, the rest are NaN
+        let names = ["FJFXPos_Mu_MinutiaeQuality_2", "OCL_Bin10_Mean"];
+        let partial = nfiq
+            .compute_request_scores(
+                &img_bytes,
+                &Nfiq2Request::Features {
+                    names: names.iter().map(|n| n.to_string()).collect(),
+                },
+            )
+            .expect("compute_request failed");
+        assert_eq!(partial.score, NO_SCORE);
+        for (name, value) in partial.named_features() {
+            if names.contains(&name) {
+                let e = expected.feature(name).expect("missing feature");
+                assert_eq!(value.to_bits(), e.to_bits());
+            } else {
+                assert!(value.is_nan(), "{name} was not requested");
+            }
+        }
+        assert!(partial.actionable.iter().all(|v| v.is_nan()));
+
+        let feedback = nfiq
+            .compute_request_scores(&img_bytes, &Nfiq2Request::FeedbackOnly)
+            .expect("compute_request failed");
+        assert_eq!(feedback.score, NO_SCORE);
+        for (a, e) in feedback.actionable.iter().zip(expected.actionable.iter()) {
+            assert_eq!(a.to_bits(), e.to_bits());
+        }
+        assert!(feedback.features.iter().all(|v| v.is_nan()));
+
+        let unknown = Nfiq2Request::Features {
+            names: vec!["no such feature".to_string()],
+        };
+        assert!(nfiq.compute_request(&img_bytes, unknown).is_err());
+    }
+
+    #[test]
+    fn test_nfiq2_compute_instrumented() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+        let expected = nfiq.compute(&img_bytes).expect("compute failed");
+
+        let full = nfiq
+            .compute_instrumented(&img_bytes, Nfiq2Request::Full)
+            .expect("compute_instrumented failed");
+        assert_eq!(full.result.score, expected.score);
+        for (a, e) in full.result.features.iter().zip(expected.features.iter()) {
+            assert_eq!(a.value.to_bits(), e.value.to_bits());
+        }
+        let measured = &full.instrumentation;
+        assert_eq!(measured.modules.len(), module_names().len());
+        assert_eq!(measured.stages.len(), stage_names().len());
+        assert!(measured.modules.iter().all(|m| m.value >= 0.0));
+        assert!(measured.stages.iter().all(|s| s.value >= 0.0));
+        assert!(measured.total_ms >= measured.modules.iter().map(|m| m.value).fold(0.0, f64::max));
+        assert!(measured.foreground_blocks > 0);
+
+        // modules a request does not need are not timed
+        let partial = nfiq
+            .compute_instrumented(
+                &img_bytes,
+                Nfiq2Request::Features {
+                    names: vec!["OCL_Bin10_Mean".to_string()],
+                },
+            )
+            .expect("compute_instrumented failed");
+        let timed: Vec<_> = partial
+            .instrumentation
+            .modules
+            .iter()
+            .filter(|m| !m.value.is_nan())
+            .map(|m| m.name.as_str())
+            .collect();
+        assert_eq!(timed, ["OrientationCertainty"]);
+        assert_eq!(partial.instrumentation.foreground_blocks, -1);
+
+        let text = instrumentation_histograms_text();
+        assert!(text.lines().any(|l| l.starts_with("MinutiaeCount count=")));
+        let json = instrumentation_histograms_json();
+        assert!(json.starts_with('{') && json.contains("\"RandomForestPrediction\""));
+    }
+
+    /// Binary PGM encoding of 8-bit grayscale pixels
+    fn encode_pgm(pixels: &[u8], width: u32, height: u32) -> Vec<u8> {
+        let mut pgm = format!("P5\n{} {}\n255\n", width, height).into_bytes();
+        pgm.extend_from_slice(pixels);
+        pgm
+    }
+
+    #[test]
+    fn test_nfiq2_compute_raw() {
+        let nfiq = create_nfiq2().expect("failed to create wrapper");
+
+        let img_bytes = std::fs::read("ext/NFIQ2-2.3.0/examples/images/SFinGe_Test01.pgm")
+            .expect("failed to read test image");
+        let image = image::load_from_memory(&img_bytes)
+            .expect("failed to decode test image")
+            .to_luma8();
+        let (width, height) = image.dimensions();
+
+        let expected = nfiq.compute(&img_bytes).expect("compute failed");
+        let actual = nfiq
+            .compute_raw(&image, width, height, 500)
+            .expect("compute_raw failed");
+        assert_eq!(actual.score, expected.score);
+        for (a, e) in actual.features.iter().zip(expected.features.iter()) {
+            assert_eq!(a.value.to_bits(), e.value.to_bits());
+        }
+
+        // the buffer must hold exactly width * height pixels
+        assert!(nfiq.compute_raw(&image, width + 1, height, 500).is_err());
+    }
 }
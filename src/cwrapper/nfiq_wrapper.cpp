@@ -1,18 +1,408 @@
 // nfiq_wrapper.cpp
 #include "nfiq_wrapper.h"
 #include <nfiq2.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 struct Nfiq2Wrapper {
-    NFIQ2::Algorithm model;
+    /// read-only model shared with every other wrapper
+    std::shared_ptr<const NFIQ2::Algorithm> model;
+    /// threads used to run independent quality modules of one image
+    std::atomic<unsigned int> module_threads;
+    /// triage policy, or null to compute every image in full; replaced
+    /// whole and accessed with std::atomic_load/atomic_store
+    std::shared_ptr<const NFIQ2::QualityMeasures::TriagePolicy> triage;
+
+    explicit Nfiq2Wrapper(
+        std::shared_ptr<const NFIQ2::Algorithm> model,
+        unsigned int module_threads = 1,
+        std::shared_ptr<const NFIQ2::QualityMeasures::TriagePolicy> triage =
+            nullptr)
+        : model(std::move(model)), module_threads(module_threads),
+          triage(std::move(triage)) {}
+};
+
+namespace {
+
+static_assert(NFIQ2_FEATURE_COUNT ==
+                  NFIQ2::QualityMeasures::NativeQualityMeasureCount,
+              "NFIQ2_FEATURE_COUNT must match the native quality measures");
+
+static_assert(NFIQ2_ALGORITHM_COUNT == NFIQ2::Instrumentation::AlgorithmCount,
+              "NFIQ2_ALGORITHM_COUNT must match the quality algorithms");
+static_assert(NFIQ2_STAGE_COUNT == NFIQ2::Instrumentation::StageCount,
+              "NFIQ2_STAGE_COUNT must match the instrumented stages");
+
+/// Identifiers of nfiq2_results_t::actionable_values, in the order of
+/// NFIQ2::QualityMeasures::getActionableQualityFeedbackIDs()
+const char* const actionable_names[NFIQ2_ACTIONABLE_COUNT] = {
+    NFIQ2::Identifiers::ActionableQualityFeedback::UniformImage,
+    NFIQ2::Identifiers::ActionableQualityFeedback::EmptyImageOrContrastTooLow,
+    NFIQ2::Identifiers::ActionableQualityFeedback::FingerprintImageWithMinutiae,
+    NFIQ2::Identifiers::ActionableQualityFeedback::SufficientFingerprintForeground,
+};
+
+/// The process-wide model. Loading it is the expensive part of creating a
+/// wrapper, so it happens once, on first use; afterwards it is never
+/// modified and wrappers only take a reference to it.
+std::shared_ptr<const NFIQ2::Algorithm> shared_model()
+{
+    // thread-safe initialization, retried on the next call if loading throws
+    static const std::shared_ptr<const NFIQ2::Algorithm> model =
+        std::make_shared<const NFIQ2::Algorithm>();
+    return model;
+}
+
+/// Thread budget of OpenCV's process-wide pool (see
+/// nfiq2wrapper_set_opencv_threads), and the batches overriding it
+struct OpenCVThreads {
+    std::mutex   lock;
+    /// cv::setNumThreads() argument; -1 is OpenCV's default, one per core
+    int          budget = -1;
+    /// batches running, which keep OpenCV on the calling thread meanwhile
+    unsigned int batches = 0;
+};
+
+OpenCVThreads& opencv_threads()
+{
+    static OpenCVThreads threads;
+    return threads;
+}
+
+/// Resize OpenCV's pool; resizing stops or starts its workers, so callers
+/// hold OpenCVThreads::lock
+void apply_opencv_threads(int threads)
+{
+    try {
+        cv::setNumThreads(threads);
+    } catch (...) {
+    }
+}
+
+/// Keeps OpenCV single-threaded while a batch's workers run, so that each of
+/// them does not fan out into OpenCV's pool as well. OpenCV only has a
+/// process-wide pool, so this also applies to other computations meanwhile;
+/// the budget is restored once the last batch ends.
+class SerialOpenCVScope {
+public:
+    SerialOpenCVScope()
+    {
+        OpenCVThreads& threads = opencv_threads();
+        std::lock_guard<std::mutex> guard(threads.lock);
+        if (threads.batches++ == 0) {
+            apply_opencv_threads(1);
+        }
+    }
+
+    ~SerialOpenCVScope()
+    {
+        OpenCVThreads& threads = opencv_threads();
+        std::lock_guard<std::mutex> guard(threads.lock);
+        if (--threads.batches == 0) {
+            apply_opencv_threads(threads.budget);
+        }
+    }
+
+    SerialOpenCVScope(const SerialOpenCVScope&) = delete;
+    SerialOpenCVScope& operator=(const SerialOpenCVScope&) = delete;
 };
 
+/// Identifiers of every quality algorithm, in the library's order
+const std::vector<std::string>& all_algorithms()
+{
+    static const std::vector<std::string> ids =
+        NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs();
+    return ids;
+}
+
+/// Identifiers of the quality algorithms computing the feedback and
+/// features `request` asks for into `ids`, unless it asks for the score,
+/// which needs all of them. Returns false on a bad feature index.
+bool requested_algorithms(const nfiq2_request_t&    request,
+                          std::vector<std::string>& ids)
+{
+    if (request.feature_count > 0 && !request.features) {
+        return false;
+    }
+    std::vector<std::string> measures;
+    measures.reserve(request.feature_count);
+    for (uint32_t i = 0; i < request.feature_count; ++i) {
+        if (request.features[i] >= NFIQ2_FEATURE_COUNT) {
+            return false;
+        }
+        measures.push_back(NFIQ2::QualityMeasures::
+                               NativeQualityMeasureIdentifiers[request.features[i]]);
+    }
+    if (request.score) {
+        return true;
+    }
+
+    if (request.actionable) {
+        ids = NFIQ2::QualityMeasures::getActionableQualityFeedbackAlgorithmIDs();
+    }
+    // duplicates are computed once
+    const auto feature_ids =
+        NFIQ2::QualityMeasures::getNativeQualityMeasureAlgorithmIDs(measures);
+    ids.insert(ids.end(), feature_ids.cbegin(), feature_ids.cend());
+    return true;
+}
+
+/// Copy `measurements` into `out`
+void copy_measurements(const NFIQ2::Instrumentation::Measurements& measurements,
+                       nfiq2_instrumentation_t*                     out)
+{
+    out->total_ms = measurements.totalMilliseconds;
+    std::copy(measurements.algorithmMilliseconds.cbegin(),
+              measurements.algorithmMilliseconds.cend(), out->algorithm_ms);
+    std::copy(measurements.stageMilliseconds.cbegin(),
+              measurements.stageMilliseconds.cend(), out->stage_ms);
+    out->scratch_allocations = measurements.scratchAllocations;
+    out->system_allocations = measurements.systemAllocations;
+    out->foreground_blocks = measurements.foregroundBlocks;
+}
+
+/// Compute what `request` asks for (null: everything) on one image with
+/// `model`, triaging it first if `triage` is not null, and measuring it
+/// into `instrumentation` if that is not null.
+/// Returns the nfiq2wrapper_compute codes.
+int compute_one(const NFIQ2::Algorithm& model,
+                const NFIQ2::QualityMeasures::TriagePolicy* triage,
+                const nfiq2_request_t*  request,
+                const uint8_t*          data,
+                uint32_t                size,
+                uint32_t                cols,
+                uint32_t                rows,
+                uint16_t                ppi,
+                unsigned int            module_threads,
+                nfiq2_results_t*        out,
+                nfiq2_instrumentation_t* instrumentation = nullptr)
+{
+    if (!out) {
+        return 1;
+    }
+    std::memset(out, 0, sizeof(*out));
+    if (instrumentation) {
+        std::memset(instrumentation, 0, sizeof(*instrumentation));
+    }
+    if (!data || size != cols * rows) {
+        return 1;
+    }
+
+    try {
+        const bool full = !request || request->score;
+        std::vector<std::string> algorithm_ids;
+        if (request && !requested_algorithms(*request, algorithm_ids)) {
+            return 1;
+        }
+
+        // measure from here, so the crop in LazyQualityMeasures counts
+        std::unique_ptr<NFIQ2::Instrumentation::Scope> scope;
+        if (instrumentation) {
+            scope.reset(new NFIQ2::Instrumentation::Scope());
+        }
+
+        // view the caller's pixels; they are only read during this call
+        const auto img = NFIQ2::FingerprintImageData::view(
+            data, size, cols, rows, 0 /*dpi units*/, ppi);
+
+        // only the modules needed, each at most once (independent modules
+        // concurrently if module_threads > 1); triage reuses them
+        NFIQ2::QualityMeasures::LazyQualityMeasures lazy(img);
+        const bool triaged = triage && lazy.triage(*triage);
+        if (!triaged) {
+            lazy.computeAlgorithms(full ? all_algorithms() : algorithm_ids,
+                                   module_threads);
+        }
+
+        std::fill(std::begin(out->actionable_values),
+                  std::end(out->actionable_values),
+                  std::numeric_limits<double>::quiet_NaN());
+        std::fill(std::begin(out->feature_values),
+                  std::end(out->feature_values),
+                  std::numeric_limits<double>::quiet_NaN());
+        out->score = NFIQ2_NO_SCORE;
+
+        // actionable feedback, from the modules computed so far
+        if (triaged || full || request->actionable) {
+            const auto actionable =
+                NFIQ2::QualityMeasures::getActionableQualityFeedback(
+                    lazy.getComputedAlgorithms());
+            for (size_t i = 0; i < NFIQ2_ACTIONABLE_COUNT; ++i) {
+                out->actionable_values[i] = actionable.at(actionable_names[i]);
+            }
+        }
+
+        if (triaged) {
+            // modules past the triage stage did not run: no score
+            out->triaged = 1;
+        } else {
+            // native features, by position
+            const auto features = lazy.getComputedNativeQualityMeasures();
+            if (full) {
+                // unified score from the modules computed above, instead of
+                // computeUnifiedQualityScore(img) which would run them all
+                // again
+                out->score = model.computeUnifiedQualityScore(features);
+                std::copy(features.cbegin(), features.cend(),
+                          out->feature_values);
+            } else {
+                for (uint32_t i = 0; i < request->feature_count; ++i) {
+                    out->feature_values[request->features[i]] =
+                        features[request->features[i]];
+                }
+            }
+        }
+
+        if (scope) {
+            copy_measurements(scope->getMeasurements(), instrumentation);
+        }
+        return 0;
+    }
+    catch (...) {
+        std::memset(out, 0, sizeof(*out));
+        if (instrumentation) {
+            std::memset(instrumentation, 0, sizeof(*instrumentation));
+        }
+        return 2;
+    }
+}
+
+/// Per-worker share of a batch. The owner takes items from the front;
+/// idle workers steal from the back of other queues.
+struct WorkQueue {
+    std::mutex           lock;
+    std::deque<uint32_t> items;
+};
+
+/// Take the next item for worker `self`, stealing once its queue is empty.
+bool next_item(std::vector<WorkQueue>& queues, unsigned int self, uint32_t& item)
+{
+    {
+        std::lock_guard<std::mutex> guard(queues[self].lock);
+        if (!queues[self].items.empty()) {
+            item = queues[self].items.front();
+            queues[self].items.pop_front();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+        WorkQueue& victim = queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Compute `count` images on a work-stealing pool of up to `threads`
+/// worker threads (0 = one per hardware thread) sharing `ctx`'s model.
+/// Each worker gets image `i` from `source(i, image)`, which returns 0 or
+/// the status to store without computing it, and hands it back to
+/// `release(i)` once computed, so only the images being computed need to
+/// be held at once.
+template <typename Source, typename Release>
+void run_batch(const Nfiq2Wrapper& ctx,
+               uint32_t            count,
+               uint32_t            threads,
+               Source              source,
+               Release             release,
+               nfiq2_results_t*    results,
+               int*                status)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memset(&results[i], 0, sizeof(results[i]));
+        status[i] = 2;
+    }
+
+    unsigned int workers = threads;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers = std::min<unsigned int>(workers, std::max(count, 1u));
+
+    // one queue per worker, seeded with a contiguous slice of the batch
+    std::vector<WorkQueue> queues(workers);
+    for (uint32_t i = 0; i < count; ++i) {
+        queues[static_cast<uint64_t>(i) * workers / count].items.push_back(i);
+    }
+
+    // every worker shares the read-only model; modules and OpenCV
+    // operations of a single image run sequentially since the batch
+    // already keeps all threads busy
+    std::unique_ptr<SerialOpenCVScope> serial;
+    if (workers > 1) {
+        serial.reset(new SerialOpenCVScope());
+    }
+    const NFIQ2::Algorithm& model = *ctx.model;
+    const auto triage = std::atomic_load(&ctx.triage);
+    auto work = [&](unsigned int self) {
+        uint32_t i;
+        while (next_item(queues, self, i)) {
+            nfiq2_image_t img;
+            std::memset(&img, 0, sizeof(img));
+            const int rc = source(i, img);
+            if (rc != 0) {
+                status[i] = rc;
+                continue;
+            }
+            status[i] = compute_one(model, triage.get(), nullptr, img.data,
+                                    img.size, img.cols, img.rows, img.ppi, 1,
+                                    &results[i]);
+            release(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned int w = 1; w < workers; ++w) {
+        try {
+            pool.emplace_back(work, w);
+        } catch (const std::system_error&) {
+            // fewer threads: the remaining queues get stolen from
+            break;
+        }
+    }
+    work(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+} // namespace
+
 extern "C" {
 
 Nfiq2Wrapper* nfiq2wrapper_create() {
     try {
-        return new Nfiq2Wrapper{};
+        return new Nfiq2Wrapper(shared_model());
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+Nfiq2Wrapper* nfiq2wrapper_clone(const Nfiq2Wrapper* ctx) {
+    if (!ctx) {
+        return nullptr;
+    }
+    try {
+        return new Nfiq2Wrapper(ctx->model, ctx->module_threads.load(),
+                                std::atomic_load(&ctx->triage));
     } catch (...) {
         return nullptr;
     }
@@ -22,6 +412,111 @@ void nfiq2wrapper_destroy(Nfiq2Wrapper* ctx) {
     delete ctx;
 }
 
+const void* nfiq2wrapper_model(const Nfiq2Wrapper* ctx) {
+    return ctx ? ctx->model.get() : nullptr;
+}
+
+void nfiq2wrapper_set_module_threads(Nfiq2Wrapper* ctx, uint32_t threads) {
+    if (ctx) {
+        ctx->module_threads.store(threads);
+    }
+}
+
+void nfiq2wrapper_set_opencv_threads(uint32_t threads) {
+    OpenCVThreads& opencv = opencv_threads();
+    std::lock_guard<std::mutex> guard(opencv.lock);
+    opencv.budget = (threads == 0) ? -1 : static_cast<int>(threads);
+    // running batches restore it when the last one ends
+    if (opencv.batches == 0) {
+        apply_opencv_threads(opencv.budget);
+    }
+}
+
+void nfiq2wrapper_default_triage_policy(nfiq2_triage_policy_t* policy) {
+    if (!policy) {
+        return;
+    }
+    const NFIQ2::QualityMeasures::TriagePolicy defaults;
+    policy->stop_on_uniform_image = defaults.stopOnUniformImage;
+    policy->uniform_image_threshold = defaults.uniformImageThreshold;
+    policy->stop_on_empty_image = defaults.stopOnEmptyImage;
+    policy->empty_image_threshold = defaults.emptyImageThreshold;
+    policy->stop_on_insufficient_foreground =
+        defaults.stopOnInsufficientForeground;
+    policy->foreground_threshold = defaults.foregroundThreshold;
+}
+
+void nfiq2wrapper_set_triage_policy(Nfiq2Wrapper*                ctx,
+                                    const nfiq2_triage_policy_t* policy) {
+    if (!ctx) {
+        return;
+    }
+    std::shared_ptr<const NFIQ2::QualityMeasures::TriagePolicy> triage;
+    if (policy) {
+        try {
+            auto copy = std::make_shared<NFIQ2::QualityMeasures::TriagePolicy>();
+            copy->stopOnUniformImage = policy->stop_on_uniform_image != 0;
+            copy->uniformImageThreshold = policy->uniform_image_threshold;
+            copy->stopOnEmptyImage = policy->stop_on_empty_image != 0;
+            copy->emptyImageThreshold = policy->empty_image_threshold;
+            copy->stopOnInsufficientForeground =
+                policy->stop_on_insufficient_foreground != 0;
+            copy->foregroundThreshold = policy->foreground_threshold;
+            triage = std::move(copy);
+        } catch (...) {
+            return;
+        }
+    }
+    std::atomic_store(&ctx->triage, std::move(triage));
+}
+
+const char* nfiq2wrapper_cpu_dispatch() {
+    static const std::string description = []() -> std::string {
+        try {
+            return "nfiq2: " + NFIQ2::Version::CPUDispatch() +
+                   "; opencv: " + NFIQ2::Version::OpenCVCPUFeatures();
+        } catch (...) {
+            return std::string();
+        }
+    }();
+    return description.c_str();
+}
+
+const char* const* nfiq2wrapper_feature_names(uint32_t* count) {
+    if (count) {
+        *count = NFIQ2_FEATURE_COUNT;
+    }
+    return NFIQ2::QualityMeasures::NativeQualityMeasureIdentifiers;
+}
+
+const char* const* nfiq2wrapper_actionable_names(uint32_t* count) {
+    if (count) {
+        *count = NFIQ2_ACTIONABLE_COUNT;
+    }
+    return actionable_names;
+}
+
+const char* const* nfiq2wrapper_algorithm_names(uint32_t* count) {
+    static const std::vector<const char*> names = []() {
+        std::vector<const char*> names;
+        for (const auto& id : all_algorithms()) {
+            names.push_back(id.c_str());
+        }
+        return names;
+    }();
+    if (count) {
+        *count = NFIQ2_ALGORITHM_COUNT;
+    }
+    return names.data();
+}
+
+const char* const* nfiq2wrapper_stage_names(uint32_t* count) {
+    if (count) {
+        *count = NFIQ2_STAGE_COUNT;
+    }
+    return NFIQ2::Instrumentation::StageIdentifiers;
+}
+
 int nfiq2wrapper_compute(Nfiq2Wrapper*    ctx,
                          const uint8_t*   data,
                          uint32_t         size,
@@ -30,73 +525,128 @@ int nfiq2wrapper_compute(Nfiq2Wrapper*    ctx,
                          uint16_t         ppi,
                          nfiq2_results_t* out)
 {
-    if (!ctx || !data || !out || size != cols * rows) {
+    if (!ctx) {
+        if (out) {
+            std::memset(out, 0, sizeof(*out));
+        }
         return 1;
     }
+    const auto triage = std::atomic_load(&ctx->triage);
+    return compute_one(*ctx->model, triage.get(), nullptr, data, size, cols,
+                       rows, ppi, ctx->module_threads.load(), out);
+}
 
-    try {
-        // build the image data
-        NFIQ2::FingerprintImageData img(data, size, cols, rows, 0 /*dpi units*/, ppi);
-
-        // native measures
-        auto algos = NFIQ2::QualityMeasures::computeNativeQualityMeasureAlgorithms(img);
-
-        // unified score (reuse the same model each call!)
-        out->score = ctx->model.computeUnifiedQualityScore(img);
-
-        // actionable feedback
-        auto act_ids = NFIQ2::QualityMeasures::getActionableQualityFeedbackIDs();
-        auto act_map = NFIQ2::QualityMeasures::getActionableQualityFeedback(algos);
-
-        out->actionable_count  = static_cast<uint32_t>(act_ids.size());
-        out->actionable_ids    = (const char**)std::malloc(sizeof(char*) * act_ids.size());
-        out->actionable_values = (double*)     std::malloc(sizeof(double) * act_ids.size());
-        for (size_t i = 0; i < act_ids.size(); ++i) {
-            const auto& id = act_ids[i];
-            char* copy = (char*)std::malloc(id.size()+1);
-            std::memcpy(copy, id.c_str(), id.size()+1);
-            out->actionable_ids[i]    = copy;
-            out->actionable_values[i] = act_map.at(id);
+int nfiq2wrapper_compute_request(Nfiq2Wrapper*          ctx,
+                                 const uint8_t*         data,
+                                 uint32_t               size,
+                                 uint32_t               cols,
+                                 uint32_t               rows,
+                                 uint16_t               ppi,
+                                 const nfiq2_request_t* request,
+                                 nfiq2_results_t*       out)
+{
+    if (!ctx) {
+        if (out) {
+            std::memset(out, 0, sizeof(*out));
         }
+        return 1;
+    }
+    const auto triage = std::atomic_load(&ctx->triage);
+    return compute_one(*ctx->model, triage.get(), request, data, size, cols,
+                       rows, ppi, ctx->module_threads.load(), out);
+}
 
-        // native features
-        auto feat_ids = NFIQ2::QualityMeasures::getNativeQualityMeasureIDs();
-        auto feat_map = NFIQ2::QualityMeasures::getNativeQualityMeasures(algos);
-
-        out->feature_count  = static_cast<uint32_t>(feat_ids.size());
-        out->feature_ids    = (const char**)std::malloc(sizeof(char*) * feat_ids.size());
-        out->feature_values = (double*)     std::malloc(sizeof(double) * feat_ids.size());
-        for (size_t i = 0; i < feat_ids.size(); ++i) {
-            const auto& id = feat_ids[i];
-            char* copy = (char*)std::malloc(id.size()+1);
-            std::memcpy(copy, id.c_str(), id.size()+1);
-            out->feature_ids[i]    = copy;
-            out->feature_values[i] = feat_map.at(id);
+int nfiq2wrapper_compute_instrumented(Nfiq2Wrapper*            ctx,
+                                      const uint8_t*           data,
+                                      uint32_t                 size,
+                                      uint32_t                 cols,
+                                      uint32_t                 rows,
+                                      uint16_t                 ppi,
+                                      const nfiq2_request_t*   request,
+                                      nfiq2_results_t*         out,
+                                      nfiq2_instrumentation_t* instrumentation)
+{
+    if (!ctx || !instrumentation) {
+        if (out) {
+            std::memset(out, 0, sizeof(*out));
         }
-
-        return 0;
+        if (instrumentation) {
+            std::memset(instrumentation, 0, sizeof(*instrumentation));
+        }
+        return 1;
     }
-    catch (...) {
-        return 2;
+    const auto triage = std::atomic_load(&ctx->triage);
+    return compute_one(*ctx->model, triage.get(), request, data, size, cols,
+                       rows, ppi, ctx->module_threads.load(), out, instrumentation);
+}
+
+char* nfiq2wrapper_histograms(uint8_t json) {
+    try {
+        const std::string histograms = json
+            ? NFIQ2::Instrumentation::getHistogramsJSON()
+            : NFIQ2::Instrumentation::getHistogramsText();
+        char* copy = static_cast<char*>(std::malloc(histograms.size() + 1));
+        if (copy) {
+            std::memcpy(copy, histograms.c_str(), histograms.size() + 1);
+        }
+        return copy;
+    } catch (...) {
+        return nullptr;
     }
 }
 
-void nfiq2wrapper_free_results(nfiq2_results_t* out) {
-    if (!out) return;
+void nfiq2wrapper_free_string(char* string) {
+    std::free(string);
+}
+
+void nfiq2wrapper_reset_histograms() {
+    NFIQ2::Instrumentation::resetHistograms();
+}
 
-    for (uint32_t i = 0; i < out->actionable_count; ++i) {
-        std::free((void*)out->actionable_ids[i]);
+int nfiq2wrapper_compute_batch(Nfiq2Wrapper*        ctx,
+                               const nfiq2_image_t* images,
+                               uint32_t             count,
+                               uint32_t             threads,
+                               nfiq2_results_t*     results,
+                               int*                 status)
+{
+    if (!ctx || (count > 0 && (!images || !results || !status))) {
+        return 1;
     }
-    std::free(out->actionable_ids);
-    std::free(out->actionable_values);
 
-    for (uint32_t i = 0; i < out->feature_count; ++i) {
-        std::free((void*)out->feature_ids[i]);
+    run_batch(*ctx, count, threads,
+              [images](uint32_t i, nfiq2_image_t& image) {
+                  image = images[i];
+                  return 0;
+              },
+              [](uint32_t) {}, results, status);
+    return 0;
+}
+
+int nfiq2wrapper_compute_batch_from(Nfiq2Wrapper*         ctx,
+                                    uint32_t              count,
+                                    uint32_t              threads,
+                                    nfiq2_image_source_t  source,
+                                    nfiq2_image_release_t release,
+                                    void*                 user,
+                                    nfiq2_results_t*      results,
+                                    int*                  status)
+{
+    if (!ctx || (count > 0 && (!source || !results || !status))) {
+        return 1;
     }
-    std::free(out->feature_ids);
-    std::free(out->feature_values);
 
-    std::memset(out, 0, sizeof(*out));
+    run_batch(*ctx, count, threads,
+              [source, user](uint32_t i, nfiq2_image_t& image) {
+                  return source(user, i, &image);
+              },
+              [release, user](uint32_t i) {
+                  if (release) {
+                      release(user, i);
+                  }
+              },
+              results, status);
+    return 0;
 }
 
 } // extern "C"
\ No newline at end of file
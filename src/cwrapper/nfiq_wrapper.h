@@ -10,26 +10,167 @@ extern "C" {
 /// Opaque handle to our NFIQ2 wrapper object
 typedef struct Nfiq2Wrapper Nfiq2Wrapper;
 
-/// Quality‐score + feature arrays
+/// Number of native quality features, see nfiq2wrapper_feature_names
+#define NFIQ2_FEATURE_COUNT 69
+/// Number of actionable feedback values, see nfiq2wrapper_actionable_names
+#define NFIQ2_ACTIONABLE_COUNT 4
+/// Number of quality modules, see nfiq2wrapper_algorithm_names
+#define NFIQ2_ALGORITHM_COUNT 10
+/// Number of timed stages, see nfiq2wrapper_stage_names
+#define NFIQ2_STAGE_COUNT 5
+/// nfiq2_results_t::score when no score was computed. Scores range from 0
+/// to 100, so 0 is a valid score.
+#define NFIQ2_NO_SCORE 255
+
+/// Quality score, actionable feedback and native features of one image.
+/// Values are stored in place, in the order of the name tables, so the
+/// struct can live on the caller's stack and needs no freeing. If the
+/// image was triaged (see nfiq2wrapper_set_triage_policy), `triaged` is 1,
+/// `score` is NFIQ2_NO_SCORE, and features and feedback that were not
+/// computed are NaN.
 typedef struct {
     uint32_t score;
+    uint32_t triaged;
+    double   actionable_values[NFIQ2_ACTIONABLE_COUNT];
+    double   feature_values[NFIQ2_FEATURE_COUNT];
+} nfiq2_results_t;
 
-    uint32_t actionable_count;
-    const char** actionable_ids;
-    double*      actionable_values;
+/// Conditions of actionable feedback under which an image is triaged:
+/// only the quality modules needed to check them run, and no score is
+/// computed. Each condition is enabled by its non-zero `stop_on_` flag.
+typedef struct {
+    /// stop if UniformImage < uniform_image_threshold
+    uint8_t stop_on_uniform_image;
+    double  uniform_image_threshold;
+    /// stop if EmptyImageOrContrastTooLow > empty_image_threshold
+    uint8_t stop_on_empty_image;
+    double  empty_image_threshold;
+    /// stop if SufficientFingerprintForeground < foreground_threshold
+    /// (runs the ROI module, one of the most expensive)
+    uint8_t stop_on_insufficient_foreground;
+    double  foreground_threshold;
+} nfiq2_triage_policy_t;
 
-    uint32_t feature_count;
-    const char** feature_ids;
-    double*      feature_values;
-} nfiq2_results_t;
+/// What nfiq2wrapper_compute_request computes. Only the quality modules
+/// needed for it run (e.g. one histogram module for "OCL_Bin10_Mean"),
+/// each at most once; values that were not requested are NaN, and
+/// `score` is NFIQ2_NO_SCORE unless requested.
+typedef struct {
+    /// non-zero to compute the score, which needs every feature
+    uint8_t         score;
+    /// non-zero to compute the actionable feedback
+    uint8_t         actionable;
+    /// indices into nfiq2wrapper_feature_names of the features to compute
+    const uint32_t* features;
+    uint32_t        feature_count;
+} nfiq2_request_t;
+
+/// Where nfiq2wrapper_compute_instrumented spent its time and memory.
+/// Times are wall-clock milliseconds, NaN for modules and stages that did
+/// not run; modules running concurrently (see
+/// nfiq2wrapper_set_module_threads) overlap.
+typedef struct {
+    /// the whole call
+    double   total_ms;
+    /// each quality module, in the order of nfiq2wrapper_algorithm_names
+    double   algorithm_ms[NFIQ2_ALGORITHM_COUNT];
+    /// stages inside the modules and the score prediction, in the order
+    /// of nfiq2wrapper_stage_names
+    double   stage_ms[NFIQ2_STAGE_COUNT];
+    /// scratch buffers the modules asked for
+    uint64_t scratch_allocations;
+    /// calls to the system allocator made for them
+    uint64_t system_allocations;
+    /// local regions in the fingerprint foreground, -1 if not segmented
+    int64_t  foreground_blocks;
+} nfiq2_instrumentation_t;
 
-/// Create a new wrapper (allocates + initializes the embedded model)
+/// One 8-bit grayscale image of a batch (see nfiq2wrapper_compute)
+typedef struct {
+    const uint8_t* data;
+    uint32_t       size;
+    uint32_t       cols;
+    uint32_t       rows;
+    uint16_t       ppi;
+} nfiq2_image_t;
+
+/// Create a new wrapper. The embedded model is loaded by the first call
+/// and shared, read-only, by every wrapper in the process, so later calls
+/// only allocate the handle.
 Nfiq2Wrapper* nfiq2wrapper_create();
 
-/// Destroy the wrapper (frees the model)
+/// Create a new wrapper sharing `ctx`'s model and settings. The two
+/// handles are independent and must each be destroyed.
+Nfiq2Wrapper* nfiq2wrapper_clone(const Nfiq2Wrapper* ctx);
+
+/// Destroy the wrapper (the shared model stays loaded)
 void nfiq2wrapper_destroy(Nfiq2Wrapper* ctx);
 
-/// Compute quality on the given raw‐pixel buffer.
+/// Address of the model used by `ctx`, the same for every wrapper sharing
+/// it; NULL if `ctx` is NULL. Only meant to be compared.
+const void* nfiq2wrapper_model(const Nfiq2Wrapper* ctx);
+
+/// Set the maximum number of threads used to run independent quality
+/// modules of a single image (FDA, FingerJetFX, LCS, ...). Values < 2
+/// (the default) run them sequentially. Results are identical either way.
+void nfiq2wrapper_set_module_threads(Nfiq2Wrapper* ctx, uint32_t threads);
+
+/// Set the number of threads OpenCV may use inside a single operation
+/// (blur, erosion, DFT, ...): 0 (OpenCV's default) for one per hardware
+/// thread, 1 for none besides the caller, e.g. in your own worker pool.
+/// The budget is process-wide, not per wrapper: OpenCV has a single pool,
+/// which this resizes, so call it once at startup rather than between
+/// computations. Batches with several workers override it with 1 while
+/// they run (for every computation of the process meanwhile), then
+/// restore it. Without a parallel framework in OpenCV (see the
+/// opencv-pthreads feature) this has no effect. Results are identical
+/// either way.
+void nfiq2wrapper_set_opencv_threads(uint32_t threads);
+
+/// Fill `policy` with NFIQ2's defaults: stop on uniform and on empty
+/// images, at the thresholds of NFIQ2's actionable feedback.
+void nfiq2wrapper_default_triage_policy(nfiq2_triage_policy_t* policy);
+
+/// Triage images computed by this wrapper, batches included, with a copy
+/// of `policy`; NULL (the default) computes every image in full.
+void nfiq2wrapper_set_triage_policy(Nfiq2Wrapper*                ctx,
+                                    const nfiq2_triage_policy_t* policy);
+
+/// Describe the instruction sets used on this CPU: the variant of the NFIQ2
+/// kernels compiled for several (see the superbuild's NFIQ2_CPU_DISPATCH),
+/// then OpenCV's baseline features and, marked with `*`, those it
+/// dispatches to (suffixed with `?` if this CPU lacks them), e.g.
+/// "nfiq2: avx2; opencv: SSE SSE2 SSE3 *SSE4.1 ... *AVX2 *AVX512-SKX?".
+/// The string is static and must not be freed.
+const char* nfiq2wrapper_cpu_dispatch();
+
+/// Identifiers of nfiq2_results_t::feature_values, e.g. "FDA_Bin10_0".
+/// The table and its strings are static and must not be freed. Stores
+/// NFIQ2_FEATURE_COUNT in `count` if it is not null.
+const char* const* nfiq2wrapper_feature_names(uint32_t* count);
+
+/// Identifiers of nfiq2_results_t::actionable_values, e.g. "UniformImage".
+/// The table and its strings are static and must not be freed. Stores
+/// NFIQ2_ACTIONABLE_COUNT in `count` if it is not null.
+const char* const* nfiq2wrapper_actionable_names(uint32_t* count);
+
+/// Identifiers of nfiq2_instrumentation_t::algorithm_ms, e.g.
+/// "MinutiaeCount". The table and its strings are static and must not be
+/// freed. Stores NFIQ2_ALGORITHM_COUNT in `count` if it is not null.
+const char* const* nfiq2wrapper_algorithm_names(uint32_t* count);
+
+/// Identifiers of nfiq2_instrumentation_t::stage_ms: "Crop",
+/// "RidgeSegment", "BlockGeometry" (which includes RidgeSegment),
+/// "FingerJetFXExtraction" (enhancement and minutiae extraction, a single
+/// call) and "RandomForestPrediction". The table and its strings are
+/// static and must not be freed. Stores NFIQ2_STAGE_COUNT in `count` if it
+/// is not null.
+const char* const* nfiq2wrapper_stage_names(uint32_t* count);
+
+/// Compute quality on the given raw‐pixel buffer (8-bit grayscale, row
+/// major, `cols * rows` bytes). The buffer is read in place, without
+/// copying, and is not referenced after the call returns. Nothing is
+/// allocated for `out`; on failure it is zeroed.
 /// Returns 0 on success, 1 on invalid args, 2 on unexpected error.
 int nfiq2wrapper_compute(Nfiq2Wrapper*    ctx,
                          const uint8_t*   data,
@@ -39,8 +180,90 @@ int nfiq2wrapper_compute(Nfiq2Wrapper*    ctx,
                          uint16_t         ppi,
                          nfiq2_results_t* out);
 
-/// Free any malloc’ed arrays inside results and zero it out.
-void nfiq2wrapper_free_results(nfiq2_results_t* out);
+/// Compute part of the results of nfiq2wrapper_compute, as `request`
+/// asks, on the same raw-pixel buffer. A NULL `request` computes
+/// everything. Images meeting the triage policy come back triaged as with
+/// nfiq2wrapper_compute.
+/// Returns 0 on success, 1 on invalid args (including a feature index
+/// >= NFIQ2_FEATURE_COUNT), 2 on unexpected error.
+int nfiq2wrapper_compute_request(Nfiq2Wrapper*          ctx,
+                                 const uint8_t*         data,
+                                 uint32_t               size,
+                                 uint32_t               cols,
+                                 uint32_t               rows,
+                                 uint16_t               ppi,
+                                 const nfiq2_request_t* request,
+                                 nfiq2_results_t*       out);
+
+/// nfiq2wrapper_compute_request, also measuring where the time and memory
+/// went into `instrumentation`, which is zeroed on failure. The
+/// measurements are added to the process-wide histograms (see
+/// nfiq2wrapper_histograms). Other calls are not measured, and results
+/// are identical either way.
+/// Returns the codes of nfiq2wrapper_compute_request, 1 if
+/// `instrumentation` is NULL.
+int nfiq2wrapper_compute_instrumented(Nfiq2Wrapper*            ctx,
+                                      const uint8_t*           data,
+                                      uint32_t                 size,
+                                      uint32_t                 cols,
+                                      uint32_t                 rows,
+                                      uint16_t                 ppi,
+                                      const nfiq2_request_t*   request,
+                                      nfiq2_results_t*         out,
+                                      nfiq2_instrumentation_t* instrumentation);
+
+/// Describe the histograms of every measurement made by
+/// nfiq2wrapper_compute_instrumented since the last
+/// nfiq2wrapper_reset_histograms, as text (one line per measurement) or,
+/// if `json` is non-zero, as a JSON object. The string must be freed with
+/// nfiq2wrapper_free_string; NULL if out of memory.
+char* nfiq2wrapper_histograms(uint8_t json);
+
+/// Free a string returned by nfiq2wrapper_histograms (NULL is ignored)
+void nfiq2wrapper_free_string(char* string);
+
+/// Empty the process-wide histograms
+void nfiq2wrapper_reset_histograms();
+
+/// Compute quality for `count` images on a work-stealing pool of up to
+/// `threads` worker threads (0 = one per hardware thread) that share the
+/// wrapper's model. `results[i]` and `status[i]` receive the outcome of
+/// `images[i]`; status codes are those of nfiq2wrapper_compute. With
+/// several workers, OpenCV stays single-threaded until the batch ends (see
+/// nfiq2wrapper_set_opencv_threads).
+/// Returns 0 if the batch ran, 1 on invalid args.
+int nfiq2wrapper_compute_batch(Nfiq2Wrapper*        ctx,
+                               const nfiq2_image_t* images,
+                               uint32_t             count,
+                               uint32_t             threads,
+                               nfiq2_results_t*     results,
+                               int*                 status);
+
+/// Supply image `index` of a batch computed by
+/// nfiq2wrapper_compute_batch_from in `image`, e.g. by decoding it.
+/// Returns 0, or a non-zero status stored for the image, which is then not
+/// computed. Called from the batch's worker threads, concurrently for
+/// different images.
+typedef int (*nfiq2_image_source_t)(void* user, uint32_t index,
+                                     nfiq2_image_t* image);
+
+/// Release image `index` of a batch once it was computed (only for images
+/// `source` supplied). Called from the batch's worker threads.
+typedef void (*nfiq2_image_release_t)(void* user, uint32_t index);
+
+/// nfiq2wrapper_compute_batch, getting each image from `source` on the
+/// worker that computes it, and giving it back to `release` (if not NULL)
+/// right after, so supplying images overlaps computing others, and only
+/// about `threads` of them are held at once. `user` is passed to both.
+/// Returns 0 if the batch ran, 1 on invalid args.
+int nfiq2wrapper_compute_batch_from(Nfiq2Wrapper*         ctx,
+                                    uint32_t              count,
+                                    uint32_t              threads,
+                                    nfiq2_image_source_t  source,
+                                    nfiq2_image_release_t release,
+                                    void*                 user,
+                                    nfiq2_results_t*      results,
+                                    int*                  status);
 
 #ifdef __cplusplus
 }
@@ -1,16 +1,70 @@
-use std::os::raw::{c_char, c_int, c_uchar, c_uint, c_ushort};
+use std::{
+    ffi::c_void,
+    os::raw::{c_char, c_int, c_uchar, c_uint, c_ushort},
+};
+
+/// NFIQ2_FEATURE_COUNT
+pub(crate) const FEATURE_COUNT: usize = 69;
+/// NFIQ2_ACTIONABLE_COUNT
+pub(crate) const ACTIONABLE_COUNT: usize = 4;
+/// NFIQ2_ALGORITHM_COUNT
+pub(crate) const ALGORITHM_COUNT: usize = 10;
+/// NFIQ2_STAGE_COUNT
+pub(crate) const STAGE_COUNT: usize = 5;
+/// NFIQ2_NO_SCORE
+pub(crate) const NO_SCORE: u32 = 255;
 
 #[repr(C)]
 pub(crate) struct Nfiq2ResultsT {
     pub(crate) score: c_uint,
-    pub(crate) actionable_count: c_uint,
-    pub(crate) actionable_ids: *const *const c_char,
-    pub(crate) actionable_values: *mut f64,
+    pub(crate) triaged: c_uint,
+    pub(crate) actionable_values: [f64; ACTIONABLE_COUNT],
+    pub(crate) feature_values: [f64; FEATURE_COUNT],
+}
+
+#[repr(C)]
+pub(crate) struct Nfiq2TriagePolicyT {
+    pub(crate) stop_on_uniform_image: u8,
+    pub(crate) uniform_image_threshold: f64,
+    pub(crate) stop_on_empty_image: u8,
+    pub(crate) empty_image_threshold: f64,
+    pub(crate) stop_on_insufficient_foreground: u8,
+    pub(crate) foreground_threshold: f64,
+}
+
+#[repr(C)]
+pub(crate) struct Nfiq2RequestT {
+    pub(crate) score: u8,
+    pub(crate) actionable: u8,
+    pub(crate) features: *const c_uint,
     pub(crate) feature_count: c_uint,
-    pub(crate) feature_ids: *const *const c_char,
-    pub(crate) feature_values: *mut f64,
 }
 
+#[repr(C)]
+pub(crate) struct Nfiq2InstrumentationT {
+    pub(crate) total_ms: f64,
+    pub(crate) algorithm_ms: [f64; ALGORITHM_COUNT],
+    pub(crate) stage_ms: [f64; STAGE_COUNT],
+    pub(crate) scratch_allocations: u64,
+    pub(crate) system_allocations: u64,
+    pub(crate) foreground_blocks: i64,
+}
+
+#[repr(C)]
+pub(crate) struct Nfiq2ImageT {
+    pub(crate) data: *const c_uchar,
+    pub(crate) size: c_uint,
+    pub(crate) cols: c_uint,
+    pub(crate) rows: c_uint,
+    pub(crate) ppi: c_ushort,
+}
+
+/// nfiq2_image_source_t
+pub(crate) type Nfiq2ImageSourceT =
+    unsafe extern "C" fn(user: *mut c_void, index: c_uint, image: *mut Nfiq2ImageT) -> c_int;
+/// nfiq2_image_release_t
+pub(crate) type Nfiq2ImageReleaseT = unsafe extern "C" fn(user: *mut c_void, index: c_uint);
+
 /// Opaque C++ wrapper handle
 #[repr(C)]
 pub struct Nfiq2WrapperOpaque {
@@ -20,7 +74,21 @@ pub struct Nfiq2WrapperOpaque {
 // FFI imports
 extern "C" {
     pub(crate) fn nfiq2wrapper_create() -> *mut Nfiq2WrapperOpaque;
+    pub(crate) fn nfiq2wrapper_clone(ctx: *const Nfiq2WrapperOpaque) -> *mut Nfiq2WrapperOpaque;
     pub(crate) fn nfiq2wrapper_destroy(ctx: *mut Nfiq2WrapperOpaque);
+    pub(crate) fn nfiq2wrapper_model(ctx: *const Nfiq2WrapperOpaque) -> *const c_void;
+    pub(crate) fn nfiq2wrapper_set_module_threads(ctx: *mut Nfiq2WrapperOpaque, threads: c_uint);
+    pub(crate) fn nfiq2wrapper_set_opencv_threads(threads: c_uint);
+    pub(crate) fn nfiq2wrapper_default_triage_policy(policy: *mut Nfiq2TriagePolicyT);
+    pub(crate) fn nfiq2wrapper_set_triage_policy(
+        ctx: *mut Nfiq2WrapperOpaque,
+        policy: *const Nfiq2TriagePolicyT,
+    );
+    pub(crate) fn nfiq2wrapper_cpu_dispatch() -> *const c_char;
+    pub(crate) fn nfiq2wrapper_feature_names(count: *mut c_uint) -> *const *const c_char;
+    pub(crate) fn nfiq2wrapper_actionable_names(count: *mut c_uint) -> *const *const c_char;
+    pub(crate) fn nfiq2wrapper_algorithm_names(count: *mut c_uint) -> *const *const c_char;
+    pub(crate) fn nfiq2wrapper_stage_names(count: *mut c_uint) -> *const *const c_char;
 
     pub(crate) fn nfiq2wrapper_compute(
         ctx: *mut Nfiq2WrapperOpaque,
@@ -32,5 +100,41 @@ extern "C" {
         out: *mut Nfiq2ResultsT,
     ) -> c_int;
 
-    pub(crate) fn nfiq2wrapper_free_results(out: *mut Nfiq2ResultsT);
+    pub(crate) fn nfiq2wrapper_compute_request(
+        ctx: *mut Nfiq2WrapperOpaque,
+        data: *const c_uchar,
+        size: c_uint,
+        cols: c_uint,
+        rows: c_uint,
+        ppi: c_ushort,
+        request: *const Nfiq2RequestT,
+        out: *mut Nfiq2ResultsT,
+    ) -> c_int;
+
+    pub(crate) fn nfiq2wrapper_compute_instrumented(
+        ctx: *mut Nfiq2WrapperOpaque,
+        data: *const c_uchar,
+        size: c_uint,
+        cols: c_uint,
+        rows: c_uint,
+        ppi: c_ushort,
+        request: *const Nfiq2RequestT,
+        out: *mut Nfiq2ResultsT,
+        instrumentation: *mut Nfiq2InstrumentationT,
+    ) -> c_int;
+
+    pub(crate) fn nfiq2wrapper_histograms(json: u8) -> *mut c_char;
+    pub(crate) fn nfiq2wrapper_free_string(string: *mut c_char);
+    pub(crate) fn nfiq2wrapper_reset_histograms();
+
+    pub(crate) fn nfiq2wrapper_compute_batch_from(
+        ctx: *mut Nfiq2WrapperOpaque,
+        count: c_uint,
+        threads: c_uint,
+        source: Nfiq2ImageSourceT,
+        release: Option<Nfiq2ImageReleaseT>,
+        user: *mut c_void,
+        results: *mut Nfiq2ResultsT,
+        status: *mut c_int,
+    ) -> c_int;
 }
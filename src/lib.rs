@@ -4,5 +4,11 @@ mod api;
 mod errors;
 mod ffi;
 
-pub use api::{create_nfiq2, Nfiq2, Nfiq2Result, Nfiq2Value};
+pub use api::{
+    actionable_names, cpu_dispatch_info, create_nfiq2, default_triage_policy, feature_names,
+    instrumentation_histograms_json, instrumentation_histograms_text, module_names,
+    reset_instrumentation_histograms, set_opencv_threads, stage_names, Nfiq2, Nfiq2BatchItem,
+    Nfiq2Instrumentation, Nfiq2InstrumentedResult, Nfiq2Request, Nfiq2Result, Nfiq2Scores,
+    Nfiq2TriagePolicy, Nfiq2Value, ACTIONABLE_COUNT, FEATURE_COUNT, NO_SCORE,
+};
 pub use errors::Nfiq2Error;